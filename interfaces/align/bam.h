@@ -513,6 +513,15 @@ struct BAMReadGroup
 typedef uint64_t BAMFilePosition;
 
 
+/* SetDecompressionThreads
+ *  set the number of threads used to inflate BGZF blocks
+ *  of BAM files opened afterwards and by BAMValidate
+ *
+ *  "count" [ IN ] - 0 inflates blocks on the reading thread,
+ *  which is the default
+ */
+ALIGN_EXTERN rc_t CC BAMFileSetDecompressionThreads ( unsigned count );
+
 /* Make
  *  open the BAM file specified by path
  *
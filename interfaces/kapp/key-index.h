@@ -0,0 +1,91 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_kapp_key_index_
+#define _h_kapp_key_index_
+
+#ifndef _h_kapp_extern_
+#include <kapp/extern.h>
+#endif
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * KeyIndex
+ *  maps spot names to densely assigned ids
+ *
+ *  names are kept as 96 bit fingerprints in an in-memory open addressing
+ *  hash; when the memory limit is reached the table is sorted and spilled
+ *  to a run in tmpfs, and runs are merged as they accumulate. each run
+ *  keeps a bloom filter in memory so that most misses do not read it.
+ *  all operations are serialized by an internal lock.
+ */
+typedef struct KeyIndex KeyIndex;
+
+
+/* Make
+ *  "tmpfs", "pid" and "n" name the scratch files
+ *
+ *  "memLimit" [ IN ] - bytes the in-memory table may grow to before spilling
+ */
+KAPP_EXTERN rc_t CC KeyIndexMake ( KeyIndex **idx, const char *tmpfs,
+    uint64_t pid, uint32_t n, size_t memLimit );
+
+
+/* Whack
+ */
+KAPP_EXTERN void CC KeyIndexWhack ( KeyIndex *self );
+
+
+/* Entry
+ *  look up key; if it is not present, it is given the next id
+ *
+ *  "id" [ OUT ] - the id of the key
+ *
+ *  "wasInserted" [ OUT ] - true if the key was new
+ */
+KAPP_EXTERN rc_t CC KeyIndexEntry ( KeyIndex *self, uint32_t *id,
+    bool *wasInserted, const void *key, size_t keylen );
+
+
+/* Merge
+ *  final merge of all spilled runs into one
+ */
+KAPP_EXTERN rc_t CC KeyIndexMerge ( KeyIndex *self );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_kapp_key_index_ */
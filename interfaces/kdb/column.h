@@ -214,6 +214,21 @@ KDB_EXTERN rc_t CC KColumnOpenParentRead ( const KColumn *self, struct KTable co
 KDB_EXTERN rc_t CC KColumnOpenParentUpdate ( KColumn *self, struct KTable **tbl );
 
 
+/* AdviseAccess
+ *  hint at the order in which blobs are going to be read
+ *  has an effect only on columns whose data are memory mapped
+ */
+typedef uint32_t KColumnAccess;
+enum
+{
+    kcaNormal,
+    kcaSequential,
+    kcaRandom
+};
+
+KDB_EXTERN rc_t CC KColumnAdviseAccess ( const KColumn *self, KColumnAccess access );
+
+
 /*--------------------------------------------------------------------------
  * KColumnBlob
  *  one or more rows of column data
@@ -262,6 +277,19 @@ KDB_EXTERN rc_t CC KColumnBlobRead ( const KColumnBlob *self,
     size_t *num_read, size_t *remaining );
 
 
+/* ReadDirect
+ *  access blob data in place without copying
+ *  available only when column data are memory mapped,
+ *  otherwise fails with an rcUnsupported state and
+ *  "Read" must be used instead
+ *
+ *  "addr" [ OUT ] and "size" [ OUT ] - blob data, which remain
+ *  valid for as long as the blob is held
+ */
+KDB_EXTERN rc_t CC KColumnBlobReadDirect ( const KColumnBlob *self,
+    const void **addr, size_t *size );
+
+
 /* Append
  *  append data to open blob
  *
@@ -77,6 +77,16 @@ KDB_EXTERN rc_t CC KDBManagerGetVFSManager ( const struct KDBManager *self,
     const struct VFSManager **vmanager );
 
 
+/* SetDataMMap
+ *  when enabled, the data of columns subsequently opened for read
+ *  from local files are memory mapped rather than read through a buffer
+ *  columns already open are not affected
+ *
+ *  disabled by default
+ */
+KDB_EXTERN rc_t CC KDBManagerSetDataMMap ( struct KDBManager const *self, bool enabled );
+
+
 /*--------------------------------------------------------------------------
  * KDatabase
  */
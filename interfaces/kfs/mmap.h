@@ -84,6 +84,32 @@ KFS_EXTERN rc_t CC KMMapPosition ( const KMMap *self, uint64_t *pos );
  */
 KFS_EXTERN rc_t CC KMMapReposition ( const KMMap *self, uint64_t pos, size_t *size );
 
+/* Advise
+ *  hint at how the region is going to be accessed
+ *
+ *  "pos" [ IN ] and "size" [ IN, DEFAULT ZERO ] - portion of
+ *  region affected, where "pos" is relative to region start.
+ *  a "size" of 0 means to end of region.
+ *
+ *  "advice" [ IN ] - expected pattern of access
+ *
+ *  returns an rcUnsupported state if the region was not mapped
+ *  by the system but read into memory, where hints are meaningless
+ */
+typedef uint32_t KMMapAdvice;
+enum
+{
+    kmmNormal,
+    kmmSequential,
+    kmmRandom,
+    kmmWillNeed,
+    kmmDontNeed
+};
+
+KFS_EXTERN rc_t CC KMMapAdvise ( const KMMap *self,
+    uint64_t pos, size_t size, KMMapAdvice advice );
+
+
 /* Addr
  *  returns starting address of memory region
  *
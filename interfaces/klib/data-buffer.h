@@ -109,6 +109,21 @@ KLIB_EXTERN rc_t CC KDataBufferMake ( KDataBuffer *buffer,
 #define KDataBufferMakeBits( buffer, bits ) \
     KDataBufferMake ( buffer, 1, bits )
 
+/* MakeView
+ *  create a buffer over memory owned by someone else, without copying
+ *
+ *  "data" [ IN ] and "bytes" [ IN ] - memory to view as bytes
+ *
+ *  "whack" [ IN, NULL OKAY ] and "obj" [ IN ] - called with "obj"
+ *  when the last reference is released, which is the point until
+ *  which "data" must remain valid
+ *
+ *  a view is never writable: MakeWritable copies its contents
+ */
+KLIB_EXTERN rc_t CC KDataBufferMakeView ( KDataBuffer *buffer,
+    const void *data, size_t bytes, void ( CC * whack ) ( void *obj ), void *obj );
+
+
 /* Sub
  *  create a sub-range reference to an existing buffer
  *
@@ -199,6 +214,23 @@ KLIB_EXTERN bool CC KDataBufferWritable ( const KDataBuffer *self );
 KLIB_EXTERN rc_t CC KDataBufferCheckIntegrity ( const KDataBuffer *self );
 
 
+/* TrimPool
+ *  give memory kept for recycling back to the system
+ *
+ * SetPoolLimit
+ *  bound the bytes kept for recycling, 0 to keep none
+ */
+KLIB_EXTERN void CC KDataBufferTrimPool ( void );
+KLIB_EXTERN void CC KDataBufferSetPoolLimit ( size_t bytes );
+
+
+/* GetPoolStats
+ *  report recycling of buffer memory, which is process-wide
+ */
+struct KSlabStats;
+KLIB_EXTERN void CC KDataBufferGetPoolStats ( struct KSlabStats *stats );
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -131,6 +131,33 @@ KLIB_EXTERN rc_t CC Unpack ( uint32_t packed, uint32_t unpacked,
     void *dst, size_t dsize, size_t *usize );
 
 
+/* KPackSimd
+ *  Pack and Unpack of 1, 2, 4 and 8 bit elements to or from
+ *  8, 16 and 32 bit elements, and vlen_decode/vlen_decodeU runs
+ *  of 1 and 2 byte values, use vector kernels when the processor
+ *  has them. the best level is picked on first use.
+ */
+typedef uint32_t KPackSimd;
+enum
+{
+    kpackScalar,
+    kpackSSE41,
+    kpackAVX2
+};
+
+/* PackSimdLevel
+ *  returns the level in use
+ */
+KLIB_EXTERN KPackSimd CC PackSimdLevel ( void );
+
+/* PackSimdLimit
+ *  caps the level used from now on, e.g. at kpackScalar to
+ *  measure the portable code. a level the processor lacks is
+ *  never used. returns the level in use afterward.
+ */
+KLIB_EXTERN KPackSimd CC PackSimdLimit ( KPackSimd limit );
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,169 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#ifndef _h_klib_slab_
+#define _h_klib_slab_
+
+#ifndef _h_klib_extern_
+#include <klib/extern.h>
+#endif
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifndef _h_atomic32_
+#include <atomic32.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * KSlab
+ *  a pool of equally sized objects to spare the system allocator
+ *  the churn of short-lived objects
+ *
+ *  freed objects are kept on a number of shards, each taken by
+ *  whichever thread is near it. a thread never waits for a shard:
+ *  when every shard is busy it goes to the system allocator.
+ *
+ *  objects come from malloc and may be given to free or realloc
+ *  instead of KSlabFree. a slab is declared statically with
+ *  KSLAB_INIT and lives for the whole process.
+ */
+#define KSLAB_SHARDS 8
+
+
+/*--------------------------------------------------------------------------
+ * KSlabBudget
+ *  bounds the bytes held by a group of slabs together
+ *  declared statically with KSLAB_BUDGET_INIT
+ */
+typedef struct KSlabBudget KSlabBudget;
+struct KSlabBudget
+{
+    /* bytes held by all slabs of the group */
+    atomic32_t held;
+
+    /* bytes they may hold */
+    volatile int32_t limit;
+};
+
+#define KSLAB_BUDGET_INIT( limit ) \
+    { { 0 }, ( limit ) }
+
+
+typedef struct KSlabShard KSlabShard;
+struct KSlabShard
+{
+    atomic32_t busy;
+    volatile uint32_t count;
+    void * volatile head;
+
+    volatile uint64_t hits;
+    volatile uint64_t misses;
+    volatile uint64_t recycled;
+    volatile uint64_t released;
+
+    /* one cache line each */
+    uint8_t align [ 16 ];
+};
+
+typedef struct KSlab KSlab;
+struct KSlab
+{
+    /* object size in bytes */
+    size_t size;
+
+    /* objects kept per shard */
+    uint32_t limit;
+
+    /* optional bound shared with other slabs */
+    KSlabBudget *budget;
+
+    /* calls that found every shard busy */
+    atomic32_t bypass;
+
+    KSlabShard shard [ KSLAB_SHARDS ];
+};
+
+#define KSLAB_INIT( size, limit ) \
+    { ( size ), ( limit ) }
+#define KSLAB_INIT_BUDGET( size, limit, budget ) \
+    { ( size ), ( limit ), ( budget ) }
+
+
+/* Alloc
+ *  returns an uninitialized object or NULL
+ */
+KLIB_EXTERN void * CC KSlabAlloc ( KSlab *self );
+
+
+/* Free
+ *  return an object to the pool, or to the system
+ *  when the pool has enough of them
+ */
+KLIB_EXTERN void CC KSlabFree ( KSlab *self, void *obj );
+
+
+/* Trim
+ *  give every object held to the system
+ *  shards busy at the time are left alone
+ */
+KLIB_EXTERN void CC KSlabTrim ( KSlab *self );
+
+
+/* GetStats
+ *  "hits" are allocations served from the pool, "misses" from the system
+ *  "recycled" objects were kept when freed, "released" were not
+ */
+typedef struct KSlabStats KSlabStats;
+struct KSlabStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t recycled;
+    uint64_t released;
+    uint64_t cached;        /* objects held now */
+    uint64_t bypass;        /* calls that found every shard busy */
+};
+
+KLIB_EXTERN void CC KSlabGetStats ( const KSlab *self, KSlabStats *stats );
+
+/* AddStats
+ *  accumulate "stats" into "sum"
+ */
+KLIB_EXTERN void CC KSlabStatsAdd ( KSlabStats *sum, const KSlabStats *stats );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_klib_slab_ */
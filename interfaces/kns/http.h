@@ -66,6 +66,21 @@ KNS_EXTERN rc_t CC KNSManagerSetHTTPTimeouts ( struct KNSManager *self,
     int32_t readMillis, int32_t writeMillis );
 
 
+/* SetHTTPReads
+ *  sets how HTTP files made afterwards read
+ *
+ *  "connections" [ IN ] - keep-alive connections per file, at most 16.
+ *   with more than one, large reads are split into ranges fetched in
+ *   parallel. the default of 1 reads each range with a single request.
+ *
+ *  "readAhead" [ IN ] - when more than one connection is used, bytes
+ *   fetched ahead of the reader once access looks sequential.
+ *   0 disables reading ahead.
+ */
+KNS_EXTERN rc_t CC KNSManagerSetHTTPReads ( struct KNSManager *self,
+    uint32_t connections, size_t readAhead );
+
+
 /*--------------------------------------------------------------------------
  * KHttp
  *  hyper text transfer protocol
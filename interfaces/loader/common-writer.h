@@ -50,7 +50,8 @@ extern "C" {
 struct VDBManager;
 struct VDatabase;
 struct KMemBank;
-struct KBTree;
+struct KeyIndex;
+struct KLock;
 struct KLoadProgressbar;
 struct ReaderFile;
 struct CommonWriter;
@@ -133,7 +134,8 @@ typedef struct CommonWriterSettings
 
 typedef struct SpotAssembler {
     const struct KLoadProgressbar *progress[4];
-    struct KBTree *key2id[NUM_ID_SPACES];
+    struct KeyIndex *key2id[NUM_ID_SPACES];
+    struct KLock *key2id_lock; /* guards the read group table and idCount */
     char *key2id_names;
     struct MMArray *id2value;
     struct KMemBank *fragsBoth; /*** mate will be there soon ***/
@@ -203,6 +203,20 @@ VDB_EXTERN rc_t CC VCursorIdRange ( const VCursor *self, uint32_t idx,
 VDB_EXTERN rc_t CC VCursorOpen ( const VCursor *self );
 
 
+/* SetReadAhead
+ *  have an open read cursor fetch and decode blobs
+ *  ahead of a forward scan using background threads
+ *
+ *  "nblobs" [ IN ] - number of blobs to keep ready per column
+ *  beyond the row being read. 0 turns read-ahead off.
+ *
+ *  read-ahead starts once access is seen to be sequential
+ *  and applies to the columns added before this call.
+ *  a cursor created without a cache is given one.
+ */
+VDB_EXTERN rc_t CC VCursorSetReadAhead ( const VCursor *self, uint32_t nblobs );
+
+
 /* RowId
  *  report current row id
  * SetRowId
@@ -362,6 +376,46 @@ VDB_EXTERN rc_t CC VCursorCellDataDirect ( const VCursor *self, int64_t row_id,
     uint32_t *boff, uint32_t *row_len );
 
 
+/* ReadRange
+ *  access a range of rows of one column a blob at a time
+ *  bypassing per-row cell lookup
+ *
+ *  "col_idx" [ IN ] - index of column to be read, returned by "AddColumn"
+ *
+ *  "first" [ IN ] and "count" [ IN ] - range of rows to be read
+ *
+ *  "f" [ IN ] and "data" [ IN, OPAQUE ] - called once per blob
+ *  with the span of requested rows it holds, in row order.
+ *  a non-zero return stops iteration and is returned.
+ *
+ *  the span and all memory it refers to are valid only
+ *  for the duration of the call.
+ */
+typedef struct VCursorBlobSpan VCursorBlobSpan;
+struct VCursorBlobSpan
+{
+    /* rows first_row .. first_row + row_count - 1 */
+    int64_t first_row;
+    uint32_t row_count;
+
+    /* element size in bits */
+    uint32_t elem_bits;
+
+    /* start of blob data */
+    const void *base;
+
+    /* per row: starting element from "base" and number of elements
+       cell starts at bit row_offset [ i ] * elem_bits from "base" */
+    const uint32_t *row_offset;
+    const uint32_t *row_len;
+};
+
+typedef rc_t ( CC * VCursorBlobSpanFunc ) ( const VCursorBlobSpan *span, void *data );
+
+VDB_EXTERN rc_t CC VCursorReadRange ( const VCursor *self, uint32_t col_idx,
+    int64_t first, uint64_t count, VCursorBlobSpanFunc f, void *data );
+
+
 /* Default
  *  give a default row value for cell
  *  TBD - document full cell data, not append
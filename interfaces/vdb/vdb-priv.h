@@ -35,6 +35,10 @@
 #include <klib/defs.h>
 #endif
 
+#ifndef _h_klib_slab_
+#include <klib/slab.h>
+#endif
+
 #include <stdarg.h>
 
 #ifdef __cplusplus
@@ -89,6 +93,89 @@ VDB_EXTERN rc_t CC VDBManagerListExternalSchemaModules ( struct VDBManager const
  */
 VDB_EXTERN rc_t CC VDBManagerDisablePagemapThread ( struct VDBManager const *self );
 
+/* SetDecodeThreads
+ *  set the maximum number of background threads used
+ *  for decoding on behalf of all cursors of this manager
+ *
+ *  a count of 0 makes all decoding happen inline
+ *  default is taken from "vdb/decode-pool/threads" in configuration
+ */
+VDB_EXTERN rc_t CC VDBManagerSetDecodeThreads ( struct VDBManager const *self, uint32_t count );
+
+
+/* SetBlobCacheCapacity
+ *  set the memory budget in bytes of the blob cache shared among
+ *  all cursors created with VTableCreateCachedCursorRead
+ *  on read-only tables of this manager
+ *
+ *  a capacity of 0 disables sharing
+ *  default is taken from "vdb/blob-cache/capacity" in configuration
+ */
+VDB_EXTERN rc_t CC VDBManagerSetBlobCacheCapacity ( struct VDBManager const *self, size_t capacity );
+
+/* GetBlobCacheStats
+ *  report usage of the shared blob cache
+ */
+typedef struct VBlobCacheStats VBlobCacheStats;
+struct VBlobCacheStats
+{
+    uint64_t capacity;      /* memory budget in bytes */
+    uint64_t contents;      /* bytes currently held */
+    uint64_t entries;       /* blobs currently held */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evictions;
+};
+
+VDB_EXTERN rc_t CC VDBManagerGetBlobCacheStats ( struct VDBManager const *self, VBlobCacheStats *stats );
+
+/* GetSchemaCacheStats
+ *  report reuse of schemas parsed when opening read-only tables and databases
+ *  caching is disabled by "vdb/schema-cache/enabled" = "false" in configuration
+ */
+typedef struct VSchemaCacheStats VSchemaCacheStats;
+struct VSchemaCacheStats
+{
+    uint64_t entries;       /* schemas currently held */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytes_saved;   /* schema text not tokenized due to hits */
+};
+
+VDB_EXTERN rc_t CC VDBManagerGetSchemaCacheStats ( struct VDBManager const *self, VSchemaCacheStats *stats );
+
+/* GetCursorTemplateStats
+ *  report reuse of the schemas that read cursors extend with the
+ *  implicit columns of a read-only table
+ *  the number of templates is limited by "vdb/cursor-template/limit"
+ *  in configuration, where 0 disables them
+ */
+typedef struct VCursorTemplateStats VCursorTemplateStats;
+struct VCursorTemplateStats
+{
+    uint64_t entries;       /* templates currently held */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t unshared;      /* cursors on tables with untyped implicit columns */
+};
+
+VDB_EXTERN rc_t CC VDBManagerGetCursorTemplateStats ( struct VDBManager const *self, VCursorTemplateStats *stats );
+
+/* GetAllocStats
+ *  report recycling of blob, page map and data buffer memory
+ *  the pools are process-wide, shared by all managers
+ */
+typedef struct VDBAllocStats VDBAllocStats;
+struct VDBAllocStats
+{
+    KSlabStats blobs;
+    KSlabStats page_maps;
+    KSlabStats buffers;
+};
+
+VDB_EXTERN rc_t CC VDBManagerGetAllocStats ( struct VDBManager const *self, VDBAllocStats *stats );
+
 
 /* Make with custom VFSManager */
 VDB_EXTERN rc_t CC VDBManagerMakeReadWithVFSManager (
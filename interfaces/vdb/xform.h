@@ -343,6 +343,72 @@ struct VRowResult
 };
 
 
+/* VRowBatchData
+ *  batch row function input block
+ *
+ *  describes one input across a run of consecutive rows
+ *
+ *  "base" [ IN ] - page data base address
+ *
+ *  "elem_bits" [ IN ] - the number of bits in each element
+ *
+ *  "first_elem" [ IN ] and "elem_count" [ IN ] - arrays with
+ *  one entry per row giving the first element of the row
+ *  relative to "base" and the number of elements in the row.
+ *  i.e. for row "i" of type "T", "( ( const T* ) base ) [ first_elem [ i ] ]"
+ *  is the first element.
+ */
+typedef struct VRowBatchData VRowBatchData;
+struct VRowBatchData
+{
+    /* element size in bits */
+    uint64_t elem_bits;
+
+    /* page data base address */
+    const void *base;
+
+    /* per row offset to first element and row length */
+    const uint32_t *first_elem;
+    const uint32_t *elem_count;
+};
+
+
+/* VRowBatchResult
+ *  batch row function output block
+ *
+ *  output rows are written one after another into "data"
+ *  in row order, and the length of each is recorded in "row_len"
+ *
+ *  "data" [ IN/OUT ] - externally allocated data buffer
+ *  may be resized or replaced, and must be checked for
+ *  adequate capacity before writing.
+ *
+ *  "elem_count" [ OUT, DEFAULT ZERO ] - return parameter for
+ *  the total number of elements written for all rows
+ *
+ *  "elem_bits" [ IN ] - element size in bits
+ *
+ *  "row_len" [ OUT ] - externally allocated array with one
+ *  entry per row, to receive the number of elements in each row
+ */
+typedef struct VRowBatchResult VRowBatchResult;
+struct VRowBatchResult
+{
+    /* return slot for total number of elements written */
+    uint64_t elem_count;
+
+    /* size of elements in bits */
+    uint64_t elem_bits;
+
+    /* externally allocated data buffer
+       NB - must be checked for storage capacity before writing */
+    struct KDataBuffer *data;
+
+    /* return slot for length of each row */
+    uint32_t *row_len;
+};
+
+
 /* VFixedRowResult
  *  fixed row function output block
  *
@@ -566,6 +632,27 @@ typedef rc_t ( CC * VFixedRowFunc ) ( void *self,
     uint32_t argc, const VRowData argv [] );
 
 
+/* VRowBatchFunc
+ *  functions that behave like VRowFunc, but are handed
+ *  a run of consecutive rows in a single call, allowing
+ *  the per-row work to be done in a tight loop.
+ *  the results are cached.
+ *
+ *  "info" [ IN ] - runtime objects and information
+ *
+ *  "row_id" [ IN ] and "row_count" [ IN ] - the run of rows
+ *  being processed
+ *
+ *  "rslt" [ IN ] - return parameter block
+ *
+ *  "argc" [ IN ] and "argv" [ IN ] - zero or more input
+ *  parameter blocks, each describing "row_count" rows
+ */
+typedef rc_t ( CC * VRowBatchFunc ) ( void *self,
+    const VXformInfo *info, int64_t row_id, uint32_t row_count,
+    VRowBatchResult *rslt, uint32_t argc, const VRowBatchData argv [] );
+
+
 
 /*==========================================================================
  * factory functions
@@ -713,7 +800,8 @@ enum
     vftFixedRow,
     vftNonDetRow,
     vftArray,
-    vftBlob
+    vftBlob,
+    vftRowBatch
 };
 
 typedef struct VFuncDesc VFuncDesc;
@@ -731,6 +819,7 @@ struct VFuncDesc
         VFixedRowFunc pf;
         VArrayFunc af;
         VBlobFunc bf;
+        VRowBatchFunc rbf;
     } u;
     
     VFuncType variant;
@@ -46,6 +46,7 @@ extern "C" {
 struct KFile;
 struct VPath;
 struct KConfig;
+struct KNamelist;
 struct KRepository;
 struct VFSManager;
 
@@ -131,6 +132,26 @@ VFS_EXTERN rc_t CC VResolverQuery ( const VResolver * self,
     struct VPath const ** cache );
 
 
+/* QueryBatch
+ *  resolve many accessions remotely before they are queried one by one
+ *
+ *  accessions that need the resolver CGI are sent to it in a few
+ *  requests instead of one request each. the answers are remembered
+ *  by the resolver - and for public data in a file that outlives the
+ *  process - so that a following VResolverQuery for any of them does
+ *  not need another round trip until the answer expires
+ *
+ *  "protocols" [ IN ] - as for VResolverQuery
+ *
+ *  "accessions" [ IN ] - list of accession names
+ *
+ *  an accession that cannot be resolved here is not an error,
+ *  it will be reported when it is queried
+ */
+VFS_EXTERN rc_t CC VResolverQueryBatch ( const VResolver * self,
+    VRemoteProtocols protocols, struct KNamelist const * accessions );
+
+
 /* Local - DEPRECATED
  *  Find an existing local file/directory that is named by the accession.
  *  rcState of rcNotFound means it does not exist.
@@ -385,7 +385,7 @@ DONE:
     return rc;
 }
 
-static rc_t BGZFileWalkBlocksUnzip(BGZFile *const self, zlib_block_t *const bufp, BGZFileWalkBlocks_cb const cb, void *const ctx)
+static rc_t BGZFileWalkBlocksUnzip(BGZFile *const self, uint8_t *const *const bufp, BGZFileWalkBlocks_cb const cb, void *const ctx)
 {
     rc_t rc;
     rc_t rc2;
@@ -403,7 +403,7 @@ static rc_t BGZFileWalkBlocksUnzip(BGZFile *const self, zlib_block_t *const bufp
     return rc ? rc : rc2;
 }
 
-static rc_t BGZFileWalkBlocks(BGZFile *self, bool decompress, zlib_block_t *bufp,
+static rc_t BGZFileWalkBlocks(BGZFile *self, bool decompress, uint8_t *const *bufp,
                               BGZFileWalkBlocks_cb cb, void *ctx)
 {
     rc_t rc;
@@ -482,6 +482,61 @@ static rc_t BGZFileInit(BGZFile *self, const KFile *kfp, BGZFile_vt *vt)
     return 0;
 }
 
+/* copies the next compressed block without inflating it
+ * returns (rcData, rcInsufficient) if eof
+ */
+static rc_t BGZFileReadRaw(BGZFile *self, uint8_t dst[/* ZLIB_BLOCK_SIZE */], unsigned *pSize)
+{
+    uint8_t const *hdr;
+    size_t avail;
+    unsigned xlen;
+    unsigned bsize = 0;
+    unsigned i;
+    
+    *pSize = 0;
+    if (self->bcount < self->bpos + ZLIB_BLOCK_SIZE && self->fpos + self->bcount < self->fsize) {
+        rc_t const rc = BGZFileGetMoreBytes(self);
+        if (rc)
+            return rc;
+    }
+    if (self->bcount <= self->bpos)
+        return RC(rcAlign, rcFile, rcReading, rcData, rcInsufficient);
+    
+    avail = self->bcount - self->bpos;
+    if (avail < 18)
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcTooShort);
+    
+    hdr = &self->buf[self->bpos];
+    if (hdr[0] != 31 || hdr[1] != 139 || hdr[2] != 8 || (hdr[3] & 0x1E) != 0x04)
+        return RC(rcAlign, rcFile, rcReading, rcFormat, rcInvalid); /* not BGZF */
+    
+    xlen = LE2HUI16(&hdr[10]);
+    if (12 + xlen > avail)
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcTooShort);
+    
+    for (i = 12; i + 4 <= 12 + xlen; ) {
+        unsigned const slen = LE2HUI16(&hdr[i + 2]);
+        
+        if (hdr[i] == 'B' && hdr[i + 1] == 'C' && slen == 2 && i + 6 <= 12 + xlen) {
+            bsize = 1 + LE2HUI16(&hdr[i + 4]);
+            break;
+        }
+        i += slen + 4;
+    }
+    if (bsize < 12 + xlen + 8) {
+        DBGMSG(DBG_ALIGN, DBG_FLAG(DBG_ALIGN_BGZF), ("BGZF Header extra field BC not found\n"));
+        return RC(rcAlign, rcFile, rcReading, rcFormat, rcInvalid); /* not BGZF */
+    }
+    if (bsize > avail)
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcTooShort);
+    
+    memcpy(dst, hdr, bsize);
+    self->bpos += bsize;
+    *pSize = bsize;
+    
+    return 0;
+}
+
 #ifndef WINDOWS
 
 /* MARK: BGZThreadFile *** Start *** */
@@ -492,54 +547,125 @@ static rc_t BGZFileInit(BGZFile *self, const KFile *kfp, BGZFile_vt *vt)
 
 typedef struct BGZThreadFile_s BGZThreadFile;
 
+#define MAX_THREAD_COUNT (64)
+/* blocks in flight per thread */
 #define BUFFER_COUNT (3)
 
-typedef struct BGZThreadFileWorkQElem_s BGZThreadFileWorkQElem;
+typedef struct BGZThreadFileBlock_s BGZThreadFileBlock;
+typedef struct BGZThreadFileWorker_s BGZThreadFileWorker;
 
-struct BGZThreadFileWorkQElem_s {
-    uint8_t *buf;
-    uint64_t pos;
-    unsigned bsz;
+enum BGZThreadFileBlockState {
+    bs_Empty,
+    bs_Busy,
+    bs_Ready
+};
+
+struct BGZThreadFileBlock_s {
+    uint64_t pos;       /* position in file of compressed block */
+    rc_t rc;
+    unsigned zsz;       /* compressed size of block */
+    unsigned bsz;       /* decompressed size of block */
+    int volatile state;
+    uint8_t zbuf[ZLIB_BLOCK_SIZE];
+    zlib_block_t buf;
+};
+
+struct BGZThreadFileWorker_s {
+    BGZThreadFile *self;
+    KThread *th;
+    z_stream zs;
 };
 
+/* The workers take turns at reading the next compressed block from
+ * the file, using the BSIZE field of its header to find its end, then
+ * inflate the blocks they read in parallel.  Blocks are kept in a ring
+ * and are handed out in file order.
+ */
 struct BGZThreadFile_s {
-    BGZFile file;
+    BGZFile file;       /* only used to read compressed blocks */
     KLock *lock;
     KCondition *have_data;
     KCondition *need_data;
-    KThread *th;
-    uint64_t pos;
-    BGZThreadFileWorkQElem que[BUFFER_COUNT];
-    rc_t volatile rc;
-    unsigned volatile nque;
+    BGZThreadFileBlock *blk;
+    BGZThreadFileWorker *worker;
+    uint64_t head;      /* next block to hand out */
+    uint64_t tail;      /* next block to be read */
+    uint64_t pos;       /* position in file after last block handed out */
+    unsigned nblk;
+    unsigned window;    /* blocks allowed in flight, grows back after a seek */
+    unsigned nworker;
+    unsigned busy;      /* number of workers with a block */
+    bool reading;
     bool eof;
-    uint8_t buffer[sizeof(zlib_block_t) * BUFFER_COUNT];
+    bool shutdown;
 };
 
+static rc_t BGZThreadFileInflate(z_stream *zs, BGZThreadFileBlock *blk)
+{
+    unsigned const hsize = 12 + LE2HUI16(&blk->zbuf[10]);
+    uint8_t const *const trailer = &blk->zbuf[blk->zsz - 8];
+    uint32_t const crc = LE2HUI32(&trailer[0]);
+    uint32_t const isize = LE2HUI32(&trailer[4]);
+    int zr;
+    
+    blk->bsz = 0;
+    if (isize > sizeof(blk->buf))
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcCorrupt);
+    
+    zr = inflateReset(zs);
+    assert(zr == Z_OK);
+    zs->next_in = (Bytef *)&blk->zbuf[hsize];
+    zs->avail_in = (uInt)(blk->zsz - hsize - 8);
+    zs->next_out = (Bytef *)blk->buf;
+    zs->avail_out = sizeof(blk->buf);
+    
+    zr = inflate(zs, Z_FINISH);
+    if (zr != Z_STREAM_END || zs->total_out != isize) {
+        DBGMSG(DBG_ALIGN, DBG_FLAG(DBG_ALIGN_BGZF), ("Unexpected Zlib result %i\n", zr));
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcCorrupt);
+    }
+    if (crc32(crc32(0, NULL, 0), blk->buf, isize) != crc)
+        return RC(rcAlign, rcFile, rcReading, rcFile, rcCorrupt);
+    
+    blk->bsz = isize;
+    return 0;
+}
+
 static rc_t BGZThreadFileRead(BGZThreadFile *self, zlib_block_t dst, unsigned *pNumRead)
 {
+    BGZThreadFileBlock *blk = NULL;
     rc_t rc;
     
     *pNumRead = 0;
     
     KLockAcquire(self->lock);
-    if ((rc = self->rc) == 0) {
-        while (self->nque == 0 && (rc = self->rc) == 0)
-            KConditionWait(self->have_data, self->lock);
-        if (rc == 0) {
-            BGZThreadFileWorkQElem const work = self->que[0];
-            
-            self->pos = work.pos;
-            if (work.buf) {
-                memcpy(dst, work.buf, *pNumRead = work.bsz);
-                memmove(&self->que[0], &self->que[1], --self->nque * sizeof(self->que[0]));
-                KConditionSignal(self->need_data);
-            }
-            else {
-                self->eof = true;
-                self->rc = rc = RC(rcAlign, rcFile, rcReading, rcData, rcInsufficient);
-            }
+    while (blk == NULL) {
+        if (self->head != self->tail) {
+            blk = &self->blk[self->head % self->nblk];
+            if (blk->state == bs_Ready)
+                break;
+            blk = NULL;
+        }
+        else if (self->eof) {
+            KLockUnlock(self->lock);
+            return RC(rcAlign, rcFile, rcReading, rcData, rcInsufficient);
+        }
+        KConditionWait(self->have_data, self->lock);
+    }
+    /* errors, including eof, are sticky */
+    if ((rc = blk->rc) == 0) {
+        memcpy(dst, blk->buf, *pNumRead = blk->bsz);
+        self->pos = blk->pos + blk->zsz;
+        blk->state = bs_Empty;
+        ++self->head;
+        if (self->window < self->nblk) {
+            self->window *= 2;
+            if (self->window > self->nblk)
+                self->window = self->nblk;
+            KConditionBroadcast(self->need_data);
         }
+        else
+            KConditionSignal(self->need_data);
     }
     KLockUnlock(self->lock);
     return rc;
@@ -547,29 +673,44 @@ static rc_t BGZThreadFileRead(BGZThreadFile *self, zlib_block_t dst, unsigned *p
 
 static rc_t CC BGZThreadFileMain(KThread const *const th, void *const vp)
 {
-    BGZThreadFile *const self = (BGZThreadFile *)vp;
-    rc_t rc = 0;
-    unsigned bufno;
+    BGZThreadFileWorker *const worker = (BGZThreadFileWorker *)vp;
+    BGZThreadFile *const self = worker->self;
     
     KLockAcquire(self->lock);
-    for (bufno = 0; ; bufno = (bufno + 1) % BUFFER_COUNT) {
-        while (self->nque == BUFFER_COUNT)
-            KConditionWait(self->need_data, self->lock);
-        {
-            BGZThreadFileWorkQElem work;
+    while (!self->shutdown) {
+        if (!self->reading && !self->eof && self->tail - self->head < self->window) {
+            BGZThreadFileBlock *const blk = &self->blk[self->tail % self->nblk];
+            rc_t rc;
             
-            work.pos = BGZFileGetPos(&self->file);
-            work.buf = &self->buffer[bufno * sizeof(zlib_block_t)];
-            rc = BGZFileRead(&self->file, work.buf, &work.bsz);
-            if (GetRCObject(rc) == rcData && GetRCState(rc) == rcInsufficient)
-                work.buf = NULL;
-            else if (rc)
-                break;
-            self->que[self->nque++] = work;
-            KConditionSignal(self->have_data);
+            blk->state = bs_Busy;
+            ++self->tail;
+            ++self->busy;
+            self->reading = true;
+            KLockUnlock(self->lock);
+            
+            blk->pos = BGZFileGetPos(&self->file);
+            rc = BGZFileReadRaw(&self->file, blk->zbuf, &blk->zsz);
+            
+            KLockAcquire(self->lock);
+            self->reading = false;
+            if (rc)
+                self->eof = true;
+            else
+                KConditionSignal(self->need_data); /* someone else can read the next one */
+            KLockUnlock(self->lock);
+            
+            if (rc == 0)
+                rc = BGZThreadFileInflate(&worker->zs, blk);
+            blk->rc = rc;
+            
+            KLockAcquire(self->lock);
+            blk->state = bs_Ready;
+            --self->busy;
+            KConditionBroadcast(self->have_data);
+            continue;
         }
+        KConditionWait(self->need_data, self->lock);
     }
-    self->rc = rc;
     KLockUnlock(self->lock);
     return 0;
 }
@@ -590,25 +731,62 @@ static uint64_t BGZThreadFileGetSize(BGZThreadFile const *const self)
     return BGZFileGetSize(&self->file);
 }
 
-static rc_t BGZThreadFileSetPos(BGZThreadFile *const self)
+/* drops whatever was read ahead and restarts the workers at pos
+ * reading only a little ahead at first, as a seek is often followed
+ * by just a few reads
+ */
+static rc_t BGZThreadFileSetPos(BGZThreadFile *const self, uint64_t const pos)
 {
-    return RC(rcAlign, rcFile, rcPositioning, rcFunction, rcUnsupported);
+    unsigned i;
+    
+    KLockAcquire(self->lock);
+    self->eof = true;
+    while (self->busy != 0)
+        KConditionWait(self->have_data, self->lock);
+    
+    for (i = 0; i != self->nblk; ++i)
+        self->blk[i].state = bs_Empty;
+    self->head = self->tail = 0;
+    self->window = 1;
+    BGZFileSetPos(&self->file, pos);
+    self->pos = pos;
+    self->eof = false;
+    KConditionBroadcast(self->need_data);
+    KLockUnlock(self->lock);
+    
+    return 0;
 }
 
 static void BGZThreadFileWhack(BGZThreadFile *const self)
 {
-    KThreadCancel(self->th);
-    KThreadWait(self->th, NULL);
+    unsigned i;
+    
+    KLockAcquire(self->lock);
+    self->shutdown = true;
+    KConditionBroadcast(self->need_data);
+    KLockUnlock(self->lock);
+    
+    for (i = 0; i != self->nworker; ++i) {
+        BGZThreadFileWorker *const worker = &self->worker[i];
+        
+        if (worker->th) {
+            KThreadWait(worker->th, NULL);
+            KThreadRelease(worker->th);
+        }
+        inflateEnd(&worker->zs);
+    }
     BGZFileWhack(&self->file);
     KConditionRelease(self->need_data);
     KConditionRelease(self->have_data);
     KLockRelease(self->lock);
-    KThreadRelease(self->th);
+    free(self->worker);
+    free(self->blk);
 }
 
-static rc_t BGZThreadFileInit(BGZThreadFile *self, const KFile *kfp, BGZFile_vt *vt)
+static rc_t BGZThreadFileInit(BGZThreadFile *self, const KFile *kfp, BGZFile_vt *vt, unsigned threads)
 {
     rc_t rc;
+    unsigned i;
     static BGZFile_vt const my_vt = {
         (rc_t (*)(void *, zlib_block_t, unsigned *))BGZThreadFileRead,
         (uint64_t (*)(void const *))BGZThreadFileGetPos,
@@ -619,8 +797,26 @@ static rc_t BGZThreadFileInit(BGZThreadFile *self, const KFile *kfp, BGZFile_vt
     };
     
     memset(self, 0, sizeof(*self));
+    if (threads > MAX_THREAD_COUNT)
+        threads = MAX_THREAD_COUNT;
+    assert(threads != 0);
     
     rc = BGZFileInit(&self->file, kfp, vt);
+    if (rc)
+        return rc;
+    
+    self->window = self->nblk = threads * BUFFER_COUNT;
+    self->blk = malloc(self->nblk * sizeof(self->blk[0]));
+    self->worker = calloc(threads, sizeof(self->worker[0]));
+    if (self->blk == NULL || self->worker == NULL)
+        rc = RC(rcAlign, rcFile, rcConstructing, rcMemory, rcExhausted);
+    for (i = 0; rc == 0 && i != threads; ++i) {
+        self->worker[i].self = self;
+        if (inflateInit2(&self->worker[i].zs, -MAX_WBITS) != Z_OK)
+            rc = RC(rcAlign, rcFile, rcConstructing, rcMemory, rcExhausted);
+        else
+            ++self->nworker;
+    }
     if (rc == 0) {
         rc = KLockMake(&self->lock);
         if (rc == 0) {
@@ -628,25 +824,64 @@ static rc_t BGZThreadFileInit(BGZThreadFile *self, const KFile *kfp, BGZFile_vt
             if (rc == 0) {
                 rc = KConditionMake(&self->need_data);
                 if (rc == 0) {
-                    rc = KThreadMake(&self->th, BGZThreadFileMain, self);
+                    for (i = 0; rc == 0 && i != self->nworker; ++i)
+                        rc = KThreadMake(&self->worker[i].th, BGZThreadFileMain, &self->worker[i]);
                     if (rc == 0) {
                         *vt = my_vt;
                         return 0;
                     }
-                    KConditionRelease(self->need_data);
+                    /* joins any workers that were started */
+                    BGZThreadFileWhack(self);
+                    memset(self, 0, sizeof(*self));
+                    memset(vt, 0, sizeof(*vt));
+                    return rc;
                 }
                 KConditionRelease(self->have_data);
             }
             KLockRelease(self->lock);
         }
-        BGZFileWhack(&self->file);
     }
+    for (i = 0; i != self->nworker; ++i)
+        inflateEnd(&self->worker[i].zs);
+    free(self->worker);
+    free(self->blk);
+    BGZFileWhack(&self->file);
     memset(self, 0, sizeof(*self));
     memset(vt, 0, sizeof(*vt));
     return rc;
 }
 
+static rc_t BGZThreadFileWalkBlocks(BGZThreadFile *const self, uint8_t *const *const bufp, BGZFileWalkBlocks_cb const cb, void *const ctx)
+{
+    rc_t rc;
+    rc_t rc2;
+    
+    do {
+        uint64_t const fpos = self->pos;
+        unsigned dsize;
+        
+        rc2 = BGZThreadFileRead(self, *bufp, &dsize);
+        rc = cb(ctx, &self->file, rc2, fpos, *bufp, dsize);
+    } while (rc == 0 && rc2 == 0);
+    if (GetRCState(rc2) == rcInsufficient && GetRCObject(rc2) == rcData)
+        rc2 = 0;
+    rc = cb(ctx, &self->file, rc2, self->pos, NULL, 0);
+    return rc ? rc : rc2;
+}
+
+#endif
+
+/* MARK: BGZF thread count */
+
+static unsigned volatile BGZFThreadCount = 0;
+
+LIB_EXPORT rc_t CC BAMFileSetDecompressionThreads(unsigned count)
+{
+#ifndef WINDOWS
+    BGZFThreadCount = count > MAX_THREAD_COUNT ? MAX_THREAD_COUNT : count;
 #endif
+    return 0;
+}
 
 /* MARK: BAMFile structures */
 
@@ -1626,7 +1861,7 @@ static rc_t BAMFileWhack(BAMFile *self) {
 static rc_t BAMFileMakeWithKFileAndHeader(BAMFile const **cself,
                                           KFile const *file,
                                           char const *headerText,
-                                          bool threaded)
+                                          unsigned threads)
 {
     BAMFile *self = calloc(1, sizeof(*self));
     rc_t rc;
@@ -1636,8 +1871,8 @@ static rc_t BAMFileMakeWithKFileAndHeader(BAMFile const **cself,
     
     KRefcountInit(&self->refcount, 1, "BAMFile", "new", "");
 #ifndef WINDOWS
-    if (threaded)
-        rc = BGZThreadFileInit(&self->file.thread, file, &self->vt);
+    if (threads)
+        rc = BGZThreadFileInit(&self->file.thread, file, &self->vt, threads);
     else
 #endif
         rc = BGZFileInit(&self->file.plain, file, &self->vt);
@@ -1656,7 +1891,7 @@ static rc_t BAMFileMakeWithKFileAndHeader(BAMFile const **cself,
 /* file is retained */
 LIB_EXPORT rc_t CC BAMFileMakeWithKFile(const BAMFile **cself, const KFile *file)
 {
-    return BAMFileMakeWithKFileAndHeader(cself, file, NULL, false);
+    return BAMFileMakeWithKFileAndHeader(cself, file, NULL, BGZFThreadCount);
 }
 
 LIB_EXPORT rc_t CC BAMFileVMakeWithDir(const BAMFile **result,
@@ -1730,7 +1965,7 @@ LIB_EXPORT rc_t CC BAMFileMakeWithHeader ( const BAMFile **cself,
     va_start(args, path);
     rc = KDirectoryVOpenFileRead(dir, &kf, path, args);
     if (rc == 0) {
-        rc = BAMFileMakeWithKFileAndHeader(cself, kf, headerText, false);
+        rc = BAMFileMakeWithKFileAndHeader(cself, kf, headerText, BGZFThreadCount);
         KFileRelease(kf);
     }
     va_end(args);
@@ -4858,7 +5093,7 @@ static rc_t BAMValidateBAM(struct VPath const *bampath,
     ctx.options = options;
     ctx.stats = &stats;
     
-    if (options > bvo_BlockCompression) {
+    if (options >= bvo_BlockCompression) {
         ctx.alloced = ZLIB_BLOCK_SIZE * 2;
         ctx.nxt = ctx.buf = malloc(ctx.alloced);
         
@@ -4869,15 +5104,38 @@ static rc_t BAMValidateBAM(struct VPath const *bampath,
     if (options > bvo_RecordStructure)
         options = bvo_RecordStructure | (options & 0xFFF0);
     
-    rc = VPath2BGZF(&bam, bampath);
-    if (rc == 0) {
-        stats.bamFileSize = bam.fsize;
-        if ((options & 7) > bvo_BlockHeaders)
-            rc = BGZFileWalkBlocks(&bam, true, (zlib_block_t *)&ctx.nxt, BAMValidate2, &ctx);
-        else
-            rc = BGZFileWalkBlocks(&bam, false, NULL, BAMValidate2, &ctx);
+#ifndef WINDOWS
+    if ((options & 7) > bvo_BlockHeaders && BGZFThreadCount != 0) {
+        BGZThreadFile tbam;
+        BGZFile_vt dummy;
+        const KFile *fp;
+        
+        rc = OpenVPathRead(&fp, bampath);
+        if (rc == 0) {
+            rc = BGZThreadFileInit(&tbam, fp, &dummy, BGZFThreadCount);
+            KFileRelease(fp);
+            if (rc == 0) {
+                stats.bamFileSize = tbam.file.fsize;
+                rc = BGZThreadFileWalkBlocks(&tbam, &ctx.nxt, BAMValidate2, &ctx);
+                BGZThreadFileWhack(&tbam);
+            }
+        }
+    }
+    else
+#endif
+    {
+        rc = VPath2BGZF(&bam, bampath);
+        if (rc == 0) {
+            stats.bamFileSize = bam.fsize;
+            if ((options & 7) > bvo_BlockHeaders)
+                rc = BGZFileWalkBlocks(&bam, true, &ctx.nxt, BAMValidate2, &ctx);
+            else
+                rc = BGZFileWalkBlocks(&bam, false, NULL, BAMValidate2, &ctx);
+        }
+        BGZFileWhack(&bam);
     }
-    BGZFileWhack(&bam);
+    free(ctx.refLen);
+    free(ctx.buf);
     return rc;
 }
 
@@ -43,56 +43,17 @@
 
 
 static
-rc_t CC align_restore_read_impl ( void *data, const VXformInfo *info, int64_t row_id,
-    VRowResult *rslt, uint32_t argc, const VRowData argv [] )
+rc_t align_restore_read_row ( INSDC_4na_bin *dst, uint32_t dst_len,
+    const INSDC_4na_bin *ref_read, uint32_t ref_read_len,
+    const uint8_t *has_mismatch,
+    const INSDC_4na_bin *mismatch, uint32_t mismatch_len,
+    const uint8_t *has_ref_offset,
+    const int32_t *ref_offset, uint32_t ref_offset_len,
+    uint32_t ploidy, const INSDC_coord_len* read_len )
 {
-    rc_t rc;
     int mmi,roi,rri,di,bi;
-    const INSDC_4na_bin	*ref_read 	= argv[0].u.data.base;
-    const uint32_t	ref_read_len 	= argv[0].u.data.elem_count;
-    const uint8_t	*has_mismatch	= argv[1].u.data.base;
-    const uint32_t	has_mismatch_len= argv[1].u.data.elem_count;
-    const INSDC_4na_bin *mismatch	= argv[2].u.data.base;
-    const uint32_t	mismatch_len	= argv[2].u.data.elem_count;
-    const uint8_t	*has_ref_offset	   = argv[3].u.data.base;
-    const uint32_t	has_ref_offset_len = argv[3].u.data.elem_count;
-    const int32_t 	*ref_offset	= argv[4].u.data.base;
-    const uint32_t	ref_offset_len  = argv[4].u.data.elem_count;
-    uint32_t ploidy = 1, rl;
-    const INSDC_coord_len* read_len = &has_mismatch_len;
-
-    INSDC_4na_bin *dst;
-    uint32_t	dst_len;
-    
-    assert(argv[0].u.data.elem_bits == 8);
-    assert(argv[1].u.data.elem_bits == 8);
-    assert(argv[2].u.data.elem_bits == 8);
-    assert(argv[3].u.data.elem_bits == 8);
-    assert(argv[4].u.data.elem_bits == 32);
-
-    ref_read	   += argv [ 0 ] . u . data . first_elem;
-    has_mismatch   += argv [ 1 ] . u . data . first_elem;
-    mismatch	   += argv [ 2 ] . u . data . first_elem;
-    has_ref_offset += argv [ 3 ] . u . data . first_elem;
-    ref_offset     += argv [ 4 ] . u . data . first_elem;
-
-    if ( has_mismatch_len != has_ref_offset_len )
-		return RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent);
-
-    if( argc > 5 ) {
-        assert(argv[5].u.data.elem_bits == 32);
-        ploidy = argv[5].u.data.elem_count;
-        read_len = argv[5].u.data.base;
-        read_len += argv[5].u.data.first_elem;
-    }
-    dst_len = has_mismatch_len;
+    uint32_t rl;
 
-    /* resize output row for the total number of reads */    
-    rslt -> data -> elem_bits = 8;
-    rc = KDataBufferResize ( rslt -> data, dst_len );
-    if ( rc != 0 ) return rc;
-    rslt -> elem_count = dst_len;
-    dst = rslt -> data -> base;
     /**** MAIN RESTORATION LOOP ***/
     for(mmi=roi=rri=di=bi=0, rl = 1; di < dst_len; di++,rri++,rl++,bi++){
         if(has_ref_offset[di] && bi >= 0){ /** bi can only become negative on Bs; skip has_ref_offset if Bs are not exhausted ***/
@@ -123,6 +84,68 @@ rc_t CC align_restore_read_impl ( void *data, const VXformInfo *info, int64_t ro
     return 0;
 }
 
+static
+rc_t CC align_restore_read_impl ( void *data, const VXformInfo *info, int64_t row_id,
+    uint32_t row_count, VRowBatchResult *rslt, uint32_t argc, const VRowBatchData argv [] )
+{
+    rc_t rc;
+    uint32_t r;
+    uint64_t total;
+    const INSDC_4na_bin	*ref_read 	= argv[0].base;
+    const uint8_t	*has_mismatch	= argv[1].base;
+    const INSDC_4na_bin *mismatch	= argv[2].base;
+    const uint8_t	*has_ref_offset	= argv[3].base;
+    const int32_t 	*ref_offset	= argv[4].base;
+    const INSDC_coord_len *read_len = argc > 5 ? argv[5].base : NULL;
+
+    INSDC_4na_bin *dst;
+    
+    assert(argv[0].elem_bits == 8);
+    assert(argv[1].elem_bits == 8);
+    assert(argv[2].elem_bits == 8);
+    assert(argv[3].elem_bits == 8);
+    assert(argv[4].elem_bits == 32);
+    assert(argc <= 5 || argv[5].elem_bits == 32);
+
+    /* output row is as long as has_mismatch */
+    for ( r = 0, total = 0; r < row_count; ++ r ) {
+        if ( argv[1].elem_count[r] != argv[3].elem_count[r] )
+            return RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent);
+        rslt -> row_len [ r ] = argv[1].elem_count[r];
+        total += argv[1].elem_count[r];
+    }
+
+    /* resize output for all rows at once */
+    rslt -> data -> elem_bits = 8;
+    rc = KDataBufferResize ( rslt -> data, total );
+    if ( rc != 0 ) return rc;
+    rslt -> elem_count = total;
+    dst = rslt -> data -> base;
+
+    for ( r = 0; r < row_count; ++ r ) {
+        uint32_t dst_len = rslt -> row_len [ r ];
+        uint32_t ploidy = 1;
+        const INSDC_coord_len *rlen = & rslt -> row_len [ r ];
+
+        if ( argc > 5 ) {
+            ploidy = argv[5].elem_count[r];
+            rlen = read_len + argv[5].first_elem[r];
+        }
+
+        rc = align_restore_read_row ( dst, dst_len,
+            ref_read + argv[0].first_elem[r], argv[0].elem_count[r],
+            has_mismatch + argv[1].first_elem[r],
+            mismatch + argv[2].first_elem[r], argv[2].elem_count[r],
+            has_ref_offset + argv[3].first_elem[r],
+            ref_offset + argv[4].first_elem[r], argv[4].elem_count[r],
+            ploidy, rlen );
+        if ( rc != 0 ) return rc;
+
+        dst += dst_len;
+    }
+    return 0;
+}
+
 
 /* 
  * function
@@ -132,8 +155,8 @@ VTRANSFACT_IMPL ( ALIGN_align_restore_read, 1, 0, 1 ) ( const void *Self, const
     VFuncDesc *rslt, const VFactoryParams *cp, const VFunctionParams *dp )
 {
 
-    rslt->u.rf = align_restore_read_impl;
-    rslt->variant = vftRow;
+    rslt->u.rbf = align_restore_read_impl;
+    rslt->variant = vftRowBatch;
     rslt -> whack = NULL;
     return 0;
 }
@@ -78,7 +78,8 @@ rc_t op2b(KDataBuffer *dst, unsigned const offset, unsigned *const count, int co
         unsigned const need = offset + digits + 1;
         
         if (need > dst->elem_count) {
-            rc_t rc = KDataBufferResize(dst, need);
+            /* grow geometrically, batches append many rows to one buffer */
+            rc_t rc = KDataBufferResize(dst, need < 2 * dst->elem_count ? 2 * dst->elem_count : need);
             if (rc) return rc;
         }
         {
@@ -298,89 +299,98 @@ static INSDC_coord_len right_soft_clip(unsigned seq_len, unsigned ref_len,
     return a < seq_len ? seq_len - a : 0;
 }
 
+/* reserve room for cigar strings of a batch of rows up front,
+   guessing one character per base of read */
 static
-rc_t CC cigar_impl ( void *data, const VXformInfo *info, int64_t row_id,
-    VRowResult *rslt, uint32_t argc, const VRowData argv [] )
+rc_t cigar_reserve(KDataBuffer *dst, uint32_t row_count, const VRowBatchData *has_mismatch)
+{
+    uint64_t total = 0;
+    uint32_t r;
+    
+    for (r = 0; r < row_count; ++r)
+        total += has_mismatch->elem_count[r];
+    return total != 0 ? KDataBufferResize(dst, total) : 0;
+}
+
+static
+rc_t CC cigar_impl ( void *data, const VXformInfo *info, int64_t row_id, uint32_t row_count,
+    VRowBatchResult *rslt, uint32_t argc, const VRowBatchData argv [] )
 {
     self_t const *self = data;
-    unsigned const rdln = argv[0].u.data.elem_count;
-    unsigned const ro_len = argv[2].u.data.elem_count;
-    bool const *has_mismatch   = argv[0].u.data.base;
-    bool const *has_ref_offset = argv[1].u.data.base;
-    int32_t const *ref_offset   = argv[2].u.data.base;
-    rc_t rc;
+    bool const *has_mismatch   = argv[0].base;
+    bool const *has_ref_offset = argv[1].base;
+    int32_t const *ref_offset  = argv[2].base;
+    uint32_t r;
+    rc_t rc = 0;
     
-    assert(argv[0].u.data.elem_bits == 8);
-    assert(argv[1].u.data.elem_bits == 8);
-    assert(argv[2].u.data.elem_bits == 32);
+    assert(argv[0].elem_bits == 8);
+    assert(argv[1].elem_bits == 8);
+    assert(argv[2].elem_bits == 32);
 
-    assert(rdln == argv[1].u.data.elem_count);
+    rslt->data->elem_bits = 8;
+    rslt->elem_count = 0;
+    rc = cigar_reserve(rslt->data, row_count, &argv[0]);
 
-    has_mismatch   += argv[0].u.data.first_elem;
-    has_ref_offset += argv[1].u.data.first_elem;
-    ref_offset     += argv[2].u.data.first_elem;
+    /* rows are appended one after another */
+    for (r = 0; r < row_count && rc == 0; ++r) {
+        unsigned const rdln = argv[0].elem_count[r];
+        unsigned const ro_len = argv[2].elem_count[r];
+        uint64_t cnt = 0;
 
-    rslt->data->elem_bits = 8;
-    if (argc == 3)
-        rc = cigar_string(rslt->data, 0, &rslt->elem_count, self->version & 0x1,
-                          has_mismatch, has_ref_offset,
-                          0, rdln, ref_offset, ro_len, NULL);
-    else {
-        int32_t const *const rfln = argv[3].u.data.base;
-        
-        rc = cigar_string_2(rslt->data, 0, &rslt->elem_count, self->version & 0x1,
-                            has_mismatch, has_ref_offset,
-                            0, rdln, ref_offset, ro_len, NULL,
-                            rfln[argv[3].u.data.first_elem],true);
+        assert(rdln == argv[1].elem_count[r]);
+
+        if (argc == 3)
+            rc = cigar_string(rslt->data, rslt->elem_count, &cnt, self->version & 0x1,
+                              has_mismatch + argv[0].first_elem[r],
+                              has_ref_offset + argv[1].first_elem[r],
+                              0, rdln, ref_offset + argv[2].first_elem[r], ro_len, NULL);
+        else {
+            int32_t const *const rfln = argv[3].base;
+            
+            rc = cigar_string_2(rslt->data, rslt->elem_count, &cnt, self->version & 0x1,
+                                has_mismatch + argv[0].first_elem[r],
+                                has_ref_offset + argv[1].first_elem[r],
+                                0, rdln, ref_offset + argv[2].first_elem[r], ro_len, NULL,
+                                rfln[argv[3].first_elem[r]],true);
+        }
+        rslt->row_len[r] = (uint32_t)cnt;
+        rslt->elem_count += cnt;
     }
     return rc;
 }
 
 static
-rc_t CC cigar_impl_2 ( void *data, const VXformInfo *info, int64_t row_id,
-                        VRowResult *rslt, uint32_t argc, const VRowData argv [] )
+rc_t cigar_row_2 ( self_t const *self, VRowBatchResult *rslt, uint32_t r,
+                   uint32_t argc, const VRowBatchData argv [] )
 {
-    self_t const *self = data;
-    bool const *has_mismatch        = argv[0].u.data.base;
-    bool const *has_ref_offset      = argv[1].u.data.base;
-    int32_t const *ref_offset       = argv[2].u.data.base;
-    INSDC_coord_len const *read_len = argv[3].u.data.base;
-    uint32_t const nreads = argv[3].u.data.elem_count;
-    uint32_t const ro_len = argv[2].u.data.elem_count;
+    bool const *has_mismatch        = (bool const *)argv[0].base + argv[0].first_elem[r];
+    bool const *has_ref_offset      = (bool const *)argv[1].base + argv[1].first_elem[r];
+    int32_t const *ref_offset       = (int32_t const *)argv[2].base + argv[2].first_elem[r];
+    INSDC_coord_len const *read_len = (INSDC_coord_len const *)argv[3].base + argv[3].first_elem[r];
+    uint32_t const nreads = argv[3].elem_count[r];
+    uint32_t const ro_len = argv[2].elem_count[r];
     uint32_t n;
     uint32_t ro_offset = 0;
     rc_t rc = 0;
     uint64_t cnt;
+    uint64_t const row_start = rslt->elem_count;
     INSDC_coord_zero start;
     INSDC_coord_len *cigar_len = NULL;
     KDataBuffer *buf = (self->version & 0x04) ? NULL : rslt->data;
-    
-    assert(argv[0].u.data.elem_bits == 8);
-    assert(argv[1].u.data.elem_bits == 8);
-    assert(argv[2].u.data.elem_bits == 32);
-    assert(argv[3].u.data.elem_bits == 32);
-    
-    has_mismatch   += argv[0].u.data.first_elem;
-    has_ref_offset += argv[1].u.data.first_elem;
-    ref_offset     += argv[2].u.data.first_elem;
-    read_len       += argv[3].u.data.first_elem;
 
     if( self->version & 0x4 ) {
-        rslt->data->elem_bits = sizeof(*cigar_len) * 8;
-        rslt->elem_count = nreads;
-        rc = KDataBufferResize(rslt->data, rslt->elem_count); if (rc) return rc;
-        cigar_len = rslt->data->base;
-        if (argv[0].u.data.elem_count == 0 ||
-            argv[1].u.data.elem_count == 0)
+        /* cigar_impl_2 sized the buffer for the whole batch */
+        assert(row_start + nreads <= rslt->data->elem_count);
+        cigar_len = (INSDC_coord_len *)rslt->data->base + row_start;
+        rslt->row_len[r] = nreads;
+        rslt->elem_count += nreads;
+        if (argv[0].elem_count[r] == 0 ||
+            argv[1].elem_count[r] == 0)
         {
             memset(cigar_len, 0, sizeof(cigar_len[0]) * nreads);
             return 0;
         }
     }
-    else {
-        rslt->data->elem_bits = 8;
-        rslt->elem_count = 0;
-    }
     for (n = 0, start = 0, ro_offset = 0; n < nreads; start += read_len[n++]) {
         if (argc == 4)
             rc = cigar_string(buf, rslt->elem_count, &cnt, self->version & 0x1,
@@ -388,13 +398,13 @@ rc_t CC cigar_impl_2 ( void *data, const VXformInfo *info, int64_t row_id,
                               start, start + read_len[n],
                               ref_offset, ro_len, &ro_offset);
         else {
-            int32_t const *const reflen = argv[4].u.data.base;
+            int32_t const *const reflen = argv[4].base;
             
             rc = cigar_string_2(buf, rslt->elem_count, &cnt, self->version & 0x1,
                                 has_mismatch, has_ref_offset,
                                 start, start + read_len[n],
                                 ref_offset, ro_len, &ro_offset,
-                                reflen[argv[4].u.data.first_elem],(nreads==1));
+                                reflen[argv[4].first_elem[r]],(nreads==1));
         }
         if (rc) return rc;
         if (cigar_len != NULL /*self->version & 0x04*/)
@@ -402,9 +412,45 @@ rc_t CC cigar_impl_2 ( void *data, const VXformInfo *info, int64_t row_id,
         else
             rslt->elem_count += cnt;
     }
+    if (cigar_len == NULL)
+        rslt->row_len[r] = (uint32_t)(rslt->elem_count - row_start);
     return 0;
 }
 
+static
+rc_t CC cigar_impl_2 ( void *data, const VXformInfo *info, int64_t row_id, uint32_t row_count,
+                        VRowBatchResult *rslt, uint32_t argc, const VRowBatchData argv [] )
+{
+    self_t const *self = data;
+    uint32_t r;
+    rc_t rc = 0;
+    
+    assert(argv[0].elem_bits == 8);
+    assert(argv[1].elem_bits == 8);
+    assert(argv[2].elem_bits == 32);
+    assert(argv[3].elem_bits == 32);
+
+    rslt->elem_count = 0;
+    if( self->version & 0x4 ) {
+        /* one length per read */
+        uint64_t total = 0;
+        
+        for (r = 0; r < row_count; ++r)
+            total += argv[3].elem_count[r];
+        rslt->data->elem_bits = sizeof(INSDC_coord_len) * 8;
+        if (total != 0)
+            rc = KDataBufferResize(rslt->data, total);
+    }
+    else {
+        rslt->data->elem_bits = 8;
+        rc = cigar_reserve(rslt->data, row_count, &argv[0]);
+    }
+
+    for (r = 0; r < row_count && rc == 0; ++r)
+        rc = cigar_row_2(self, rslt, r, argc, argv);
+    return rc;
+}
+
 static
 void CC self_whack( void *ptr )
 {
@@ -429,8 +475,8 @@ VTRANSFACT_IMPL ( ALIGN_cigar, 1, 0, 0 ) ( const void *Self, const VXfactInfo *i
     default:
         return RC ( rcXF, rcFunction, rcConstructing, rcParam, rcIncorrect );
     }
-    rslt->u.rf = cigar_impl;
-    rslt->variant = vftRow;
+    rslt->u.rbf = cigar_impl;
+    rslt->variant = vftRowBatch;
     rslt -> self = malloc ( sizeof self );
     memcpy(rslt -> self,&self,sizeof(self));
     rslt -> whack = self_whack;
@@ -460,8 +506,8 @@ VTRANSFACT_IMPL ( ALIGN_cigar_2, 2, 0, 0 ) ( const void *Self, const VXfactInfo
     } else {
         return RC(rcXF, rcFunction, rcConstructing, rcParam, rcIncorrect);
     }
-    rslt->u.rf = cigar_impl_2;
-    rslt->variant = vftRow;
+    rslt->u.rbf = cigar_impl_2;
+    rslt->variant = vftRowBatch;
     rslt->self = malloc(sizeof self);
     memcpy(rslt->self, &self, sizeof(self));
     rslt->whack = self_whack;
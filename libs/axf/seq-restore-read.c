@@ -123,75 +123,99 @@ static INSDC_4na_bin  map[]={
 };
 
 static
-rc_t CC seq_restore_read_impl ( void *data, const VXformInfo *info, int64_t row_id,
-                               VRowResult *rslt, uint32_t argc, const VRowData argv [] )
+rc_t seq_restore_read_row ( const RestoreRead *self, INSDC_4na_bin *dst,
+                            const INSDC_4na_bin *src, uint32_t src_len, INSDC_coord_len len,
+                            uint32_t num_reads, const int64_t *align_id,
+                            const INSDC_coord_len *read_len, const uint8_t *read_type )
 {
-    rc_t rc;
+    rc_t rc = 0;
     int i;
-    RestoreRead		*self = data;
-    INSDC_4na_bin	*dst;
-    INSDC_coord_len 	len;
-    uint32_t		src_len		= argv[0].u.data.elem_count;
-    const INSDC_4na_bin	*src		= argv[0].u.data.base;
-    const uint32_t 	num_reads	= argv[1].u.data.elem_count;
-    const int64_t	*align_id	= argv[1].u.data.base;
-    const INSDC_coord_len *read_len  	= argv[2].u.data.base;
-    const uint8_t	*read_type	= argv[3].u.data.base;
-    
-    assert(argv[0].u.data.elem_bits == 8);
-    assert(argv[1].u.data.elem_bits == 64);
-    assert(argv[2].u.data.elem_bits == sizeof(INSDC_coord_len)*8);
-    assert(argv[2].u.data.elem_count == num_reads);
-    assert(argv[3].u.data.elem_count == num_reads);
-    
-    
-    src   += argv [ 0 ] . u . data . first_elem;
-    align_id  += argv [ 1 ] . u . data . first_elem;
-    read_len  += argv [ 2 ] . u . data . first_elem;
-    read_type += argv [ 3 ] . u . data . first_elem;
-    
-    for(i=0,len=0;i<num_reads;i++){
-        len+=read_len[i];
-    }
-    /* resize output row */    
-    rslt->data->elem_bits = 8;
-    rc = KDataBufferResize(rslt->data, len);
-    rslt->elem_count = len;
-    dst = rslt->data->base;
-    if ( rc == 0  && len > 0 ) {
-        if(len == src_len){ /*** shortcut - all data is local ***/
-            memcpy(dst,src,len);
-        } else for(i=0;i<num_reads && rc == 0;i++){ /*** checking read by read ***/
-            if(align_id[i] > 0) {
-                    const INSDC_4na_bin *r_src;
-                    uint32_t             r_src_len;
-                    rc = VCursorCellDataDirect ( self -> curs,  align_id[i], self -> read_idx, NULL, ( const void** ) & r_src, NULL, & r_src_len );
-                    if(rc == 0){
-                        if(r_src_len == read_len[i]){
-                            if(read_type[i]&SRA_READ_TYPE_FORWARD){
-                                memcpy(dst,r_src,read_len[i]);
-                            }else if(read_type[i]&SRA_READ_TYPE_REVERSE){
-                                int j,k;
-                                for(j=0,k=read_len[i]-1;j<read_len[i];j++,k--){
-                                    dst[j]=map[r_src[k]&15];
-                                }
-                            } else {
-                                rc = RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent);
+
+    if(len == src_len){ /*** shortcut - all data is local ***/
+        memcpy(dst,src,len);
+    } else for(i=0;i<num_reads && rc == 0;i++){ /*** checking read by read ***/
+        if(align_id[i] > 0) {
+                const INSDC_4na_bin *r_src;
+                uint32_t             r_src_len;
+                rc = VCursorCellDataDirect ( self -> curs,  align_id[i], self -> read_idx, NULL, ( const void** ) & r_src, NULL, & r_src_len );
+                if(rc == 0){
+                    if(r_src_len == read_len[i]){
+                        if(read_type[i]&SRA_READ_TYPE_FORWARD){
+                            memcpy(dst,r_src,read_len[i]);
+                        }else if(read_type[i]&SRA_READ_TYPE_REVERSE){
+                            int j,k;
+                            for(j=0,k=read_len[i]-1;j<read_len[i];j++,k--){
+                                dst[j]=map[r_src[k]&15];
                             }
                         } else {
                             rc = RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent);
                         }
+                    } else {
+                        rc = RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent);
                     }
-            } else { /*** data is in READ column **/
-                if(src_len >= read_len[i]){
-                    memcpy(dst,src,read_len[i]);
-                    src_len -= read_len[i];
-                    src     += read_len[i];
-                } else {
-                    return RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent );
                 }
+        } else { /*** data is in READ column **/
+            if(src_len >= read_len[i]){
+                memcpy(dst,src,read_len[i]);
+                src_len -= read_len[i];
+                src     += read_len[i];
+            } else {
+                return RC(rcXF, rcFunction, rcExecuting, rcData, rcInconsistent );
             }
-            dst += read_len[i];
+        }
+        dst += read_len[i];
+    }
+    return rc;
+}
+
+static
+rc_t CC seq_restore_read_impl ( void *data, const VXformInfo *info, int64_t row_id, uint32_t row_count,
+                               VRowBatchResult *rslt, uint32_t argc, const VRowBatchData argv [] )
+{
+    rc_t rc;
+    uint32_t i, r;
+    uint64_t total;
+    RestoreRead		*self = data;
+    INSDC_4na_bin	*dst;
+    const INSDC_4na_bin	*src		= argv[0].base;
+    const int64_t	*align_id	= argv[1].base;
+    const INSDC_coord_len *read_len  	= argv[2].base;
+    const uint8_t	*read_type	= argv[3].base;
+    
+    assert(argv[0].elem_bits == 8);
+    assert(argv[1].elem_bits == 64);
+    assert(argv[2].elem_bits == sizeof(INSDC_coord_len)*8);
+
+    /* size all rows up front so that the output is resized once */
+    for(r=0,total=0;r<row_count;r++){
+        const INSDC_coord_len *rl = read_len + argv[2].first_elem[r];
+        INSDC_coord_len len;
+
+        assert(argv[2].elem_count[r] == argv[1].elem_count[r]);
+        assert(argv[3].elem_count[r] == argv[1].elem_count[r]);
+
+        for(i=0,len=0;i<argv[1].elem_count[r];i++){
+            len+=rl[i];
+        }
+        rslt->row_len[r] = len;
+        total += len;
+    }
+
+    rslt->data->elem_bits = 8;
+    rc = KDataBufferResize(rslt->data, total);
+    rslt->elem_count = total;
+    dst = rslt->data->base;
+
+    for(r=0;r<row_count && rc == 0;r++){
+        INSDC_coord_len len = rslt->row_len[r];
+        if(len > 0){
+            rc = seq_restore_read_row ( self, dst,
+                                        src + argv[0].first_elem[r], argv[0].elem_count[r], len,
+                                        argv[1].elem_count[r],
+                                        align_id + argv[1].first_elem[r],
+                                        read_len + argv[2].first_elem[r],
+                                        read_type + argv[3].first_elem[r] );
+            dst += len;
         }
     }
     return rc;
@@ -208,8 +232,8 @@ VTRANSFACT_IMPL ( ALIGN_seq_restore_read, 1, 0, 0 ) ( const void *Self, const VX
     rc_t rc = RestoreReadMake ( & fself, info -> tbl);
     if(rc == 0 ) {
         rslt->self = fself;
-        rslt->u.ndf = seq_restore_read_impl;
-        rslt->variant = vftRow;
+        rslt->u.rbf = seq_restore_read_impl;
+        rslt->variant = vftRowBatch;
         rslt -> whack = RestoreReadWhack;
     }
     return rc;
@@ -0,0 +1,581 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <kapp/extern.h>
+#include <kapp/key-index.h>
+
+#include <sysalloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <klib/rc.h>
+#include <klib/printf.h>
+#include <klib/log.h>
+#include <klib/status.h>
+
+#include <kfs/directory.h>
+#include <kfs/file.h>
+
+#include <kproc/lock.h>
+
+#define KI_MIN_TABLE (1u << 12)
+#define KI_BLOCK_ENTRIES (256u)
+#define KI_MERGE_FANIN (8u)
+#define KI_BLOOM_BITS (8u) /* at least this many filter bits per entry */
+#define KI_BLOOM_PROBES (4u)
+
+/* a slot is empty while id1 is zero; it holds id + 1 otherwise */
+typedef struct KIEntry {
+    uint64_t hash;
+    uint32_t check;
+    uint32_t id1;
+} KIEntry;
+
+typedef struct KIRun {
+    KFile *file;
+    KIEntry *fence; /* first entry of each block */
+    uint64_t *bloom; /* rules out most keys without reading a block */
+    uint64_t bloomMask;
+    uint64_t count;
+    uint32_t blocks;
+    uint32_t level;
+} KIRun;
+
+struct KeyIndex {
+    KLock *lock;
+    KDirectory *dir;
+    KIEntry *table;
+    KIRun *run;
+    uint64_t pid;
+    size_t tableSize;
+    size_t tableMax;
+    size_t used;
+    unsigned numRuns;
+    unsigned runAlloc;
+    unsigned runSeq;
+    uint32_t n;
+    uint32_t count;
+    KIEntry block[KI_BLOCK_ENTRIES];
+    char tmpfs[4096];
+};
+
+static uint64_t KIMix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t KIHash(void const *key, size_t keylen, uint64_t seed)
+{
+    uint8_t const *const s = key;
+    uint64_t h = KIMix(seed ^ keylen);
+    size_t i;
+
+    for (i = 0; i + 8 <= keylen; i += 8) {
+        uint64_t w;
+
+        memcpy(&w, &s[i], 8);
+        h = KIMix(h ^ w) + 0x9E3779B97F4A7C15ull;
+    }
+    if (i < keylen) {
+        uint64_t w = 0;
+
+        memcpy(&w, &s[i], keylen - i);
+        h = KIMix(h ^ w) + 0x9E3779B97F4A7C15ull;
+    }
+    return KIMix(h);
+}
+
+static int KIEntryCmp(KIEntry const *a, KIEntry const *b)
+{
+    if (a->hash != b->hash)
+        return a->hash < b->hash ? -1 : 1;
+    if (a->check != b->check)
+        return a->check < b->check ? -1 : 1;
+    return 0;
+}
+
+static int CC KIEntrySort(void const *a, void const *b)
+{
+    return KIEntryCmp(a, b);
+}
+
+LIB_EXPORT rc_t CC KeyIndexMake(KeyIndex **rslt, const char *tmpfs, uint64_t pid, uint32_t n, size_t memLimit)
+{
+    KeyIndex *const self = calloc(1, sizeof(*self));
+    rc_t rc;
+
+    if (self == NULL)
+        return RC(rcApp, rcIndex, rcConstructing, rcMemory, rcExhausted);
+
+    rc = string_printf(self->tmpfs, sizeof(self->tmpfs), NULL, "%s", tmpfs);
+    if (rc == 0)
+        rc = KLockMake(&self->lock);
+    if (rc == 0)
+        rc = KDirectoryNativeDir(&self->dir);
+    if (rc == 0) {
+        self->pid = pid;
+        self->n = n;
+        self->tableMax = KI_MIN_TABLE;
+        while (self->tableMax * 2 * sizeof(self->table[0]) <= memLimit)
+            self->tableMax *= 2;
+        self->tableSize = KI_MIN_TABLE;
+        self->table = calloc(self->tableSize, sizeof(self->table[0]));
+        if (self->table == NULL)
+            rc = RC(rcApp, rcIndex, rcConstructing, rcMemory, rcExhausted);
+    }
+    if (rc == 0) {
+        *rslt = self;
+        return 0;
+    }
+    KeyIndexWhack(self);
+    return rc;
+}
+
+static KIEntry *KITableSlot(KIEntry *table, size_t tableSize, KIEntry const *key)
+{
+    size_t const mask = tableSize - 1;
+    size_t i = (size_t)key->hash & mask;
+
+    while (table[i].id1 != 0) {
+        if (table[i].hash == key->hash && table[i].check == key->check)
+            break;
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static rc_t KITableGrow(KeyIndex *self)
+{
+    size_t const newSize = self->tableSize * 2;
+    KIEntry *const table = calloc(newSize, sizeof(table[0]));
+    size_t i;
+
+    if (table == NULL)
+        return RC(rcApp, rcIndex, rcResizing, rcMemory, rcExhausted);
+    for (i = 0; i != self->tableSize; ++i) {
+        if (self->table[i].id1 != 0)
+            *KITableSlot(table, newSize, &self->table[i]) = self->table[i];
+    }
+    free(self->table);
+    self->table = table;
+    self->tableSize = newSize;
+    return 0;
+}
+
+/* OpenRunFile
+ *  scratch files are unlinked as soon as they are created
+ */
+static rc_t KIOpenRunFile(KeyIndex *self, KFile **file)
+{
+    char fname[4096];
+    rc_t rc = string_printf(fname, sizeof(fname), NULL, "%s/key2id.%lu.%u.%u",
+                            self->tmpfs, self->pid, self->n, ++self->runSeq);
+
+    if (rc == 0) {
+        rc = KDirectoryCreateFile(self->dir, file, true, 0600, kcmInit, fname);
+        KDirectoryRemove(self->dir, 0, fname);
+    }
+    return rc;
+}
+
+static rc_t KIRunAppend(KeyIndex *self, KIRun const *run)
+{
+    if (self->numRuns == self->runAlloc) {
+        unsigned const alloc = self->runAlloc ? self->runAlloc * 2 : 16;
+        void *const tmp = realloc(self->run, alloc * sizeof(self->run[0]));
+
+        if (tmp == NULL)
+            return RC(rcApp, rcIndex, rcResizing, rcMemory, rcExhausted);
+        self->run = tmp;
+        self->runAlloc = alloc;
+    }
+    self->run[self->numRuns++] = *run;
+    return 0;
+}
+
+static void KIRunWhack(KIRun *run)
+{
+    KFileRelease(run->file);
+    free(run->fence);
+    free(run->bloom);
+    memset(run, 0, sizeof(*run));
+}
+
+/* Bloom
+ *  the probes step through the filter by the check word, which is
+ *  independent of the hash
+ */
+static rc_t KIRunBloomMake(KIRun *run, uint64_t expected)
+{
+    uint64_t bits = 512;
+
+    while (bits < expected * KI_BLOOM_BITS)
+        bits <<= 1;
+    run->bloom = calloc(bits / 64, sizeof(run->bloom[0]));
+    if (run->bloom == NULL)
+        return RC(rcApp, rcIndex, rcWriting, rcMemory, rcExhausted);
+    run->bloomMask = bits - 1;
+    return 0;
+}
+
+static void KIRunBloomAdd(KIRun *run, KIEntry const *entry)
+{
+    uint64_t const step = ((uint64_t)entry->check << 1) | 1;
+    uint64_t bit = entry->hash;
+    unsigned i;
+
+    for (i = 0; i != KI_BLOOM_PROBES; ++i, bit += step)
+        run->bloom[(bit & run->bloomMask) >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+static bool KIRunBloomTest(KIRun const *run, KIEntry const *key)
+{
+    uint64_t const step = ((uint64_t)key->check << 1) | 1;
+    uint64_t bit = key->hash;
+    unsigned i;
+
+    for (i = 0; i != KI_BLOOM_PROBES; ++i, bit += step) {
+        if ((run->bloom[(bit & run->bloomMask) >> 6] & ((uint64_t)1 << (bit & 63))) == 0)
+            return false;
+    }
+    return true;
+}
+
+/* RunWriter
+ *  writes sorted entries in blocks and keeps the first entry of each;
+ *  the run's bloom filter must be made before the first put
+ */
+typedef struct KIRunWriter {
+    KIRun run;
+    uint32_t fenceAlloc;
+    uint32_t fill;
+    KIEntry buf[KI_BLOCK_ENTRIES];
+} KIRunWriter;
+
+static rc_t KIRunWriterFlush(KIRunWriter *self)
+{
+    rc_t rc = 0;
+
+    if (self->fill > 0) {
+        uint64_t const pos = (uint64_t)self->run.blocks * sizeof(self->buf);
+
+        if (self->run.blocks == self->fenceAlloc) {
+            uint32_t const alloc = self->fenceAlloc ? self->fenceAlloc * 2 : 64;
+            void *const tmp = realloc(self->run.fence, alloc * sizeof(self->run.fence[0]));
+
+            if (tmp == NULL)
+                return RC(rcApp, rcIndex, rcWriting, rcMemory, rcExhausted);
+            self->run.fence = tmp;
+            self->fenceAlloc = alloc;
+        }
+        rc = KFileWriteAll(self->run.file, pos, self->buf, self->fill * sizeof(self->buf[0]), NULL);
+        if (rc == 0) {
+            self->run.fence[self->run.blocks++] = self->buf[0];
+            self->run.count += self->fill;
+            self->fill = 0;
+        }
+    }
+    return rc;
+}
+
+static rc_t KIRunWriterPut(KIRunWriter *self, KIEntry const *entry)
+{
+    KIRunBloomAdd(&self->run, entry);
+    self->buf[self->fill++] = *entry;
+    return self->fill == KI_BLOCK_ENTRIES ? KIRunWriterFlush(self) : 0;
+}
+
+/* RunReader
+ *  sequential reader used by the merge
+ */
+typedef struct KIRunReader {
+    KIRun const *run;
+    uint64_t next;
+    uint32_t fill;
+    uint32_t cur;
+    KIEntry buf[KI_BLOCK_ENTRIES];
+} KIRunReader;
+
+static rc_t KIRunReaderFill(KIRunReader *self)
+{
+    uint64_t const remain = self->run->count - self->next;
+    uint32_t const want = remain < KI_BLOCK_ENTRIES ? (uint32_t)remain : KI_BLOCK_ENTRIES;
+    size_t num_read;
+    rc_t rc;
+
+    self->cur = self->fill = 0;
+    if (want == 0)
+        return 0;
+    rc = KFileReadAll(self->run->file, self->next * sizeof(self->buf[0]), self->buf, want * sizeof(self->buf[0]), &num_read);
+    if (rc == 0 && num_read != want * sizeof(self->buf[0]))
+        rc = RC(rcApp, rcIndex, rcReading, rcData, rcInsufficient);
+    if (rc == 0) {
+        self->fill = want;
+        self->next += want;
+    }
+    return rc;
+}
+
+/* MergeRuns
+ *  merges the runs [ first, numRuns ) into one run of the given level
+ */
+static rc_t KIMergeRuns(KeyIndex *self, unsigned first, uint32_t level)
+{
+    unsigned const k = self->numRuns - first;
+    KIRunReader *const rdr = calloc(k, sizeof(rdr[0]));
+    KIRunWriter *const wtr = calloc(1, sizeof(*wtr));
+    uint64_t total = 0;
+    rc_t rc = 0;
+    unsigned i;
+
+    if (rdr == NULL || wtr == NULL)
+        rc = RC(rcApp, rcIndex, rcWriting, rcMemory, rcExhausted);
+    for (i = 0; rc == 0 && i != k; ++i) {
+        rdr[i].run = &self->run[first + i];
+        total += rdr[i].run->count;
+        rc = KIRunReaderFill(&rdr[i]);
+    }
+    if (rc == 0)
+        rc = KIRunBloomMake(&wtr->run, total);
+    if (rc == 0)
+        rc = KIOpenRunFile(self, &wtr->run.file);
+    while (rc == 0) {
+        KIRunReader *best = NULL;
+
+        for (i = 0; i != k; ++i) {
+            if (rdr[i].cur < rdr[i].fill) {
+                if (best == NULL || KIEntryCmp(&rdr[i].buf[rdr[i].cur], &best->buf[best->cur]) < 0)
+                    best = &rdr[i];
+            }
+        }
+        if (best == NULL)
+            break;
+        rc = KIRunWriterPut(wtr, &best->buf[best->cur]);
+        if (rc == 0 && ++best->cur == best->fill)
+            rc = KIRunReaderFill(best);
+    }
+    if (rc == 0)
+        rc = KIRunWriterFlush(wtr);
+    if (rc == 0) {
+        for (i = first; i != self->numRuns; ++i)
+            KIRunWhack(&self->run[i]);
+        self->numRuns = first;
+        wtr->run.level = level;
+        rc = KIRunAppend(self, &wtr->run);
+        if (rc == 0)
+            memset(&wtr->run, 0, sizeof(wtr->run));
+    }
+    if (wtr)
+        KIRunWhack(&wtr->run);
+    free(wtr);
+    free(rdr);
+    return rc;
+}
+
+/* Spill
+ *  writes the table out as a sorted run, then merges whenever the
+ *  newest KI_MERGE_FANIN runs share a level
+ */
+static rc_t KISpill(KeyIndex *self)
+{
+    KIRunWriter *const wtr = calloc(1, sizeof(*wtr));
+    size_t i, j;
+    rc_t rc;
+
+    if (wtr == NULL)
+        return RC(rcApp, rcIndex, rcWriting, rcMemory, rcExhausted);
+
+    for (i = j = 0; i != self->tableSize; ++i) {
+        if (self->table[i].id1 != 0)
+            self->table[j++] = self->table[i];
+    }
+    assert(j == self->used);
+    qsort(self->table, j, sizeof(self->table[0]), KIEntrySort);
+
+    rc = KIRunBloomMake(&wtr->run, j);
+    if (rc == 0)
+        rc = KIOpenRunFile(self, &wtr->run.file);
+    for (i = 0; rc == 0 && i != j; ++i)
+        rc = KIRunWriterPut(wtr, &self->table[i]);
+    if (rc == 0)
+        rc = KIRunWriterFlush(wtr);
+    if (rc == 0)
+        rc = KIRunAppend(self, &wtr->run);
+    if (rc == 0) {
+        STSMSG(2, ("key index %u: spilled %zu names to run %u", self->n, j, self->numRuns));
+        memset(self->table, 0, self->tableSize * sizeof(self->table[0]));
+        self->used = 0;
+
+        while (rc == 0 && self->numRuns >= KI_MERGE_FANIN) {
+            unsigned const first = self->numRuns - KI_MERGE_FANIN;
+            uint32_t const level = self->run[first].level;
+
+            for (i = first + 1; i != self->numRuns; ++i) {
+                if (self->run[i].level != level)
+                    break;
+            }
+            if (i != self->numRuns)
+                break;
+            rc = KIMergeRuns(self, first, level + 1);
+        }
+    }
+    else
+        KIRunWhack(&wtr->run);
+    free(wtr);
+    return rc;
+}
+
+/* RunFind
+ *  the bloom filter turns away most keys the run does not hold; for the
+ *  rest the fences select the one block that can hold the key
+ */
+static rc_t KIRunFind(KeyIndex *self, KIRun const *run, KIEntry const *key, uint32_t *id1)
+{
+    uint32_t lo = 0;
+    uint32_t hi = run->blocks;
+    uint64_t first;
+    uint32_t count;
+    size_t num_read;
+    rc_t rc;
+
+    *id1 = 0;
+    if (!KIRunBloomTest(run, key))
+        return 0;
+    while (lo < hi) {
+        uint32_t const mid = lo + (hi - lo) / 2;
+
+        if (KIEntryCmp(&run->fence[mid], key) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return 0;
+
+    first = (uint64_t)(lo - 1) * KI_BLOCK_ENTRIES;
+    count = run->count - first < KI_BLOCK_ENTRIES ? (uint32_t)(run->count - first) : KI_BLOCK_ENTRIES;
+    rc = KFileReadAll(run->file, first * sizeof(self->block[0]), self->block, count * sizeof(self->block[0]), &num_read);
+    if (rc == 0 && num_read != count * sizeof(self->block[0]))
+        rc = RC(rcApp, rcIndex, rcReading, rcData, rcInsufficient);
+    if (rc == 0) {
+        KIEntry const *const found = bsearch(key, self->block, count, sizeof(self->block[0]), KIEntrySort);
+
+        if (found)
+            *id1 = found->id1;
+    }
+    return rc;
+}
+
+static rc_t KeyIndexEntryLocked(KeyIndex *self, uint32_t *id, bool *wasInserted, void const *key, size_t keylen)
+{
+    KIEntry tmp;
+    KIEntry *slot;
+    rc_t rc = 0;
+
+    tmp.hash = KIHash(key, keylen, 0);
+    tmp.check = (uint32_t)KIHash(key, keylen, 0x5bd1e995);
+
+    slot = KITableSlot(self->table, self->tableSize, &tmp);
+    if (slot->id1 == 0) {
+        unsigned i;
+
+        for (i = self->numRuns; i != 0; ) {
+            uint32_t id1;
+
+            rc = KIRunFind(self, &self->run[--i], &tmp, &id1);
+            if (rc)
+                return rc;
+            if (id1 != 0) {
+                *id = id1 - 1;
+                *wasInserted = false;
+                return 0;
+            }
+        }
+        if (self->count == UINT32_MAX - 1)
+            return RC(rcApp, rcIndex, rcInserting, rcId, rcExhausted);
+
+        if ((self->used + 1) * 4 > self->tableSize * 3) {
+            rc = self->tableSize < self->tableMax ? KITableGrow(self) : KISpill(self);
+            if (rc)
+                return rc;
+            slot = KITableSlot(self->table, self->tableSize, &tmp);
+        }
+        tmp.id1 = ++self->count;
+        *slot = tmp;
+        ++self->used;
+        *wasInserted = true;
+    }
+    else
+        *wasInserted = false;
+    *id = slot->id1 - 1;
+    return 0;
+}
+
+LIB_EXPORT rc_t CC KeyIndexEntry(KeyIndex *self, uint32_t *id, bool *wasInserted, const void *key, size_t keylen)
+{
+    rc_t rc = KLockAcquire(self->lock);
+
+    if (rc == 0) {
+        rc = KeyIndexEntryLocked(self, id, wasInserted, key, keylen);
+        KLockUnlock(self->lock);
+    }
+    return rc;
+}
+
+LIB_EXPORT rc_t CC KeyIndexMerge(KeyIndex *self)
+{
+    rc_t rc = KLockAcquire(self->lock);
+
+    if (rc == 0) {
+        if (self->numRuns > 1) {
+            STSMSG(1, ("key index %u: merging %u runs", self->n, self->numRuns));
+            rc = KIMergeRuns(self, 0, self->run[self->numRuns - 1].level + 1);
+        }
+        KLockUnlock(self->lock);
+    }
+    return rc;
+}
+
+LIB_EXPORT void CC KeyIndexWhack(KeyIndex *self)
+{
+    if (self) {
+        unsigned i;
+
+        for (i = 0; i != self->numRuns; ++i)
+            KIRunWhack(&self->run[i]);
+        free(self->run);
+        free(self->table);
+        KDirectoryRelease(self->dir);
+        KLockRelease(self->lock);
+        free(self);
+    }
+}
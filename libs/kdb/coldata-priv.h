@@ -38,6 +38,7 @@ extern "C" {
 /*--------------------------------------------------------------------------
  * forwards
  */
+struct KMMap;
 typedef union KColumnPageMap KColumnPageMap;
 
 
@@ -58,6 +59,11 @@ struct KColumnData
     /* data fork itself */
     struct KFile const *f;
 
+    /* optional mapping of data fork up to eof
+       when mapped, "addr" is its base and "f" is unbuffered */
+    struct KMMap const *mm;
+    const uint8_t *addr;
+
     /* page size */
     size_t pgsize;
 };
@@ -69,9 +75,11 @@ struct KColumnData
     ( ( reuse_pages ) ? 4096 : 1 )
 
 /* Open
+ *  "try_mmap" [ IN ] - map the data fork into memory
+ *  if it is a local file, otherwise read it through a buffer
  */
 rc_t KColumnDataOpenRead ( KColumnData *self,
-    const KDirectory *dir, uint64_t eof, size_t pgsize );
+    const KDirectory *dir, uint64_t eof, size_t pgsize, bool try_mmap );
 
 /* Whack
  */
@@ -83,6 +91,18 @@ rc_t KColumnDataWhack ( KColumnData *self );
 rc_t KColumnDataRead ( const KColumnData *self, const KColumnPageMap *pm,
     size_t offset, void *buffer, size_t bsize, size_t *num_read );
 
+/* Addr
+ *  returns address of blob data within mapped data fork
+ *  fails with rcUnsupported state if the data fork is not mapped
+ */
+rc_t KColumnDataAddr ( const KColumnData *self, const KColumnPageMap *pm,
+    size_t offset, size_t size, const void **addr );
+
+/* Advise
+ *  pass access hint along to mapped data fork
+ */
+rc_t KColumnDataAdvise ( const KColumnData *self, uint32_t access );
+
 
 /*--------------------------------------------------------------------------
  * KColumnPageMap
@@ -26,8 +26,10 @@
 
 #include <kdb/extern.h>
 #include "coldata-priv.h"
+#include <kdb/column.h>
 #include <kfs/file.h>
 #include <kfs/buffile.h>
+#include <kfs/mmap.h>
 #include <kfs/impl.h>
 #include <klib/rc.h>
 #include <sysalloc.h>
@@ -70,15 +72,54 @@ rc_t KColumnDataInit ( KColumnData *self, uint64_t pos, size_t pgsize )
     return rc;
 }
 
+/* MapRead
+ *  map a local data fork up to eof
+ *  leaves data fork unmapped if anything gets in the way
+ */
+static
+void KColumnDataMapRead ( KColumnData *self, uint64_t eof )
+{
+    uint64_t off;
+    const KMMap *mm;
+    const void *addr;
+
+    /* only files on local disk are worth mapping */
+    if ( eof == 0 || ( uint64_t ) ( size_t ) eof != eof ||
+         KFileGetSysFile ( self -> f, & off ) == NULL )
+    {
+        return;
+    }
+
+    if ( KMMapMakeRgnRead ( & mm, self -> f, 0, ( size_t ) eof ) == 0 )
+    {
+        /* a region that had to be read into memory will not do */
+        if ( KMMapAdvise ( mm, 0, 0, kmmNormal ) == 0 &&
+             KMMapAddrRead ( mm, & addr ) == 0 )
+        {
+            self -> mm = mm;
+            self -> addr = addr;
+            return;
+        }
+
+        KMMapRelease ( mm );
+    }
+}
+
 /* Open
  */
 rc_t KColumnDataOpenRead ( KColumnData *self,
-    const KDirectory *dir, uint64_t eof, size_t pgsize )
+    const KDirectory *dir, uint64_t eof, size_t pgsize, bool try_mmap )
 {
     rc_t rc = KDirectoryVOpenFileRead ( dir,
         & self -> f, "data", NULL );
+
+    self -> mm = NULL;
+    self -> addr = NULL;
+    if ( rc == 0 && try_mmap )
+        KColumnDataMapRead ( self, eof );
+
 #if DATA_READ_FILE_BUFFER
-    if ( rc == 0 )
+    if ( rc == 0 && self -> mm == NULL )
     {
         const KFile * orig = self -> f;
         rc = KBufFileMakeRead ( & self -> f, self -> f, DATA_READ_FILE_BUFFER );
@@ -94,7 +135,15 @@ rc_t KColumnDataOpenRead ( KColumnData *self,
     }
 #endif
     if ( rc == 0 )
+    {
         rc = KColumnDataInit ( self, eof, pgsize );
+        if ( rc != 0 )
+        {
+            KMMapRelease ( self -> mm );
+            self -> mm = NULL;
+            self -> addr = NULL;
+        }
+    }
     return rc;
 }
 
@@ -102,9 +151,15 @@ rc_t KColumnDataOpenRead ( KColumnData *self,
  */
 rc_t KColumnDataWhack ( KColumnData *self )
 {
-    rc_t rc = KFileRelease ( self -> f );
+    rc_t rc = KMMapRelease ( self -> mm );
     if ( rc == 0 )
-        self -> f = NULL;
+    {
+        self -> mm = NULL;
+        self -> addr = NULL;
+        rc = KFileRelease ( self -> f );
+        if ( rc == 0 )
+            self -> f = NULL;
+    }
     return rc;
 }
 
@@ -126,8 +181,75 @@ rc_t KColumnDataRead ( const KColumnData *self, const KColumnPageMap *pm,
         return 0;
     }
 
-    pos = pm -> pg * self -> pgsize;
-    return KFileRead ( self -> f, pos + offset, buffer, bsize, num_read );
+    pos = pm -> pg * self -> pgsize + offset;
+
+    if ( self -> addr != NULL )
+    {
+        /* mapping covers everything up to eof */
+        assert ( num_read != NULL );
+        if ( pos >= self -> eof )
+            bsize = 0;
+        else if ( pos + bsize > self -> eof )
+            bsize = ( size_t ) ( self -> eof - pos );
+        memcpy ( buffer, self -> addr + pos, bsize );
+        * num_read = bsize;
+        return 0;
+    }
+
+    return KFileRead ( self -> f, pos, buffer, bsize, num_read );
+}
+
+/* Addr
+ *  returns address of blob data within mapped data fork
+ */
+rc_t KColumnDataAddr ( const KColumnData *self, const KColumnPageMap *pm,
+    size_t offset, size_t size, const void **addr )
+{
+    uint64_t pos;
+
+    assert ( self != NULL );
+    assert ( pm != NULL );
+    assert ( addr != NULL );
+
+    if ( self -> addr == NULL )
+        return RC ( rcDB, rcColumn, rcAccessing, rcMemMap, rcUnsupported );
+
+    pos = pm -> pg * self -> pgsize + offset;
+    if ( pos + size > self -> eof )
+        return RC ( rcDB, rcColumn, rcAccessing, rcRange, rcExcessive );
+
+    * addr = self -> addr + pos;
+    return 0;
+}
+
+/* Advise
+ *  pass access hint along to mapped data fork
+ */
+rc_t KColumnDataAdvise ( const KColumnData *self, uint32_t access )
+{
+    KMMapAdvice advice;
+
+    assert ( self != NULL );
+
+    if ( self -> mm == NULL )
+        return 0;
+
+    switch ( access )
+    {
+    case kcaNormal:
+        advice = kmmNormal;
+        break;
+    case kcaSequential:
+        advice = kmmSequential;
+        break;
+    case kcaRandom:
+        advice = kmmRandom;
+        break;
+    default:
+        return RC ( rcDB, rcColumn, rcAccessing, rcParam, rcInvalid );
+    }
+
+    return KMMapAdvise ( self -> mm, 0, 0, advice );
 }
 
 
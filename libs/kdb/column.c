@@ -179,7 +179,7 @@ rc_t KColumnMake ( KColumn **colp, const KDirectory *dir, const char *path )
 }
 
 static
-rc_t KColumnMakeRead ( KColumn **colp, const KDirectory *dir, const char *path )
+rc_t KColumnMakeRead ( KColumn **colp, const KDirectory *dir, const char *path, bool try_mmap )
 {
     rc_t rc = KColumnMake ( colp, dir, path );
     if ( rc == 0 )
@@ -193,7 +193,7 @@ rc_t KColumnMakeRead ( KColumn **colp, const KDirectory *dir, const char *path )
         if ( rc == 0 )
         {
             rc = KColumnDataOpenRead ( & self -> df,
-                dir, data_eof, pgsize );
+                dir, data_eof, pgsize, try_mmap );
             if ( rc == 0 )
             {
                 switch ( self -> checksum )
@@ -252,7 +252,7 @@ rc_t KDBManagerVOpenColumnReadInt ( const KDBManager *self,
         rc = KDBOpenPathTypeRead ( self, wd, colpath, &dir, kptColumn, NULL, try_srapath );
         if ( rc == 0 )
         {
-            rc = KColumnMakeRead ( & col, dir, colpath );
+            rc = KColumnMakeRead ( & col, dir, colpath, self -> data_mmap );
             if ( rc == 0 )
             {
                 col -> mgr = KDBManagerAttach ( self );
@@ -492,6 +492,32 @@ LIB_EXPORT rc_t CC KColumnOpenParentRead ( const KColumn *self, const KTable **t
 }
 
 
+/* AdviseAccess
+ *  hint at the order in which blobs are going to be read
+ */
+LIB_EXPORT rc_t CC KColumnAdviseAccess ( const KColumn *self, KColumnAccess access )
+{
+    if ( self == NULL )
+        return RC ( rcDB, rcColumn, rcAccessing, rcSelf, rcNull );
+
+    switch ( access )
+    {
+    case kcaNormal:
+    case kcaSequential:
+    case kcaRandom:
+        break;
+    default:
+        return RC ( rcDB, rcColumn, rcAccessing, rcParam, rcInvalid );
+    }
+
+    /* nothing to advise unless data are mapped */
+    if ( self -> df . mm == NULL )
+        return 0;
+
+    return KColumnDataAdvise ( & self -> df, access );
+}
+
+
 /*--------------------------------------------------------------------------
  * KColumnBlob
  *  one or more rows of column data
@@ -851,6 +877,39 @@ LIB_EXPORT rc_t CC KColumnBlobRead ( const KColumnBlob *self,
     return rc;
 }
 
+
+/* ReadDirect
+ *  access blob data in place without copying
+ */
+LIB_EXPORT rc_t CC KColumnBlobReadDirect ( const KColumnBlob *self,
+    const void **addr, size_t *size )
+{
+    rc_t rc;
+
+    if ( addr == NULL || size == NULL )
+        rc = RC ( rcDB, rcBlob, rcReading, rcParam, rcNull );
+    else
+    {
+        if ( self == NULL )
+            rc = RC ( rcDB, rcBlob, rcReading, rcSelf, rcNull );
+        else
+        {
+            rc = KColumnDataAddr ( & self -> col -> df, & self -> pmorig,
+                0, self -> loc . u . blob . size, addr );
+            if ( rc == 0 )
+            {
+                * size = self -> loc . u . blob . size;
+                return 0;
+            }
+        }
+
+        * addr = NULL;
+        * size = 0;
+    }
+
+    return rc;
+}
+
 /* GetDirectory
  */
 LIB_EXPORT rc_t CC KColumnGetDirectoryRead ( const KColumn *self, const KDirectory **dir )
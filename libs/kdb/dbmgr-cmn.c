@@ -241,6 +241,19 @@ LIB_EXPORT rc_t CC KDBManagerGetVFSManager ( const KDBManager *self,
 }
 
 
+/* SetDataMMap
+ *  choose how data of columns opened for read are accessed
+ */
+LIB_EXPORT rc_t CC KDBManagerSetDataMMap ( const KDBManager *self, bool enabled )
+{
+    if ( self == NULL )
+        return RC ( rcDB, rcMgr, rcUpdating, rcSelf, rcNull );
+
+    ( ( KDBManager* ) self ) -> data_mmap = enabled;
+    return 0;
+}
+
+
 /* Version
  *  returns the library version
  */
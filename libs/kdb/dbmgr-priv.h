@@ -74,6 +74,9 @@ struct KDBManager
 
     /* other managers needed by the KDB manager */
     struct VFSManager * vfsmgr;
+
+    /* memory map data forks of columns opened for read */
+    bool data_mmap;
 };
 
 
@@ -1536,6 +1536,17 @@ LIB_EXPORT rc_t CC KColumnOpenParentUpdate ( KColumn *self, KTable **tbl )
     return rc;
 }
 
+/* AdviseAccess
+ *  hint at the order in which blobs are going to be read
+ *  has no effect in update mode
+ */
+LIB_EXPORT rc_t CC KColumnAdviseAccess ( const KColumn *self, KColumnAccess access )
+{
+    if ( self == NULL )
+        return RC ( rcDB, rcColumn, rcAccessing, rcSelf, rcNull );
+    return 0;
+}
+
 /* OpenDirectory
  *  duplicate reference to the directory in use
  *  NB - returned reference must be released
@@ -2145,6 +2156,25 @@ LIB_EXPORT rc_t CC KColumnBlobRead ( const KColumnBlob *self,
     return rc;
 }
 
+
+/* ReadDirect
+ *  column data are never memory mapped in update mode
+ */
+LIB_EXPORT rc_t CC KColumnBlobReadDirect ( const KColumnBlob *self,
+    const void **addr, size_t *size )
+{
+    if ( addr == NULL || size == NULL )
+        return RC ( rcDB, rcBlob, rcReading, rcParam, rcNull );
+
+    * addr = NULL;
+    * size = 0;
+
+    if ( self == NULL )
+        return RC ( rcDB, rcBlob, rcReading, rcSelf, rcNull );
+
+    return RC ( rcDB, rcBlob, rcReading, rcFunction, rcUnsupported );
+}
+
 /* KColumnBlobAppend
  *  append data to open blob
  *
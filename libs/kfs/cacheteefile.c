@@ -30,7 +30,12 @@ struct KCacheTeeFile;
 #include <kfs/impl.h>
 #include <kfs/lockfile.h>
 
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+#include <kproc/thread.h>
+
 #include <klib/rc.h>
+#include <klib/container.h>
 #include <klib/log.h>
 #include <klib/out.h>
 #include <klib/text.h>
@@ -64,6 +69,37 @@ struct KCacheTeeFile;
 #define CACHE_TEE_DEFAULT_BLOCKSIZE ( 32 * 1024 )
 #define CACHE_TEE_REPORT 0
 
+/* the amount of fetched data allowed to wait for the flusher
+   before readers are held back */
+#define CACHE_TEE_MAX_PENDING ( 64 * 1024 * 1024 )
+
+
+/*--------------------------------------------------------------------------
+ * KCacheTeeFetch
+ *  a range of blocks being read from the remote file
+ *
+ *  it stays on the in-flight list of the tee-file from the moment the
+ *  fetch starts until its content is in the local file and the bitmap,
+ *  readers of any of its blocks wait on "ready" and are served from "data"
+ */
+typedef struct KCacheTeeFetch KCacheTeeFetch;
+struct KCacheTeeFetch
+{
+    DLNode dad;
+    KCacheTeeFetch * next_write;
+    KCondition * ready;
+    uint64_t first_block;
+    uint64_t block_count;
+    uint64_t pos;
+    size_t valid;
+    rc_t rc;
+    uint32_t refcount;
+    bool done;
+    bool in_flight;
+    uint8_t data [ 1 ];
+};
+
+
 typedef struct KCacheTeeFile
 {
     KFile dad;
@@ -73,23 +109,40 @@ typedef struct KCacheTeeFile
     KDirectory * dir;
     KLockFile * lock;
 
+    /* guards bitmap, in_flight, the write-queue, recent and log_file_pos */
+    KLock * mutex;
+
+    /* serializes fetches from the remote, which may be a single connection */
+    KLock * remote_lock;
+    KCondition * flush_cond;
+    KCondition * drained;
+    KThread * flusher;
+
+    /* fetches that are running or not yet in the local file */
+    DLList in_flight;
+
+    /* completed fetches waiting for the flusher */
+    KCacheTeeFetch * write_head;
+    KCacheTeeFetch * write_tail;
+
+    /* the last completed fetch, serves small sequential reads */
+    KCacheTeeFetch * recent;
+
     uint8_t * bitmap;
-    uint8_t * scratch_buffer;
 
     uint64_t remote_size;
     uint64_t local_size;
     uint64_t block_count;
     uint64_t log_file_pos;
-    uint64_t first_block_in_scratch;
+    uint64_t pending_bytes;
 
     /* size_t */ uint64_t bitmap_bytes;
-    /* size_t */ uint64_t scratch_size;
-    /* size_t */ uint64_t valid_scratch_bytes;
     uint32_t block_size;
     uint32_t cluster_factor;
     bool fully_in_cache;
     bool report;
     bool local_read_only;
+    bool quitting;
     char local_path [ 1 ];
 } KCacheTeeFile;
 
@@ -573,6 +626,19 @@ static rc_t promote_cache( KCacheTeeFile * cf )
 }
 
 
+/* Release
+ *  called with the mutex of the owning tee-file held
+ */
+static void KCacheTeeFetchRelease( KCacheTeeFetch *self )
+{
+    if ( self != NULL && -- self -> refcount == 0 )
+    {
+        KConditionRelease( self -> ready );
+        free( self );
+    }
+}
+
+
 /* Destroy
  */
 static rc_t CC KCacheTeeFileDestroy( KCacheTeeFile *self )
@@ -582,6 +648,19 @@ static rc_t CC KCacheTeeFileDestroy( KCacheTeeFile *self )
         OUTMSG(( "\nDESTROY cacheteefile '%s'\n\n", self -> local_path ));
     }
 
+    /* let the flusher write out what is still queued */
+    if ( self -> flusher != NULL )
+    {
+        rc_t status;
+        KLockAcquire( self -> mutex );
+        self -> quitting = true;
+        KConditionSignal( self -> flush_cond );
+        KLockUnlock( self -> mutex );
+        KThreadWait( self -> flusher, &status );
+        KThreadRelease( self -> flusher );
+    }
+    KCacheTeeFetchRelease( self -> recent );
+
     if ( !self -> local_read_only && self -> lock != NULL )
     {
         rc_t rc = IsCacheFileComplete ( self -> local, &self -> fully_in_cache, false );
@@ -597,8 +676,11 @@ static rc_t CC KCacheTeeFileDestroy( KCacheTeeFile *self )
 
     if ( self->bitmap != NULL )
         free( self->bitmap );
-    if ( self->scratch_buffer != NULL )
-        free( self->scratch_buffer );
+
+    KConditionRelease( self -> drained );
+    KConditionRelease( self -> flush_cond );
+    KLockRelease( self -> remote_lock );
+    KLockRelease( self -> mutex );
 
     KDirectoryRelease ( self->dir );
     KFileRelease ( self -> remote );
@@ -665,35 +747,6 @@ static rc_t write_bitmap( const KCacheTeeFile *cself, uint64_t start_block, uint
 }
 
 
-static rc_t resize_scratch_buffer( const KCacheTeeFile *cself, /* size_t */ uint64_t new_size )
-{
-    rc_t rc = 0;
-    KCacheTeeFile *self = ( KCacheTeeFile * )cself;
-
-    /* create scratch-buffer or resize it if needed */
-    if ( self->scratch_size == 0 )
-    {
-        self->scratch_buffer = malloc( new_size );
-        if ( self->scratch_buffer == NULL )
-            rc = RC ( rcFS, rcFile, rcConstructing, rcMemory, rcExhausted );
-        else
-            self->scratch_size = new_size;
-    }
-    else if ( self->scratch_size < new_size )
-    {
-        uint8_t * tmp = realloc( self->scratch_buffer, new_size );
-        if ( tmp == NULL )
-            rc = RC ( rcFS, rcFile, rcConstructing, rcMemory, rcExhausted );
-        else
-        {
-            self->scratch_buffer = tmp;
-            self->scratch_size = new_size;
-        }
-    }
-    return rc;
-}
-
-
 size_t check_rd_len( const KCacheTeeFile *cself, uint64_t pos, size_t bsize )
 {
     size_t res = bsize;
@@ -710,39 +763,183 @@ size_t check_rd_len( const KCacheTeeFile *cself, uint64_t pos, size_t bsize )
 }
 
 
-static rc_t rd_remote_wr_local( const KCacheTeeFile *cself, uint64_t pos,
+/* FetchMake
+ *  creates a fetch for "bytes" bytes at "pos", covering "block_count" blocks
+ */
+static rc_t KCacheTeeFetchMake( KCacheTeeFetch **fetch, uint64_t first_block,
+                                uint64_t block_count, uint64_t pos, size_t bytes )
+{
+    rc_t rc;
+    KCacheTeeFetch *f = malloc( sizeof *f + bytes );
+    if ( f == NULL )
+        return RC ( rcFS, rcFile, rcReading, rcMemory, rcExhausted );
+
+    rc = KConditionMake( &f -> ready );
+    if ( rc != 0 )
+    {
+        free( f );
+        return rc;
+    }
+
+    f -> next_write = NULL;
+    f -> first_block = first_block;
+    f -> block_count = block_count;
+    f -> pos = pos;
+    f -> valid = 0;
+    f -> rc = 0;
+    f -> refcount = 1;
+    f -> done = false;
+    f -> in_flight = false;
+
+    *fetch = f;
+    return 0;
+}
+
+
+/* FetchCopy
+ *  copies what the fetch holds at "pos" into the caller's buffer
+ *  returns false if "pos" is not in the fetched data
+ */
+static bool KCacheTeeFetchCopy( const KCacheTeeFetch *self, uint64_t pos,
                                 void *buffer, size_t bsize, size_t *num_read )
 {
-    rc_t rc = 0;
-    if ( bsize > 0 )
+    if ( self != NULL && pos >= self -> pos && pos < self -> pos + self -> valid )
     {
-        size_t bytes_read;
-        *num_read = 0;
-        rc = KFileReadAll( cself->remote, pos, buffer, bsize, &bytes_read );
-        if ( rc == 0 )
+        size_t offset = ( size_t ) ( pos - self -> pos );
+        size_t to_read = self -> valid - offset;
+        if ( to_read > bsize )
+            to_read = bsize;
+        memmove( buffer, &( self -> data[ offset ] ), to_read );
+        *num_read = to_read;
+        return true;
+    }
+    return false;
+}
+
+
+/* FindFetch
+ *  the in-flight fetch covering "block", called with the mutex held
+ */
+static KCacheTeeFetch * KCacheTeeFileFindFetch( const KCacheTeeFile *self, uint64_t block )
+{
+    DLNode *n;
+    for ( n = DLListHead( &self -> in_flight ); n != NULL; n = DLNodeNext( n ) )
+    {
+        KCacheTeeFetch *f = ( KCacheTeeFetch * ) n;
+        if ( block >= f -> first_block && block - f -> first_block < f -> block_count )
+            return f;
+    }
+    return NULL;
+}
+
+
+/* FlushFetch
+ *  writes a completed fetch into the local file and marks its blocks in the bitmap
+ *  called without the mutex, consumes one reference to the fetch
+ */
+static void KCacheTeeFileFlushFetch( KCacheTeeFile *self, KCacheTeeFetch *fetch )
+{
+    size_t written;
+    rc_t rc = KFileWriteAll( self->local, fetch -> pos, fetch -> data, fetch -> valid, &written );
+    if ( rc == 0 && written != fetch -> valid )
+        rc = RC ( rcFS, rcFile, rcWriting, rcTransfer, rcIncomplete );
+    if ( rc != 0 )
+    {
+        PLOGERR( klogErr, ( klogErr, rc, "cannot write local data $(p).$(s)",
+                            "p=%lu,s=%lu", fetch -> pos, fetch -> valid ) );
+    }
+    else if ( self->report )
+    {
+        OUTMSG(( "writing local data: %u bytes written at pos %lu\n", written, fetch -> pos ));
+    }
+
+    KLockAcquire( self -> mutex );
+    if ( rc == 0 )
+    {
+        set_bitmap( self, fetch -> first_block, fetch -> block_count );
+        write_bitmap( self, fetch -> first_block, fetch -> block_count );
+    }
+
+    /* from now on the blocks are read from the local file - or fetched again if the write failed */
+    DLListUnlink( &self -> in_flight, &fetch -> dad );
+    fetch -> in_flight = false;
+    self -> pending_bytes -= fetch -> valid;
+    KConditionBroadcast( self -> drained );
+
+    KCacheTeeFetchRelease( fetch );
+    KLockUnlock( self -> mutex );
+}
+
+
+/* Flusher
+ *  background thread moving completed fetches into the local file
+ *  the queue is drained before the thread exits
+ */
+static rc_t CC KCacheTeeFileFlusher( const KThread *t, void *data )
+{
+    KCacheTeeFile *self = data;
+
+    KLockAcquire( self -> mutex );
+    while ( self -> write_head != NULL || ! self -> quitting )
+    {
+        KCacheTeeFetch *fetch = self -> write_head;
+        if ( fetch == NULL )
+            KConditionWait( self -> flush_cond, self -> mutex );
+        else
         {
-            if ( cself->report )
-            {
-                OUTMSG(( "reading remote data: %u bytes read at pos %lu\n", bytes_read, pos ));
-            }
+            self -> write_head = fetch -> next_write;
+            if ( self -> write_head == NULL )
+                self -> write_tail = NULL;
 
-            if ( cself->local_read_only )
-            {
-                *num_read = bytes_read;
-            }
-            else
+            KLockUnlock( self -> mutex );
+            KCacheTeeFileFlushFetch( self, fetch );
+            KLockAcquire( self -> mutex );
+        }
+    }
+    KLockUnlock( self -> mutex );
+
+    return 0;
+}
+
+
+/* MakeSync
+ *  creates the locks, the conditions and - for a writable cache - the flusher
+ *  without a flusher, local writes happen on the reader's thread
+ */
+static rc_t KCacheTeeFileMakeSync( KCacheTeeFile *self )
+{
+    rc_t rc = KLockMake( &self -> mutex );
+    if ( rc == 0 )
+    {
+        rc = KLockMake( &self -> remote_lock );
+        if ( rc == 0 )
+        {
+            rc = KConditionMake( &self -> flush_cond );
+            if ( rc == 0 )
             {
-                rc = KFileWriteAll( cself->local, pos, buffer, bytes_read, num_read );
-                if ( rc == 0 && cself->report )
+                rc = KConditionMake( &self -> drained );
+                if ( rc == 0 )
                 {
-                    OUTMSG(( "writing local data: %u bytes written at pos %lu\n", *num_read, pos ));
+                    if ( ! self -> local_read_only &&
+                         KThreadMake( &self -> flusher, KCacheTeeFileFlusher, self ) != 0 )
+                    {
+                        self -> flusher = NULL;
+                    }
+                    return 0;
                 }
+                KConditionRelease( self -> flush_cond );
+                self -> flush_cond = NULL;
             }
+            KLockRelease( self -> remote_lock );
+            self -> remote_lock = NULL;
         }
+        KLockRelease( self -> mutex );
+        self -> mutex = NULL;
     }
     return rc;
 }
 
+
 #if 0
 static rc_t KCacheTeeFileRead_Starting_with_Cache_Hit( const KCacheTeeFile *cself, uint64_t pos,
                                void *buffer, size_t bsize, size_t *num_read, uint64_t first_requested_block )
@@ -1024,14 +1221,14 @@ static uint64_t calc_req_blocks( uint64_t pos, uint64_t first_req_block, size_t
     return res;
 }
 
-static rc_t KCacheTeeFileRead_simple_cached( const KCacheTeeFile *cself, uint64_t pos,
+static rc_t KCacheTeeFileRead_simple_cached( KCacheTeeFile *self, uint64_t pos,
                                              void *buffer, size_t bsize, size_t *num_read, uint64_t first_req_block )
 {
-    rc_t rc = 0;
-    bool found_in_scratch = false;
+    rc_t rc;
     size_t to_read;
     size_t block_count = 1;
-    uint64_t req_blocks = calc_req_blocks( pos, first_req_block, bsize, cself->block_size );
+    uint64_t reachable;
+    uint64_t req_blocks = calc_req_blocks( pos, first_req_block, bsize, self->block_size );
 
     /* we read as much as we have from the local cache, forcing the caller
        to eventually make another request ( the non-cached part of it ) afterwards */
@@ -1045,62 +1242,63 @@ static rc_t KCacheTeeFileRead_simple_cached( const KCacheTeeFile *cself, uint64_
             block++;
             block_count++;
         }
-        while ( ( block_count < req_blocks ) && ( IS_CACHE_BIT( cself, block ) ) );
+        while ( ( block_count < req_blocks ) && ( IS_CACHE_BIT( self, block ) ) );
     }
 
-    /* check if we eventually have the requested bytes in the scratch-buffer */
-    if ( cself -> first_block_in_scratch == first_req_block )
-    {
-        uint64_t first_pos_in_scratch = first_req_block;
-        first_pos_in_scratch *= cself->block_size;
-        if ( pos >= first_pos_in_scratch )
-        {
-            uint64_t last_pos_in_scratch = first_pos_in_scratch;
-            last_pos_in_scratch += cself -> valid_scratch_bytes;
-            found_in_scratch = ( pos < last_pos_in_scratch );
-            if ( found_in_scratch )
-            {
-                uint64_t available_in_scratch = ( last_pos_in_scratch - pos );
-                if ( bsize > available_in_scratch )
-                    to_read = available_in_scratch;
-                else
-                    to_read = bsize;
+    /* now we have to check how much of the request can be satisfied from the local file */
+    reachable = first_req_block;
+    reachable += block_count;
+    reachable *= self->block_size;
+    reachable -= pos;
 
-                memmove ( buffer, &( cself->scratch_buffer[ pos - first_pos_in_scratch ] ), to_read );
-                *num_read = to_read;
-            }
-        }
-    }
+    /* are we requesting beyond the end of file? */
+    if ( reachable >= bsize )
+        to_read = check_rd_len( self, pos, bsize );
+    else
+        to_read = check_rd_len( self, pos, reachable );
 
-    if ( !found_in_scratch )
-    {
-        /* now we have to check how much of the request can be satisfied from the local file */
-        uint64_t reachable = first_req_block;
-        reachable += block_count;
-        reachable *= cself->block_size;
-        reachable -= pos;
-
-        /* are we requesting beyond the end of file? */
-        if ( reachable >= bsize )
-            to_read = check_rd_len( cself, pos, bsize );
-        else
-            to_read = check_rd_len( cself, pos, reachable );
+    /* blocks never leave the cache, the local file can be read without the lock */
+    KLockUnlock( self -> mutex );
+    rc = KFileReadAll( self->local, pos, buffer, to_read, num_read );
+    KLockAcquire( self -> mutex );
 
-        rc = KFileReadAll( cself->local, pos, buffer, to_read, num_read );
+    return rc;
+}
+
+
+static rc_t KCacheTeeFileRead_in_flight( KCacheTeeFile *self, KCacheTeeFetch *fetch, uint64_t pos,
+                                         void *buffer, size_t bsize, size_t *num_read )
+{
+    rc_t rc = 0;
+
+    /* join the wait-list of the fetch instead of reading the same blocks again */
+    ++ fetch -> refcount;
+    while ( rc == 0 && ! fetch -> done )
+        rc = KConditionWait( fetch -> ready, self -> mutex );
+
+    if ( rc == 0 )
+    {
+        rc = fetch -> rc;
+        if ( rc == 0 )
+            KCacheTeeFetchCopy( fetch, pos, buffer, bsize, num_read );
     }
 
+    KCacheTeeFetchRelease( fetch );
     return rc;
 }
 
 
-static rc_t KCacheTeeFileRead_simple_not_cached( const KCacheTeeFile *cself, uint64_t pos,
+static rc_t KCacheTeeFileRead_simple_not_cached( KCacheTeeFile *self, uint64_t pos,
                                                  void *buffer, size_t bsize, size_t *num_read, uint64_t first_req_block )
 {
     rc_t rc;
+    KCacheTeeFetch *fetch;
     size_t to_read_remote;
     size_t block_count = 1;
-    uint64_t req_blocks = calc_req_blocks( pos, first_req_block, bsize, cself->block_size );
+    uint64_t block_start;
+    uint64_t req_blocks = calc_req_blocks( pos, first_req_block, bsize, self->block_size );
 
+    /* stop at the first block that is cached or already being fetched by another reader */
     if ( req_blocks >  1 )
     {
         uint64_t block = first_req_block;
@@ -1110,49 +1308,81 @@ static rc_t KCacheTeeFileRead_simple_not_cached( const KCacheTeeFile *cself, uin
             block++;
             block_count++;
         }
-        while ( ( block_count < req_blocks ) && ( !( IS_CACHE_BIT( cself, block ) ) ) );
+        while ( ( block_count < req_blocks ) &&
+                ( !( IS_CACHE_BIT( self, block ) ) ) &&
+                ( KCacheTeeFileFindFetch( self, block ) == NULL ) );
     }
 
-    to_read_remote = ( block_count * cself->block_size );
-    rc = resize_scratch_buffer( cself, to_read_remote );
+    block_start = first_req_block;
+    block_start *= self->block_size;
+    to_read_remote = check_rd_len( self, block_start, block_count * self->block_size );
+
+    rc = KCacheTeeFetchMake( &fetch, first_req_block, block_count, block_start, to_read_remote );
     if ( rc == 0 )
     {
-        size_t l_num_read;
-        uint64_t block_start = first_req_block;
-        block_start *= cself->block_size;
-        to_read_remote = check_rd_len( cself, block_start, to_read_remote );
-        rc = rd_remote_wr_local( cself, block_start, cself->scratch_buffer, to_read_remote, &l_num_read );
+        size_t l_num_read = 0;
+
+        /* publish the fetch, then leave the lock to other readers while waiting for the remote */
+        DLListPushTail( &self -> in_flight, &fetch -> dad );
+        fetch -> in_flight = true;
+
+        KLockUnlock( self -> mutex );
+        rc = KLockAcquire( self -> remote_lock );
         if ( rc == 0 )
         {
-            ( ( KCacheTeeFile * )cself ) -> first_block_in_scratch = first_req_block;
-            ( ( KCacheTeeFile * )cself ) -> valid_scratch_bytes = l_num_read;
-            if ( !cself->local_read_only )
-            {
-                set_bitmap( cself, first_req_block, block_count );
-                rc = write_bitmap( cself, first_req_block, block_count );
-            }
+            rc = KFileReadAll( self->remote, block_start, fetch -> data, to_read_remote, &l_num_read );
+            KLockUnlock( self -> remote_lock );
         }
-        if ( rc == 0 )
+        if ( rc == 0 && self->report )
         {
-            /* what we have to return to the caller is somewhere in the scratch_buffer */
-            uint64_t offset = pos;
-            offset -= block_start;
+            OUTMSG(( "reading remote data: %u bytes read at pos %lu\n", l_num_read, block_start ));
+        }
+        KLockAcquire( self -> mutex );
+
+        fetch -> rc = rc;
+        fetch -> valid = ( rc == 0 ) ? l_num_read : 0;
+        fetch -> done = true;
+        KConditionBroadcast( fetch -> ready );
 
-            /* how much we can copy depends on how much was not in cache,
-               and how much was requested in the first place... */
-            if ( l_num_read >= offset )
+        if ( rc != 0 || self->local_read_only )
+        {
+            DLListUnlink( &self -> in_flight, &fetch -> dad );
+            fetch -> in_flight = false;
+        }
+        else
+        {
+            ++ fetch -> refcount;
+            self -> pending_bytes += fetch -> valid;
+            if ( self -> flusher != NULL )
             {
-                l_num_read -= offset;
-                if ( l_num_read > bsize )
-                    l_num_read = bsize;
-                memmove ( buffer, &( cself->scratch_buffer[ offset ] ), l_num_read );
+                /* hand the local write over to the flusher */
+                fetch -> next_write = NULL;
+                if ( self -> write_tail == NULL )
+                    self -> write_head = fetch;
+                else
+                    self -> write_tail -> next_write = fetch;
+                self -> write_tail = fetch;
+                KConditionSignal( self -> flush_cond );
             }
             else
             {
-                l_num_read = 0;
+                KLockUnlock( self -> mutex );
+                KCacheTeeFileFlushFetch( self, fetch );
+                KLockAcquire( self -> mutex );
             }
-            *num_read = l_num_read;
         }
+
+        if ( rc == 0 )
+        {
+            /* what we have to return to the caller is somewhere in the fetched data */
+            KCacheTeeFetchCopy( fetch, pos, buffer, bsize, num_read );
+
+            KCacheTeeFetchRelease( self -> recent );
+            ++ fetch -> refcount;
+            self -> recent = fetch;
+        }
+
+        KCacheTeeFetchRelease( fetch );
     }
     return rc;
 }
@@ -1162,6 +1392,7 @@ static rc_t KCacheTeeFileRead_simple( const KCacheTeeFile *cself, uint64_t pos,
                                       void *buffer, size_t bsize, size_t *num_read )
 {
     rc_t rc;
+    KCacheTeeFile *self = ( KCacheTeeFile * ) cself;
     uint64_t first_req_block = pos;
     first_req_block /= cself->block_size;
 
@@ -1170,22 +1401,33 @@ static rc_t KCacheTeeFileRead_simple( const KCacheTeeFile *cself, uint64_t pos,
         OUTMSG(( "\nREQUEST '%s': %,lu .[%,lu] ( first_req_block=%,lu )\n",
                  cself->local_path, pos, bsize, first_req_block ));
 
-    /* "simple" strategy, read only that much as requested... */
-    if ( IS_CACHE_BIT( cself, first_req_block ) )
-    {
-        rc = KCacheTeeFileRead_simple_cached( cself, pos, buffer, bsize, num_read, first_req_block );
-    }
-    else
+    rc = KLockAcquire( self -> mutex );
+    if ( rc != 0 )
+        return rc;
+
+    /* do not let the data waiting for the flusher grow without bounds */
+    while ( rc == 0 && self -> flusher != NULL && self -> pending_bytes >= CACHE_TEE_MAX_PENDING )
+        rc = KConditionWait( self -> drained, self -> mutex );
+
+    if ( rc == 0 )
     {
-        rc = KCacheTeeFileRead_simple_not_cached( cself, pos, buffer, bsize, num_read, first_req_block );
+        KCacheTeeFetch *fetch;
+
+        /* "simple" strategy, read only that much as requested... */
+        if ( KCacheTeeFetchCopy( self -> recent, pos, buffer, bsize, num_read ) )
+            rc = 0;
+        else if ( ( fetch = KCacheTeeFileFindFetch( self, first_req_block ) ) != NULL )
+            rc = KCacheTeeFileRead_in_flight( self, fetch, pos, buffer, bsize, num_read );
+        else if ( IS_CACHE_BIT( cself, first_req_block ) )
+            rc = KCacheTeeFileRead_simple_cached( self, pos, buffer, bsize, num_read, first_req_block );
+        else
+            rc = KCacheTeeFileRead_simple_not_cached( self, pos, buffer, bsize, num_read, first_req_block );
     }
 
     if ( cself->logger != NULL )
-    {
-        KCacheTeeFile * self = ( KCacheTeeFile * ) cself;
         log_to_file( self->logger, &self->log_file_pos, pos, bsize, *num_read );
-    }
 
+    KLockUnlock( self -> mutex );
     return rc;
 }
 
@@ -1283,10 +1525,17 @@ static rc_t make_cache_tee( struct KDirectory *self, struct KFile const **tee,
         cf -> local_read_only = !( local -> write_enabled );
         cf -> block_size = ( blocksize > 0 ) ? blocksize : CACHE_TEE_DEFAULT_BLOCKSIZE;
         cf -> bitmap = NULL;
-        cf -> scratch_buffer = NULL;
-        cf -> scratch_size = 0;
-        cf -> first_block_in_scratch = 0;
-        cf -> valid_scratch_bytes = 0;
+        cf -> mutex = NULL;
+        cf -> remote_lock = NULL;
+        cf -> flush_cond = NULL;
+        cf -> drained = NULL;
+        cf -> flusher = NULL;
+        DLListInit( &cf -> in_flight );
+        cf -> write_head = NULL;
+        cf -> write_tail = NULL;
+        cf -> recent = NULL;
+        cf -> pending_bytes = 0;
+        cf -> quitting = false;
 
         rc = KFileSize( local, &cf -> local_size );
         if ( rc != 0 )
@@ -1368,6 +1617,8 @@ static rc_t make_cache_tee( struct KDirectory *self, struct KFile const **tee,
                             if ( rc == 0 )
                             {
                                 rc = KFileInit( &cf -> dad, (const union KFile_vt *)&vtKCacheTeeFile, "KCacheTeeFile", path, true, false );
+                                if ( rc == 0 )
+                                    rc = KCacheTeeFileMakeSync( cf );
                                 if ( rc == 0 )
                                 {
                                     /* the wrapper is ready to use now! */
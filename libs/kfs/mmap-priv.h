@@ -100,6 +100,15 @@ rc_t KMMapROSys ( KMMap *self, uint64_t pos, size_t size );
 rc_t KMMapUnmap ( KMMap *self );
 
 
+/* AdviseSys
+ *  pass access hint for a portion of a system mapped region
+ *
+ *  "addr" [ IN ] and "size" [ IN ] - portion of mapping,
+ *  not necessarily page aligned
+ */
+rc_t KMMapAdviseSys ( const KMMap *self, const char *addr, size_t size, KMMapAdvice advice );
+
+
 #ifdef __cplusplus
 }
 #endif
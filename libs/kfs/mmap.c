@@ -190,6 +190,31 @@ LIB_EXPORT rc_t CC KMMapPosition ( const KMMap *self, uint64_t *pos )
 }
 
 
+/* Advise
+ *  hint at how the region is going to be accessed
+ */
+LIB_EXPORT rc_t CC KMMapAdvise ( const KMMap *self,
+    uint64_t pos, size_t size, KMMapAdvice advice )
+{
+    if ( self == NULL )
+        return RC ( rcFS, rcMemMap, rcAccessing, rcSelf, rcNull );
+
+    if ( advice > kmmDontNeed )
+        return RC ( rcFS, rcMemMap, rcAccessing, rcParam, rcInvalid );
+
+    if ( ! self -> sys_mmap )
+        return RC ( rcFS, rcMemMap, rcAccessing, rcMemMap, rcUnsupported );
+
+    if ( pos >= self -> size )
+        return 0;
+
+    if ( size == 0 || pos + size > self -> size )
+        size = ( size_t ) ( self -> size - pos );
+
+    return KMMapAdviseSys ( self, self -> addr + pos, size, advice );
+}
+
+
 /* Addr
  *  returns starting address of memory region
  *
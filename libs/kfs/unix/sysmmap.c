@@ -121,6 +121,43 @@ rc_t KMMapROSys ( KMMap *self, uint64_t pos, size_t size )
 }
 
 
+/* AdviseSys
+ *  pass access hint for a portion of a system mapped region
+ */
+rc_t KMMapAdviseSys ( const KMMap *self, const char *addr, size_t size, KMMapAdvice advice )
+{
+    int sys_advice;
+    size_t pg_mask = self -> pg_size - 1;
+
+    /* madvise wants a page aligned start */
+    const char *left = ( const char* ) ( ( size_t ) addr & ~ pg_mask );
+    size += addr - left;
+
+    switch ( advice )
+    {
+    case kmmSequential:
+        sys_advice = POSIX_MADV_SEQUENTIAL;
+        break;
+    case kmmRandom:
+        sys_advice = POSIX_MADV_RANDOM;
+        break;
+    case kmmWillNeed:
+        sys_advice = POSIX_MADV_WILLNEED;
+        break;
+    case kmmDontNeed:
+        sys_advice = POSIX_MADV_DONTNEED;
+        break;
+    default:
+        sys_advice = POSIX_MADV_NORMAL;
+    }
+
+    if ( posix_madvise ( ( void* ) left, size, sys_advice ) != 0 )
+        return RC ( rcFS, rcMemMap, rcAccessing, rcParam, rcInvalid );
+
+    return 0;
+}
+
+
 /* Unmap
  *  removes a memory map
  */
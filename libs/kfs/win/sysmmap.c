@@ -117,6 +117,15 @@ rc_t KMMapROSys ( KMMap *self, uint64_t pos, size_t size )
 }
 
 
+/* AdviseSys
+ *  no equivalent hints are taken here
+ */
+rc_t KMMapAdviseSys ( const KMMap *self, const char *addr, size_t size, KMMapAdvice advice )
+{
+    return 0;
+}
+
+
 /* Unmap
  *  removes a memory map
  */
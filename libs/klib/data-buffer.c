@@ -27,6 +27,7 @@
 #include <klib/extern.h>
 #include <klib/data-buffer.h>
 #include <klib/rc.h>
+#include <klib/slab.h>
 #include <atomic32.h>
 #include <bitstr.h>
 #include <sysalloc.h>
@@ -50,6 +51,17 @@ struct buffer_impl_t {
 #if DEBUG_MALLOC_FREE
     uint32_t foo;
 #endif
+    /* data are not inline but belong to a buffer_view_t owner */
+    uint32_t view;
+};
+
+/* a view of external memory */
+typedef struct buffer_view_t buffer_view_t;
+struct buffer_view_t {
+    buffer_impl_t dad;
+    const void *data;
+    void ( CC * whack ) ( void *obj );
+    void *obj;
 };
 
 static size_t roundup(size_t value, unsigned bits)
@@ -58,15 +70,94 @@ static size_t roundup(size_t value, unsigned bits)
     return (value + mask) & (~mask);
 }
 
+/*--------------------------------------------------------------------------
+ * payload pools
+ *  capacities up to 1MB are rounded up to size classes four to an
+ *  octave, starting at 4KB, so that freed payloads can be recycled.
+ *  a class keeps up to 256KB of payloads per slab shard, and at least one,
+ *  while all classes together hold no more than the pool budget.
+ */
+#define POOL_MIN_BITS 12
+#define POOL_CLASSES 33
+#define POOL_MAX_CAPACITY (((size_t)1) << 20)
+#define POOL_SHARD_BYTES (256 * 1024)
+#define POOL_BUDGET (32 * 1024 * 1024)
+
+#define POOL_CAPACITY(K, Q) ((((size_t)1) << (POOL_MIN_BITS + (K))) / 4 * (Q))
+#define POOL_LIMIT(CAP) ((CAP) >= POOL_SHARD_BYTES ? 1 : (uint32_t)(POOL_SHARD_BYTES / (CAP)))
+#define POOL_SLAB(K, Q) KSLAB_INIT_BUDGET(POOL_CAPACITY(K, Q) + sizeof(buffer_impl_t), \
+    POOL_LIMIT(POOL_CAPACITY(K, Q)), &pool_budget)
+#define POOL_OCTAVE(K) POOL_SLAB(K, 4), POOL_SLAB(K, 5), POOL_SLAB(K, 6), POOL_SLAB(K, 7)
+
+static KSlabBudget pool_budget = KSLAB_BUDGET_INIT(POOL_BUDGET);
+
+static KSlab pool[POOL_CLASSES] = {
+    POOL_OCTAVE(0), POOL_OCTAVE(1), POOL_OCTAVE(2), POOL_OCTAVE(3),
+    POOL_OCTAVE(4), POOL_OCTAVE(5), POOL_OCTAVE(6), POOL_OCTAVE(7),
+    POOL_SLAB(8, 4)
+};
+
+/* class of the smallest capacity >= "capacity", or -1 */
+static int pool_class(size_t capacity, size_t *class_capacity)
+{
+    size_t n;
+    unsigned k, q;
+
+    if (capacity == 0 || capacity > POOL_MAX_CAPACITY)
+        return -1;
+
+    /* octave k holds capacities above 2^(POOL_MIN_BITS + k) */
+    n = (capacity - 1) >> POOL_MIN_BITS;
+    if (n == 0) {
+        *class_capacity = POOL_CAPACITY(0, 4);
+        return 0;
+    }
+    for (k = 0; (n >> k) > 1; ++k)
+        ;
+    for (q = 5; q < 8; ++q) {
+        if (POOL_CAPACITY(k, q) >= capacity) {
+            *class_capacity = POOL_CAPACITY(k, q);
+            return (int)(k * 4 + q - 4);
+        }
+    }
+    *class_capacity = POOL_CAPACITY(k + 1, 4);
+    return (int)(k * 4 + 4);
+}
+
+/* class of a buffer whose capacity is exactly a class capacity, or -1 */
+static int pool_exact(size_t capacity)
+{
+    size_t class_capacity;
+    int i = pool_class(capacity, &class_capacity);
+    return (i >= 0 && class_capacity == capacity) ? i : -1;
+}
+
+/* capacity to ask for: the class capacity when there is one */
+static size_t pool_capacity(size_t capacity)
+{
+    size_t class_capacity;
+    return pool_class(capacity, &class_capacity) >= 0 ? class_capacity : capacity;
+}
+
 static
 rc_t allocate(buffer_impl_t **target, size_t capacity) {
-    buffer_impl_t *y = malloc(capacity + sizeof(*y));
+    buffer_impl_t *y;
+    size_t class_capacity;
+    int i = pool_class(capacity, &class_capacity);
+
+    if (i >= 0) {
+        capacity = class_capacity;
+        y = KSlabAlloc(&pool[i]);
+    }
+    else
+        y = malloc(capacity + sizeof(*y));
 
     if (y == NULL)
         return RC(rcRuntime, rcBuffer, rcAllocating, rcMemory, rcExhausted);
 
     y->allocated = capacity;
     atomic32_set(&y->refcount, 1);
+    y->view = 0;
     
 #if DEBUG_MALLOC_FREE
     y->foo = 0;
@@ -96,7 +187,19 @@ static void release(buffer_impl_t *self) {
         }
         self->foo = 55;
 #endif
-        free(self);
+        if (self->view) {
+            buffer_view_t *view = (buffer_view_t *)self;
+            if (view->whack != NULL)
+                view->whack(view->obj);
+            free(self);
+        }
+        else {
+            int i = pool_exact(self->allocated);
+            if (i >= 0)
+                KSlabFree(&pool[i], self);
+            else
+                free(self);
+        }
     }
 #if DEBUG_MALLOC_FREE
     else if (refcount < 1) {
@@ -112,6 +215,7 @@ static rc_t reallocate(buffer_impl_t **target, size_t capacity) {
 
     if (capacity <= self->allocated)
         return 0;
+    capacity = pool_capacity(capacity);
 
     /* check reference count for copies */
     if (atomic32_read(&self->refcount) <= 1)
@@ -140,7 +244,7 @@ static rc_t shrink(buffer_impl_t **target, size_t capacity)
 {
     buffer_impl_t *self = *target;
     
-    if (capacity < self->allocated && atomic32_read(&self->refcount) == 1) {
+    if (capacity < self->allocated && atomic32_read(&self->refcount) == 1 && !self->view) {
         buffer_impl_t *temp = realloc(self, capacity + sizeof(*temp));
         
         if (temp == NULL)
@@ -152,28 +256,33 @@ static rc_t shrink(buffer_impl_t **target, size_t capacity)
     return 0;
 }
 
+static void const *get_data(buffer_impl_t const *self)
+{
+    if (self->view)
+        return ((buffer_view_t const *)self)->data;
+    return &self[1];
+}
+
 /*
  either returns original with refcount == 2
  or returns new copy with refcount == 1
+ views are always copied
  */
 static buffer_impl_t* make_copy(buffer_impl_t *self) {
-    if (atomic32_read_and_add_eq(&self->refcount, 1, 1)==1)
+    if (!self->view && atomic32_read_and_add_eq(&self->refcount, 1, 1)==1)
         return self;
     else {
         buffer_impl_t *copy = malloc(self->allocated + sizeof(*self));
         if (copy) {
-            memcpy(copy, self, self->allocated + sizeof(*copy));
+            memcpy(copy, self, sizeof(*copy));
+            memcpy(&copy[1], get_data(self), self->allocated);
             atomic32_set(&copy->refcount, 1);
+            copy->view = 0;
         }
         return copy;
     }
 }
 
-static void const *get_data(buffer_impl_t const *self)
-{
-    return &self[1];
-}
-
 static void const *get_data_endp(buffer_impl_t const *self)
 {
     return (uint8_t const *)get_data(self) + self->allocated;
@@ -234,6 +343,42 @@ LIB_EXPORT rc_t CC KDataBufferMake(KDataBuffer *target, uint64_t elem_bits, uint
     return rc;
 }
 
+/* MakeView
+ *  create a buffer over memory owned by someone else
+ */
+LIB_EXPORT rc_t CC KDataBufferMakeView(KDataBuffer *target, const void *data, size_t bytes,
+    void ( CC * whack ) ( void *obj ), void *obj) {
+    buffer_view_t *view;
+
+    if (target == NULL)
+        return RC(rcRuntime, rcBuffer, rcConstructing, rcParam, rcNull);
+
+    memset (target, 0, sizeof(*target));
+
+    if (data == NULL && bytes != 0)
+        return RC(rcRuntime, rcBuffer, rcConstructing, rcParam, rcNull);
+
+    view = malloc(sizeof(*view));
+    if (view == NULL)
+        return RC(rcRuntime, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+
+    view->dad.allocated = bytes;
+    atomic32_set(&view->dad.refcount, 1);
+#if DEBUG_MALLOC_FREE
+    view->dad.foo = 0;
+#endif
+    view->dad.view = 1;
+    view->data = data;
+    view->whack = whack;
+    view->obj = obj;
+
+    target->ignore = &view->dad;
+    target->base = (void *)data;
+    target->elem_bits = 8;
+    target->elem_count = bytes;
+    return 0;
+}
+
 LIB_EXPORT rc_t CC KDataBufferResize(KDataBuffer *self, uint64_t new_count) {
     rc_t rc;
     buffer_impl_t *imp;
@@ -267,7 +412,7 @@ LIB_EXPORT rc_t CC KDataBufferResize(KDataBuffer *self, uint64_t new_count) {
         return rc;
     }
 
-    cur_end = &((const uint8_t *)imp)[imp->allocated + sizeof *imp];
+    cur_end = get_data_endp(imp);
     new_end = &((const uint8_t *)self->base)[(bits + self->bit_offset + 7) >> 3];
     if (cur_end >= new_end) {
         /* requested end-of-buffer is within current allocation; realloc not required */
@@ -275,6 +420,22 @@ LIB_EXPORT rc_t CC KDataBufferResize(KDataBuffer *self, uint64_t new_count) {
         return 0;
     }
 
+    new_size = roundup((bits + self->bit_offset + 7) / 8, 12);
+
+    if (imp->view) {
+        /* a view cannot grow, so its contents move to a buffer of its own */
+        rc = allocate(&new_imp, new_size);
+        if (rc == 0) {
+            memcpy((void *)get_data(new_imp), self->base,
+                (size_t)((self->elem_bits * self->elem_count + self->bit_offset + 7) >> 3));
+            release(imp);
+            self->base = (void *)get_data(new_imp);
+            self->ignore = new_imp;
+            self->elem_count = new_count;
+        }
+        return rc;
+    }
+
     if (!KDataBufferWritable(self))
         return RC(rcRuntime, rcBuffer, rcResizing, rcSelf, rcReadonly);
     
@@ -399,7 +560,7 @@ LIB_EXPORT rc_t CC KDataBufferMakeWritable (const KDataBuffer *cself, KDataBuffe
             }
             return RC(rcRuntime, rcBuffer, rcAllocating, rcMemory, rcExhausted);
         }
-        else if (atomic32_read(&self->refcount) == 1) {
+        else if (atomic32_read(&self->refcount) == 1 && !self->view) {
             /* sub-buffer but is only reference so let it be */
             if ((KDataBuffer const *)target != cself) {
                 *target = *cself;
@@ -447,6 +608,7 @@ LIB_EXPORT rc_t CC KDataBufferWhack (KDataBuffer *self)
 LIB_EXPORT bool CC KDataBufferWritable(const KDataBuffer *cself)
 {
     return (cself != NULL && cself->ignore != NULL &&
+            ((buffer_impl_t *)cself->ignore)->view == 0 &&
             atomic32_read(&((buffer_impl_t *)cself->ignore)->refcount) == 1) ? true : false;
 }
 
@@ -459,6 +621,44 @@ LIB_EXPORT rc_t CC KDataBufferShrink(KDataBuffer *self)
     return 0;
 }
 
+/* TrimPool
+ *  give the memory held by the payload pools back to the system
+ */
+LIB_EXPORT void CC KDataBufferTrimPool(void)
+{
+    int i;
+    for (i = 0; i < POOL_CLASSES; ++i)
+        KSlabTrim(&pool[i]);
+}
+
+/* SetPoolLimit
+ *  bound the bytes held by the payload pools, 0 to keep none
+ */
+LIB_EXPORT void CC KDataBufferSetPoolLimit(size_t bytes)
+{
+    pool_budget.limit = bytes > INT32_MAX ? INT32_MAX : (int32_t)bytes;
+    if (atomic32_read(&pool_budget.held) > pool_budget.limit)
+        KDataBufferTrimPool();
+}
+
+/* GetPoolStats
+ *  sum of the payload pools
+ */
+LIB_EXPORT void CC KDataBufferGetPoolStats(KSlabStats *stats)
+{
+    int i;
+    KSlabStats one;
+
+    if (stats == NULL)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    for (i = 0; i < POOL_CLASSES; ++i) {
+        KSlabGetStats(&pool[i], &one);
+        KSlabStatsAdd(stats, &one);
+    }
+}
+
 LIB_EXPORT size_t CC KDataBufferMemorySize(KDataBuffer const *self)
 {
     if (self && self->ignore) {
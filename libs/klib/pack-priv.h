@@ -0,0 +1,75 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_pack_priv_
+#define _h_pack_priv_
+
+#ifndef _h_klib_pack_
+#include <klib/pack.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * vector kernels
+ *  each converts a leading run of its input and returns the number
+ *  of elements converted, which may be 0. callers finish the rest
+ *  with the scalar code.
+ */
+
+/* PackSimd
+ *  "unpacked" in { 8, 16, 32 }, "packed" in { 1, 2, 4, 8 }
+ *  converts a multiple of 8 elements, so the rest starts on a byte.
+ *  "dst" may equal "src" but must not lie above it within it.
+ */
+uint32_t PackSimd ( uint32_t unpacked, uint32_t packed,
+    void *dst, const void *src, uint32_t count );
+
+/* UnpackSimd
+ *  "packed" in { 1, 2, 4, 8 }, "unpacked" in { 8, 16, 32 }
+ *  converts a multiple of 8 elements from a byte aligned "src".
+ *  "dst" and "src" must not overlap.
+ */
+uint32_t UnpackSimd ( uint32_t packed, uint32_t unpacked,
+    void *dst, const void *src, uint32_t count );
+
+/* VlenDecodeRun
+ *  decodes a leading run of 1 or 2 byte values
+ *  "sign" selects the vlen_decode format over vlen_decodeU
+ *  "consumed" [ OUT ] - source bytes used
+ */
+uint64_t VlenDecodeRun ( uint64_t *dst, uint64_t dcount,
+    const uint8_t *src, uint64_t ssize, bool sign, uint64_t *consumed );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_pack_priv_ */
@@ -0,0 +1,776 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include <klib/extern.h>
+#include <klib/pack.h>
+#include "pack-priv.h"
+
+#include <string.h>
+#include <assert.h>
+
+/* the kernels are compiled for their instruction set function by
+   function, so the library as a whole still runs on any x86 */
+#if defined __GNUC__ && ( defined __x86_64__ || defined __i386__ )
+#define PACK_SIMD 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__ ( ( target ( "sse4.1" ), always_inline ) ) inline
+#define TARGET_AVX2 __attribute__ ( ( target ( "avx2" ), always_inline ) ) inline
+#define KERNEL_SSE41 __attribute__ ( ( target ( "sse4.1" ) ) )
+#define KERNEL_AVX2 __attribute__ ( ( target ( "avx2" ) ) )
+#else
+#define PACK_SIMD 0
+#endif
+
+
+#if PACK_SIMD
+
+/*--------------------------------------------------------------------------
+ * VlenWindow
+ *  for each pattern of continuation bits in 8 source bytes, a shuffle
+ *  putting the leading 1 and 2 byte values into 16 bit lanes, first
+ *  byte high, with the number of values and of bytes they take
+ */
+typedef struct VlenWindow VlenWindow;
+struct VlenWindow
+{
+    uint8_t shuffle [ 16 ];
+    uint8_t count;
+    uint8_t bytes;
+};
+
+static VlenWindow vlen_window [ 256 ];
+static volatile bool vlen_window_ready;
+
+static
+void VlenWindowInit ( void )
+{
+    uint32_t m;
+
+    if ( vlen_window_ready )
+        return;
+
+    for ( m = 0; m < 256; ++ m )
+    {
+        VlenWindow *w = & vlen_window [ m ];
+        uint32_t pos, k;
+
+        memset ( w -> shuffle, 0x80, sizeof w -> shuffle );
+        for ( pos = k = 0; pos < 8; ++ k )
+        {
+            if ( ( m & ( 1U << pos ) ) == 0 )
+            {
+                w -> shuffle [ k * 2 ] = ( uint8_t ) pos;
+                pos += 1;
+            }
+            else if ( pos < 7 && ( m & ( 2U << pos ) ) == 0 )
+            {
+                w -> shuffle [ k * 2 ] = ( uint8_t ) ( pos + 1 );
+                w -> shuffle [ k * 2 + 1 ] = ( uint8_t ) pos;
+                pos += 2;
+            }
+            else
+            {
+                break;
+            }
+        }
+        w -> count = ( uint8_t ) k;
+        w -> bytes = ( uint8_t ) pos;
+    }
+
+    /* the table is complete before anyone sees a vector level */
+    __sync_synchronize ();
+    vlen_window_ready = true;
+}
+
+#endif /* PACK_SIMD */
+
+
+/*--------------------------------------------------------------------------
+ * KPackSimd
+ */
+static volatile int32_t pack_simd_level = -1;
+
+static
+KPackSimd PackSimdDetect ( void )
+{
+#if PACK_SIMD
+    __builtin_cpu_init ();
+    if ( __builtin_cpu_supports ( "sse4.1" ) )
+    {
+        VlenWindowInit ();
+        if ( __builtin_cpu_supports ( "avx2" ) )
+            return kpackAVX2;
+        return kpackSSE41;
+    }
+#endif
+    return kpackScalar;
+}
+
+/* PackSimdLevel
+ *  returns the level in use
+ */
+LIB_EXPORT KPackSimd CC PackSimdLevel ( void )
+{
+    int32_t level = pack_simd_level;
+    if ( level < 0 )
+        pack_simd_level = level = ( int32_t ) PackSimdDetect ();
+    return ( KPackSimd ) level;
+}
+
+/* PackSimdLimit
+ *  caps the level used from now on
+ */
+LIB_EXPORT KPackSimd CC PackSimdLimit ( KPackSimd limit )
+{
+    KPackSimd level = PackSimdDetect ();
+    if ( level > limit )
+        level = limit;
+    pack_simd_level = ( int32_t ) level;
+    return level;
+}
+
+
+#if PACK_SIMD
+
+/*--------------------------------------------------------------------------
+ * SSE4.1
+ *  16 elements at a time
+ */
+
+/* spread the 16 elements held in 2 * packed source bytes
+   over 16 bytes, first element first */
+static TARGET_SSE41
+__m128i UnpackBytesSSE41 ( const uint8_t *src, uint32_t packed )
+{
+    __m128i b, m;
+    uint32_t w;
+
+    switch ( packed )
+    {
+    case 1:
+    {
+        uint16_t h;
+        const __m128i bits = _mm_set_epi8 ( 1, 2, 4, 8, 16, 32, 64, -128,
+                                            1, 2, 4, 8, 16, 32, 64, -128 );
+        memcpy ( & h, src, sizeof h );
+        b = _mm_shuffle_epi8 ( _mm_cvtsi32_si128 ( h ),
+            _mm_set_epi8 ( 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 ) );
+        return _mm_min_epu8 ( _mm_and_si128 ( b, bits ), _mm_set1_epi8 ( 1 ) );
+    }
+    case 2:
+        memcpy ( & w, src, sizeof w );
+        b = _mm_cvtsi32_si128 ( ( int ) w );
+        m = _mm_set1_epi8 ( 3 );
+        return _mm_unpacklo_epi16 (
+            _mm_unpacklo_epi8 ( _mm_and_si128 ( _mm_srli_epi16 ( b, 6 ), m ),
+                                _mm_and_si128 ( _mm_srli_epi16 ( b, 4 ), m ) ),
+            _mm_unpacklo_epi8 ( _mm_and_si128 ( _mm_srli_epi16 ( b, 2 ), m ),
+                                _mm_and_si128 ( b, m ) ) );
+    case 4:
+        b = _mm_loadl_epi64 ( ( const __m128i* ) src );
+        m = _mm_set1_epi8 ( 15 );
+        return _mm_unpacklo_epi8 ( _mm_and_si128 ( _mm_srli_epi16 ( b, 4 ), m ),
+                                   _mm_and_si128 ( b, m ) );
+    }
+    return _mm_loadu_si128 ( ( const __m128i* ) src );
+}
+
+static TARGET_SSE41
+void UnpackStoreSSE41 ( uint8_t *dst, __m128i v, uint32_t unpacked )
+{
+    __m128i *d = ( __m128i* ) dst;
+
+    switch ( unpacked )
+    {
+    case 8:
+        _mm_storeu_si128 ( d, v );
+        break;
+    case 16:
+        _mm_storeu_si128 ( d, _mm_cvtepu8_epi16 ( v ) );
+        _mm_storeu_si128 ( d + 1, _mm_cvtepu8_epi16 ( _mm_srli_si128 ( v, 8 ) ) );
+        break;
+    case 32:
+        _mm_storeu_si128 ( d, _mm_cvtepu8_epi32 ( v ) );
+        _mm_storeu_si128 ( d + 1, _mm_cvtepu8_epi32 ( _mm_srli_si128 ( v, 4 ) ) );
+        _mm_storeu_si128 ( d + 2, _mm_cvtepu8_epi32 ( _mm_srli_si128 ( v, 8 ) ) );
+        _mm_storeu_si128 ( d + 3, _mm_cvtepu8_epi32 ( _mm_srli_si128 ( v, 12 ) ) );
+        break;
+    }
+}
+
+/* UNPACK_LOOP
+ *  UNPACK_LOOPS has a loop for each pair of widths,
+ *  so the helpers fold away
+ */
+#define UNPACK_LOOP( arch, packed, unpacked, dst, src, count )                      \
+    for ( i = 0; i < ( count ); i += ELEMS_ ## arch,                                \
+              src += ( ELEMS_ ## arch * packed ) >> 3,                              \
+              dst += ( ELEMS_ ## arch * unpacked ) >> 3 )                           \
+        UnpackStore ## arch ( dst, UnpackBytes ## arch ( src, packed ), unpacked )
+
+#define UNPACK_LOOPS( arch, packed, unpacked, dst, src, count )                     \
+    switch ( unpacked )                                                             \
+    {                                                                               \
+    case 8:                                                                         \
+        UNPACK_LOOP ( arch, packed, 8, dst, src, count );                           \
+        break;                                                                      \
+    case 16:                                                                        \
+        UNPACK_LOOP ( arch, packed, 16, dst, src, count );                          \
+        break;                                                                      \
+    case 32:                                                                        \
+        UNPACK_LOOP ( arch, packed, 32, dst, src, count );                          \
+        break;                                                                      \
+    }
+
+#define ELEMS_SSE41 16
+
+static KERNEL_SSE41
+uint32_t UnpackSSE41 ( uint32_t packed, uint32_t unpacked,
+    uint8_t *dst, const uint8_t *src, uint32_t count )
+{
+    uint32_t i;
+    count &= ~ ( uint32_t ) ( ELEMS_SSE41 - 1 );
+
+    switch ( packed )
+    {
+    case 1:
+        /* the byte table in unpack.c does as well at this width */
+        if ( unpacked == 8 )
+            return 0;
+        UNPACK_LOOPS ( SSE41, 1, unpacked, dst, src, count )
+        break;
+    case 2:
+        UNPACK_LOOPS ( SSE41, 2, unpacked, dst, src, count )
+        break;
+    case 4:
+        UNPACK_LOOPS ( SSE41, 4, unpacked, dst, src, count )
+        break;
+    case 8:
+        UNPACK_LOOPS ( SSE41, 8, unpacked, dst, src, count )
+        break;
+    }
+    return count;
+}
+
+/* gather 16 elements into 16 bytes; they are known to fit */
+static TARGET_SSE41
+__m128i PackLoadSSE41 ( const uint8_t *src, uint32_t unpacked )
+{
+    const __m128i *s = ( const __m128i* ) src;
+
+    switch ( unpacked )
+    {
+    case 16:
+        return _mm_packus_epi16 ( _mm_loadu_si128 ( s ), _mm_loadu_si128 ( s + 1 ) );
+    case 32:
+        return _mm_packus_epi16 (
+            _mm_packus_epi32 ( _mm_loadu_si128 ( s ), _mm_loadu_si128 ( s + 1 ) ),
+            _mm_packus_epi32 ( _mm_loadu_si128 ( s + 2 ), _mm_loadu_si128 ( s + 3 ) ) );
+    }
+    return _mm_loadu_si128 ( s );
+}
+
+static TARGET_SSE41
+void PackStoreSSE41 ( uint8_t *dst, __m128i v, uint32_t packed )
+{
+    uint32_t w;
+    uint16_t h;
+
+    switch ( packed )
+    {
+    case 1:
+        /* reverse each group of 8 so the first lands in the MSB */
+        v = _mm_shuffle_epi8 ( v, _mm_set_epi8 ( 8, 9, 10, 11, 12, 13, 14, 15,
+                                                 0, 1, 2, 3, 4, 5, 6, 7 ) );
+        h = ( uint16_t ) _mm_movemask_epi8 ( _mm_slli_epi16 ( v, 7 ) );
+        memcpy ( dst, & h, sizeof h );
+        break;
+    case 2:
+        v = _mm_maddubs_epi16 ( v, _mm_set1_epi16 ( 0x0104 ) );
+        v = _mm_madd_epi16 ( v, _mm_set1_epi32 ( 0x00010010 ) );
+        v = _mm_packus_epi16 ( _mm_packus_epi32 ( v, v ), v );
+        w = ( uint32_t ) _mm_cvtsi128_si32 ( v );
+        memcpy ( dst, & w, sizeof w );
+        break;
+    case 4:
+        v = _mm_maddubs_epi16 ( v, _mm_set1_epi16 ( 0x0110 ) );
+        _mm_storel_epi64 ( ( __m128i* ) dst, _mm_packus_epi16 ( v, v ) );
+        break;
+    case 8:
+        _mm_storeu_si128 ( ( __m128i* ) dst, v );
+        break;
+    }
+}
+
+#define PACK_LOOP( arch, unpacked, packed, dst, src, count )                        \
+    for ( i = 0; i < ( count ); i += ELEMS_ ## arch,                                \
+              src += ( ELEMS_ ## arch * unpacked ) >> 3,                            \
+              dst += ( ELEMS_ ## arch * packed ) >> 3 )                             \
+        PackStore ## arch ( dst, PackLoad ## arch ( src, unpacked ), packed )
+
+#define PACK_LOOPS( arch, unpacked, packed, dst, src, count )                       \
+    switch ( packed )                                                               \
+    {                                                                               \
+    case 1:                                                                         \
+        PACK_LOOP ( arch, unpacked, 1, dst, src, count );                           \
+        break;                                                                      \
+    case 2:                                                                         \
+        PACK_LOOP ( arch, unpacked, 2, dst, src, count );                           \
+        break;                                                                      \
+    case 4:                                                                         \
+        PACK_LOOP ( arch, unpacked, 4, dst, src, count );                           \
+        break;                                                                      \
+    case 8:                                                                         \
+        PACK_LOOP ( arch, unpacked, 8, dst, src, count );                           \
+        break;                                                                      \
+    }
+
+static KERNEL_SSE41
+uint32_t PackSSE41 ( uint32_t unpacked, uint32_t packed,
+    uint8_t *dst, const uint8_t *src, uint32_t count )
+{
+    uint32_t i;
+    count &= ~ ( uint32_t ) ( ELEMS_SSE41 - 1 );
+
+    switch ( unpacked )
+    {
+    case 8:
+        PACK_LOOPS ( SSE41, 8, packed, dst, src, count )
+        break;
+    case 16:
+        PACK_LOOPS ( SSE41, 16, packed, dst, src, count )
+        break;
+    case 32:
+        PACK_LOOPS ( SSE41, 32, packed, dst, src, count )
+        break;
+    }
+    return count;
+}
+
+/* write 16 single byte values */
+static TARGET_SSE41
+void VlenStore1SSE41 ( uint64_t *dst, __m128i v, bool sign )
+{
+    __m128i *d = ( __m128i* ) dst;
+    __m128i s = _mm_setzero_si128 ();
+    int k;
+
+    if ( sign )
+    {
+        const __m128i sbit = _mm_set1_epi8 ( 0x40 );
+        s = _mm_cmpeq_epi8 ( _mm_and_si128 ( v, sbit ), sbit );
+        v = _mm_and_si128 ( v, _mm_set1_epi8 ( 0x3F ) );
+    }
+    for ( k = 0; k < 8; ++ k )
+    {
+        __m128i y = _mm_cvtepu8_epi64 ( v );
+        if ( sign )
+        {
+            __m128i n = _mm_cvtepi8_epi64 ( s );
+            y = _mm_sub_epi64 ( _mm_xor_si128 ( y, n ), n );
+            s = _mm_srli_si128 ( s, 2 );
+        }
+        _mm_storeu_si128 ( d + k, y );
+        v = _mm_srli_si128 ( v, 2 );
+    }
+}
+
+/* the values of one window in 16 bit lanes, signed if asked */
+static TARGET_SSE41
+__m128i VlenLanesSSE41 ( __m128i v, const VlenWindow *w, bool sign )
+{
+    __m128i x = _mm_shuffle_epi8 ( v, _mm_loadu_si128 ( ( const __m128i* ) w -> shuffle ) );
+    __m128i u = _mm_or_si128 (
+        _mm_and_si128 ( _mm_srli_epi16 ( x, 1 ), _mm_set1_epi16 ( 0x3F80 ) ),
+        _mm_and_si128 ( x, _mm_set1_epi16 ( 0x7F ) ) );
+
+    if ( sign )
+    {
+        /* the sign follows the continuation bit of the first byte,
+           which only 2 byte values have in the high half */
+        __m128i sbit = _mm_blendv_epi8 ( _mm_set1_epi16 ( 0x40 ),
+            _mm_set1_epi16 ( 0x2000 ), _mm_srai_epi16 ( x, 15 ) );
+        __m128i neg = _mm_cmpeq_epi16 ( _mm_and_si128 ( u, sbit ), sbit );
+        u = _mm_andnot_si128 ( sbit, u );
+        u = _mm_sub_epi16 ( _mm_xor_si128 ( u, neg ), neg );
+    }
+    return u;
+}
+
+/* write 8 values of a window */
+static TARGET_SSE41
+void VlenStore2SSE41 ( uint64_t *dst, __m128i v, const VlenWindow *w, bool sign )
+{
+    __m128i *d = ( __m128i* ) dst;
+    __m128i u = VlenLanesSSE41 ( v, w, sign );
+    int k;
+
+    for ( k = 0; k < 4; ++ k )
+    {
+        _mm_storeu_si128 ( d + k, sign ? _mm_cvtepi16_epi64 ( u ) : _mm_cvtepu16_epi64 ( u ) );
+        u = _mm_srli_si128 ( u, 4 );
+    }
+}
+
+/* VLEN_RUN
+ *  looks at 16 source bytes at a time. when none has the continuation
+ *  bit they are 16 values; otherwise the leading 1 and 2 byte values
+ *  of the first 8 are taken as "vlen_window" lays them out. a window
+ *  always writes 8 values, since the destination has room, but only
+ *  those it found are kept.
+ */
+#define VLEN_RUN( arch, dst, dcount, src, ssize, sign, consumed )               \
+    uint64_t i = 0, j = 0;                                                      \
+    while ( ssize - i >= 16 && dcount - j >= 8 )                                \
+    {                                                                           \
+        __m128i v = _mm_loadu_si128 ( ( const __m128i* ) ( src + i ) );         \
+        uint32_t m = ( uint32_t ) _mm_movemask_epi8 ( v );                      \
+        if ( m == 0 && dcount - j >= 16 )                                       \
+        {                                                                       \
+            VlenStore1 ## arch ( dst + j, v, sign );                            \
+            i += 16;                                                            \
+            j += 16;                                                            \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            const VlenWindow *w = & vlen_window [ m & 0xFF ];                   \
+            if ( w -> count == 0 )                                              \
+                break;                                                          \
+            VlenStore2 ## arch ( dst + j, v, w, sign );                         \
+            i += w -> bytes;                                                    \
+            j += w -> count;                                                    \
+        }                                                                       \
+    }                                                                           \
+    * consumed = i;                                                             \
+    return j
+
+static KERNEL_SSE41
+uint64_t VlenRunSSE41 ( uint64_t *dst, uint64_t dcount,
+    const uint8_t *src, uint64_t ssize, bool sign, uint64_t *consumed )
+{
+    VLEN_RUN ( SSE41, dst, dcount, src, ssize, sign, consumed );
+}
+
+
+/*--------------------------------------------------------------------------
+ * AVX2
+ *  32 elements at a time, as two 16 element halves in the lanes
+ */
+
+static TARGET_AVX2
+__m256i Lanes ( __m128i lo, __m128i hi )
+{
+    return _mm256_inserti128_si256 ( _mm256_castsi128_si256 ( lo ), hi, 1 );
+}
+
+static TARGET_AVX2
+__m256i UnpackBytesAVX2 ( const uint8_t *src, uint32_t packed )
+{
+    __m256i b, m;
+    uint32_t w [ 2 ];
+
+    switch ( packed )
+    {
+    case 1:
+    {
+        uint16_t h [ 2 ];
+        const __m256i bits = _mm256_set_epi8 (
+            1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+            1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+        memcpy ( h, src, sizeof h );
+        b = Lanes ( _mm_cvtsi32_si128 ( h [ 0 ] ), _mm_cvtsi32_si128 ( h [ 1 ] ) );
+        b = _mm256_shuffle_epi8 ( b, _mm256_set_epi8 (
+            1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+            1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 ) );
+        return _mm256_min_epu8 ( _mm256_and_si256 ( b, bits ), _mm256_set1_epi8 ( 1 ) );
+    }
+    case 2:
+        memcpy ( w, src, sizeof w );
+        b = Lanes ( _mm_cvtsi32_si128 ( ( int ) w [ 0 ] ), _mm_cvtsi32_si128 ( ( int ) w [ 1 ] ) );
+        m = _mm256_set1_epi8 ( 3 );
+        return _mm256_unpacklo_epi16 (
+            _mm256_unpacklo_epi8 ( _mm256_and_si256 ( _mm256_srli_epi16 ( b, 6 ), m ),
+                                   _mm256_and_si256 ( _mm256_srli_epi16 ( b, 4 ), m ) ),
+            _mm256_unpacklo_epi8 ( _mm256_and_si256 ( _mm256_srli_epi16 ( b, 2 ), m ),
+                                   _mm256_and_si256 ( b, m ) ) );
+    case 4:
+        b = Lanes ( _mm_loadl_epi64 ( ( const __m128i* ) src ),
+                    _mm_loadl_epi64 ( ( const __m128i* ) ( src + 8 ) ) );
+        m = _mm256_set1_epi8 ( 15 );
+        return _mm256_unpacklo_epi8 ( _mm256_and_si256 ( _mm256_srli_epi16 ( b, 4 ), m ),
+                                      _mm256_and_si256 ( b, m ) );
+    }
+    return _mm256_loadu_si256 ( ( const __m256i* ) src );
+}
+
+static TARGET_AVX2
+void UnpackStoreAVX2 ( uint8_t *dst, __m256i v, uint32_t unpacked )
+{
+    __m256i *d = ( __m256i* ) dst;
+    __m128i lo = _mm256_castsi256_si128 ( v );
+    __m128i hi = _mm256_extracti128_si256 ( v, 1 );
+
+    switch ( unpacked )
+    {
+    case 8:
+        _mm256_storeu_si256 ( d, v );
+        break;
+    case 16:
+        _mm256_storeu_si256 ( d, _mm256_cvtepu8_epi16 ( lo ) );
+        _mm256_storeu_si256 ( d + 1, _mm256_cvtepu8_epi16 ( hi ) );
+        break;
+    case 32:
+        _mm256_storeu_si256 ( d, _mm256_cvtepu8_epi32 ( lo ) );
+        _mm256_storeu_si256 ( d + 1, _mm256_cvtepu8_epi32 ( _mm_srli_si128 ( lo, 8 ) ) );
+        _mm256_storeu_si256 ( d + 2, _mm256_cvtepu8_epi32 ( hi ) );
+        _mm256_storeu_si256 ( d + 3, _mm256_cvtepu8_epi32 ( _mm_srli_si128 ( hi, 8 ) ) );
+        break;
+    }
+}
+
+#define ELEMS_AVX2 32
+
+static KERNEL_AVX2
+uint32_t UnpackAVX2 ( uint32_t packed, uint32_t unpacked,
+    uint8_t *dst, const uint8_t *src, uint32_t count )
+{
+    uint32_t i;
+    count &= ~ ( uint32_t ) ( ELEMS_AVX2 - 1 );
+
+    switch ( packed )
+    {
+    case 1:
+        UNPACK_LOOPS ( AVX2, 1, unpacked, dst, src, count )
+        break;
+    case 2:
+        UNPACK_LOOPS ( AVX2, 2, unpacked, dst, src, count )
+        break;
+    case 4:
+        UNPACK_LOOPS ( AVX2, 4, unpacked, dst, src, count )
+        break;
+    case 8:
+        UNPACK_LOOPS ( AVX2, 8, unpacked, dst, src, count )
+        break;
+    }
+    return count;
+}
+
+/* the in-lane packs interleave their halves; the permutes
+   put the 32 bytes back in element order */
+static TARGET_AVX2
+__m256i PackLoadAVX2 ( const uint8_t *src, uint32_t unpacked )
+{
+    const __m256i *s = ( const __m256i* ) src;
+    __m256i v;
+
+    switch ( unpacked )
+    {
+    case 16:
+        v = _mm256_packus_epi16 ( _mm256_loadu_si256 ( s ), _mm256_loadu_si256 ( s + 1 ) );
+        return _mm256_permute4x64_epi64 ( v, 0xD8 );
+    case 32:
+        v = _mm256_packus_epi16 (
+            _mm256_packus_epi32 ( _mm256_loadu_si256 ( s ), _mm256_loadu_si256 ( s + 1 ) ),
+            _mm256_packus_epi32 ( _mm256_loadu_si256 ( s + 2 ), _mm256_loadu_si256 ( s + 3 ) ) );
+        return _mm256_permutevar8x32_epi32 ( v, _mm256_setr_epi32 ( 0, 4, 1, 5, 2, 6, 3, 7 ) );
+    }
+    return _mm256_loadu_si256 ( s );
+}
+
+static TARGET_AVX2
+void PackStoreAVX2 ( uint8_t *dst, __m256i v, uint32_t packed )
+{
+    uint32_t w [ 2 ];
+
+    switch ( packed )
+    {
+    case 1:
+        v = _mm256_shuffle_epi8 ( v, _mm256_set_epi8 (
+            8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+            8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 ) );
+        w [ 0 ] = ( uint32_t ) _mm256_movemask_epi8 ( _mm256_slli_epi16 ( v, 7 ) );
+        memcpy ( dst, w, sizeof w [ 0 ] );
+        break;
+    case 2:
+        v = _mm256_maddubs_epi16 ( v, _mm256_set1_epi16 ( 0x0104 ) );
+        v = _mm256_madd_epi16 ( v, _mm256_set1_epi32 ( 0x00010010 ) );
+        v = _mm256_packus_epi16 ( _mm256_packus_epi32 ( v, v ), v );
+        w [ 0 ] = ( uint32_t ) _mm_cvtsi128_si32 ( _mm256_castsi256_si128 ( v ) );
+        w [ 1 ] = ( uint32_t ) _mm_cvtsi128_si32 ( _mm256_extracti128_si256 ( v, 1 ) );
+        memcpy ( dst, w, sizeof w );
+        break;
+    case 4:
+        v = _mm256_maddubs_epi16 ( v, _mm256_set1_epi16 ( 0x0110 ) );
+        v = _mm256_permute4x64_epi64 ( _mm256_packus_epi16 ( v, v ), 0x08 );
+        _mm_storeu_si128 ( ( __m128i* ) dst, _mm256_castsi256_si128 ( v ) );
+        break;
+    case 8:
+        _mm256_storeu_si256 ( ( __m256i* ) dst, v );
+        break;
+    }
+}
+
+static KERNEL_AVX2
+uint32_t PackAVX2 ( uint32_t unpacked, uint32_t packed,
+    uint8_t *dst, const uint8_t *src, uint32_t count )
+{
+    uint32_t i;
+    count &= ~ ( uint32_t ) ( ELEMS_AVX2 - 1 );
+
+    switch ( unpacked )
+    {
+    case 8:
+        PACK_LOOPS ( AVX2, 8, packed, dst, src, count )
+        break;
+    case 16:
+        PACK_LOOPS ( AVX2, 16, packed, dst, src, count )
+        break;
+    case 32:
+        PACK_LOOPS ( AVX2, 32, packed, dst, src, count )
+        break;
+    }
+    return count;
+}
+
+static TARGET_AVX2
+void VlenStore1AVX2 ( uint64_t *dst, __m128i v, bool sign )
+{
+    __m256i *d = ( __m256i* ) dst;
+    __m128i s = _mm_setzero_si128 ();
+    int k;
+
+    if ( sign )
+    {
+        const __m128i sbit = _mm_set1_epi8 ( 0x40 );
+        s = _mm_cmpeq_epi8 ( _mm_and_si128 ( v, sbit ), sbit );
+        v = _mm_and_si128 ( v, _mm_set1_epi8 ( 0x3F ) );
+    }
+    for ( k = 0; k < 4; ++ k )
+    {
+        __m256i y = _mm256_cvtepu8_epi64 ( v );
+        if ( sign )
+        {
+            __m256i n = _mm256_cvtepi8_epi64 ( s );
+            y = _mm256_sub_epi64 ( _mm256_xor_si256 ( y, n ), n );
+            s = _mm_srli_si128 ( s, 4 );
+        }
+        _mm256_storeu_si256 ( d + k, y );
+        v = _mm_srli_si128 ( v, 4 );
+    }
+}
+
+static TARGET_AVX2
+void VlenStore2AVX2 ( uint64_t *dst, __m128i v, const VlenWindow *w, bool sign )
+{
+    __m256i *d = ( __m256i* ) dst;
+    __m128i u = VlenLanesSSE41 ( v, w, sign );
+
+    if ( sign )
+    {
+        _mm256_storeu_si256 ( d, _mm256_cvtepi16_epi64 ( u ) );
+        _mm256_storeu_si256 ( d + 1, _mm256_cvtepi16_epi64 ( _mm_srli_si128 ( u, 8 ) ) );
+    }
+    else
+    {
+        _mm256_storeu_si256 ( d, _mm256_cvtepu16_epi64 ( u ) );
+        _mm256_storeu_si256 ( d + 1, _mm256_cvtepu16_epi64 ( _mm_srli_si128 ( u, 8 ) ) );
+    }
+}
+
+static KERNEL_AVX2
+uint64_t VlenRunAVX2 ( uint64_t *dst, uint64_t dcount,
+    const uint8_t *src, uint64_t ssize, bool sign, uint64_t *consumed )
+{
+    VLEN_RUN ( AVX2, dst, dcount, src, ssize, sign, consumed );
+}
+
+#endif /* PACK_SIMD */
+
+
+/*--------------------------------------------------------------------------
+ * dispatch
+ */
+
+/* PackSimd
+ *  converts a leading multiple of 8 elements
+ */
+uint32_t PackSimd ( uint32_t unpacked, uint32_t packed,
+    void *dst, const void *src, uint32_t count )
+{
+#if PACK_SIMD
+    if ( unpacked > 32 || packed > 8 || ( packed & ( packed - 1 ) ) != 0 )
+        return 0;
+
+    switch ( PackSimdLevel () )
+    {
+    case kpackAVX2:
+        return PackAVX2 ( unpacked, packed, dst, src, count );
+    case kpackSSE41:
+        return PackSSE41 ( unpacked, packed, dst, src, count );
+    }
+#endif
+    return 0;
+}
+
+/* UnpackSimd
+ *  converts a leading multiple of 8 elements
+ */
+uint32_t UnpackSimd ( uint32_t packed, uint32_t unpacked,
+    void *dst, const void *src, uint32_t count )
+{
+#if PACK_SIMD
+    if ( unpacked > 32 || packed > 8 || ( packed & ( packed - 1 ) ) != 0 )
+        return 0;
+
+    switch ( PackSimdLevel () )
+    {
+    case kpackAVX2:
+        return UnpackAVX2 ( packed, unpacked, dst, src, count );
+    case kpackSSE41:
+        return UnpackSSE41 ( packed, unpacked, dst, src, count );
+    }
+#endif
+    return 0;
+}
+
+/* VlenDecodeRun
+ *  decodes a leading run of 1 or 2 byte values
+ */
+uint64_t VlenDecodeRun ( uint64_t *dst, uint64_t dcount,
+    const uint8_t *src, uint64_t ssize, bool sign, uint64_t *consumed )
+{
+    * consumed = 0;
+#if PACK_SIMD
+    switch ( PackSimdLevel () )
+    {
+    case kpackAVX2:
+        return VlenRunAVX2 ( dst, dcount, src, ssize, sign, consumed );
+    case kpackSSE41:
+        return VlenRunSSE41 ( dst, dcount, src, ssize, sign, consumed );
+    }
+#endif
+    return 0;
+}
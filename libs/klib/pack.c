@@ -27,6 +27,7 @@
 #include <klib/extern.h>
 #include <klib/pack.h>
 #include <klib/rc.h>
+#include "pack-priv.h"
 #include <arch-impl.h>
 #include <sysalloc.h>
 
@@ -494,6 +495,22 @@ LIB_EXPORT rc_t CC Pack ( uint32_t unpacked, uint32_t packed,
     if ( dst_off != 0 )
         return RC ( rcXF, rcBuffer, rcPacking, rcOffset, rcUnsupported );
 
+    /* vector kernels take the leading elements of the common widths,
+       moving forward like the code below, so "dst" may not lie above
+       "src" within it */
+    if ( ( char* ) dst <= ( const char* ) src ||
+         ( char* ) dst >= ( const char* ) src + ssize )
+    {
+        uint32_t done = PackSimd ( unpacked, packed, dst, src,
+            ( uint32_t ) ( ssize / ( unpacked >> 3 ) ) );
+        if ( done != 0 )
+        {
+            src = & ( ( const char* ) src ) [ ( ( size_t ) done * unpacked ) >> 3 ];
+            dst = & ( ( char* ) dst ) [ ( ( size_t ) done * packed ) >> 3 ];
+            ssize -= ( ( size_t ) done * unpacked ) >> 3;
+        }
+    }
+
     switch ( unpacked )
     {
     case 8:
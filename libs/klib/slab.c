@@ -0,0 +1,230 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <klib/extern.h>
+#include <klib/slab.h>
+#include <atomic32.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*--------------------------------------------------------------------------
+ * KSlab
+ */
+
+/* threads are told apart by their stacks, which lie at least
+   a megabyte apart; the shard is only a hint, not an owner */
+static
+uint32_t KSlabHome ( void )
+{
+    volatile int here;
+    size_t h = ( size_t ) & here >> 20;
+    h ^= h >> 5;
+    return ( uint32_t ) ( h % KSLAB_SHARDS );
+}
+
+static
+KSlabShard *KSlabLock ( KSlab *self )
+{
+    uint32_t i, home = KSlabHome ();
+    for ( i = 0; i < KSLAB_SHARDS; ++ i )
+    {
+        KSlabShard *shard = & self -> shard [ ( home + i ) % KSLAB_SHARDS ];
+        if ( atomic32_test_and_set ( & shard -> busy, 1, 0 ) == 0 )
+            return shard;
+    }
+    atomic32_inc ( & self -> bypass );
+    return NULL;
+}
+
+static
+void KSlabUnlock ( KSlabShard *shard )
+{
+    atomic32_test_and_set ( & shard -> busy, 0, 1 );
+}
+
+
+/* Alloc
+ *  returns an uninitialized object or NULL
+ */
+LIB_EXPORT void * CC KSlabAlloc ( KSlab *self )
+{
+    void *obj = NULL;
+    KSlabShard *shard;
+
+    assert ( self != NULL );
+    assert ( self -> size >= sizeof ( void* ) );
+
+    shard = KSlabLock ( self );
+    if ( shard != NULL )
+    {
+        obj = shard -> head;
+        if ( obj != NULL )
+        {
+            shard -> head = * ( void * volatile * ) obj;
+            -- shard -> count;
+            ++ shard -> hits;
+            if ( self -> budget != NULL )
+                atomic32_add ( & self -> budget -> held, - ( int ) self -> size );
+        }
+        else
+        {
+            ++ shard -> misses;
+        }
+        KSlabUnlock ( shard );
+    }
+
+    if ( obj == NULL )
+        obj = malloc ( self -> size );
+
+    return obj;
+}
+
+
+/* Reserve
+ *  account for an object about to be held, if the budget allows
+ */
+static
+bool KSlabReserve ( KSlab *self )
+{
+    KSlabBudget *budget = self -> budget;
+    if ( budget == NULL )
+        return true;
+    return atomic32_add_if_le ( & budget -> held,
+        ( int ) self -> size, budget -> limit - ( int ) self -> size );
+}
+
+
+/* Free
+ *  return an object to the pool
+ */
+LIB_EXPORT void CC KSlabFree ( KSlab *self, void *obj )
+{
+    KSlabShard *shard;
+
+    assert ( self != NULL );
+
+    if ( obj == NULL )
+        return;
+
+    shard = KSlabLock ( self );
+    if ( shard != NULL )
+    {
+        if ( shard -> count < self -> limit && KSlabReserve ( self ) )
+        {
+            * ( void * volatile * ) obj = shard -> head;
+            shard -> head = obj;
+            ++ shard -> count;
+            ++ shard -> recycled;
+            obj = NULL;
+        }
+        else
+        {
+            ++ shard -> released;
+        }
+        KSlabUnlock ( shard );
+    }
+
+    free ( obj );
+}
+
+
+/* Trim
+ *  give every object held to the system
+ */
+LIB_EXPORT void CC KSlabTrim ( KSlab *self )
+{
+    uint32_t i;
+
+    if ( self == NULL )
+        return;
+
+    for ( i = 0; i < KSLAB_SHARDS; ++ i )
+    {
+        KSlabShard *shard = & self -> shard [ i ];
+        if ( atomic32_test_and_set ( & shard -> busy, 1, 0 ) == 0 )
+        {
+            void *obj = shard -> head;
+            uint32_t count = shard -> count;
+
+            shard -> head = NULL;
+            shard -> count = 0;
+            shard -> released += count;
+            KSlabUnlock ( shard );
+
+            if ( self -> budget != NULL )
+                atomic32_add ( & self -> budget -> held, - ( int ) ( self -> size * count ) );
+
+            while ( obj != NULL )
+            {
+                void *next = * ( void * volatile * ) obj;
+                free ( obj );
+                obj = next;
+            }
+        }
+    }
+}
+
+
+/* GetStats
+ *  counters are read without taking the shards
+ */
+LIB_EXPORT void CC KSlabGetStats ( const KSlab *self, KSlabStats *stats )
+{
+    uint32_t i;
+
+    assert ( stats != NULL );
+    memset ( stats, 0, sizeof * stats );
+
+    if ( self != NULL )
+    {
+        for ( i = 0; i < KSLAB_SHARDS; ++ i )
+        {
+            const KSlabShard *shard = & self -> shard [ i ];
+            stats -> hits += shard -> hits;
+            stats -> misses += shard -> misses;
+            stats -> recycled += shard -> recycled;
+            stats -> released += shard -> released;
+            stats -> cached += shard -> count;
+        }
+        stats -> bypass = ( uint32_t ) atomic32_read ( & self -> bypass );
+    }
+}
+
+LIB_EXPORT void CC KSlabStatsAdd ( KSlabStats *sum, const KSlabStats *stats )
+{
+    assert ( sum != NULL && stats != NULL );
+
+    sum -> hits += stats -> hits;
+    sum -> misses += stats -> misses;
+    sum -> recycled += stats -> recycled;
+    sum -> released += stats -> released;
+    sum -> cached += stats -> cached;
+    sum -> bypass += stats -> bypass;
+}
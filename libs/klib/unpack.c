@@ -27,6 +27,7 @@
 #include <klib/extern.h>
 #include <klib/pack.h>
 #include <klib/rc.h>
+#include "pack-priv.h"
 #include <arch-impl.h>
 #include <sysalloc.h>
 
@@ -810,6 +811,27 @@ LIB_EXPORT rc_t CC Unpack ( uint32_t packed, uint32_t unpacked,
     if ( src_off != 0 )
         return RC ( rcXF, rcBuffer, rcUnpacking, rcOffset, rcUnsupported );
 
+    /* vector kernels take the leading elements of the common widths.
+       they move forward, so the buffers must be apart, and the source
+       must hold exactly "count" elements for the code below to agree */
+    if ( ssize == ( bitsz_t ) count * packed )
+    {
+        const char *s = src;
+        char *d = dst;
+
+        if ( d >= s + ( ( ssize + 7 ) >> 3 ) || d + * usize <= s )
+        {
+            uint32_t done = UnpackSimd ( packed, unpacked, dst, src, count );
+            if ( done == count )
+                return 0;
+
+            src = s + ( ( ( size_t ) done * packed ) >> 3 );
+            dst = d + ( ( ( size_t ) done * unpacked ) >> 3 );
+            ssize -= ( bitsz_t ) done * packed;
+            count -= done;
+        }
+    }
+
     switch ( unpacked )
     {
     case 8:
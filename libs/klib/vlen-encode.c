@@ -27,6 +27,8 @@
 #include <klib/extern.h>
 #include <klib/vlen-encode.h>
 #include <klib/rc.h>
+#include <klib/pack.h>
+#include "pack-priv.h"
 #include <sysalloc.h>
 
 #include <byteswap.h>
@@ -305,6 +307,7 @@ LIB_EXPORT rc_t CC vlen_decode ( int64_t *Y, uint64_t ycount,
     const void *Src, uint64_t ssize, uint64_t *consumed ) {
     const uint8_t *src = Src;
     uint64_t i, j;
+    bool runs;
     
     if (Y == NULL || Src == NULL)
         return RC(rcXF, rcFunction, rcExecuting, rcParam, rcNull);
@@ -313,9 +316,21 @@ LIB_EXPORT rc_t CC vlen_decode ( int64_t *Y, uint64_t ycount,
     if (ssize < ycount)
         return RC(rcXF, rcFunction, rcExecuting, rcData, rcInsufficient);
     
+    runs = ycount >= 8 && PackSimdLevel() != kpackScalar;
     for (i = 0, j = 0; j != ycount && i + 10 < ssize; ++j) {
         int64_t y;
         int sgn;
+
+        /* runs of 1 and 2 byte values go to the vector kernels */
+        if (runs && i + 16 <= ssize && (src[i] & src[i + 1] & 0x80) == 0) {
+            uint64_t n;
+            uint64_t m = VlenDecodeRun((uint64_t *)Y + j, ycount - j, src + i, ssize - i, true, &n);
+            if (m != 0) {
+                i += n;
+                j += m - 1;
+                continue;
+            }
+        }
 #define XTYPE_SIZE 64
 #if XTYPE_SIZE == 64
 #define XTYPE uint64_t
@@ -692,6 +707,7 @@ LIB_EXPORT rc_t CC vlen_decodeU ( uint64_t Y[], uint64_t ycount,
     const void *Src, uint64_t ssize, uint64_t *consumed ) {
     const uint8_t *src = Src;
     uint64_t i, j;
+    bool runs;
     
     if (Y == NULL || Src == NULL)
         return RC(rcXF, rcFunction, rcExecuting, rcParam, rcNull);
@@ -700,9 +716,21 @@ LIB_EXPORT rc_t CC vlen_decodeU ( uint64_t Y[], uint64_t ycount,
     if (ssize < ycount)
         return RC(rcXF, rcFunction, rcExecuting, rcData, rcInsufficient);
     
+    runs = ycount >= 8 && PackSimdLevel() != kpackScalar;
     for (j = i = 0; j != ycount; ++j) {
         uint64_t n;
-        rc_t rc = vlen_decodeU1_imp(Y + j, src + i, ssize - i, &n);
+        rc_t rc;
+
+        /* runs of 1 and 2 byte values go to the vector kernels */
+        if (runs && i + 16 <= ssize && (src[i] & src[i + 1] & 0x80) == 0) {
+            uint64_t m = VlenDecodeRun(Y + j, ycount - j, src + i, ssize - i, false, &n);
+            if (m != 0) {
+                i += n;
+                j += m - 1;
+                continue;
+            }
+        }
+        rc = vlen_decodeU1_imp(Y + j, src + i, ssize - i, &n);
         if (rc)
             return rc;
         i += n;
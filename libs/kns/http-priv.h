@@ -51,6 +51,10 @@
 #define MAX_HTTP_WRITE_LIMIT ( 15 * 1000 )
 #endif
 
+#ifndef MAX_HTTP_FILE_CONNECTIONS
+#define MAX_HTTP_FILE_CONNECTIONS 16
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
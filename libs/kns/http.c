@@ -52,6 +52,9 @@ typedef struct KHttpFile KHttpFile;
 #include <klib/printf.h>
 #include <klib/vector.h>
 #include <kproc/timeout.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+#include <kproc/thread.h>
 
 #include <os-native.h>
 #include <strtol.h>
@@ -2848,6 +2851,47 @@ LIB_EXPORT rc_t CC KHttpRequestPOST ( KHttpRequest *self, KHttpResult **_rslt )
  * KHttpFile
  */
 
+/* unit of parallel and read-ahead requests */
+#define KHTTP_FILE_CHUNK_SIZE ( 256 * 1024 )
+
+/* consecutive sequential reads before reading ahead */
+#define KHTTP_FILE_MIN_SEQ 2
+
+enum
+{
+    khcQueued,
+    khcRunning,
+    khcDone
+};
+
+/* KHttpFileChunk
+ *  a range of the file fetched by a worker, either a part of a
+ *  large read going into the caller's buffer, linked into "queue",
+ *  or read ahead into its own storage, linked into "ahead"
+ */
+typedef struct KHttpFileChunk KHttpFileChunk;
+struct KHttpFileChunk
+{
+    DLNode dad;
+
+    uint64_t pos;
+    size_t size;
+    size_t num_read;
+    uint8_t *buffer;
+    rc_t rc;
+    uint32_t state;
+
+    /* read-ahead chunk no longer wanted: worker frees it */
+    bool abandoned;
+};
+
+static
+void CC KHttpFileChunkWhack ( DLNode *n, void *ignore )
+{
+    free ( n );
+}
+
+typedef struct KHttpFileWorker KHttpFileWorker;
 
 struct KHttpFile
 {
@@ -2859,11 +2903,267 @@ struct KHttpFile
 
     String url;
     KDataBuffer url_buffer;
+
+    /* parallel reads, NULL lock if not enabled */
+    KLock *lock;
+    KCondition *work;           /* signaled when a chunk is queued or on shutdown */
+    KCondition *done;           /* broadcast when a chunk completes */
+
+    DLList queue;               /* parts of a large read waiting for a worker */
+    DLList ahead;               /* chunks read ahead, in file order */
+    uint32_t ahead_queued;      /* of which waiting for a worker */
+
+    KHttpFileWorker *worker;
+    uint32_t max_workers;
+    uint32_t num_workers;
+
+    /* bytes held in "ahead" and limit */
+    size_t ahead_size;
+    size_t ahead_limit;
+
+    /* sequential access detection */
+    uint64_t last_end;
+    uint32_t seq;
+
+    bool shutdown;
+};
+
+/* KHttpFileWorker
+ *  a thread with its own keep-alive connection
+ */
+struct KHttpFileWorker
+{
+    KHttpFile *file;
+    KThread *t;
+    KHttp *http;
+
+    /* private copy, as making a connection writes into it */
+    KDataBuffer url_buffer;
 };
 
+static
+rc_t KHttpFileReadRange ( KHttp *http, const char *url, uint64_t pos,
+    void *buffer, size_t bsize, size_t *num_read, struct timeout_t *tm )
+{
+    KHttpRequest *req;
+    rc_t rc = KHttpMakeRequest ( http, &req, url );
+
+    * num_read = 0;
+
+    if ( rc == 0 )
+    {
+        /* request min ( bsize, file_size ) bytes */
+        rc = KHttpRequestByteRange ( req, pos, bsize );
+        if ( rc == 0 )
+        {
+            KHttpResult *rslt;
+            
+            rc = KHttpRequestGET ( req, &rslt );
+            if ( rc == 0 )
+            {
+                uint32_t code;
+                
+                /* dont need to know what the response message was */
+                rc = KHttpResultStatus ( rslt, &code, NULL, 0, NULL );
+                if ( rc == 0 )
+                {
+                    switch ( code )
+                    {
+                    case 206:
+                    {
+                        uint64_t start_pos;
+                        size_t result_size;
+
+                        /* extract actual amount being returned by server */
+                        rc = KHttpResultRange ( rslt, &start_pos, &result_size );
+                        if ( rc == 0 && 
+                             start_pos == pos &&
+                             result_size == bsize )
+                        {
+                            KStream *response;
+                            
+                            rc = KHttpResultGetInputStream ( rslt, &response );
+                            if ( rc == 0 )
+                            {
+                                rc = KStreamTimedReadExactly ( response, buffer, result_size, tm );
+                                if ( rc != 0 )
+                                {
+                                    KHttpClose ( http );
+                                    return ResetRCContext ( rc, rcNS, rcFile, rcReading );
+                                }
+
+                                * num_read = result_size;
+
+                                KStreamRelease ( response );
+                            }
+                        }
+                        break;
+                    }
+                    case 416:
+                    default:
+                        rc = RC ( rcNS, rcFile, rcReading, rcFileDesc, rcInvalid );
+                    }
+                }
+                KHttpResultRelease ( rslt );
+            }
+        }
+        KHttpRequestRelease ( req );
+    }
+
+    return rc;
+}
+
+static
+rc_t KHttpFileWorkerConnect ( KHttpFileWorker *self )
+{
+    const KHttpFile *file = self -> file;
+    const KDataBuffer *src = & file -> url_buffer;
+
+    rc_t rc = KDataBufferMakeBytes ( & self -> url_buffer, src -> elem_count );
+    if ( rc == 0 )
+    {
+        URLBlock block;
+
+        memcpy ( self -> url_buffer . base, src -> base, src -> elem_count );
+        rc = ParseUrl ( &block, self -> url_buffer . base, src -> elem_count - 1 );
+        if ( rc == 0 )
+        {
+            const KHttp *http = file -> http;
+            rc = KNSManagerMakeHttpInt ( http -> mgr, & self -> http, & self -> url_buffer,
+                NULL, http -> vers, http -> read_timeout, http -> write_timeout,
+                & block . host, block . port );
+            if ( rc == 0 )
+                return 0;
+        }
+
+        KDataBufferWhack ( & self -> url_buffer );
+    }
+
+    self -> http = NULL;
+    return rc;
+}
+
+static
+rc_t CC KHttpFileWorkerRun ( const KThread *t, void *data )
+{
+    KHttpFileWorker *self = data;
+    KHttpFile *file = self -> file;
+    rc_t conn_rc = 0;
+
+    rc_t rc = KLockAcquire ( file -> lock );
+    if ( rc != 0 )
+        return rc;
+
+    while ( ! file -> shutdown )
+    {
+        /* a reader waiting on a large read comes first */
+        KHttpFileChunk *c = ( KHttpFileChunk* ) DLListPopHead ( & file -> queue );
+        if ( c == NULL && file -> ahead_queued != 0 )
+        {
+            c = ( KHttpFileChunk* ) DLListHead ( & file -> ahead );
+            while ( c -> state != khcQueued )
+                c = ( KHttpFileChunk* ) DLNodeNext ( & c -> dad );
+            -- file -> ahead_queued;
+        }
+        if ( c == NULL )
+        {
+            rc = KConditionWait ( file -> work, file -> lock );
+            if ( rc != 0 )
+                break;
+            continue;
+        }
+
+        c -> state = khcRunning;
+        KLockUnlock ( file -> lock );
+
+        /* connect on first use, outside of the lock */
+        if ( self -> http == NULL && conn_rc == 0 )
+            conn_rc = KHttpFileWorkerConnect ( self );
+
+        if ( conn_rc != 0 )
+            c -> rc = conn_rc;
+        else
+        {
+            c -> rc = KHttpFileReadRange ( self -> http, self -> url_buffer . base,
+                c -> pos, c -> buffer, c -> size, & c -> num_read, NULL );
+        }
+
+        KLockAcquire ( file -> lock );
+        c -> state = khcDone;
+        if ( c -> abandoned )
+            free ( c );
+        KConditionBroadcast ( file -> done );
+    }
+
+    KLockUnlock ( file -> lock );
+    return rc;
+}
+
+/* StartWorkers
+ *  on first parallel read
+ */
+static
+void KHttpFileStartWorkers ( KHttpFile *self )
+{
+    if ( self -> worker == NULL )
+    {
+        self -> worker = calloc ( self -> max_workers, sizeof self -> worker [ 0 ] );
+        if ( self -> worker == NULL )
+            self -> max_workers = 0;
+    }
+
+    while ( self -> num_workers < self -> max_workers )
+    {
+        KHttpFileWorker *w = & self -> worker [ self -> num_workers ];
+        w -> file = self;
+        if ( KThreadMake ( & w -> t, KHttpFileWorkerRun, w ) != 0 )
+        {
+            /* make do with what there is */
+            self -> max_workers = self -> num_workers;
+            break;
+        }
+        ++ self -> num_workers;
+    }
+}
+
+static
+void KHttpFileStopWorkers ( KHttpFile *self )
+{
+    uint32_t i;
+
+    KLockAcquire ( self -> lock );
+    self -> shutdown = true;
+    KConditionBroadcast ( self -> work );
+    KLockUnlock ( self -> lock );
+
+    for ( i = 0; i < self -> num_workers; ++ i )
+    {
+        KHttpFileWorker *w = & self -> worker [ i ];
+        KThreadWait ( w -> t, NULL );
+        KThreadRelease ( w -> t );
+        if ( w -> http != NULL )
+        {
+            KHttpRelease ( w -> http );
+            KDataBufferWhack ( & w -> url_buffer );
+        }
+    }
+    free ( self -> worker );
+
+    /* workers are gone: whatever is left can go */
+    DLListWhack ( & self -> ahead, KHttpFileChunkWhack, NULL );
+}
+
 static
 rc_t CC KHttpFileDestroy ( KHttpFile *self )
 {
+    if ( self -> lock != NULL )
+    {
+        KHttpFileStopWorkers ( self );
+        KConditionRelease ( self -> done );
+        KConditionRelease ( self -> work );
+        KLockRelease ( self -> lock );
+    }
+
     KHttpRelease ( self -> http );
     KDataBufferWhack ( & self -> url_buffer );
     free ( self );
@@ -2901,99 +3201,288 @@ rc_t CC KHttpFileSetSize ( KHttpFile *self, uint64_t size )
     return RC ( rcNS, rcFile, rcUpdating, rcFile, rcReadonly );
 }
 
+/* DropChunk
+ *  remove a read-ahead chunk, leaving it to its worker if still running
+ *  called under lock
+ */
 static
-rc_t CC KHttpFileTimedRead ( const KHttpFile *cself, uint64_t pos,
-    void *buffer, size_t bsize, size_t *num_read, struct timeout_t *tm )
+void KHttpFileDropChunk ( KHttpFile *self, KHttpFileChunk *c )
 {
-    rc_t rc;
-    KHttpFile *self = ( KHttpFile * ) cself;
-    KHttp *http = self -> http;
+    DLListUnlink ( & self -> ahead, & c -> dad );
+    self -> ahead_size -= c -> size;
 
-    /* starting position was beyond EOF */
-    if ( pos >= self -> file_size )
+    switch ( c -> state )
     {
-        *num_read = 0;
-        return 0;
+    case khcQueued:
+        -- self -> ahead_queued;
+        free ( c );
+        break;
+    case khcRunning:
+        c -> abandoned = true;
+        break;
+    default:
+        free ( c );
     }
-#if 0
-    /* position is within http header buffer */
-    else if ( KHttpBlockBufferContainsPos ( http, pos ) )
+}
+
+/* ReadAhead
+ *  copy out of chunks read ahead, starting at "pos"
+ *  waiting on a chunk still being fetched
+ *  drops every chunk that has been read past
+ *  called under lock
+ */
+static
+size_t KHttpFileReadAhead ( KHttpFile *self, uint64_t pos, uint8_t *buffer, size_t bsize )
+{
+    size_t total = 0;
+    KHttpFileChunk *c = ( KHttpFileChunk* ) DLListHead ( & self -> ahead );
+
+    while ( c != NULL && total < bsize )
     {
+        KHttpFileChunk *next = ( KHttpFileChunk* ) DLNodeNext ( & c -> dad );
+        uint64_t cur = pos + total;
+
+        if ( c -> pos + c -> size <= cur )
+        {
+            /* read past */
+            KHttpFileDropChunk ( self, c );
+        }
+        else if ( c -> pos > cur )
+        {
+            /* a gap: reader went back */
+            break;
+        }
+        else
+        {
+            size_t offset, to_copy;
+
+            while ( c -> state != khcDone )
+            {
+                if ( KConditionWait ( self -> done, self -> lock ) != 0 )
+                    return total;
+            }
 
+            if ( c -> rc != 0 || c -> num_read != c -> size )
+            {
+                /* let the reader try for itself */
+                KHttpFileDropChunk ( self, c );
+                break;
+            }
+
+            offset = ( size_t ) ( cur - c -> pos );
+            to_copy = c -> size - offset;
+            if ( to_copy > bsize - total )
+                to_copy = bsize - total;
+            memmove ( & buffer [ total ], & c -> buffer [ offset ], to_copy );
+            total += to_copy;
+
+            if ( offset + to_copy == c -> size )
+                KHttpFileDropChunk ( self, c );
+        }
+
+        c = next;
     }
-#endif
-    /* starting position was within file but the range fell beyond EOF */
-    else 
+
+    if ( total == 0 && c != NULL && c -> pos > pos )
     {
-        KHttpRequest *req;
+        /* not sequential any more: drop everything */
+        while ( ( c = ( KHttpFileChunk* ) DLListHead ( & self -> ahead ) ) != NULL )
+            KHttpFileDropChunk ( self, c );
+    }
 
-        /* limit request to file size */
-        if ( pos + bsize > self -> file_size )
-            bsize = self -> file_size - pos;
-        
-        rc = KHttpMakeRequest ( http, &req, self -> url_buffer . base );
-        if ( rc == 0 )
+    return total;
+}
+
+/* ScheduleAhead
+ *  queue chunks following "pos" up to the read-ahead limit
+ *  called under lock
+ */
+static
+void KHttpFileScheduleAhead ( KHttpFile *self, uint64_t pos )
+{
+    KHttpFileChunk *tail = ( KHttpFileChunk* ) DLListTail ( & self -> ahead );
+    bool queued = false;
+
+    if ( tail != NULL && tail -> pos + tail -> size > pos )
+        pos = tail -> pos + tail -> size;
+
+    while ( pos < self -> file_size &&
+            self -> ahead_size + KHTTP_FILE_CHUNK_SIZE <= self -> ahead_limit )
+    {
+        size_t size = KHTTP_FILE_CHUNK_SIZE;
+        KHttpFileChunk *c;
+
+        if ( pos + size > self -> file_size )
+            size = ( size_t ) ( self -> file_size - pos );
+
+        c = malloc ( sizeof * c + size );
+        if ( c == NULL )
+            break;
+
+        memset ( c, 0, sizeof * c );
+        c -> pos = pos;
+        c -> size = size;
+        c -> buffer = ( uint8_t* ) ( c + 1 );
+        c -> state = khcQueued;
+
+        DLListPushTail ( & self -> ahead, & c -> dad );
+        self -> ahead_size += size;
+        ++ self -> ahead_queued;
+
+        queued = true;
+        pos += size;
+    }
+
+    if ( queued )
+        KConditionBroadcast ( self -> work );
+}
+
+/* SplitRead
+ *  read a large range in parts, in parallel with the workers
+ *  parts that fail are retried on the main connection
+ *  called under lock, which is released while reading
+ */
+static
+rc_t KHttpFileSplitRead ( KHttpFile *self, uint64_t pos,
+    uint8_t *buffer, size_t bsize, struct timeout_t *tm )
+{
+    rc_t rc = 0;
+    uint32_t i, count = ( uint32_t ) ( ( bsize + KHTTP_FILE_CHUNK_SIZE - 1 ) / KHTTP_FILE_CHUNK_SIZE );
+
+    KHttpFileChunk *part = calloc ( count, sizeof part [ 0 ] );
+    if ( part == NULL )
+        return RC ( rcNS, rcFile, rcReading, rcMemory, rcExhausted );
+
+    for ( i = 0; i < count; ++ i )
+    {
+        size_t offset = ( size_t ) i * KHTTP_FILE_CHUNK_SIZE;
+        part [ i ] . pos = pos + offset;
+        part [ i ] . size = bsize - offset < KHTTP_FILE_CHUNK_SIZE ? bsize - offset : KHTTP_FILE_CHUNK_SIZE;
+        part [ i ] . buffer = & buffer [ offset ];
+        part [ i ] . state = khcQueued;
+        DLListPushTail ( & self -> queue, & part [ i ] . dad );
+    }
+    KConditionBroadcast ( self -> work );
+
+    /* take parts from the back while the workers take them from the front */
+    for ( i = count; i -- > 0; )
+    {
+        KHttpFileChunk *c = & part [ i ];
+        if ( c -> state != khcQueued )
+            break;
+
+        DLListUnlink ( & self -> queue, & c -> dad );
+        c -> state = khcRunning;
+        KLockUnlock ( self -> lock );
+
+        c -> rc = KHttpFileReadRange ( self -> http, self -> url_buffer . base,
+            c -> pos, c -> buffer, c -> size, & c -> num_read, tm );
+
+        KLockAcquire ( self -> lock );
+        c -> state = khcDone;
+    }
+
+    /* parts cannot be left behind with the workers */
+    for ( i = 0; i < count; ++ i )
+    {
+        while ( part [ i ] . state != khcDone )
+            KConditionWait ( self -> done, self -> lock );
+    }
+
+    KLockUnlock ( self -> lock );
+    for ( rc = 0, i = 0; rc == 0 && i < count; ++ i )
+    {
+        KHttpFileChunk *c = & part [ i ];
+        if ( c -> rc != 0 || c -> num_read != c -> size )
         {
-            /* request min ( bsize, file_size ) bytes */
-            rc = KHttpRequestByteRange ( req, pos, bsize );
+            rc = KHttpFileReadRange ( self -> http, self -> url_buffer . base,
+                c -> pos, c -> buffer, c -> size, & c -> num_read, tm );
+            if ( rc == 0 && c -> num_read != c -> size )
+                rc = RC ( rcNS, rcFile, rcReading, rcTransfer, rcIncomplete );
+        }
+    }
+    KLockAcquire ( self -> lock );
+
+    free ( part );
+    return rc;
+}
+
+static
+rc_t KHttpFileParallelRead ( KHttpFile *self, uint64_t pos,
+    uint8_t *buffer, size_t bsize, size_t *num_read, struct timeout_t *tm )
+{
+    size_t total;
+
+    rc_t rc = KLockAcquire ( self -> lock );
+    if ( rc != 0 )
+        return rc;
+
+    if ( pos != self -> last_end )
+        self -> seq = 0;
+    else if ( self -> seq < KHTTP_FILE_MIN_SEQ )
+        ++ self -> seq;
+
+    total = KHttpFileReadAhead ( self, pos, buffer, bsize );
+    if ( total < bsize )
+    {
+        if ( bsize - total >= 2 * KHTTP_FILE_CHUNK_SIZE )
+            KHttpFileStartWorkers ( self );
+
+        if ( bsize - total >= 2 * KHTTP_FILE_CHUNK_SIZE && self -> num_workers != 0 )
+        {
+            rc = KHttpFileSplitRead ( self, pos + total, & buffer [ total ], bsize - total, tm );
             if ( rc == 0 )
-            {
-                KHttpResult *rslt;
-                
-                rc = KHttpRequestGET ( req, &rslt );
-                if ( rc == 0 )
-                {
-                    uint32_t code;
-                    
-                    /* dont need to know what the response message was */
-                    rc = KHttpResultStatus ( rslt, &code, NULL, 0, NULL );
-                    if ( rc == 0 )
-                    {
-                        switch ( code )
-                        {
-                        case 206:
-                        {
-                            uint64_t start_pos;
-                            size_t result_size;
-
-                            /* extract actual amount being returned by server */
-                            rc = KHttpResultRange ( rslt, &start_pos, &result_size );
-                            if ( rc == 0 && 
-                                 start_pos == pos &&
-                                 result_size == bsize )
-                            {
-                                KStream *response;
-                                
-                                rc = KHttpResultGetInputStream ( rslt, &response );
-                                if ( rc == 0 )
-                                {
-                                    rc = KStreamTimedReadExactly ( response, buffer, result_size, tm );
-                                    if ( rc != 0 )
-                                    {
-                                        KHttpClose ( http );
-                                        return ResetRCContext ( rc, rcNS, rcFile, rcReading );
-                                    }
+                total = bsize;
+        }
+        else
+        {
+            size_t partial;
 
-                                    * num_read = result_size;
+            KLockUnlock ( self -> lock );
+            rc = KHttpFileReadRange ( self -> http, self -> url_buffer . base,
+                pos + total, & buffer [ total ], bsize - total, & partial, tm );
+            KLockAcquire ( self -> lock );
 
-                                    KStreamRelease ( response );
-                                }
-                            }
-                            break;
-                        }
-                        case 416:
-                        default:
-                            rc = RC ( rcNS, rcFile, rcReading, rcFileDesc, rcInvalid );
-                        }
-                    }
-                    KHttpResultRelease ( rslt );
-                }
-            }
-            KHttpRequestRelease ( req );
+            total += partial;
         }
     }
 
-    return rc;
+    self -> last_end = pos + total;
+    if ( rc == 0 && self -> seq >= KHTTP_FILE_MIN_SEQ && self -> ahead_limit != 0 )
+    {
+        KHttpFileStartWorkers ( self );
+        if ( self -> num_workers != 0 )
+            KHttpFileScheduleAhead ( self, self -> last_end );
+    }
+
+    KLockUnlock ( self -> lock );
+
+    * num_read = total;
+    return total != 0 ? 0 : rc;
+}
+
+static
+rc_t CC KHttpFileTimedRead ( const KHttpFile *cself, uint64_t pos,
+    void *buffer, size_t bsize, size_t *num_read, struct timeout_t *tm )
+{
+    KHttpFile *self = ( KHttpFile * ) cself;
+
+    /* starting position was beyond EOF */
+    if ( pos >= self -> file_size )
+    {
+        *num_read = 0;
+        return 0;
+    }
+
+    /* starting position was within file but the range fell beyond EOF */
+    if ( pos + bsize > self -> file_size )
+        bsize = self -> file_size - pos;
+
+    if ( self -> lock != NULL )
+        return KHttpFileParallelRead ( self, pos, buffer, bsize, num_read, tm );
+
+    return KHttpFileReadRange ( self -> http, self -> url_buffer . base,
+        pos, buffer, bsize, num_read, tm );
 }
 
 static
@@ -3029,6 +3518,34 @@ uint32_t CC KHttpFileGetType ( const KHttpFile *self )
     return kfdFile;
 }
 
+/* InitParallel
+ *  set up for reading through "workers" additional connections
+ *  the file keeps to its single connection if this fails
+ */
+static
+void KHttpFileInitParallel ( KHttpFile *self, uint32_t workers, size_t read_ahead )
+{
+    if ( KLockMake ( & self -> lock ) == 0 )
+    {
+        if ( KConditionMake ( & self -> work ) == 0 )
+        {
+            if ( KConditionMake ( & self -> done ) == 0 )
+            {
+                DLListInit ( & self -> queue );
+                DLListInit ( & self -> ahead );
+                self -> max_workers = workers;
+                self -> ahead_limit = read_ahead;
+                self -> last_end = ~ ( uint64_t ) 0;
+                return;
+            }
+            KConditionRelease ( self -> work );
+        }
+        KLockRelease ( self -> lock );
+    }
+
+    self -> lock = NULL;
+}
+
 static KFile_vt_v1 vtKHttpFile = 
 {
     1, 2,
@@ -3112,6 +3629,9 @@ rc_t SecretKNSManagerVMakeHttpFile ( const KNSManager *self,
                                             f -> file_size = size;
                                             f -> http = http;
 
+                                            if ( self -> http_max_conns > 1 )
+                                                KHttpFileInitParallel ( f, self -> http_max_conns - 1, self -> http_read_ahead );
+
                                             * file = & f -> dad;
 
                                             return 0;
@@ -113,6 +113,7 @@ LIB_EXPORT rc_t CC KNSManagerMake ( KNSManager **mgrp )
             mgr -> conn_write_timeout = MAX_CONN_WRITE_LIMIT;
             mgr -> http_read_timeout = MAX_HTTP_READ_LIMIT;
             mgr -> http_write_timeout = MAX_HTTP_WRITE_LIMIT;
+            mgr -> http_max_conns = 1;
             mgr -> verbose = false;
 
             rc = KNSManagerInit ();
@@ -305,3 +306,28 @@ LIB_EXPORT rc_t CC KNSManagerSetHTTPTimeouts ( KNSManager *self,
 
     return 0;
 }
+
+
+/* SetHTTPReads
+ *  sets how HTTP files made afterwards read
+ *
+ *  "connections" [ IN ] - connections per file, limited to 16
+ *  "readAhead" [ IN ] - bytes to fetch ahead of sequential reads
+ */
+LIB_EXPORT rc_t CC KNSManagerSetHTTPReads ( KNSManager *self,
+    uint32_t connections, size_t readAhead )
+{
+    if ( self == NULL )
+        return RC ( rcNS, rcMgr, rcUpdating, rcSelf, rcNull );
+
+    /* limit values */
+    if ( connections == 0 )
+        connections = 1;
+    else if ( connections > MAX_HTTP_FILE_CONNECTIONS )
+        connections = MAX_HTTP_FILE_CONNECTIONS;
+
+    self -> http_max_conns = connections;
+    self -> http_read_ahead = readAhead;
+
+    return 0;
+}
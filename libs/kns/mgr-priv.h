@@ -47,6 +47,8 @@ struct KNSManager
     int32_t conn_write_timeout;
     int32_t http_read_timeout;
     int32_t http_write_timeout;
+    uint32_t http_max_conns;
+    size_t http_read_ahead;
     bool verbose;
 };
 
@@ -2498,6 +2498,86 @@ CipherVec AESBCMEMBER(Decrypt) (CipherVec state,
 }
 
 
+#if USE_AES_NI
+/* ----------------------------------------------------------------------
+ * DecryptCbc
+ *
+ *   Decrypt a run of blocks in cipher-block chaining mode.
+ *
+ *   Unlike encryption each block's decryption depends only on cipher text
+ *   so four blocks at a time are interleaved through the rounds to keep
+ *   the AES unit busy instead of waiting on each AESDEC in turn.
+ *
+ *   in and out may be the same buffer.
+ */
+#define AES_CBC_LANES 4
+
+static
+void AESBCMEMBER(DecryptCbc) (const void * in, void * out,
+                              uint32_t block_count, void * ivec,
+                              const void * decrypt_key)
+{
+    const AESKeySchedule * key = decrypt_key;
+    const uint8_t * pin = in;
+    uint8_t * pout = out;
+    CipherVec feedback;
+    unsigned Nr;
+
+    assert (key);
+
+    Nr = key->number_of_rounds;
+    memmove (&feedback, ivec, sizeof feedback);
+
+    for ( ; block_count >= AES_CBC_LANES; block_count -= AES_CBC_LANES)
+    {
+        CipherVec cipher [AES_CBC_LANES];
+        CipherVec state [AES_CBC_LANES];
+        unsigned ix, lane;
+
+        memmove (cipher, pin, sizeof cipher);
+
+        for (lane = 0; lane < AES_CBC_LANES; ++lane)
+            state[lane] = AESBCMEMBER(EqInvFirstRound) (cipher[lane],
+                                                        key->round_keys[0]);
+        for (ix = 1; ix < Nr; ++ix)
+            for (lane = 0; lane < AES_CBC_LANES; ++lane)
+                state[lane] = AESBCMEMBER(EqInvMiddleRound) (state[lane],
+                                                             key->round_keys[ix]);
+        for (lane = 0; lane < AES_CBC_LANES; ++lane)
+            state[lane] = AESBCMEMBER(EqInvLastRound) (state[lane],
+                                                       key->round_keys[Nr]);
+
+        state[0] = AESBCMEMBER(VecXor) (state[0], feedback);
+        for (lane = 1; lane < AES_CBC_LANES; ++lane)
+            state[lane] = AESBCMEMBER(VecXor) (state[lane], cipher[lane - 1]);
+        feedback = cipher[AES_CBC_LANES - 1];
+
+        memmove (pout, state, sizeof state);
+
+        pin += sizeof cipher;
+        pout += sizeof state;
+    }
+
+    for ( ; block_count > 0; --block_count)
+    {
+        CipherVec cipher;
+        CipherVec state;
+
+        memmove (&cipher, pin, sizeof cipher);
+        state = AESBCMEMBER(EqInvCipher) (cipher, key->round_keys, Nr);
+        state = AESBCMEMBER(VecXor) (state, feedback);
+        feedback = cipher;
+        memmove (pout, &state, sizeof state);
+
+        pin += sizeof cipher;
+        pout += sizeof state;
+    }
+
+    memmove (ivec, &feedback, sizeof feedback);
+}
+#endif
+
+
 /* ----------------------------------------------------------------------
  * MakeProcessorSupport
  *
@@ -2595,7 +2675,7 @@ bool AESBCMEMBER(ProcessorSupport) ()
 static const
 KBlockCipherVec_vt_v1 AESBCMEMBER(_vt_) = 
 {
-    { 1, 1 },
+    { 1, 2 },
 
     AESBCMEMBER(Destroy),
     AESBCMEMBER(BlockSize),
@@ -2603,7 +2683,12 @@ KBlockCipherVec_vt_v1 AESBCMEMBER(_vt_) =
     AESBCMEMBER(SetEncryptKey),
     AESBCMEMBER(SetDecryptKey),
     AESBCMEMBER(Encrypt),
-    AESBCMEMBER(Decrypt)
+    AESBCMEMBER(Decrypt),
+#if USE_AES_NI
+    AESBCMEMBER(DecryptCbc)
+#else
+    NULL
+#endif
 };
 
 
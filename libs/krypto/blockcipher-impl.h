@@ -168,6 +168,15 @@ struct KBlockCipherVec_vt_v1
 
     /* end minor version == 0 */
 
+    /* start minor version == 2 */
+
+    /* NULL if the block cipher can do no better than a block at a time */
+    void        (* decrypt_cbc     )(const void * in, void * out,
+                                     uint32_t block_count, void * ivec,
+                                     const void * decrypt_key);
+
+    /* end minor version == 2 */
+
 };
 
 union KBlockCipherVec
@@ -424,6 +424,16 @@ rc_t CMEMBER(DecryptCbc) (CIPHER_IMPL * self, const void * in, void * out, uint3
     const uint8_t * pin;
     uint8_t * pout;
 
+    /* let the block cipher pipeline the run when it can */
+    if ((self->block_cipher->version.min >= 2) &&
+        (self->block_cipher->v1.decrypt_cbc != NULL))
+    {
+        self->block_cipher->v1.decrypt_cbc (in, out, block_count,
+                                            self->dad.decrypt_ivec,
+                                            self->dad.decrypt_key);
+        return 0;
+    }
+
     ivec = CipherVecIn (self->dad.decrypt_ivec);
 
     for ((pin = in), (pout = out);
@@ -443,42 +443,63 @@ BLOCK_FUNC(EncryptCTR,encrypt_ctr)
 BLOCK_FUNC(DecryptCTR,decrypt_ctr)
 
 
-#ifndef USE_SLOW_ONES
-#define USE_SLOW_ONES 0
-#endif
+/* ----------
+ * MakeInt
+ *
+ * Pick the fastest implementation this processor supports.  Every flavor
+ * is always linked in: a flavor the compiler could not build is a stub and
+ * a flavor the processor lacks fails its cpuid check, both answering with
+ * rcUnsupported.  The choice for AES is made on first use and remembered.
+ *
+ * Without AES-NI the byte oriented flavor is used: both vector flavors
+ * measure slower than it (see tools/nenctool/cipherbench).
+ */
+static kcipher_subtype KCipherBestSubType = ksubcipher_none;
+
 rc_t KCipherMakeInt (KCipher ** new_cipher, kcipher_type type)
 {
-    rc_t rc;
+    static const kcipher_subtype order [] =
+    {
+        ksubcipher_accelerated,
+        ksubcipher_byte
+    };
+    rc_t rc = 0;
+    unsigned ix;
 
     *new_cipher = NULL;
 
-#if 0
-    rc = KCipherVecAesNiMake (new_cipher, type);
-    if (rc)
+    if (type == kcipher_AES)
     {
-        if (GetRCState(rc) == rcUnsupported)
+        switch (KCipherBestSubType)
         {
-#if USE_SLOW_ONES
-            rc = KCipherVecRegMake (new_cipher, type);
-            if (rc)
-            {
-                if (GetRCState(rc) == rcUnsupported)
-                {
-                    rc = KCipherVecMake (new_cipher, type);
-                    if (GetRCState(rc) == rcUnsupported)
-                    {
-#endif
-#endif
-                        rc = KCipherByteMake (new_cipher, type);
-#if 0
-#if USE_SLOW_ONES
-                    }
-                }
-            }
-#endif
+        case ksubcipher_accelerated:
+            return KCipherVecAesNiMake (new_cipher, type);
+        case ksubcipher_byte:
+            return KCipherByteMake (new_cipher, type);
         }
     }
-#endif
+
+    for (ix = 0; ix < sizeof order / sizeof order [0]; ++ ix)
+    {
+        switch (order [ix])
+        {
+        case ksubcipher_accelerated:
+            rc = KCipherVecAesNiMake (new_cipher, type);
+            break;
+        default:
+            rc = KCipherByteMake (new_cipher, type);
+            break;
+        }
+        if (rc == 0)
+        {
+            /* racing threads can only store the same answer */
+            if (type == kcipher_AES)
+                KCipherBestSubType = order [ix];
+            break;
+        }
+        if (GetRCState (rc) != rcUnsupported)
+            break;
+    }
     return rc;
 }
 
@@ -502,21 +523,15 @@ rc_t KCipherMake (KCipher ** new_cipher, kcipher_type type)
             case ksubcipher_byte:
                 rc = KCipherByteMake (new_cipher, type);
                 break;
-#ifdef USEVEC
             case ksubcipher_vec:
                 rc = KCipherVecMake (new_cipher, type);
                 break;
-#endif
-#ifdef USEVECREG
             case ksubcipher_vecreg:
                 rc = KCipherVecRegMake (new_cipher, type);
                 break;
-#endif
-#ifdef USEAESNI
             case ksubcipher_accelerated:
                 rc = KCipherVecAesNiMake (new_cipher, type);
                 break;
-#endif
             default:
                 rc = KCipherMakeInt (new_cipher, type);
                 break;
@@ -42,6 +42,9 @@
 /* #include <klib/status.h> */
 #include <kfs/file.h>
 #include <kfs/sra.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+#include <kproc/thread.h>
 #include <sysalloc.h>
 
 #include <byteswap.h>
@@ -94,7 +97,10 @@ struct KEncFile
     bool eof;                   
     bool sra;                   /* we know we are encrypting an SRA/KAR archive file */
     bool swarm;                 /* block mode for swarm mode using KReencFile or KEncryptFile */
+    bool serial;                /* worker threads could not be started */
     KEncFileVersion version;    /* version from the header if read; or the one being written */
+    KKey key;                   /* kept to make ciphers for worker threads */
+    struct KEncFileWorkers * workers; /* NULL until parallel reading or writing starts */
 };
 
 
@@ -599,16 +605,18 @@ void KEncFileIVecInit (const uint64_t block_id, KEncFileIVec * ivec)
 
  
 /* ----------
- * BlockEncrypt
+ * BlockEncryptInt
  *
  * Not thread safe - use of cipher schedules ivec and block key in the ciphers
  *
- * If this function were a protected region where only one thread could be in
- * the body of this function at a time it could be made thread safe.
+ * Touches nothing but the ciphers and the two blocks so threads each with
+ * their own pair of ciphers can encrypt different blocks at the same time.
+ * The crc is returned in host order; e->crc is in file order.
  */
 static
-rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
-                           KEncFileBlock * e)
+rc_t KEncFileBlockEncryptInt (KEncFileCiphers * ciphers, bool bswap,
+                              KEncFileBlock * d, KEncFileBlock * e,
+                              KEncFileCRC * pcrc)
 {
     SHA256State state;
     uint64_t id;
@@ -618,9 +626,10 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
     KEncFileIVec ivec;
     rc_t rc;
 
-    assert (self);
+    assert (ciphers);
     assert (d);
     assert (e);
+    assert (pcrc);
 
     /*
      * First we finish preparing the two ciphers by creating the block
@@ -634,11 +643,11 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
     /*
      * set the ivec for both the master and data block ciphers
      */
-    rc = KCipherSetEncryptIVec (self->ciphers.master, &ivec);
+    rc = KCipherSetEncryptIVec (ciphers->master, &ivec);
     if (rc)
         return rc;
 
-    rc = KCipherSetEncryptIVec (self->ciphers.block, &ivec);
+    rc = KCipherSetEncryptIVec (ciphers->block, &ivec);
     if (rc)
         return rc;
 
@@ -657,7 +666,7 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
     /*
      * create the block key schedule out of the block user key
      */
-    rc = KCipherSetEncryptKey (self->ciphers.block, d->key, sizeof d->key);
+    rc = KCipherSetEncryptKey (ciphers->block, d->key, sizeof d->key);
     if (rc)
         return rc;
 
@@ -694,7 +703,7 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
             d->data[bindex] = d->data[rindex];
         
             ++rindex;
-            if (rindex >= sizeof self->block.key / sizeof *pw)
+            if (rindex >= sizeof d->key / sizeof *pw)
                 rindex = 0;
         }
     }
@@ -704,7 +713,7 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
      * Endian choice we'll need to byte swap the block id and the block valid
      * count
      */
-    if (self->bswap)
+    if (bswap)
     {
         assert (sizeof id == 8);
         id = bswap_64 (id);
@@ -733,7 +742,7 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
         KOutMsg ("\n");
     }
 #endif
-    rc = KCipherEncryptCBC (self->ciphers.master, d->key, e->key,
+    rc = KCipherEncryptCBC (ciphers->master, d->key, e->key,
                             sizeof (d->key) / sizeof (ivec));
     if (rc)
         return rc;
@@ -749,7 +758,7 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
     /*
      * encrypt the data, offset and valid values
      */
-    rc = KCipherEncryptCBC (self->ciphers.block, 
+    rc = KCipherEncryptCBC (ciphers->block, 
                             d->data, e->data,
                             (sizeof d->data + sizeof d->u) / sizeof (ivec));
     if (rc)
@@ -759,21 +768,44 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
 
     crc = CRC32 (0, e, (char*)(&e->crc)-(char*)e);
 
-    self->block.crc = crc;
+    *pcrc = crc;
 
-    if (self->bswap)
+    if (bswap)
     {
         assert (sizeof crc == 4);
         crc = bswap_32 (crc);
     }
     e->crc_copy = e->crc = crc;
 
+    return 0;
+}
+
+
+/* ----------
+ * BlockEncrypt
+ *
+ * Not thread safe - use of cipher schedules ivec and block key in the ciphers
+ * and the footer accounting
+ */
+static
+rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
+                           KEncFileBlock * e)
+{
+    rc_t rc;
+
+    assert (self);
+
+    rc = KEncFileBlockEncryptInt (&self->ciphers, self->bswap, d, e,
+                                  &self->block.crc);
+    if (rc)
+        return rc;
+
 /*     KOutMsg ("%s: %lu %lu %lu ", __func__, self->foot.block_count, self->foot.crc_checksum,self->block.id); */
     if (self->foot.block_count <= self->block.id)
         self->foot.block_count = self->block.id + 1;
 
     if (!self->sought)
-        self->foot.crc_checksum += crc;
+        self->foot.crc_checksum += e->crc;
 
 /*     KOutMsg ("%lu %lu\n", __func__, self->foot.block_count, self->foot.crc_checksum); */
 
@@ -781,6 +813,8 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
 }
 
 
+
+
 /* ----------
  * BlockDecrypt
  *   decrypt decrypts the data from a KEncFileBlock into the KEncFileBlock
@@ -788,12 +822,13 @@ rc_t KEncFileBlockEncrypt (KEncFile * self, KEncFileBlock * d,
  *
  * Not thread safe - use of cipher schedules ivec and block key in the ciphers
  *
- * If this function were a protected region where only one thread could be in
- * the body of this function at a time it could be made thread safe.
+ * Like BlockEncryptInt only the ciphers are modified so each thread with
+ * its own ciphers can decrypt a different block.
  */
 static
-rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
-                           const KEncFileBlock * e, KEncFileBlock * d)
+rc_t KEncFileBlockDecryptInt (KEncFileCiphers * ciphers, bool bswap,
+                              KEncFileBlockId bid, const KEncFileBlock * e,
+                              KEncFileBlock * d)
 {
     KEncFileIVec ivec;
     rc_t rc;
@@ -806,11 +841,11 @@ rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
     /*
      * set the ivec for both the master and data block ciphers
      */
-    rc = KCipherSetDecryptIVec (self->ciphers.master, &ivec);
+    rc = KCipherSetDecryptIVec (ciphers->master, &ivec);
     if (rc)
         return rc;
 
-    rc = KCipherSetDecryptIVec (self->ciphers.block, &ivec);
+    rc = KCipherSetDecryptIVec (ciphers->block, &ivec);
     if (rc)
         return rc;
 
@@ -818,7 +853,7 @@ rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
      * decrypt the block key and initial vector using the user key and 
      * the computer ivec
      */
-    rc = KCipherDecryptCBC (self->ciphers.master, e->key, d->key,
+    rc = KCipherDecryptCBC (ciphers->master, e->key, d->key,
                             (sizeof e->key) / sizeof ivec);
     if (rc)
         return rc;
@@ -827,17 +862,17 @@ rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
      * now create the AES key for the block from the newly decrypted 
      * block key
      */
-    rc = KCipherSetDecryptKey (self->ciphers.block, d->key,
+    rc = KCipherSetDecryptKey (ciphers->block, d->key,
                                sizeof d->key);
     if (rc)
         return rc;
 
-    rc = KCipherDecryptCBC (self->ciphers.block, e->data, d->data,
+    rc = KCipherDecryptCBC (ciphers->block, e->data, d->data,
                             (sizeof e->data + sizeof e->u) / sizeof ivec);
     if (rc)
         return rc;
 
-    if (self->bswap)
+    if (bswap)
     {
         assert (sizeof d->u.valid == 2);
         d->u.valid = bswap_16 (d->u.valid);
@@ -852,6 +887,14 @@ rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
 }
 
 
+static __inline__
+rc_t KEncFileBlockDecrypt (KEncFile * self, KEncFileBlockId bid,
+                           const KEncFileBlock * e, KEncFileBlock * d)
+{
+    return KEncFileBlockDecryptInt (&self->ciphers, self->bswap, bid, e, d);
+}
+
+
 /*
  * if not decrypting block can be NULL
  */
@@ -1197,6 +1240,584 @@ rc_t KEncFileBlockFlush (KEncFile * self, KEncFileBlock * dec_block)
 }
 
 
+/* ----------
+ * KeysInit
+ */
+static
+rc_t KEncFileCiphersMake (KEncFileCiphers * ciphers, const KKey * key)
+{
+    KCipherManager * mgr;
+    size_t z;
+    rc_t rc;
+
+    switch ( key->type)
+    {
+    default:
+        return RC (rcKrypto, rcEncryptionKey, rcConstructing, rcParam, rcInvalid);
+
+    case kkeyNone:
+        return RC (rcKrypto, rcEncryptionKey, rcConstructing, rcParam, rcIncorrect);
+
+    case kkeyAES128:
+        z = 128/8; break;
+
+    case kkeyAES192:
+        z = 192/8; break;
+
+    case kkeyAES256:
+        z = 256/8; break;
+    }
+    rc = KCipherManagerMake (&mgr);
+    if (rc == 0)
+    {
+        rc = KCipherManagerMakeCipher (mgr, &ciphers->master, kcipher_AES);
+        if (rc == 0)
+        {
+            rc = KCipherManagerMakeCipher (mgr, &ciphers->block, kcipher_AES);
+            if (rc == 0)
+            {
+                rc = KCipherSetDecryptKey (ciphers->master, key->text, z);
+                if (rc == 0)
+                {
+                    rc = KCipherSetEncryptKey (ciphers->master, key->text, z);
+                    if (rc == 0)
+                        goto keep_ciphers;
+                }
+                KCipherRelease (ciphers->block);
+                ciphers->block = NULL;
+            }
+            KCipherRelease (ciphers->master);
+            ciphers->master = NULL;
+        }
+    keep_ciphers:
+        KCipherManagerRelease (mgr);
+    }
+    return rc;
+}
+
+
+static
+rc_t KEncFileCiphersInit (KEncFile * self, const KKey * key, bool read, bool write)
+{
+    rc_t rc = KEncFileCiphersMake (&self->ciphers, key);
+
+    /* workers make their own ciphers from the same key */
+    if (rc == 0)
+        self->key = *key;
+    return rc;
+}
+
+
+static
+void KEncFileCiphersWhack (KEncFileCiphers * ciphers)
+{
+    KCipherRelease (ciphers->master);
+    KCipherRelease (ciphers->block);
+}
+
+
+
+/* ----------------------------------------------------------------------
+ * Workers
+ *
+ * Every block has its own key and ivec so once read a block can be decrypted
+ * or encrypted independently of the others. Each worker thread owns a pair
+ * of ciphers made from the file key.
+ *
+ * Jobs live in a ring of KENC_RING_BLOCKS slots. The encrypted side of the
+ * ring is an array laid out as in the file so a run of blocks is moved to or
+ * from the encrypted file with a single read or write.
+ *
+ * A read only reader that moves sequentially gets the blocks ahead of it read
+ * and decrypted in the ring. A write only writer that writes several whole
+ * blocks in one call gets them encrypted together. Footer accounting stays on
+ * the caller's thread in block order.
+ */
+#define KENC_WORKER_THREADS 4
+#define KENC_RING_BLOCKS 16
+
+typedef struct KEncFileJob KEncFileJob;
+struct KEncFileJob
+{
+    KEncFileJob * next;         /* queue link */
+    KEncFileBlockId block_id;
+    KEncFileCRC crc;            /* crc of an encrypted block in host order */
+    rc_t rc;
+    bool encrypt;
+    bool missing;               /* read block was all zero */
+    bool queued;                /* submitted but not yet finished */
+};
+
+typedef struct KEncFileWorkers KEncFileWorkers;
+struct KEncFileWorkers
+{
+    KLock * lock;
+    KCondition * todo;          /* signaled when a job is queued or on quit */
+    KCondition * done;          /* broadcast when a job is finished */
+    KThread * thread [KENC_WORKER_THREADS];
+    uint32_t thread_count;
+    KEncFileJob * head;
+    KEncFileJob * tail;
+    const KKey * key;
+    bool bswap;
+    bool quitting;
+
+    /* read ahead window holds block ids [first, next) */
+    KEncFileBlockId first;
+    KEncFileBlockId next;
+    KEncFileBlockId limit;      /* id of the footer */
+
+    KEncFileJob job [KENC_RING_BLOCKS];
+    KEncFileBlock enc [KENC_RING_BLOCKS];
+    KEncFileBlock dec [KENC_RING_BLOCKS];
+};
+
+
+static
+rc_t KEncFileWorkerDecrypt (KEncFileWorkers * w, KEncFileCiphers * ciphers,
+                            KEncFileJob * job, KEncFileBlock * e,
+                            KEncFileBlock * d)
+{
+    job->missing = BufferAllZero (e, sizeof * e);
+    if (job->missing)
+        return 0;
+
+    if (w->bswap)
+    {
+        e->crc = bswap_32 (e->crc);
+        e->crc_copy = bswap_32 (e->crc_copy);
+        e->id = bswap_64 (e->id);
+    }
+    job->crc = e->crc;
+
+    d->crc = d->crc_copy = 0;
+    return KEncFileBlockDecryptInt (ciphers, w->bswap, job->block_id, e, d);
+}
+
+
+static
+rc_t CC KEncFileWorker (const KThread * t, void * data)
+{
+    KEncFileWorkers * w = data;
+    KEncFileCiphers ciphers;
+    rc_t crc;
+
+    crc = KEncFileCiphersMake (&ciphers, w->key);
+
+    KLockAcquire (w->lock);
+    while (true)
+    {
+        KEncFileJob * job = w->head;
+        size_t slot;
+        rc_t rc;
+
+        if (job == NULL)
+        {
+            if (w->quitting)
+                break;
+            KConditionWait (w->todo, w->lock);
+            continue;
+        }
+
+        w->head = job->next;
+        if (w->head == NULL)
+            w->tail = NULL;
+        KLockUnlock (w->lock);
+
+        slot = job - w->job;
+        if (crc != 0)
+            rc = crc;
+        else if (job->encrypt)
+            rc = KEncFileBlockEncryptInt (&ciphers, w->bswap, &w->dec[slot],
+                                          &w->enc[slot], &job->crc);
+        else
+            rc = KEncFileWorkerDecrypt (w, &ciphers, job, &w->enc[slot],
+                                        &w->dec[slot]);
+
+        KLockAcquire (w->lock);
+        job->rc = rc;
+        job->queued = false;
+        KConditionBroadcast (w->done);
+    }
+    KLockUnlock (w->lock);
+
+    if (crc == 0)
+        KEncFileCiphersWhack (&ciphers);
+    return crc;
+}
+
+
+/* queue count jobs from the ring starting at slot */
+static
+void KEncFileWorkersSubmit (KEncFileWorkers * w, size_t slot, size_t count,
+                            KEncFileBlockId block_id, bool encrypt)
+{
+    size_t i;
+
+    KLockAcquire (w->lock);
+    for (i = 0; i < count; ++ i)
+    {
+        KEncFileJob * job = &w->job[slot + i];
+
+        job->next = NULL;
+        job->block_id = block_id + i;
+        job->crc = 0;
+        job->rc = 0;
+        job->encrypt = encrypt;
+        job->missing = false;
+        job->queued = true;
+
+        if (w->tail == NULL)
+            w->head = job;
+        else
+            w->tail->next = job;
+        w->tail = job;
+    }
+    KConditionBroadcast (w->todo);
+    KLockUnlock (w->lock);
+}
+
+
+static
+rc_t KEncFileWorkersWait (KEncFileWorkers * w, size_t slot, size_t count)
+{
+    rc_t rc = 0;
+    size_t i;
+
+    KLockAcquire (w->lock);
+    for (i = 0; i < count; ++ i)
+    {
+        KEncFileJob * job = &w->job[slot + i];
+
+        while (job->queued)
+            KConditionWait (w->done, w->lock);
+        if (rc == 0)
+            rc = job->rc;
+    }
+    KLockUnlock (w->lock);
+    return rc;
+}
+
+
+static
+void KEncFileWorkersWhack (KEncFileWorkers * w)
+{
+    uint32_t i;
+
+    KLockAcquire (w->lock);
+    w->quitting = true;
+    KConditionBroadcast (w->todo);
+    KLockUnlock (w->lock);
+
+    for (i = 0; i < w->thread_count; ++ i)
+    {
+        rc_t status;
+        KThreadWait (w->thread[i], &status);
+        KThreadRelease (w->thread[i]);
+    }
+    KConditionRelease (w->done);
+    KConditionRelease (w->todo);
+    KLockRelease (w->lock);
+    free (w);
+}
+
+
+static
+rc_t KEncFileWorkersMake (KEncFile * self)
+{
+    KEncFileWorkers * w;
+    rc_t rc;
+
+    assert (self);
+    assert (self->workers == NULL);
+
+    w = calloc (1, sizeof * w);
+    if (w == NULL)
+        return RC (rcKrypto, rcFile, rcConstructing, rcMemory, rcExhausted);
+
+    w->key = &self->key;
+    w->bswap = self->bswap;
+    w->limit = EncryptedPos_to_BlockId (self->enc_size, NULL, NULL);
+
+    rc = KLockMake (&w->lock);
+    if (rc == 0)
+    {
+        rc = KConditionMake (&w->todo);
+        if (rc == 0)
+        {
+            rc = KConditionMake (&w->done);
+            if (rc == 0)
+            {
+                for (w->thread_count = 0;
+                     w->thread_count < KENC_WORKER_THREADS;
+                     ++ w->thread_count)
+                {
+                    rc = KThreadMake (&w->thread[w->thread_count],
+                                      KEncFileWorker, w);
+                    if (rc)
+                        break;
+                }
+                if (w->thread_count > 0)
+                {
+                    self->workers = w;
+                    return 0;
+                }
+                KConditionRelease (w->done);
+            }
+            KConditionRelease (w->todo);
+        }
+        KLockRelease (w->lock);
+    }
+    free (w);
+    return rc;
+}
+
+
+/* start workers on first use, or remember that we can not */
+static
+bool KEncFileWorkersReady (KEncFile * self)
+{
+    if (self->workers == NULL && !self->serial)
+    {
+        rc_t rc = KEncFileWorkersMake (self);
+        if (rc)
+        {
+            PLOGERR (klogWarn, (klogWarn, rc, "could not start encryption "
+                                "worker threads; using '$(T)'", "T=%s",
+                                "a single thread"));
+            self->serial = true;
+        }
+    }
+    return self->workers != NULL;
+}
+
+
+/* ----------
+ * ReadAheadFill
+ *    read the encrypted blocks up to but not including end into the ring
+ *    and queue their decryption
+ */
+static
+rc_t KEncFileReadAheadFill (KEncFile * self, KEncFileBlockId end)
+{
+    KEncFileWorkers * w = self->workers;
+    rc_t rc = 0;
+
+    if (end > w->limit)
+        end = w->limit;
+    assert (end <= w->first + KENC_RING_BLOCKS);
+
+    while ((rc == 0) && (w->next < end))
+    {
+        size_t slot = (size_t)(w->next % KENC_RING_BLOCKS);
+        size_t count = (size_t)(end - w->next);
+        uint64_t epos = BlockId_to_EncryptedPos (w->next);
+        size_t num_read;
+
+        if (count > KENC_RING_BLOCKS - slot)
+            count = KENC_RING_BLOCKS - slot;
+
+        rc = KEncFileBufferRead (self, epos, &w->enc[slot],
+                                 count * sizeof w->enc[0], &num_read);
+        if ((rc == 0) && (num_read != count * sizeof w->enc[0]))
+            rc = RC (rcKrypto, rcFile, rcReading, rcBuffer, rcInsufficient);
+        if (rc)
+        {
+            PLOGERR (klogErr, (klogErr, rc, "Failure to read blocks '$(B)' "
+                               "to '$(L)' at '$(E)' in encrypted file",
+                               "B=%lu,L=%lu,E=%lu", w->next,
+                               w->next + count - 1, epos));
+            break;
+        }
+
+        KEncFileWorkersSubmit (w, slot, count, w->next, false);
+        w->next += count;
+    }
+    return rc;
+}
+
+
+/* ----------
+ * ReadAhead
+ *    fetch a block for a sequential read only reader from the ring
+ *
+ *    "handled" is set to false when the block is to be read in the
+ *    usual way because the access is not sequential or the file is
+ *    not suitable
+ */
+static
+rc_t KEncFileReadAhead (KEncFile * self, KEncFileBlockId block_id,
+                        bool * handled)
+{
+    KEncFileWorkers * w;
+    size_t slot;
+    rc_t rc;
+
+    *handled = false;
+
+    if (self->dad.write_enabled || !self->seekable || !self->size_known)
+        return 0;
+
+    /* only go parallel for a reader that has moved on to the next block */
+    if ((w = self->workers) == NULL)
+    {
+        if ((self->block.u.valid == 0) || (block_id != self->block.id + 1))
+            return 0;
+        if (!KEncFileWorkersReady (self))
+            return 0;
+        w = self->workers;
+        w->first = w->next = block_id;
+    }
+
+    if (block_id >= w->limit)
+        return 0;
+
+    if ((block_id < w->first) || (block_id >= w->next))
+    {
+        if ((self->block.u.valid == 0) || (block_id != self->block.id + 1))
+            return 0;
+
+        /* restart the window here */
+        KEncFileWorkersWait (w, 0, KENC_RING_BLOCKS);
+        w->first = w->next = block_id;
+    }
+    else if (block_id > w->first)
+    {
+        /* skipped blocks give back their slots once finished */
+        for (; w->first < block_id; ++ w->first)
+            KEncFileWorkersWait (w, (size_t)(w->first % KENC_RING_BLOCKS), 1);
+    }
+
+    /* top up in runs of at least half the ring */
+    if (w->next - block_id <= KENC_RING_BLOCKS / 2)
+    {
+        rc = KEncFileReadAheadFill (self, block_id + KENC_RING_BLOCKS);
+
+        /* a failure beyond this block will be seen again when reached */
+        if (rc && (w->next <= block_id))
+            return rc;
+    }
+
+    slot = (size_t)(block_id % KENC_RING_BLOCKS);
+    rc = KEncFileWorkersWait (w, slot, 1);
+    *handled = true;
+    if (rc)
+        return rc;
+
+    self->eof = false;
+    if (self->sought == false)
+    {
+        if (block_id == 0)
+        {
+            self->foot.block_count = 1;
+            self->foot.crc_checksum = w->job[slot].crc;
+        }
+        else
+        {
+            ++self->foot.block_count;
+            self->foot.crc_checksum += w->job[slot].crc;
+        }
+    }
+
+    if (w->job[slot].missing)
+    {
+        memset (&self->block, 0, sizeof self->block);
+        return RC (rcKrypto, rcFile, rcReading, rcData, rcIncomplete);
+    }
+
+    memmove (&self->block, &w->dec[slot], sizeof self->block);
+    return 0;
+}
+
+
+/* ----------
+ * WriteBlocks
+ *    encrypt and write as many whole blocks of a write only writer as
+ *    the ring holds
+ *
+ *    "handled" is set to false when the write is to be done in the
+ *    usual way
+ */
+static
+rc_t KEncFileWriteBlocks (KEncFile * self, KEncFileBlockId block_id,
+                          const void * buffer, size_t bsize,
+                          size_t * pnum_writ, bool * handled)
+{
+    KEncFileWorkers * w;
+    size_t count, i, num_writ;
+    rc_t rc = 0;
+
+    *handled = false;
+
+    if (!KEncFileWorkersReady (self))
+        return 0;
+    w = self->workers;
+
+    count = bsize / sizeof self->block.data;
+    if (count > KENC_RING_BLOCKS)
+        count = KENC_RING_BLOCKS;
+
+    /* the previous block goes out first, it writes the header if needed */
+    if (self->dirty)
+    {
+        rc = KEncFileBlockFlush (self, &self->block);
+        if (rc)
+            return rc;
+    }
+    *handled = true;
+
+    for (i = 0; i < count; ++ i)
+    {
+        KEncFileBlock * d = &w->dec[i];
+
+        d->id = block_id + i;
+        d->u.valid = sizeof d->data;
+        memmove (d->data, (const uint8_t *)buffer + i * sizeof d->data,
+                 sizeof d->data);
+    }
+    KEncFileWorkersSubmit (w, 0, count, block_id, true);
+    rc = KEncFileWorkersWait (w, 0, count);
+    if (rc)
+        return rc;
+
+    for (i = 0; i < count; ++ i)
+    {
+        if (self->foot.block_count <= block_id + i)
+            self->foot.block_count = block_id + i + 1;
+
+        if (!self->sought)
+            self->foot.crc_checksum += w->enc[i].crc;
+    }
+
+    rc = KEncFileBufferWrite (self, BlockId_to_EncryptedPos (block_id),
+                              w->enc, count * sizeof w->enc[0], &num_writ);
+    if (rc)
+        PLOGERR (klogErr, (klogErr, rc,
+                           "error writing encrypted blocks '$(B)' to '$(L)'",
+                           "B=%lu,L=%lu", block_id, block_id + count - 1));
+
+    else if (num_writ != count * sizeof w->enc[0])
+    {
+        rc = RC (rcKrypto, rcFile, rcWriting, rcBuffer, rcInsufficient);
+        PLOGERR (klogErr, (klogErr, rc, "error writing encrypted blocks "
+                           "'$(B)' to '$(L)' wrote '$(Z)'",
+                           "B=%lu,L=%lu,Z=%zu", block_id,
+                           block_id + count - 1, num_writ));
+    }
+    else
+    {
+        /* the last block becomes the current, already flushed, block */
+        memmove (&self->block, &w->dec[count - 1], sizeof self->block);
+        self->block.crc = w->job[count - 1].crc;
+        self->dirty = false;
+
+        self->dec_size = BlockId_to_DecryptedPos (block_id + count);
+        *pnum_writ = count * sizeof self->block.data;
+    }
+    return rc;
+}
+
+
 /* ----------------------------------------------------------------------
  * Interface Functions
  *
@@ -1215,6 +1836,9 @@ rc_t CC KEncFileDestroy (KEncFile *self)
 
     assert (self);
 
+    if (self->workers != NULL)
+        KEncFileWorkersWhack (self->workers);
+
     if (self->dad.write_enabled)
     {
         /*
@@ -1653,7 +2277,13 @@ rc_t CC KEncFileRead (const KEncFile *cself,
 
             /* now try to read in a new block */
             if (rc == 0)
-                rc = KEncFileBlockRead (self, &self->block, block_id, false);
+            {
+                bool handled;
+
+                rc = KEncFileReadAhead (self, block_id, &handled);
+                if ((rc == 0) && !handled)
+                    rc = KEncFileBlockRead (self, &self->block, block_id, false);
+            }
 
             if (rc == 0)
             {
@@ -1739,6 +2369,19 @@ rc_t CC KEncFileWrite (KEncFile *self, uint64_t pos,
         /* Block Id for this write */
         block_id = DecryptedPos_to_BlockId (pos, &offset);
 
+        /* several whole blocks after the first are encrypted together */
+        if ((offset == 0) && (block_id > 0) &&
+            (bsize >= 2 * sizeof self->block.data) &&
+            (!self->dad.read_enabled) && (!self->swarm))
+        {
+            bool handled;
+
+            rc = KEncFileWriteBlocks (self, block_id, buffer, bsize,
+                                      pnum_writ, &handled);
+            if (rc || handled)
+                return rc;
+        }
+
         block_max = BlockId_to_DecryptedPos (block_id+1);
 
         new_size = pos + bsize;
@@ -1846,63 +2489,6 @@ uint32_t CC KEncFileType (const KEncFile *self)
  *  create a new file object
  */
 
-/* ----------
- * KeysInit
- */
-static
-rc_t KEncFileCiphersInit (KEncFile * self, const KKey * key, bool read, bool write)
-{
-    KCipherManager * mgr;
-    size_t z;
-    rc_t rc;
-
-    switch ( key->type)
-    {
-    default:
-        return RC (rcKrypto, rcEncryptionKey, rcConstructing, rcParam, rcInvalid);
-
-    case kkeyNone:
-        return RC (rcKrypto, rcEncryptionKey, rcConstructing, rcParam, rcIncorrect);
-
-    case kkeyAES128:
-        z = 128/8; break;
-
-    case kkeyAES192:
-        z = 192/8; break;
-
-    case kkeyAES256:
-        z = 256/8; break;
-    }
-    rc = KCipherManagerMake (&mgr);
-    if (rc == 0)
-    {
-        rc = KCipherManagerMakeCipher (mgr, &self->ciphers.master, kcipher_AES);
-        if (rc == 0)
-        {
-            rc = KCipherManagerMakeCipher (mgr, &self->ciphers.block, kcipher_AES);
-            if (rc == 0)
-            {
-                rc = KCipherSetDecryptKey (self->ciphers.master, key->text, z);
-                if (rc == 0)
-                {
-                    rc = KCipherSetEncryptKey (self->ciphers.master, key->text, z);
-                    if (rc == 0)
-                        goto keep_ciphers;
-                }
-                KCipherRelease (self->ciphers.block);
-                self->ciphers.block = NULL;
-            }
-            KCipherRelease (self->ciphers.master);
-            self->ciphers.master = NULL;
-        }
-    keep_ciphers:
-        KCipherManagerRelease (mgr);
-    }
-    return rc;
-}
-
-
-
 static const KFile_vt_v1 vtKEncFile =
 {
     /* version */
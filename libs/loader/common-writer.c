@@ -35,14 +35,15 @@
 #include <klib/printf.h>
 #include <klib/status.h>
 
-#include <kdb/btree.h>
-
 #include <kfs/pmem.h>
 #include <kfs/file.h>
 #include <kfs/pagefile.h>
 
+#include <kproc/lock.h>
+
 #include <kapp/progressbar.h>
 #include <kapp/main.h>
+#include <kapp/key-index.h>
 
 #include <vdb/manager.h>
 #include <vdb/database.h>
@@ -90,39 +91,18 @@ typedef struct FragmentInfo {
 } FragmentInfo;
 
 
-rc_t OpenKBTree(const CommonWriterSettings* settings, struct KBTree **const rslt, size_t const n, size_t const max)
+rc_t OpenKeyIndex(const CommonWriterSettings* settings, struct KeyIndex **const rslt, size_t const n, size_t const max)
 {
-    size_t const cacheSize = (((settings->cache_size - (settings->cache_size / 2) - (settings->cache_size / 8)) / max)
-                            + 0xFFFFF) & ~((size_t)0xFFFFF);
-    KFile *file = NULL;
-    KDirectory *dir;
-    char fname[4096];
-    rc_t rc;
-
-    rc = KDirectoryNativeDir(&dir);
-    if (rc)
-        return rc;
-    
-    rc = string_printf(fname, sizeof(fname), NULL, "%s/key2id.%u.%u", settings->tmpfs, settings->pid, n); if (rc) return rc;
-    STSMSG(1, ("Path for scratch files: %s\n", fname));
-    rc = KDirectoryCreateFile(dir, &file, true, 0600, kcmInit, fname);
-    KDirectoryRemove(dir, 0, fname);
-    KDirectoryRelease(dir);
-    if (rc == 0) {
-        rc = KBTreeMakeUpdate(rslt, file, cacheSize,
-                              false, kbtOpaqueKey,
-                              1, 255, sizeof ( uint32_t ),
-                              NULL
-                              );
-        KFileRelease(file);
+    size_t const memLimit = (((settings->cache_size - (settings->cache_size / 2) - (settings->cache_size / 8)) / max)
+                          + 0xFFFFF) & ~((size_t)0xFFFFF);
+    rc_t const rc = KeyIndexMake(rslt, settings->tmpfs, settings->pid, (unsigned)n, memLimit);
 #if PERF
-        if (rc == 0) {
-            static unsigned treecount = 0;
+    if (rc == 0) {
+        static unsigned indexcount = 0;
 
-            (void)PLOGMSG(klogInfo, (klogInfo, "Number of trees: $(cnt)", "cnt=%u", ++treecount));
-        }
-#endif
+        (void)PLOGMSG(klogInfo, (klogInfo, "Number of key indices: $(cnt)", "cnt=%u", ++indexcount));
     }
+#endif
     return rc;
 }
 
@@ -130,17 +110,16 @@ rc_t GetKeyIDOld(const CommonWriterSettings* settings, SpotAssembler* const ctx,
 {
     size_t const keylen = strlen(key);
     rc_t rc;
-    uint64_t tmpKey;
+    uint32_t tmpKey;
 
     if (ctx->key2id_count == 0) {
-        rc = OpenKBTree(settings, &ctx->key2id[0], 1, 1);
+        rc = OpenKeyIndex(settings, &ctx->key2id[0], 1, 1);
         if (rc) return rc;
         ctx->key2id_count = 1;
     }
     if (memcmp(key, name, keylen) == 0) {
         /* qname starts with read group; no append */
-        tmpKey = ctx->idCount[0];
-        rc = KBTreeEntry(ctx->key2id[0], &tmpKey, wasInserted, name, namelen);
+        rc = KeyIndexEntry(ctx->key2id[0], &tmpKey, wasInserted, name, namelen);
     }
     else {
         char sbuf[4096];
@@ -157,8 +136,7 @@ rc_t GetKeyIDOld(const CommonWriterSettings* settings, SpotAssembler* const ctx,
         }
         rc = string_printf(buf, bsize, &actsize, "%s\t%.*s", key, (int)namelen, name);
         
-        tmpKey = ctx->idCount[0];
-        rc = KBTreeEntry(ctx->key2id[0], &tmpKey, wasInserted, buf, actsize);
+        rc = KeyIndexEntry(ctx->key2id[0], &tmpKey, wasInserted, buf, actsize);
         if (hbuf)
             free(hbuf);
     }
@@ -274,7 +252,8 @@ static size_t GetFixedNameLength(char const name[], size_t const namelen)
     return namelen;
 }
 
-rc_t GetKeyID(CommonWriterSettings *const settings,
+static
+rc_t GetKeyIDLocked(CommonWriterSettings *const settings,
               SpotAssembler *const ctx,
               uint64_t *const rslt,
               bool *const wasInserted,
@@ -291,7 +270,7 @@ rc_t GetKeyID(CommonWriterSettings *const settings,
         unsigned const h = HashKey(key, keylen);
         size_t f;
         size_t e = ctx->key2id_count;
-        uint64_t tmpKey;
+        uint32_t tmpKey;
         
         *rslt = 0;
         {{
@@ -336,8 +315,8 @@ rc_t GetKeyID(CommonWriterSettings *const settings,
         }
         if (ctx->key2id_count < ctx->key2id_max) {
             size_t const name_max = ctx->key2id_name_max + keylen + 1;
-            KBTree *tree;
-            rc_t rc = OpenKBTree(settings, &tree, ctx->key2id_count + 1, 1); /* ctx->key2id_max); */
+            struct KeyIndex *tree;
+            rc_t rc = OpenKeyIndex(settings, &tree, ctx->key2id_count + 1, 1); /* ctx->key2id_max); */
             
             if (rc) return rc;
             
@@ -379,8 +358,7 @@ rc_t GetKeyID(CommonWriterSettings *const settings,
                 ctx->key2id_hash[h] = (uint32_t)((((ctx->key2id_hash[h] & ~(0xFFu)) | f) << 8) | 3);
             }
         GET_ID:
-            tmpKey = ctx->idCount[f];
-            rc = KBTreeEntry(ctx->key2id[f], &tmpKey, wasInserted, name, namelen);
+            rc = KeyIndexEntry(ctx->key2id[f], &tmpKey, wasInserted, name, namelen);
             if (rc == 0) {
                 *rslt = (((uint64_t)f) << 32) | tmpKey;
                 if (*wasInserted)
@@ -393,6 +371,23 @@ rc_t GetKeyID(CommonWriterSettings *const settings,
     }
 }
 
+rc_t GetKeyID(CommonWriterSettings *const settings,
+              SpotAssembler *const ctx,
+              uint64_t *const rslt,
+              bool *const wasInserted,
+              char const key[],
+              char const name[],
+              size_t const o_namelen)
+{
+    rc_t rc = KLockAcquire(ctx->key2id_lock);
+    
+    if (rc == 0) {
+        rc = GetKeyIDLocked(settings, ctx, rslt, wasInserted, key, name, o_namelen);
+        KLockUnlock(ctx->key2id_lock);
+    }
+    return rc;
+}
+
 static rc_t OpenMMapFile(const CommonWriterSettings* settings, SpotAssembler *const ctx, KDirectory *const dir)
 {
     KFile *file = NULL;
@@ -444,6 +439,9 @@ rc_t SetupContext(const CommonWriterSettings* settings, SpotAssembler *ctx)
     
     ctx->pass = 1;
     
+    rc = KLockMake(&ctx->key2id_lock);
+    if (rc) return rc;
+    
     if (settings->mode == mode_Archive) {
         KDirectory *dir;
         size_t fragSizeBoth; /*** temporary hold for first side of mate pair with both sides aligned**/
@@ -488,6 +486,7 @@ void ContextRelease(SpotAssembler *ctx)
     KLoadProgressbar_Release(ctx->progress[2], true);
     KLoadProgressbar_Release(ctx->progress[3], true);
     MMArrayWhack(ctx->id2value);
+    KLockRelease(ctx->key2id_lock);
 }
 
 static
@@ -1371,7 +1370,7 @@ rc_t ArchiveFile(const struct ReaderFile *const reader,
         
         rc = GetKeyID(G, ctx, &keyId, &wasInserted, spotGroup, name, namelen);
         if (rc) {
-            (void)PLOGERR(klogErr, (klogErr, rc, "KBTreeEntry: failed on key '$(key)'", "key=%.*s", namelen, name));
+            (void)PLOGERR(klogErr, (klogErr, rc, "KeyIndexEntry: failed on key '$(key)'", "key=%.*s", namelen, name));
             goto LOOP_END;
         }
         rc = MMArrayGet(ctx->id2value, (void **)&value, keyId);
@@ -1999,9 +1998,15 @@ rc_t CommonWriterArchive(CommonWriter *const self,
                      self->align,
                      &self->had_alignments,
                      &self->had_sequences);
+    if (rc == 0) {
+        /*** names in the next file are looked up against one run per index ***/
+        size_t i;
+        for (i = 0; rc == 0 && i != self->ctx.key2id_count; ++i)
+            rc = KeyIndexMerge(self->ctx.key2id[i]);
+    }
     if (rc)
         self->commit = false;
-    
+
     self->err_count += self->settings.errCount;
     return rc;
 }
@@ -2012,8 +2017,7 @@ rc_t CommonWriterComplete(CommonWriter* self, bool quitting, uint64_t maxDistanc
     /*** No longer need memory for key2id ***/
     size_t i;
     for (i = 0; i != self->ctx.key2id_count; ++i) {
-        KBTreeDropBacking(self->ctx.key2id[i]);
-        KBTreeRelease(self->ctx.key2id[i]);
+        KeyIndexWhack(self->ctx.key2id[i]);
         self->ctx.key2id[i] = NULL;
     }
     free(self->ctx.key2id_names);
@@ -0,0 +1,318 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include "nucstrstr-wide.h"
+
+#include <string.h>
+#include <assert.h>
+#include <immintrin.h>
+
+/* this file is compiled once for each of these */
+#if USE_AVX512
+
+#define WIDEMEMBER( name ) name ## _avx512
+#define WIDE_BYTES 64
+
+typedef __m512i widereg_t;
+typedef __m256i halfreg_t;
+
+#define wide_loadu( src ) \
+    _mm512_loadu_si512 ( ( const void* ) ( src ) )
+#define half_loadu( src ) \
+    _mm256_loadu_si256 ( ( const __m256i* ) ( src ) )
+#define wide_broadcast( src ) \
+    _mm512_broadcast_i32x4 ( _mm_load_si128 ( ( const __m128i* ) ( src ) ) )
+#define wide_and( a, b ) \
+    _mm512_and_si512 ( a, b )
+
+/* mask bits are per compared element rather than per byte */
+#define MASK_BYTES( qbytes ) \
+    ( ( qbytes ) < 8 ? ( qbytes ) : 8 )
+
+#elif USE_AVX2
+
+#define WIDEMEMBER( name ) name ## _avx2
+#define WIDE_BYTES 32
+
+typedef __m256i widereg_t;
+typedef __m128i halfreg_t;
+
+#define wide_loadu( src ) \
+    _mm256_loadu_si256 ( ( const __m256i* ) ( src ) )
+#define half_loadu( src ) \
+    _mm_loadu_si128 ( ( const __m128i* ) ( src ) )
+#define wide_broadcast( src ) \
+    _mm256_broadcastsi128_si256 ( _mm_load_si128 ( ( const __m128i* ) ( src ) ) )
+#define wide_and( a, b ) \
+    _mm256_and_si256 ( a, b )
+
+/* movemask gives one bit per byte */
+#define MASK_BYTES( qbytes ) 1
+
+#else
+#error "nucstrstr-wide.c requires USE_AVX2 or USE_AVX512"
+#endif
+
+
+/* wide_match
+ *  compare a and b lane by lane, where lanes are "qbytes" wide
+ *  returns a mask with the low bit of each equal lane set,
+ *  in units of MASK_BYTES ( qbytes )
+ */
+static __inline__
+uint64_t wide_match ( widereg_t a, widereg_t b, unsigned int qbytes )
+{
+    uint64_t m;
+
+#if USE_AVX512
+    switch ( qbytes )
+    {
+    case 1:
+        return _mm512_cmpeq_epi8_mask ( a, b );
+    case 2:
+        return _mm512_cmpeq_epi16_mask ( a, b );
+    case 4:
+        return _mm512_cmpeq_epi32_mask ( a, b );
+    case 8:
+        return _mm512_cmpeq_epi64_mask ( a, b );
+    }
+
+    /* both quadwords of a 16 byte lane */
+    m = _mm512_cmpeq_epi64_mask ( a, b );
+    return m & ( m >> 1 ) & 0x55;
+#else
+    switch ( qbytes )
+    {
+    case 1:
+        return ( uint32_t ) _mm256_movemask_epi8 ( _mm256_cmpeq_epi8 ( a, b ) );
+    case 2:
+        m = ( uint32_t ) _mm256_movemask_epi8 ( _mm256_cmpeq_epi16 ( a, b ) );
+        return m & 0x55555555;
+    case 4:
+        m = ( uint32_t ) _mm256_movemask_epi8 ( _mm256_cmpeq_epi32 ( a, b ) );
+        return m & 0x11111111;
+    case 8:
+        m = ( uint32_t ) _mm256_movemask_epi8 ( _mm256_cmpeq_epi64 ( a, b ) );
+        return m & 0x01010101;
+    }
+
+    m = ( uint32_t ) _mm256_movemask_epi8 ( _mm256_cmpeq_epi64 ( a, b ) );
+    return m & ( m >> 8 ) & 0x00010001;
+#endif
+}
+
+
+/* load_4na
+ *  load half a register of 2na starting at "src"
+ *  and expand each base into a 4na nibble, giving
+ *  the same layout as expand_2na in nucstrstr.c
+ */
+static __inline__
+widereg_t load_4na ( const uint8_t *src )
+{
+    halfreg_t half = half_loadu ( src );
+    widereg_t w, idx;
+
+    /* each byte of 2na, i.e. 4 bases, becomes a 16-bit word
+       whose low byte takes the first 2 bases and high byte the last 2.
+       a table lookup per nibble does the conversion */
+#if USE_AVX512
+    w = _mm512_cvtepu8_epi16 ( half );
+    idx = _mm512_or_si512 ( _mm512_srli_epi16 ( w, 4 ),
+        _mm512_slli_epi16 ( _mm512_and_si512 ( w, _mm512_set1_epi16 ( 0x0F ) ), 8 ) );
+    return _mm512_shuffle_epi8 ( _mm512_broadcast_i32x4 ( _mm_setr_epi8 (
+        0x11, 0x12, 0x14, 0x18, 0x21, 0x22, 0x24, 0x28,
+        0x41, 0x42, 0x44, 0x48, ( char ) 0x81, ( char ) 0x82, ( char ) 0x84, ( char ) 0x88 ) ), idx );
+#else
+    w = _mm256_cvtepu8_epi16 ( half );
+    idx = _mm256_or_si256 ( _mm256_srli_epi16 ( w, 4 ),
+        _mm256_slli_epi16 ( _mm256_and_si256 ( w, _mm256_set1_epi16 ( 0x0F ) ), 8 ) );
+    return _mm256_shuffle_epi8 ( _mm256_broadcastsi128_si256 ( _mm_setr_epi8 (
+        0x11, 0x12, 0x14, 0x18, 0x21, 0x22, 0x24, 0x28,
+        0x41, 0x42, 0x44, 0x48, ( char ) 0x81, ( char ) 0x82, ( char ) 0x84, ( char ) 0x88 ) ), idx );
+#endif
+}
+
+
+/* eval_wide
+ *  the scan shared by 2na and 4na
+ *
+ *  each register holds WIDE_BYTES / qbytes copies of the pattern
+ *  in each of its 4 shifts, so one load tests that many positions
+ *  at once in each shift. "qbytes" loads at successive byte offsets
+ *  cover every starting byte within a register's worth of sequence.
+ *
+ *  unlike the SSE evaluators, the buffer is reloaded at each offset
+ *  rather than shifted, since wide byte shifts stay within 128 bits.
+ */
+static __inline__
+int eval_wide ( const void *qv, unsigned int qbytes,
+    unsigned int qlen, const uint8_t *ncbi2na, unsigned int pos, unsigned int len,
+    int is_4na )
+{
+    /* pattern and mask for each of the 4 shifts */
+    const uint8_t ( * query ) [ 2 ] [ 16 ] = qv;
+    widereg_t p0, p1, p2, p3, m0, m1, m2, m3;
+    unsigned int start, stop, b, k, span, src_lane, mask_bytes;
+    size_t bytes, tail_start;
+    const uint8_t *src;
+
+    /* the last few loads come from a zero padded copy,
+       never from beyond the end of the sequence */
+    uint8_t tail [ WIDE_BYTES * 3 ];
+
+    /* this test is performed outside */
+    assert ( len >= qlen );
+
+    /* first and last positions where a match may begin */
+    start = pos;
+    stop = pos + len - qlen;
+
+    /* the sequence length in bytes */
+    bytes = ( pos + len + 3 ) >> 2;
+
+    p0 = wide_broadcast ( query [ 0 ] [ 0 ] );
+    m0 = wide_broadcast ( query [ 0 ] [ 1 ] );
+    p1 = wide_broadcast ( query [ 1 ] [ 0 ] );
+    m1 = wide_broadcast ( query [ 1 ] [ 1 ] );
+    p2 = wide_broadcast ( query [ 2 ] [ 0 ] );
+    m2 = wide_broadcast ( query [ 2 ] [ 1 ] );
+    p3 = wide_broadcast ( query [ 3 ] [ 0 ] );
+    m3 = wide_broadcast ( query [ 3 ] [ 1 ] );
+
+    /* sequence bytes per register and per pattern lane,
+       given that 4na takes two register bytes per 2na byte */
+    span = is_4na ? WIDE_BYTES / 2 : WIDE_BYTES;
+    src_lane = is_4na ? qbytes / 2 : qbytes;
+    mask_bytes = MASK_BYTES ( qbytes );
+    tail_start = bytes;
+
+    for ( b = pos >> 2; ( b << 2 ) <= stop; b += span )
+    {
+        /* loads of this block reach "span + src_lane - 1" bytes past "b" */
+        if ( b < tail_start && b + span + src_lane > bytes )
+        {
+            tail_start = b;
+            memcpy ( tail, ncbi2na + b, bytes - b );
+            memset ( & tail [ bytes - b ], 0, sizeof tail - ( bytes - b ) );
+        }
+        src = b < tail_start ? ncbi2na + b : tail + ( b - tail_start );
+
+        for ( k = 0; k < src_lane; ++ k )
+        {
+            uint64_t ra, rb, rc, rd;
+
+            if ( is_4na )
+            {
+                widereg_t buffer = load_4na ( src + k );
+                ra = wide_match ( wide_and ( buffer, p0 ), wide_and ( buffer, m0 ), qbytes );
+                rb = wide_match ( wide_and ( buffer, p1 ), wide_and ( buffer, m1 ), qbytes );
+                rc = wide_match ( wide_and ( buffer, p2 ), wide_and ( buffer, m2 ), qbytes );
+                rd = wide_match ( wide_and ( buffer, p3 ), wide_and ( buffer, m3 ), qbytes );
+            }
+            else
+            {
+                widereg_t buffer = wide_loadu ( src + k );
+                ra = wide_match ( wide_and ( buffer, m0 ), p0, qbytes );
+                rb = wide_match ( wide_and ( buffer, m1 ), p1, qbytes );
+                rc = wide_match ( wide_and ( buffer, m2 ), p2, qbytes );
+                rd = wide_match ( wide_and ( buffer, m3 ), p3, qbytes );
+            }
+
+            /* test for any promising results */
+            if ( ( ra | rb | rc | rd ) != 0 )
+            {
+                uint64_t r [ 4 ];
+                unsigned int s;
+
+                r [ 0 ] = ra;
+                r [ 1 ] = rb;
+                r [ 2 ] = rc;
+                r [ 3 ] = rd;
+
+                /* convert each hit into a base position
+                   and keep those within range */
+                for ( s = 0; s < 4; ++ s )
+                {
+                    for ( ; r [ s ] != 0; r [ s ] &= r [ s ] - 1 )
+                    {
+                        unsigned int lane = __builtin_ctzll ( r [ s ] ) * mask_bytes;
+                        unsigned int found = ( ( b + k + ( is_4na ? lane / 2 : lane ) ) << 2 ) + s;
+                        if ( found >= start && found <= stop )
+                            return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/* Eval2na
+ * Eval4na
+ *  expand "qbytes" into a constant for each specialization
+ */
+int WIDEMEMBER ( NucStrstrWideEval2na ) ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len )
+{
+    switch ( qbytes )
+    {
+    case 1:
+        return eval_wide ( query, 1, qlen, ncbi2na, pos, len, 0 );
+    case 2:
+        return eval_wide ( query, 2, qlen, ncbi2na, pos, len, 0 );
+    case 4:
+        return eval_wide ( query, 4, qlen, ncbi2na, pos, len, 0 );
+    case 8:
+        return eval_wide ( query, 8, qlen, ncbi2na, pos, len, 0 );
+    case 16:
+        return eval_wide ( query, 16, qlen, ncbi2na, pos, len, 0 );
+    }
+
+    assert ( 0 );
+    return 0;
+}
+
+int WIDEMEMBER ( NucStrstrWideEval4na ) ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len )
+{
+    switch ( qbytes )
+    {
+    case 2:
+        return eval_wide ( query, 2, qlen, ncbi2na, pos, len, 1 );
+    case 4:
+        return eval_wide ( query, 4, qlen, ncbi2na, pos, len, 1 );
+    case 8:
+        return eval_wide ( query, 8, qlen, ncbi2na, pos, len, 1 );
+    case 16:
+        return eval_wide ( query, 16, qlen, ncbi2na, pos, len, 1 );
+    }
+
+    assert ( 0 );
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_nucstrstr_wide_
+#define _h_nucstrstr_wide_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * wide NucStrstr evaluators
+ *  versions of the non-positional 2na and 4na evaluators
+ *  using 256 or 512 bit registers
+ *
+ *  nucstrstr-wide.c is built once per instruction set,
+ *  and NucStrstrInit chooses among them by what the CPU supports
+ *
+ *  "query" [ IN ] - the 4 shifted pattern/mask pairs of 16 bytes each,
+ *  16 byte aligned, as prepared by NucStrFastaExprMake2/4
+ *
+ *  "qbytes" [ IN ] - bytes per replicated pattern lane, i.e.
+ *  1, 2, 4, 8 or 16 for 2na and 2, 4, 8 or 16 for 4na
+ *
+ *  "qlen" [ IN ] - number of bases in the pattern
+ *
+ *  "ncbi2na", "pos" and "len" are as for NucStrstrSearch, except
+ *  that data beyond the end of the sequence is never read
+ *
+ *  returns non-zero if the pattern was found
+ */
+typedef int ( * NucStrstrWideEval ) ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len );
+
+int NucStrstrWideEval2na_avx2 ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len );
+int NucStrstrWideEval4na_avx2 ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len );
+
+int NucStrstrWideEval2na_avx512 ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len );
+int NucStrstrWideEval4na_avx512 ( const void *query, unsigned int qbytes,
+    unsigned int qlen, const void *ncbi2na, unsigned int pos, unsigned int len );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_nucstrstr_wide_ */
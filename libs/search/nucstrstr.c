@@ -37,6 +37,10 @@
 #include <stdio.h>
 #include <byteswap.h>
 
+#if WIDE_NUCSTRSTR
+#include "nucstrstr-wide.h"
+#endif
+
 #define TRACE_OPERATIONS 0
 #define TRACE_PARSE 1
 #define TRACE_HEADER 1
@@ -90,6 +94,12 @@ typedef union
 
 static int8_t fasta_2na_map [ 128 ];
 static int8_t fasta_4na_map [ 128 ];
+
+#if WIDE_NUCSTRSTR
+/* chosen by NucStrstrInit when the CPU supports them */
+static NucStrstrWideEval wide_eval_2na;
+static NucStrstrWideEval wide_eval_4na;
+#endif
 static uint16_t expand_2na [ 256 ] =
    /* AAAA    AAAC    AAAG    AAAT    AACA    AACC    AACG    AACT */
 {   0x1111, 0x1112, 0x1114, 0x1118, 0x1121, 0x1122, 0x1124, 0x1128,
@@ -1296,7 +1306,7 @@ const char *nss_primary_expr ( const char *p, const char *end,
     switch ( * p )
     {
     case '^':
-        e = malloc ( sizeof e -> sub );
+        e = malloc ( sizeof * e );
         if ( e == NULL )
             * status = errno;
         else
@@ -1311,7 +1321,7 @@ const char *nss_primary_expr ( const char *p, const char *end,
         }
         return p;
     case '(':
-        e = malloc ( sizeof e -> sub );
+        e = malloc ( sizeof * e );
         if ( e == NULL )
             * status = errno;
         else
@@ -1338,7 +1348,7 @@ const char *nss_primary_expr ( const char *p, const char *end,
         {
             ++ p;
 
-            e = malloc ( sizeof e -> sub );
+            e = malloc ( sizeof * e );
             if ( e == NULL )
                 * status = errno;
             else
@@ -1377,7 +1387,7 @@ const char *nss_unary_expr ( const char *p, const char *end,
         * status = EINVAL;
     else
     {
-        NucStrExpr *e = malloc ( sizeof e -> sub );
+        NucStrExpr *e = malloc ( sizeof * e );
         if ( e == NULL )
             * status = errno;
         else
@@ -1449,7 +1459,7 @@ const char *nss_expr ( const char *p, const char *end,
                 }
 #endif
 
-                e = malloc ( sizeof e -> boolean );
+                e = malloc ( sizeof * e );
                 if ( e == NULL )
                 {
                     * status = errno;
@@ -1511,6 +1521,21 @@ void NucStrstrInit ( void )
     for ( i = 0; i < 256; ++ i )
         expand_2na [ i ] = bswap_16 ( expand_2na [ i ] );
 #endif
+
+#if WIDE_NUCSTRSTR
+    /* use the widest registers available */
+    __builtin_cpu_init ();
+    if ( __builtin_cpu_supports ( "avx512bw" ) )
+    {
+        wide_eval_2na = NucStrstrWideEval2na_avx512;
+        wide_eval_4na = NucStrstrWideEval4na_avx512;
+    }
+    else if ( __builtin_cpu_supports ( "avx2" ) )
+    {
+        wide_eval_2na = NucStrstrWideEval2na_avx2;
+        wide_eval_4na = NucStrstrWideEval4na_avx2;
+    }
+#endif
 }
 
 /* NucStrstrMake
@@ -2216,10 +2241,15 @@ int eval_2na_8 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -2266,7 +2296,14 @@ int eval_2na_8 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -2307,6 +2344,23 @@ int eval_2na_8 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -2509,10 +2563,15 @@ int eval_2na_16 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -2559,7 +2618,14 @@ int eval_2na_16 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -2600,6 +2666,23 @@ int eval_2na_16 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -2802,10 +2885,15 @@ int eval_2na_32 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -2852,7 +2940,14 @@ int eval_2na_32 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -2893,6 +2988,23 @@ int eval_2na_32 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -3096,10 +3208,15 @@ int eval_2na_64 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -3146,7 +3263,14 @@ int eval_2na_64 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -3187,6 +3311,23 @@ int eval_2na_64 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -3389,10 +3530,15 @@ int eval_2na_128 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -3439,7 +3585,14 @@ int eval_2na_128 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -3480,6 +3633,23 @@ int eval_2na_128 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -3683,6 +3853,11 @@ int eval_2na_pos ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* used to hold entry position */
 #if positional
     unsigned int start;
@@ -3691,7 +3866,7 @@ int eval_2na_pos ( const NucStrFastaExpr *self,
     /* kludge for streaming in a byte at a time
        only needed when qbytes > 1 */
 #if qbytes > 1
-    int slam;
+    int slam = 0;
     const uint8_t *p;
 #endif
 
@@ -3743,7 +3918,14 @@ int eval_2na_pos ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_2NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -3784,6 +3966,23 @@ int eval_2na_pos ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_2NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -4077,6 +4276,11 @@ int eval_4na_16 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
 #if qbytes > 2
     const uint8_t *p;
 #endif
@@ -4121,7 +4325,14 @@ int eval_4na_16 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_4NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -4166,6 +4377,23 @@ int eval_4na_16 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_4NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -4299,6 +4527,11 @@ int eval_4na_32 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
 #if qbytes > 2
     const uint8_t *p;
 #endif
@@ -4343,7 +4576,14 @@ int eval_4na_32 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_4NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -4388,6 +4628,23 @@ int eval_4na_32 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_4NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -4522,6 +4779,11 @@ int eval_4na_64 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
 #if qbytes > 2
     const uint8_t *p;
 #endif
@@ -4566,7 +4828,14 @@ int eval_4na_64 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_4NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -4611,6 +4880,23 @@ int eval_4na_64 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_4NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -4744,6 +5030,11 @@ int eval_4na_128 ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
 #if qbytes > 2
     const uint8_t *p;
 #endif
@@ -4788,7 +5079,14 @@ int eval_4na_128 ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_4NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -4833,6 +5131,23 @@ int eval_4na_128 ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_4NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -4967,6 +5282,11 @@ int eval_4na_pos ( const NucStrFastaExpr *self,
     /* used for shifting buffer, testing exit */
     unsigned int num_passes, stop;
 
+    /* shifts of lane 0 lying before "pos" on first pass */
+#if qbytes < 16
+    unsigned int skip;
+#endif
+
     /* used to hold entry position */
 #if positional
     unsigned int start;
@@ -5021,7 +5341,14 @@ int eval_4na_pos ( const NucStrFastaExpr *self,
 
     /* for reporting - give a buffer alignment */
     ALIGN_4NA_HEADER ( buffer, pos & ~ 3, len );
+#if qbytes == 16
     switch ( pos & 3 )
+#else
+    /* lanes other than 0 hold positions past "pos" in every
+       shift, so enter with all shifts and mask lane 0 below */
+    skip = pos & 3;
+    switch ( 0 )
+#endif
     {
     default:
 
@@ -5066,6 +5393,23 @@ int eval_4na_pos ( const NucStrFastaExpr *self,
                 res_adj ( rd );
                 ALIGN_4NA_RESULT ( buffer, p3, m3, ri, rd );
 
+#if qbytes < 16
+                /* drop lane 0 hits lying before entry position */
+                if ( skip != 0 )
+                {
+                    switch ( skip )
+                    {
+                    case 3:
+                        rc &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 2:
+                        rb &= ~ ( ( 1 << qbytes ) - 1 );
+                    case 1:
+                        ra &= ~ ( ( 1 << qbytes ) - 1 );
+                    }
+                    skip = 0;
+                }
+#endif
+
                 /* adjust pos */
                 pos &= ~ 3;
 
@@ -5199,6 +5543,30 @@ int eval_4na_pos ( const NucStrFastaExpr *self,
 #endif /* INTEL_INTRINSICS */
 
 
+/* EVAL_2NA
+ * EVAL_4NA
+ *  run the evaluator for "qbits" wide patterns,
+ *  preferring a wide version where one was chosen
+ */
+#if WIDE_NUCSTRSTR
+#define EVAL_2NA( qbits, self, ncbi2na, pos, len ) \
+    ( wide_eval_2na != NULL ? \
+      ( * wide_eval_2na ) ( ( self ) -> query, ( qbits ) / 8, \
+          ( self ) -> size, ncbi2na, pos, len ) : \
+      eval_2na_ ## qbits ( self, ncbi2na, pos, len ) )
+#define EVAL_4NA( qbits, self, ncbi2na, pos, len ) \
+    ( wide_eval_4na != NULL ? \
+      ( * wide_eval_4na ) ( ( self ) -> query, ( qbits ) / 8, \
+          ( self ) -> size, ncbi2na, pos, len ) : \
+      eval_4na_ ## qbits ( self, ncbi2na, pos, len ) )
+#else
+#define EVAL_2NA( qbits, self, ncbi2na, pos, len ) \
+    eval_2na_ ## qbits ( self, ncbi2na, pos, len )
+#define EVAL_4NA( qbits, self, ncbi2na, pos, len ) \
+    eval_4na_ ## qbits ( self, ncbi2na, pos, len )
+#endif
+
+
 /* NucStrstrSearch
  *  search buffer from starting position
  *
@@ -5226,40 +5594,40 @@ LIB_EXPORT int CC NucStrstrSearch ( const NucStrstr *self,
         case type_2na_64:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_2na_64 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_2NA ( 64, & self -> fasta, ncbi2na, pos, len );
         case type_4na_64:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_4na_64 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_4NA ( 64, & self -> fasta, ncbi2na, pos, len );
 #if INTEL_INTRINSICS
         case type_2na_8:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_2na_8 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_2NA ( 8, & self -> fasta, ncbi2na, pos, len );
         case type_2na_16:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_2na_16 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_2NA ( 16, & self -> fasta, ncbi2na, pos, len );
         case type_2na_32:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_2na_32 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_2NA ( 32, & self -> fasta, ncbi2na, pos, len );
         case type_2na_128:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_2na_128 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_2NA ( 128, & self -> fasta, ncbi2na, pos, len );
         case type_4na_16:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_4na_16 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_4NA ( 16, & self -> fasta, ncbi2na, pos, len );
         case type_4na_32:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_4na_32 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_4NA ( 32, & self -> fasta, ncbi2na, pos, len );
         case type_4na_128:
             if ( len < self -> fasta . size ) return 0;
 	    if(selflen) *selflen=self -> fasta . size;
-            return eval_4na_128 ( & self -> fasta, ncbi2na, pos, len );
+            return EVAL_4NA ( 128, & self -> fasta, ncbi2na, pos, len );
 #endif
         case type_2na_pos:
             if ( len < self -> fasta . size ) return 0;
@@ -0,0 +1,505 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#include "page-map.h"
+#include "blob-priv.h"
+
+#include <vdb/vdb-priv.h>
+#include <klib/rc.h>
+#include <klib/text.h>
+#include <klib/printf.h>
+#include <klib/container.h>
+#include <kproc/lock.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*--------------------------------------------------------------------------
+ * VBlobSharedKey
+ *  identifies the output of a single cursor column
+ *  independently of the cursor that produced it
+ */
+
+rc_t VBlobSharedKeyMake ( VBlobSharedKey **keyp, const char *fmt, ... )
+{
+    rc_t rc;
+    size_t size;
+    char text [ 4096 ];
+
+    va_list args;
+    va_start ( args, fmt );
+    rc = string_vprintf ( text, sizeof text, & size, fmt, args );
+    va_end ( args );
+
+    * keyp = NULL;
+
+    if ( rc == 0 )
+    {
+        VBlobSharedKey *key = malloc ( sizeof * key + size );
+        if ( key == NULL )
+            return RC ( rcVDB, rcBlob, rcConstructing, rcMemory, rcExhausted );
+
+        memcpy ( key -> text, text, size + 1 );
+        key -> size = ( uint32_t ) size;
+        key -> hash = string_hash ( text, size );
+        * keyp = key;
+    }
+
+    return rc;
+}
+
+void CC VBlobSharedKeyWhack ( void *item, void *ignore )
+{
+    free ( item );
+}
+
+static
+int VBlobSharedKeyCmp ( const VBlobSharedKey *a, const VBlobSharedKey *b )
+{
+    if ( a == b )
+        return 0;
+    if ( a -> hash != b -> hash )
+        return a -> hash < b -> hash ? -1 : 1;
+    return strcmp ( a -> text, b -> text );
+}
+
+
+/*--------------------------------------------------------------------------
+ * VBlobSharedEntry
+ *  a blob held by a shard of the shared cache
+ */
+typedef struct VBlobSharedEntry VBlobSharedEntry;
+struct VBlobSharedEntry
+{
+    BSTNode bn;
+    DLNode ln;
+    size_t size;
+    const VBlob *blob;
+    VBlobSharedKey key;
+};
+
+static
+rc_t VBlobSharedEntryMake ( VBlobSharedEntry **entryp,
+    const VBlobSharedKey *key, const VBlob *blob, size_t blob_size )
+{
+    VBlobSharedEntry *entry = malloc ( sizeof * entry + key -> size );
+    if ( entry == NULL )
+        return RC ( rcVDB, rcBlob, rcInserting, rcMemory, rcExhausted );
+
+    memcpy ( & entry -> key, key, sizeof * key + key -> size );
+    entry -> size = blob_size;
+    entry -> blob = blob;
+    VBlobAddRef ( ( VBlob* ) blob );
+
+    * entryp = entry;
+    return 0;
+}
+
+static
+void CC VBlobSharedEntryWhack ( BSTNode *n, void *ignore )
+{
+    VBlobSharedEntry *self = ( VBlobSharedEntry* ) n;
+    VBlobRelease ( ( VBlob* ) self -> blob );
+    free ( self );
+}
+
+static
+void CC VBlobSharedEntryWhackLRU ( DLNode *n, void *ignore )
+{
+    VBlobSharedEntryWhack ( ( BSTNode* ) ( ( char* ) n - sizeof ( BSTNode ) ), ignore );
+}
+
+typedef struct VBlobSharedEntryKey VBlobSharedEntryKey;
+struct VBlobSharedEntryKey
+{
+    const VBlobSharedKey *key;
+    int64_t row_id;
+};
+
+static
+int CC VBlobSharedEntryCmp ( const void *item, const BSTNode *n )
+{
+    const VBlobSharedEntryKey *a = item;
+    const VBlobSharedEntry *b = ( const VBlobSharedEntry* ) n;
+
+    int diff = VBlobSharedKeyCmp ( a -> key, & b -> key );
+    if ( diff != 0 )
+        return diff;
+
+    if ( a -> row_id < b -> blob -> start_id )
+        return -1;
+    return a -> row_id > b -> blob -> stop_id;
+}
+
+static
+int CC VBlobSharedEntrySort ( const BSTNode *item, const BSTNode *n )
+{
+    const VBlobSharedEntry *a = ( const VBlobSharedEntry* ) item;
+    const VBlobSharedEntry *b = ( const VBlobSharedEntry* ) n;
+
+    int diff = VBlobSharedKeyCmp ( & a -> key, & b -> key );
+    if ( diff != 0 )
+        return diff;
+
+    if ( a -> blob -> stop_id < b -> blob -> start_id )
+        return -1;
+    return a -> blob -> start_id > b -> blob -> stop_id;
+}
+
+
+/*--------------------------------------------------------------------------
+ * VBlobSharedCache
+ *  a read-only blob cache owned by VDBManager
+ *  and shared by all of its cached read cursors
+ *
+ *  entries are distributed among shards by key hash,
+ *  i.e. all blobs of one column land in the same shard.
+ *  each shard has its own lock, tree and LRU list, but
+ *  all of them draw from one global memory budget: when it
+ *  is exceeded, shards holding more than their even share
+ *  are trimmed first, then any shard down to the budget.
+ */
+#define VBLOB_SHARED_CACHE_SHARDS 16
+
+typedef struct VBlobSharedShard VBlobSharedShard;
+struct VBlobSharedShard
+{
+    KLock *lock;
+    BSTree cache;
+    DLList lru;
+    size_t contents;
+    uint64_t entries;
+
+    /* statistics */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evictions;
+};
+
+struct VBlobSharedCache
+{
+    /* guards "capacity" and "contents", taken inside of shard locks only */
+    KLock *budget_lock;
+    size_t capacity;
+    size_t contents;
+    VBlobSharedShard shard [ VBLOB_SHARED_CACHE_SHARDS ];
+};
+
+rc_t VBlobSharedCacheMake ( VBlobSharedCache **cachep, size_t capacity )
+{
+    rc_t rc = 0;
+    uint32_t i;
+
+    VBlobSharedCache *self = calloc ( 1, sizeof * self );
+    if ( self == NULL )
+        return RC ( rcVDB, rcMgr, rcConstructing, rcMemory, rcExhausted );
+
+    self -> capacity = capacity;
+    rc = KLockMake ( & self -> budget_lock );
+    for ( i = 0; rc == 0 && i < VBLOB_SHARED_CACHE_SHARDS; ++ i )
+    {
+        VBlobSharedShard *shard = & self -> shard [ i ];
+        BSTreeInit ( & shard -> cache );
+        DLListInit ( & shard -> lru );
+        rc = KLockMake ( & shard -> lock );
+    }
+
+    if ( rc != 0 )
+    {
+        VBlobSharedCacheWhack ( self );
+        self = NULL;
+    }
+
+    * cachep = self;
+    return rc;
+}
+
+void VBlobSharedCacheWhack ( VBlobSharedCache *self )
+{
+    if ( self != NULL )
+    {
+        uint32_t i;
+        for ( i = 0; i < VBLOB_SHARED_CACHE_SHARDS; ++ i )
+        {
+            VBlobSharedShard *shard = & self -> shard [ i ];
+            BSTreeWhack ( & shard -> cache, VBlobSharedEntryWhack, NULL );
+            KLockRelease ( shard -> lock );
+        }
+        KLockRelease ( self -> budget_lock );
+        free ( self );
+    }
+}
+
+/* Capacity
+ *  may be changed by any thread at any time
+ */
+static
+size_t VBlobSharedCacheCapacity ( const VBlobSharedCache *self )
+{
+    size_t capacity = 0;
+    if ( KLockAcquire ( self -> budget_lock ) == 0 )
+    {
+        capacity = self -> capacity;
+        KLockUnlock ( self -> budget_lock );
+    }
+    return capacity;
+}
+
+/* Charge
+ *  adds "size" to the global contents
+ *  returns true if the budget is exceeded afterwards
+ */
+static
+bool VBlobSharedCacheCharge ( VBlobSharedCache *self, int64_t size )
+{
+    bool over = false;
+    if ( KLockAcquire ( self -> budget_lock ) == 0 )
+    {
+        self -> contents += size;
+        over = self -> contents > self -> capacity;
+        KLockUnlock ( self -> budget_lock );
+    }
+    return over;
+}
+
+/* Evict
+ *  unlinks least recently used entries of a shard while the global
+ *  budget is exceeded and the shard holds more than "keep" bytes
+ *  victims are moved onto "dead" to be whacked outside of the lock
+ *  must be called with shard lock held
+ */
+static
+void VBlobSharedShardEvict ( VBlobSharedCache *self,
+    VBlobSharedShard *shard, size_t keep, DLList *dead )
+{
+    bool over = VBlobSharedCacheCharge ( self, 0 );
+    while ( over && shard -> contents > keep )
+    {
+        VBlobSharedEntry *victim;
+        DLNode *last = DLListPopTail ( & shard -> lru );
+        if ( last == NULL )
+            break;
+
+        victim = ( VBlobSharedEntry* ) ( ( char* ) last - sizeof victim -> bn );
+        BSTreeUnlink ( & shard -> cache, & victim -> bn );
+        shard -> contents -= victim -> size;
+        -- shard -> entries;
+        ++ shard -> evictions;
+
+        DLListPushTail ( dead, & victim -> ln );
+        over = VBlobSharedCacheCharge ( self, - ( int64_t ) victim -> size );
+    }
+}
+
+/* Trim
+ *  brings the cache back within its budget
+ *  visits the shards one at a time, starting after "first",
+ *  in a first pass only shards above their even share give up entries
+ *  must be called without any shard lock held
+ */
+static
+void VBlobSharedCacheTrim ( VBlobSharedCache *self, uint32_t first )
+{
+    uint32_t pass, i;
+    size_t fair = VBlobSharedCacheCapacity ( self ) / VBLOB_SHARED_CACHE_SHARDS;
+
+    for ( pass = 0; pass < 2; ++ pass )
+    {
+        for ( i = 1; i <= VBLOB_SHARED_CACHE_SHARDS; ++ i )
+        {
+            VBlobSharedShard *shard = & self -> shard [ ( first + i ) % VBLOB_SHARED_CACHE_SHARDS ];
+
+            if ( ! VBlobSharedCacheCharge ( self, 0 ) )
+                return;
+
+            if ( KLockAcquire ( shard -> lock ) == 0 )
+            {
+                DLList dead;
+                DLListInit ( & dead );
+
+                VBlobSharedShardEvict ( self, shard, pass == 0 ? fair : 0, & dead );
+                KLockUnlock ( shard -> lock );
+
+                DLListWhack ( & dead, VBlobSharedEntryWhackLRU, NULL );
+            }
+        }
+    }
+}
+
+void VBlobSharedCacheSetCapacity ( VBlobSharedCache *self, size_t capacity )
+{
+    if ( self != NULL )
+    {
+        if ( KLockAcquire ( self -> budget_lock ) == 0 )
+        {
+            self -> capacity = capacity;
+            KLockUnlock ( self -> budget_lock );
+        }
+        VBlobSharedCacheTrim ( self, 0 );
+    }
+}
+
+bool VBlobSharedCacheEnabled ( const VBlobSharedCache *self )
+{
+    return self != NULL && VBlobSharedCacheCapacity ( self ) != 0;
+}
+
+/* Find
+ *  returns a new reference to a blob for "key" containing "row_id"
+ *  or NULL if not cached
+ */
+const VBlob *VBlobSharedCacheFind ( VBlobSharedCache *self,
+    const VBlobSharedKey *key, int64_t row_id )
+{
+    const VBlob *blob = NULL;
+    VBlobSharedShard *shard = & self -> shard [ key -> hash % VBLOB_SHARED_CACHE_SHARDS ];
+
+    if ( KLockAcquire ( shard -> lock ) == 0 )
+    {
+        VBlobSharedEntry *entry;
+        VBlobSharedEntryKey ekey;
+
+        ekey . key = key;
+        ekey . row_id = row_id;
+        entry = ( VBlobSharedEntry* ) BSTreeFind ( & shard -> cache, & ekey, VBlobSharedEntryCmp );
+        if ( entry == NULL )
+            ++ shard -> misses;
+        else
+        {
+            /* maintain LRU */
+            DLListUnlink ( & shard -> lru, & entry -> ln );
+            DLListPushHead ( & shard -> lru, & entry -> ln );
+
+            blob = entry -> blob;
+            VBlobAddRef ( ( VBlob* ) blob );
+            ++ shard -> hits;
+        }
+
+        KLockUnlock ( shard -> lock );
+    }
+
+    return blob;
+}
+
+/* Save
+ *  offer a blob produced under "key" to other cursors
+ */
+rc_t VBlobSharedCacheSave ( VBlobSharedCache *self,
+    const VBlobSharedKey *key, const VBlob *blob )
+{
+    rc_t rc;
+    size_t blob_size;
+    VBlobSharedEntry *entry;
+    uint32_t shard_idx = key -> hash % VBLOB_SHARED_CACHE_SHARDS;
+    VBlobSharedShard *shard = & self -> shard [ shard_idx ];
+
+    if ( blob -> no_cache )
+        return 0;
+
+    /* blobs larger than a quarter of the whole budget are not shared */
+    blob_size = sizeof * entry + key -> size + sizeof * blob + VBlobCacheFootprint ( blob );
+    if ( blob_size > VBlobSharedCacheCapacity ( self ) / 4 )
+        return 0;
+
+    rc = VBlobExpandPageMap ( blob );
+    if ( rc == 0 )
+        rc = VBlobSharedEntryMake ( & entry, key, blob, blob_size );
+    if ( rc == 0 )
+    {
+        rc = KLockAcquire ( shard -> lock );
+        if ( rc == 0 )
+        {
+            VBlobSharedEntry *existing;
+            bool over = false;
+            DLList dead;
+            DLListInit ( & dead );
+
+            /* another cursor may have beaten us to it */
+            if ( BSTreeInsertUnique ( & shard -> cache, & entry -> bn,
+                     ( BSTNode** ) & existing, VBlobSharedEntrySort ) != 0 )
+            {
+                DLListPushTail ( & dead, & entry -> ln );
+            }
+            else
+            {
+                shard -> contents += blob_size;
+                ++ shard -> entries;
+                ++ shard -> inserts;
+                DLListPushHead ( & shard -> lru, & entry -> ln );
+
+                over = VBlobSharedCacheCharge ( self, ( int64_t ) blob_size );
+            }
+
+            KLockUnlock ( shard -> lock );
+
+            DLListWhack ( & dead, VBlobSharedEntryWhackLRU, NULL );
+
+            /* other shards are tried before the one just added to */
+            if ( over )
+                VBlobSharedCacheTrim ( self, shard_idx );
+        }
+        else
+        {
+            VBlobSharedEntryWhack ( & entry -> bn, NULL );
+        }
+    }
+
+    return rc;
+}
+
+/* GetStats
+ *  sum counters over all shards
+ */
+void VBlobSharedCacheGetStats ( VBlobSharedCache *self, VBlobCacheStats *stats )
+{
+    uint32_t i;
+
+    memset ( stats, 0, sizeof * stats );
+    if ( self == NULL )
+        return;
+
+    stats -> capacity = VBlobSharedCacheCapacity ( self );
+    for ( i = 0; i < VBLOB_SHARED_CACHE_SHARDS; ++ i )
+    {
+        VBlobSharedShard *shard = & self -> shard [ i ];
+        if ( KLockAcquire ( shard -> lock ) == 0 )
+        {
+            stats -> contents += shard -> contents;
+            stats -> entries += shard -> entries;
+            stats -> hits += shard -> hits;
+            stats -> misses += shard -> misses;
+            stats -> inserts += shard -> inserts;
+            stats -> evictions += shard -> evictions;
+            KLockUnlock ( shard -> lock );
+        }
+    }
+}
@@ -68,25 +68,9 @@ struct PageMap;
 struct BlobHeaders;
 struct VProduction;
 struct VBlobPageMapCache;
+struct VDecodePool;
 
-typedef struct PageMapProcessRequest{
-    struct PageMap *pm;        /**** deserialized form **/
-    KDataBuffer data;   /**** serialized   form **/
-    uint32_t    row_count;
-    uint64_t    elem_count;
-    rc_t rc;            /**** results **/
-
-    volatile enum {
-        ePMPR_STATE_NONE=0,
-        ePMPR_STATE_SERIALIZE_REQUESTED,
-        ePMPR_STATE_DESERIALIZE_REQUESTED,
-        ePMPR_STATE_SERIALIZE_DONE,
-        ePMPR_STATE_DESERIALIZE_DONE,
-	ePMPR_STATE_EXIT
-    } state;            /**** request state      **/
-    struct KLock      *lock;
-    struct KCondition *cond;
-} PageMapProcessRequest;
+typedef struct PageMapProcessRequest PageMapProcessRequest;
 
 
 /*--------------------------------------------------------------------------
@@ -100,6 +84,7 @@ struct VBlob
     struct PageMap *pm;
     struct BlobHeaders *headers;
     struct VBlobPageMapCache *spmc; /* cache for split */
+    PageMapProcessRequest *pmpr; /* page map being deserialized in background */
     KDataBuffer data;
     KRefcount refcount;
 
@@ -152,7 +137,7 @@ rc_t VBlobCreateFromData(
                          int64_t start_id, int64_t stop_id,
                          const KDataBuffer *src,
                          uint32_t elem_bits,
-			 PageMapProcessRequest const *pmpr
+                         struct VDecodePool *pool
 );
 
 rc_t VBlobCreateFromSingleRow(
@@ -190,8 +175,53 @@ void VBlobMRUCacheDestroy( VBlobMRUCache *self );
 const VBlob* VBlobMRUCacheFind(const VBlobMRUCache *cself, uint32_t col_idx, int64_t row_id);
 rc_t VBlobMRUCacheSave(const VBlobMRUCache *cself, uint32_t col_idx, const VBlob *blob);
 
+/* CacheFootprint
+ *  bytes charged against a cache budget for holding blob
+ */
+size_t VBlobCacheFootprint ( const VBlob *self );
+
+
+/*--------------------------------------------------------------------------
+ * VBlobSharedCache
+ *  process-wide, thread-safe cache of decoded cursor-column blobs
+ *  owned by VDBManager and shared among its cached read cursors
+ */
+struct VBlobCacheStats;
+
+typedef struct VBlobSharedKey VBlobSharedKey;
+struct VBlobSharedKey
+{
+    uint32_t hash;
+    uint32_t size;
+    char text [ 1 ];
+};
 
-rc_t PageMapProcessGetPagemap(const PageMapProcessRequest *self,struct PageMap **pm);
+rc_t VBlobSharedKeyMake ( VBlobSharedKey **key, const char *fmt, ... );
+void CC VBlobSharedKeyWhack ( void *item, void *ignore );
+
+typedef struct VBlobSharedCache VBlobSharedCache;
+
+rc_t VBlobSharedCacheMake ( VBlobSharedCache **cache, size_t capacity );
+void VBlobSharedCacheWhack ( VBlobSharedCache *self );
+void VBlobSharedCacheSetCapacity ( VBlobSharedCache *self, size_t capacity );
+bool VBlobSharedCacheEnabled ( const VBlobSharedCache *self );
+const VBlob *VBlobSharedCacheFind ( VBlobSharedCache *self, const VBlobSharedKey *key, int64_t row_id );
+rc_t VBlobSharedCacheSave ( VBlobSharedCache *self, const VBlobSharedKey *key, const VBlob *blob );
+void VBlobSharedCacheGetStats ( VBlobSharedCache *self, struct VBlobCacheStats *stats );
+
+
+/* ResolvePageMap
+ *  collect a page map being deserialized in background, if any
+ *  must be called before accessing "pm" of a blob that came
+ *  from VBlobCreateFromData with a decode pool
+ */
+rc_t VBlobResolvePageMap ( const VBlob *self );
+
+/* ExpandPageMap
+ *  resolve and fully expand page map and mark it shared
+ *  so that blob may be read by other threads
+ */
+rc_t VBlobExpandPageMap ( const VBlob *self );
 
 
 #ifdef __cplusplus
@@ -32,12 +32,14 @@
 #include "blob-headers.h"
 #include "blob.h"
 #include "blob-priv.h"
+#include "decode-pool.h"
 #include <klib/rc.h>
 #include <klib/defs.h>
 #include <byteswap.h>
 #include <klib/data-buffer.h>
 #include <klib/container.h>
 #include <klib/vlen-encode.h>
+#include <klib/slab.h>
 #include <kdb/btree.h>
 #include <vdb/schema.h>
 #include <vdb/xform.h>
@@ -70,6 +72,24 @@ void VBlobCheckIntegrity ( const VBlob *self )
 }
 #endif
 
+/* blobs are recycled, unless they carry a name of variable length */
+#if ! VBLOG_HAS_NAME
+static KSlab VBlobSlab = KSLAB_INIT ( sizeof ( VBlob ), 256 );
+#define VBlobFree( self ) KSlabFree ( & VBlobSlab, self )
+#else
+#define VBlobFree( self ) free ( self )
+#endif
+
+void VBlobGetSlabStats ( KSlabStats *blobs, KSlabStats *page_maps )
+{
+#if ! VBLOG_HAS_NAME
+    KSlabGetStats ( & VBlobSlab, blobs );
+#else
+    memset ( blobs, 0, sizeof * blobs );
+#endif
+    PageMapGetSlabStats ( page_maps );
+}
+
 rc_t VBlobNew ( VBlob **lhs, int64_t start_id, int64_t stop_id, const char *name ) {
     VBlob *y;
     
@@ -78,7 +98,9 @@ rc_t VBlobNew ( VBlob **lhs, int64_t start_id, int64_t stop_id, const char *name
 #if VBLOG_HAS_NAME
     *lhs = y = malloc(sizeof(*y) + strlen(name));
 #else
-    *lhs = y = calloc(1, sizeof(*y));
+    *lhs = y = KSlabAlloc ( & VBlobSlab );
+    if (y)
+        memset(y, 0, sizeof(*y));
 #endif
     if (y) {
         KRefcountInit(&y->refcount, 1, "VBlob", "new", name);
@@ -90,6 +112,7 @@ rc_t VBlobNew ( VBlob **lhs, int64_t start_id, int64_t stop_id, const char *name
         y->pm = NULL;
         y->headers = NULL;
         y->spmc = NULL;
+        y->pmpr = NULL;
         memset(&y->data, 0, sizeof(y->data));
         y->no_cache = 0;
         strcpy(&(((char *)y->name)[0]), name);
@@ -118,7 +141,11 @@ rc_t VBlobNewAsArray(struct VBlob **lhs, int64_t start_id, int64_t stop_id, uint
 	return rc;
 }
 
+static void PageMapProcessRequestWhack ( PageMapProcessRequest *self );
+
 static rc_t VBlobDestroy( VBlob *that ) {
+    if (that->pmpr)
+        PageMapProcessRequestWhack(that->pmpr);
     if (that->spmc) {
         int i;
         
@@ -129,7 +156,7 @@ static rc_t VBlobDestroy( VBlob *that ) {
     KDataBufferWhack(&that->data);
     BlobHeadersRelease(that->headers);
     PageMapRelease(that->pm);
-    free(that);
+    VBlobFree(that);
     return 0;
 }
 
@@ -374,69 +401,144 @@ static rc_t encode_header_v2(
     return 0;
 }
 
-static
-rc_t PageMapProcessRequestLock(PageMapProcessRequest *self)
+/*--------------------------------------------------------------------------
+ * PageMapProcessRequest
+ *  background deserialization of a blob page map
+ */
+struct PageMapProcessRequest
 {
-	rc_t rc=RC(rcVDB,rcPagemap, rcConstructing, rcSelf, rcNull);
-	if(self){
-		/*** no plans to wait here the thread should be released by now ****/
-		rc = KLockAcquire(self->lock);
-		if(rc == 0){
-			if(self->state != ePMPR_STATE_NONE){ /*** thread is not released yet **/
-				assert(0); /** should not happen ***/
-				KLockUnlock(self->lock);
-				rc=RC(rcVDB, rcPagemap, rcConstructing, rcThread, rcBusy);
-			}
-		}
-	}
-	return rc;
+    VDecodeJob dad;
+    struct VDecodePool *pool;
+    struct PageMap *pm;         /* deserialized form */
+    KDataBuffer data;           /* serialized form */
+    uint32_t row_count;
+};
+
+/* page map requests are made for blobs decoded in the background */
+static KSlab PageMapProcessRequestSlab = KSLAB_INIT ( sizeof ( PageMapProcessRequest ), 64 );
+
+void VBlobTrimSlabs ( void )
+{
+#if ! VBLOG_HAS_NAME
+    KSlabTrim ( & VBlobSlab );
+#endif
+    KSlabTrim ( & PageMapProcessRequestSlab );
+    PageMapTrimSlab ();
 }
 
+/* a page map this small is cheaper to decode than to hand off */
+#define PAGEMAP_ASYNC_MIN_BYTES 64
+
 static
-void PageMapProcessRequestLaunch(PageMapProcessRequest *self)
+rc_t PageMapProcessRequestRun ( VDecodeJob *job )
 {
-	KConditionSignal ( self -> cond );
-	KLockUnlock(self -> lock);
+    PageMapProcessRequest *self = ( PageMapProcessRequest* ) job;
+    rc_t rc = PageMapDeserialize ( & self -> pm, self -> data . base,
+        self -> data . elem_count, self -> row_count );
+    if ( rc == 0 )
+    {
+        /* expanded here so that readers never mutate it */
+        rc = PageMapExpandFull ( self -> pm );
+        assert ( rc == 0 );
+    }
+    KDataBufferWhack ( & self -> data );
+    return rc;
 }
 
-rc_t PageMapProcessGetPagemap(const PageMapProcessRequest *cself,struct PageMap **pm)
+static
+rc_t PageMapProcessRequestMake ( PageMapProcessRequest **pmprp,
+    struct VDecodePool *pool, const KDataBuffer *data,
+    uint32_t offset, uint32_t size, uint32_t row_count )
 {
-	rc_t rc=RC(rcVDB,rcPagemap, rcConstructing, rcSelf, rcNull);
-        if(cself){
-	    PageMapProcessRequest *self=(PageMapProcessRequest*)cself;
-	    if(self->lock == NULL){
-		/** NOT LOCKABLE **/
-		rc=0;
-	    } else if((rc = KLockAcquire ( self->lock ))==0){
-CHECK_AGAIN:
-		switch(self->state){
-		 case ePMPR_STATE_DESERIALIZE_REQUESTED:
-			/*fprintf(stderr,"Waiting for pagemap %p\n",cself->lock);*/
-			rc = KConditionWait ( self -> cond, self -> lock );
-                        goto CHECK_AGAIN;
-		 case ePMPR_STATE_DESERIALIZE_DONE:
-			assert(self->pm);
-			/*fprintf(stderr,"Pagemap %p Used R:%6d|DR:%d|LR:%d\n",self->lock, self->pm->row_count,self->pm->data_recs,self->pm->leng_recs);*/
-			*pm=self->pm;
-			self->pm = NULL;
-			KDataBufferWhack(&self->data);
-			self->row_count = 0;
-			self->state = ePMPR_STATE_NONE;
-			KConditionSignal(self->cond);
-			KLockUnlock(self -> lock);
-			break;
-		case ePMPR_STATE_NONE: /* not requested */
-			KLockUnlock(self -> lock);
-		    rc = 0;
-		    break;
-		 default: /** should never happen ***/
-			assert(0);
-			KLockUnlock(self -> lock);
-			return RC(rcVDB, rcPagemap, rcConverting, rcParam, rcInvalid );
-		}
-	    }
+    rc_t rc;
+    PageMapProcessRequest *pmpr = KSlabAlloc ( & PageMapProcessRequestSlab );
+    if ( pmpr == NULL )
+        return RC ( rcVDB, rcPagemap, rcConstructing, rcMemory, rcExhausted );
+
+    VDecodeJobInit ( & pmpr -> dad, PageMapProcessRequestRun );
+    pmpr -> pool = pool;
+    pmpr -> pm = NULL;
+    pmpr -> row_count = row_count;
+    rc = KDataBufferSub ( data, & pmpr -> data, offset, size );
+    if ( rc == 0 )
+    {
+        rc = VDecodePoolSubmit ( pool, & pmpr -> dad );
+        if ( rc == 0 )
+        {
+            * pmprp = pmpr;
+            return 0;
         }
+        KDataBufferWhack ( & pmpr -> data );
+    }
+    KSlabFree ( & PageMapProcessRequestSlab, pmpr );
+    return rc;
+}
+
+static
+void PageMapProcessRequestWhack ( PageMapProcessRequest *self )
+{
+    if ( VDecodePoolCancel ( self -> pool, & self -> dad ) )
+        PageMapRelease ( self -> pm );
+    else
+        KDataBufferWhack ( & self -> data );
+    KSlabFree ( & PageMapProcessRequestSlab, self );
+}
+
+rc_t VBlobResolvePageMap ( const VBlob *cself )
+{
+    rc_t rc;
+    VBlob *self = ( VBlob* ) cself;
+    PageMapProcessRequest *pmpr;
+
+    if ( self == NULL )
+        return RC ( rcVDB, rcBlob, rcAccessing, rcSelf, rcNull );
+
+    pmpr = self -> pmpr;
+    if ( pmpr == NULL )
+        return 0;
+
+    rc = VDecodePoolWait ( pmpr -> pool, & pmpr -> dad );
+    if ( rc == 0 )
+    {
+        assert ( self -> pm == NULL );
+        self -> pm = pmpr -> pm;
+        pmpr -> pm = NULL;
+    }
+
+    self -> pmpr = NULL;
+    PageMapProcessRequestWhack ( pmpr );
+
+    return rc;
+}
+
+/* ExpandPageMap
+ *  PageMap lookups expand regions lazily and remember the last hit.
+ *  expand completely before handing the blob to other threads,
+ *  and mark the map shared, so that readers write nothing at all.
+ */
+rc_t VBlobExpandPageMap ( const VBlob *self )
+{
+    const PageMap *pm;
+    rc_t rc = VBlobResolvePageMap ( self );
+    if ( rc != 0 )
         return rc;
+
+    pm = self -> pm;
+    if ( pm == NULL )
+        return 0;
+
+    rc = 0;
+    if ( pm -> data_recs != 1 &&
+         ! ( pm -> random_access && pm -> leng_recs == 1 ) &&
+         pm -> exp_row_last < pm -> row_count )
+    {
+        rc = PageMapExpand ( pm, pm -> row_count );
+    }
+
+    /* from here on lookups leave the search hint alone */
+    if ( rc == 0 )
+        ( ( PageMap* ) pm ) -> shared = true;
+    return rc;
 }
 
 
@@ -445,7 +547,7 @@ rc_t VBlobCreateFromData_v2(
                             VBlob **lhs,
                             const KDataBuffer *data,
                             int64_t start_id, int64_t stop_id,
-                            uint32_t elem_bits, PageMapProcessRequest *pmpr
+                            uint32_t elem_bits, struct VDecodePool *pool
 ) {
     uint64_t ssize = data->elem_count;
     uint32_t hsize;
@@ -483,13 +585,8 @@ rc_t VBlobCreateFromData_v2(
             rc = BlobHeadersCreateFromData(&y->headers, src+offset , hsize);
         if (rc == 0) {
             if (msize > 0) {
-                if(PageMapProcessRequestLock(pmpr)==0) {
-                    KDataBufferSub(data, &pmpr->data, pagemap_offset, msize);
-                    pmpr->row_count = BlobRowCount(y);
-                    pmpr->state = ePMPR_STATE_DESERIALIZE_REQUESTED;
-                    /*fprintf(stderr,"Pagemap %p Requested R:%6d|SZ:%d|%ld:%ld\n",pmpr->lock, pmpr->row_count,msize,start_id, stop_id);*/
-                    PageMapProcessRequestLaunch(pmpr);
-                }
+                if (pool != NULL && msize >= PAGEMAP_ASYNC_MIN_BYTES)
+                    rc = PageMapProcessRequestMake(&y->pmpr, pool, data, pagemap_offset, msize, BlobRowCount(y));
                 else {
                     KDataBuffer tdata;
                     KDataBufferSub(data, &tdata, pagemap_offset, msize);
@@ -605,7 +702,7 @@ rc_t VBlobCreateFromData_v1(
         }
         /* like a call to VBlobRelease (y); */
         TRACK_BLOB (VBlobRelease-free, y);
-        free(y);
+        VBlobFree(y);
     }
     return rc;
 }
@@ -935,7 +1032,7 @@ rc_t VBlobSerialize ( const VBlob *self, KDataBuffer *result ) {
 rc_t VBlobCreateFromData ( struct VBlob **lhs,
                          int64_t start_id, int64_t stop_id,
                          const KDataBuffer *src,
-                         uint32_t elem_bits , PageMapProcessRequest const *pmpr)
+                         uint32_t elem_bits , struct VDecodePool *pool)
 {
     VBlob *y = NULL;
     rc_t rc;
@@ -950,7 +1047,7 @@ rc_t VBlobCreateFromData ( struct VBlob **lhs,
     if ((((const uint8_t *)src->base)[0] & 0x80) == 0)
         rc = VBlobCreateFromData_v1(&y, src, start_id, stop_id, elem_bits);
     else
-        rc = VBlobCreateFromData_v2(&y, src, start_id, stop_id, elem_bits, (PageMapProcessRequest*)pmpr);
+        rc = VBlobCreateFromData_v2(&y, src, start_id, stop_id, elem_bits, pool);
 
     if (rc == 0)
         *lhs = y;
@@ -1421,6 +1518,18 @@ int CC VBlobCacheSort ( const BSTNode *a, const BSTNode *b )
     return item -> blob -> start_id > node -> blob -> stop_id;
 }
 
+size_t VBlobCacheFootprint ( const VBlob *self )
+{
+    size_t bytes = KDataBufferBytes ( & self -> data );
+    if ( self -> pm != NULL )
+    {
+        bytes += KDataBufferBytes ( & self -> pm -> cstorage )
+               + KDataBufferBytes ( & self -> pm -> dstorage )
+               + KDataBufferBytes ( & self -> pm -> istorage );
+    }
+    return bytes;
+}
+
 struct VBlobMRUCache { /* read-only blob cache */
     BSTree cache;
     DLList lru;
@@ -1513,13 +1622,7 @@ rc_t VBlobMRUCacheSave(const VBlobMRUCache *cself, uint32_t col_idx, const VBlob
 
     if(blob->no_cache) return 0;
 
-    blob_size  += KDataBufferBytes(&blob->data);
-    if (blob->pm != NULL) {
-        blob_size += 
-                  KDataBufferBytes(&blob->pm->cstorage)
-                + KDataBufferBytes(&blob->pm->dstorage)
-                + KDataBufferBytes(&blob->pm->istorage);
-    }
+    blob_size  += VBlobCacheFootprint(blob);
     /** auto-raise capacity for large blob **/
     if(blob_size > self -> capacity) self -> capacity = blob_size;
 
@@ -80,5 +80,16 @@ rc_t VBlobMakeRowBuffer( struct VRowBuffer **lhs,
  */
 rc_t VBlobSerialize(const VBlob *cself, KDataBuffer *result);
 
+/* GetSlabStats
+ *  recycling of blob and page map objects, which is process-wide
+ */
+struct KSlabStats;
+void VBlobGetSlabStats ( struct KSlabStats *blobs, struct KSlabStats *page_maps );
+
+/* TrimSlabs
+ *  free blob, page map and page map request objects kept for recycling
+ */
+void VBlobTrimSlabs ( void );
+
 
 #endif /* _h_blob_ */
@@ -45,6 +45,8 @@
 #undef KONST
 #undef SKONST
 #include "blob-priv.h"
+#include "decode-pool.h"
+#include "cursor-template.h"
 #include "page-map.h"
 
 #include <vdb/cursor.h>
@@ -52,6 +54,7 @@
 #include <vdb/vdb-priv.h>
 #include <kdb/table.h>
 #include <kdb/meta.h>
+#include <kdb/kdb-priv.h>
 #include <kdb/namelist.h>
 #include <kfs/dyload.h>
 #include <klib/symbol.h>
@@ -82,10 +85,8 @@
 #define DISABLE_READ_CACHE 0
 #endif
 
-/* normally false
-   can be set for certain applications using VDBManagerDisablePagemapThread
-*/
-static bool s_disable_pagemap_thread;
+/* cache given by VCursorSetReadAhead to a cursor created without one */
+#define VCURSOR_READ_AHEAD_CACHE ( 32 * 1024 * 1024 )
 
 
 /*--------------------------------------------------------------------------
@@ -258,7 +259,9 @@ static void CC VCursorVColumnWhack_checked( void *item, void *data )
 rc_t VCursorDestroy ( VCursor *self )
 {
     KRefcountWhack ( & self -> refcount, "VCursor" );
+    VCursorReadAheadWhack ( self -> read_ahead );
     VBlobMRUCacheDestroy ( self->blob_mru_cache);
+    VectorWhack ( & self -> blob_shared_keys, VBlobSharedKeyWhack, NULL );
     if ( self -> user_whack != NULL )
         ( * self -> user_whack ) ( self -> user );
     BSTreeWhack ( & self -> named_params, NamedParamNodeWhack, NULL );
@@ -313,6 +316,26 @@ LIB_EXPORT rc_t CC VCursorRelease ( const VCursor *self )
     return 0;
 }
 
+/* Init
+ *  finish construction once the schema and table are in place
+ */
+static
+void VCursorInit ( VCursor *curs, const VTable *tbl )
+{
+    curs -> tbl = VTableAttach ( tbl );
+    VectorInit ( & curs -> row, 1, 16 );
+    VCursorCacheInit ( & curs -> col, 0, 16 );
+    VCursorCacheInit ( & curs -> phys, 0, 16 );
+    VCursorCacheInit ( & curs -> prod, 0, 16 );
+    VectorInit ( & curs -> owned, 0, 64 );
+    VectorInit ( & curs -> trig, 0, 64 );
+    VectorInit ( & curs -> blob_shared_keys, 1, 16 );
+    KRefcountInit ( & curs -> refcount, 1, "VCursor", "make", "vcurs" );
+    curs -> state = vcConstruct;
+    curs -> permit_add_column = true;
+    curs -> suspend_triggers  = false;
+}
+
 /* Make - PRIVATE
  */
 rc_t VCursorMake ( VCursor **cursp, const VTable *tbl )
@@ -340,17 +363,7 @@ rc_t VCursorMake ( VCursor **cursp, const VTable *tbl )
             rc = STableCloneExtend ( tbl -> stbl, & curs -> stbl, curs -> schema );
             if ( rc == 0 )
             {
-                curs -> tbl = VTableAttach ( tbl );
-                VectorInit ( & curs -> row, 1, 16 );
-                VCursorCacheInit ( & curs -> col, 0, 16 );
-                VCursorCacheInit ( & curs -> phys, 0, 16 );
-                VCursorCacheInit ( & curs -> prod, 0, 16 );
-                VectorInit ( & curs -> owned, 0, 64 );
-                VectorInit ( & curs -> trig, 0, 64 );
-                KRefcountInit ( & curs -> refcount, 1, "VCursor", "make", "vcurs" );
-                curs -> state = vcConstruct;
-                curs -> permit_add_column = true;
-                curs -> suspend_triggers  = false;
+                VCursorInit ( curs, tbl );
                 * cursp = curs;
                 return 0;
             }
@@ -366,6 +379,43 @@ rc_t VCursorMake ( VCursor **cursp, const VTable *tbl )
     return rc;
 }
 
+/* MakeFromTemplate - PRIVATE
+ *  the cursor schema is a child of the template schema,
+ *  taking the extended table from it as is
+ */
+rc_t VCursorMakeFromTemplate ( VCursor **cursp, const VTable *tbl,
+    const VSchema *tmpl, const STable *stbl )
+{
+    rc_t rc;
+    VCursor *curs;
+
+    assert ( cursp != NULL );
+    assert ( tbl != NULL );
+    assert ( tmpl != NULL && stbl != NULL );
+
+    curs = calloc ( 1, sizeof * curs );
+    if ( curs == NULL )
+        rc = RC ( rcVDB, rcCursor, rcConstructing, rcMemory, rcExhausted );
+    else
+    {
+        /* column metadata may still add declarations to the child */
+        rc = VSchemaMake ( & curs -> schema, tmpl );
+        if ( rc == 0 )
+        {
+            curs -> stbl = ( STable* ) stbl;
+            VCursorInit ( curs, tbl );
+            * cursp = curs;
+            return 0;
+        }
+
+        free ( curs );
+    }
+
+    * cursp = NULL;
+
+    return rc;
+}
+
 /* SupplementSchema
  *  scan table for physical column names
  *  create transparent yet incomplete (untyped) columns for unknown names
@@ -414,10 +464,10 @@ rc_t VCursorSupplementName ( const KSymTable *tbl,
 }
 
 static
-rc_t VCursorSupplementPhysical ( const KSymTable *tbl, const VCursor *self )
+rc_t VCursorSupplementPhysical ( const KSymTable *tbl, const VTable *vtbl, STable *stbl )
 {
     KNamelist *names;
-    rc_t rc = KTableListCol ( self -> tbl -> ktbl, & names );
+    rc_t rc = KTableListCol ( vtbl -> ktbl, & names );
     if ( rc == 0 )
     {
         uint32_t i, count;
@@ -427,7 +477,7 @@ rc_t VCursorSupplementPhysical ( const KSymTable *tbl, const VCursor *self )
             const char *name;
             rc = KNamelistGet ( names, i, & name );
             if ( rc == 0 )
-                rc = VCursorSupplementName ( tbl, self -> stbl, NULL, name );
+                rc = VCursorSupplementName ( tbl, stbl, NULL, name );
         }
         KNamelistRelease ( names );
     }
@@ -435,12 +485,13 @@ rc_t VCursorSupplementPhysical ( const KSymTable *tbl, const VCursor *self )
 }
 
 static
-rc_t VCursorSupplementStatic ( const KSymTable *tbl, const VCursor *self )
+rc_t VCursorSupplementStatic ( const KSymTable *tbl, const VTable *vtbl,
+    const VSchema *schema, STable *stbl )
 {
     rc_t rc;
     KNamelist *names;
 
-    const KMDataNode *root = self -> tbl -> col_node;
+    const KMDataNode *root = vtbl -> col_node;
     if ( root == NULL )
         return 0;
 
@@ -465,9 +516,9 @@ rc_t VCursorSupplementStatic ( const KSymTable *tbl, const VCursor *self )
                     if ( rc == 0 && size != 0 )
                     {
                         VTypedecl td;
-                        rc = VSchemaResolveTypedecl ( self -> schema, & td, typedecl );
+                        rc = VSchemaResolveTypedecl ( schema, & td, typedecl );
                         if ( rc == 0 )
-                            rc = VCursorSupplementName ( tbl, self -> stbl, & td, name );
+                            rc = VCursorSupplementName ( tbl, stbl, & td, name );
 
                         rc = 0; /*** don't care if name is not in the schema ***/
 		
@@ -484,20 +535,25 @@ rc_t VCursorSupplementStatic ( const KSymTable *tbl, const VCursor *self )
     return rc;
 }
 
-rc_t VCursorSupplementSchema ( const VCursor *self )
+rc_t VTableSupplementSchema ( const VTable *self, const VSchema *schema, STable *stbl )
 {
     KSymTable tbl;
-    rc_t rc = init_tbl_symtab ( & tbl, self -> schema, self -> stbl );
+    rc_t rc = init_tbl_symtab ( & tbl, schema, stbl );
     if ( rc == 0 )
     {
-        rc = VCursorSupplementPhysical ( & tbl, self );
+        rc = VCursorSupplementPhysical ( & tbl, self, stbl );
         if ( rc == 0 )
-            rc = VCursorSupplementStatic ( & tbl, self );
+            rc = VCursorSupplementStatic ( & tbl, self, schema, stbl );
         KSymTableWhack ( & tbl );
     }
     return rc;
 }
 
+rc_t VCursorSupplementSchema ( const VCursor *self )
+{
+    return VTableSupplementSchema ( self -> tbl, self -> schema, self -> stbl );
+}
+
 
 /* CreateCachedCursorRead
  *  creates a read cursor object onto table with a cache limit in bytes
@@ -527,33 +583,19 @@ static rc_t VTableCreateCachedCursorReadImpl ( const VTable *self,
             if ( self -> col_node == NULL )
                 KMetadataOpenNodeRead ( self -> meta, & ( ( VTable* ) self ) -> col_node, "col" );
 #endif
-            rc = VCursorMake ( & curs, self );
+            /* supplemented schema is shared among cursors on read-only tables */
+            rc = VCursorTemplateCacheMakeCursor ( self -> mgr -> cursor_templates, & curs, self );
             if ( rc == 0 ) {
                 curs -> blob_mru_cache = VBlobMRUCacheMake(capacity);
+                if ( curs -> blob_mru_cache != NULL && self -> read_only )
+                    curs -> blob_shared_cache = self -> mgr -> blob_cache;
                 curs -> read_only = true;
-                rc = VCursorSupplementSchema ( curs );
-               
-#if 0  
-                if ( create_pagemap_thread && capacity > 0 && rc == 0 )
-                {
-                    rc = VCursorLaunchPagemapThread ( curs );
-                    if ( rc != 0 )
-                    {
-                        if ( GetRCState( rc ) == rcNotAvailable )
-                            rc = 0;
-                    }
-                }   
-#endif
-                if ( rc == 0 )
-                {
-                    if(capacity > 0)
-                        curs->launch_cnt = 5;
-                    else
-                        curs->launch_cnt=200;
-                    * cursp = curs;
-                    return 0;
-                }
-                VCursorRelease ( curs );
+                if(capacity > 0)
+                    curs->launch_cnt = 5;
+                else
+                    curs->launch_cnt=200;
+                * cursp = curs;
+                return 0;
             }
         }
         * cursp = NULL;
@@ -1379,6 +1421,54 @@ rc_t VCursorCloseRowRead ( VCursor *self )
 }
 
 
+/* SharedBlobKey
+ *  identify output of a cursor column to the manager's blob cache
+ *  by table path, table type, column name and column type
+ *
+ *  returns NULL if column output is not to be shared
+ */
+static
+const VBlobSharedKey *VCursorSharedBlobKey ( const VCursor *cself, uint32_t col_idx, const VColumn *col )
+{
+    rc_t rc;
+    const char *path;
+    char td [ 256 ];
+    VBlobSharedKey *key;
+    VCursor *self = ( VCursor* ) cself;
+
+    if ( ! VBlobSharedCacheEnabled ( self -> blob_shared_cache ) )
+        return NULL;
+
+    /* named parameters make column output specific to this cursor */
+    if ( self -> named_params . root != NULL )
+        return NULL;
+
+    key = VectorGet ( & self -> blob_shared_keys, col_idx );
+    if ( key != NULL )
+        return key;
+
+    rc = KTableGetPath ( self -> tbl -> ktbl, & path );
+    if ( rc == 0 )
+        rc = VTypedeclToText ( & col -> td, self -> schema, td, sizeof td );
+    if ( rc == 0 )
+    {
+        rc = VBlobSharedKeyMake ( & key, "%s\t%S#%u\t%S\t%s", path,
+            & self -> stbl -> name -> name, self -> stbl -> version,
+            & col -> scol -> name -> name, td );
+        if ( rc == 0 )
+        {
+            rc = VectorSet ( & self -> blob_shared_keys, col_idx, key );
+            if ( rc == 0 )
+                return key;
+            free ( key );
+        }
+    }
+
+    /* column cannot be identified: stop sharing for this cursor */
+    self -> blob_shared_cache = NULL;
+    return NULL;
+}
+
 /* Read
  *  read entire single row of byte-aligned data into a buffer
  *
@@ -1407,6 +1497,7 @@ rc_t VCursorReadColumnDirectInt ( const VCursor *cself, int64_t row_id, uint32_t
     rc_t rc,rc_cache=0;
     const VColumn *col;
     const VBlob *blob;
+    const VBlobSharedKey *skey;
 
     col = ( const void* ) VectorGet ( & cself -> row, col_idx );
     if ( col == NULL )
@@ -1421,8 +1512,43 @@ rc_t VCursorReadColumnDirectInt ( const VCursor *cself, int64_t row_id, uint32_t
     if(blob){
         /* ask column to read from blob */
 	assert(row_id >= blob->start_id && row_id <= blob->stop_id);
+        if(rslt) *rslt=blob;
         return VColumnReadCachedBlob ( col, blob, row_id, elem_bits, base, boff, row_len);
     }
+
+    /* check blobs decoded by other cursors */
+    skey = VCursorSharedBlobKey ( cself, col_idx, col );
+    if ( skey != NULL )
+    {
+        blob = VBlobSharedCacheFind ( cself -> blob_shared_cache, skey, row_id );
+        if ( blob != NULL )
+        {
+            /* local cache takes its own reference */
+            rc_cache = VBlobMRUCacheSave ( cself -> blob_mru_cache, col_idx, blob );
+            rc = VColumnReadCachedBlob ( col, blob, row_id, elem_bits, base, boff, row_len );
+            /* a reference not taken by the local cache goes to the caller, if any */
+            if ( rc_cache == 0 || rslt == NULL )
+                VBlobRelease ( ( VBlob* ) blob );
+            if ( rslt ) *rslt = blob;
+            return rc;
+        }
+    }
+
+    /* check blobs fetched in background */
+    if ( cself -> read_ahead != NULL && cself -> named_params . root == NULL )
+    {
+        blob = VCursorReadAheadFind ( cself -> read_ahead, col_idx, row_id );
+        if ( blob != NULL )
+        {
+            rc_cache = VBlobMRUCacheSave ( cself -> blob_mru_cache, col_idx, blob );
+            rc = VColumnReadCachedBlob ( col, blob, row_id, elem_bits, base, boff, row_len );
+            if ( rc_cache == 0 || rslt == NULL )
+                VBlobRelease ( ( VBlob* ) blob );
+            if ( rslt ) *rslt = blob;
+            return rc;
+        }
+    }
+
     { /* ask column to produce a blob to be cached */
 	VBlobMRUCacheCursorContext cctx;
 	cctx.cache=cself -> blob_mru_cache;
@@ -1433,8 +1559,13 @@ rc_t VCursorReadColumnDirectInt ( const VCursor *cself, int64_t row_id, uint32_t
 	if(rslt) *rslt = NULL;
         return rc;
     }
-    if(blob->stop_id > blob->start_id + 4)
+    if ( cself -> read_ahead != NULL )
+        VCursorReadAheadSkip ( cself -> read_ahead, col_idx, blob );
+    if(blob->stop_id > blob->start_id + 4) {
 	    rc_cache=VBlobMRUCacheSave(cself->blob_mru_cache, col_idx, blob);
+	    if ( skey != NULL )
+		VBlobSharedCacheSave ( cself -> blob_shared_cache, skey, blob );
+    }
     if(rslt==NULL){ /** user does not care about the blob ***/
 	if( rc_cache == 0){
 		VBlobRelease((VBlob*)blob);
@@ -1974,6 +2105,124 @@ LIB_EXPORT rc_t CC VCursorCellDataDirect ( const VCursor *self, int64_t row_id,
 }
 
 
+/* ReadRange
+ *  access a range of rows of one column a blob at a time
+ */
+LIB_EXPORT rc_t CC VCursorReadRange ( const VCursor *self, uint32_t col_idx,
+    int64_t first, uint64_t count, VCursorBlobSpanFunc f, void *data )
+{
+    rc_t rc;
+    uint32_t *rows = NULL;
+    uint32_t rows_max = 0;
+
+    if ( self == NULL )
+        return RC ( rcVDB, rcCursor, rcReading, rcSelf, rcNull );
+    if ( f == NULL )
+        return RC ( rcVDB, rcCursor, rcReading, rcFunction, rcNull );
+    if ( ! self -> read_only )
+        return RC ( rcVDB, rcCursor, rcReading, rcCursor, rcWriteonly );
+
+    switch ( self -> state )
+    {
+    case vcConstruct:
+        return RC ( rcVDB, rcCursor, rcReading, rcCursor, rcNotOpen );
+    case vcReady:
+    case vcRowOpen:
+        break;
+    default:
+        return RC ( rcVDB, rcCursor, rcReading, rcCursor, rcInvalid );
+    }
+
+    for ( rc = 0; rc == 0 && count != 0; )
+    {
+        const VBlob *blob;
+        const void *base;
+        uint32_t elem_bits, boff, row_len;
+
+        rc = VCursorReadColumnDirectInt ( self, first, col_idx,
+            & elem_bits, & base, & boff, & row_len, & blob );
+        if ( rc == 0 && blob == NULL )
+            rc = RC ( rcVDB, rcCursor, rcReading, rcBlob, rcNotFound );
+        if ( rc == 0 )
+        {
+            PageMapIterator iter;
+            uint32_t i, n;
+
+            /* the span ends with the blob or the range, whichever comes first */
+            uint64_t in_blob = ( uint64_t ) ( blob -> stop_id - first ) + 1;
+            if ( in_blob > count )
+                in_blob = count;
+            n = in_blob > UINT32_MAX ? UINT32_MAX : ( uint32_t ) in_blob;
+
+            /* hold on to blob during callback */
+            VBlobAddRef ( ( VBlob* ) blob );
+
+            if ( n > rows_max )
+            {
+                void *tmp = realloc ( rows, 2 * sizeof rows [ 0 ] * n );
+                if ( tmp == NULL )
+                    rc = RC ( rcVDB, rcCursor, rcReading, rcMemory, rcExhausted );
+                else
+                {
+                    rows = tmp;
+                    rows_max = n;
+                }
+            }
+
+            /* the page map may still be deserializing in the decode pool */
+            if ( rc == 0 )
+                rc = VBlobResolvePageMap ( blob );
+            if ( rc == 0 && blob -> pm != NULL )
+                rc = PageMapNewIterator ( blob -> pm, & iter, first - blob -> start_id, n );
+            if ( rc == 0 )
+            {
+                VCursorBlobSpan span;
+                uint32_t *offsets = rows;
+                uint32_t *lengths = rows + rows_max;
+
+                if ( blob -> pm == NULL )
+                {
+                    /* without a page map the blob is a single row,
+                       repeated for every row it covers */
+                    uint32_t const len = ( uint32_t ) blob -> data . elem_count;
+                    for ( i = 0; i < n; ++ i )
+                    {
+                        offsets [ i ] = 0;
+                        lengths [ i ] = len;
+                    }
+                }
+                else
+                {
+                    for ( i = 0; i < n; ++ i )
+                    {
+                        offsets [ i ] = PageMapIteratorDataOffset ( & iter );
+                        lengths [ i ] = PageMapIteratorDataLength ( & iter );
+                        PageMapIteratorNext ( & iter );
+                    }
+                }
+
+                span . first_row = first;
+                span . row_count = n;
+                span . elem_bits = elem_bits;
+                span . base = blob -> data . base;
+                span . row_offset = offsets;
+                span . row_len = lengths;
+
+                rc = ( * f ) ( & span, data );
+
+                first += n;
+                count -= n;
+            }
+
+            VBlobRelease ( ( VBlob* ) blob );
+        }
+    }
+
+    free ( rows );
+    return rc;
+}
+
+
 /* OpenParent
  *  duplicate reference to parent table
  *  NB - returned reference must be released
@@ -2326,124 +2575,63 @@ LIB_EXPORT struct VSchema const * CC VCursorGetSchema ( struct VCursor const *se
 }
 
 
-static rc_t run_pagemap_thread ( const KThread *t, void *data )
+/* SetReadAhead
+ *  fetch and decode blobs ahead of a forward scan in background
+ */
+LIB_EXPORT rc_t CC VCursorSetReadAhead ( const VCursor *cself, uint32_t nblobs )
 {
     rc_t rc;
-    VCursor *self = data;
-    /* acquire lock */
-    MTCURSOR_DBG (( "run_pagemap_thread: acquiring lock\n" ));
-    while((rc = KLockAcquire ( self -> pmpr.lock ))==0){
-CHECK_AGAIN:
-	switch(self->pmpr.state){
-	 case ePMPR_STATE_NONE: 		/* wait for new request */
-	 case ePMPR_STATE_SERIALIZE_DONE: 	/* wait for result pickup **/
-	 case ePMPR_STATE_DESERIALIZE_DONE:	/* wait for result pickup **/
-		MTCURSOR_DBG (( "run_pagemap_thread: waiting for new request\n" ));
-		rc = KConditionWait ( self -> pmpr.cond, self -> pmpr.lock );
-		goto CHECK_AGAIN;
-	 case ePMPR_STATE_EXIT: /** exit requested ***/
-		MTCURSOR_DBG (( "run_pagemap_thread: exit by request\n" ));
-		KLockUnlock(self -> pmpr.lock);
-		return 0;
-	 case ePMPR_STATE_DESERIALIZE_REQUESTED:
-		MTCURSOR_DBG (( "run_pagemap_thread: request to deserialize\n" ));
-		self->pmpr.rc = PageMapDeserialize(&self->pmpr.pm,self->pmpr.data.base,self->pmpr.data.elem_count,self->pmpr.row_count);
-		if(self->pmpr.rc == 0){
-			self->pmpr.rc=PageMapExpandFull(self->pmpr.pm);
-			/*self->pmpr.rc=PageMapExpand(self->pmpr.pm,self->pmpr.row_count<2048?self->pmpr.row_count-1:2048);*/
-			assert(self->pmpr.rc == 0);
-		}
-		self->pmpr.state = ePMPR_STATE_DESERIALIZE_DONE;
-		/*fprintf(stderr,"Pagemap %p Done R:%6d|DR:%d|LR:%d\n",self->pmpr.lock, self->pmpr.pm->row_count,self->pmpr.pm->data_recs,self->pmpr.pm->leng_recs);*/
-		KConditionSignal ( self -> pmpr.cond );
-		KLockUnlock(self -> pmpr.lock);
-		break;
-	 case ePMPR_STATE_SERIALIZE_REQUESTED:
-		MTCURSOR_DBG (( "run_pagemap_thread: request to serialize\n" ));
-		self->pmpr.rc = PageMapSerialize(self->pmpr.pm,&self->pmpr.data,0,&self->pmpr.elem_count);
-		self->pmpr.state = ePMPR_STATE_SERIALIZE_DONE;
-		KConditionSignal ( self -> pmpr.cond );
-		KLockUnlock(self -> pmpr.lock);
-		break;
-	 default:
-		assert(0);
-		KLockUnlock(self -> pmpr.lock);
-		return RC(rcVDB, rcPagemap, rcConverting, rcParam, rcInvalid );
-	 
-	}
-    }
-    MTCURSOR_DBG (( "run_pagemap_thread: exit\n" ));
-    return rc;
-}
+    VCursor *self = ( VCursor* ) cself;
 
-rc_t VCursorLaunchPagemapThread(VCursor *curs)
-{
-	rc_t rc;
+    if ( self == NULL )
+        return RC ( rcVDB, rcCursor, rcUpdating, rcSelf, rcNull );
+    if ( ! self -> read_only )
+        return RC ( rcVDB, rcCursor, rcUpdating, rcCursor, rcWriteonly );
+    if ( self -> state < vcReady )
+        return RC ( rcVDB, rcCursor, rcUpdating, rcCursor, rcNotOpen );
 
-    assert ( curs != NULL );
-	curs -> pagemap_thread = NULL; /** if fails - will not use **/
+    /* columns may have been added since last time */
+    VCursorReadAheadWhack ( self -> read_ahead );
+    self -> read_ahead = NULL;
 
-    if ( s_disable_pagemap_thread )
-        return RC ( rcVDB, rcCursor, rcExecuting, rcThread, rcNotAvailable );
+    /* without a worker thread to fetch them there is nothing to gain */
+    if ( nblobs == 0 || ! VDecodePoolThreaded ( VCursorDecodePool ( self ) ) )
+        return 0;
 
-	rc = KLockMake ( & curs -> pmpr.lock );
-	if(rc == 0)
+    /* fetched blobs are kept in cursor cache once reached */
+    if ( self -> blob_mru_cache == NULL )
     {
-		rc = KConditionMake ( & curs -> pmpr.cond );
-        if(rc == 0)
-        {
-            rc = KThreadMake ( & curs -> pagemap_thread, run_pagemap_thread, curs );
-            if ( rc == 0 )
-                return 0;
-
-            KConditionRelease ( curs -> pmpr . cond );
-            curs -> pmpr . cond = NULL;
-        }
-
-        KLockRelease ( curs -> pmpr . lock );
-        curs -> pmpr . lock = NULL;
+        self -> blob_mru_cache = VBlobMRUCacheMake ( VCURSOR_READ_AHEAD_CACHE );
+        if ( self -> blob_mru_cache == NULL )
+            return RC ( rcVDB, rcCursor, rcUpdating, rcMemory, rcExhausted );
     }
 
-	return rc;
+    rc = VCursorReadAheadMake ( & self -> read_ahead, self, nblobs );
+    return rc;
 }
 
-rc_t VCursorTerminatePagemapThread(VCursor *self)
-{
-	rc_t rc=0;
-
-    assert ( self != NULL );
-
-	if(self -> pagemap_thread != NULL)
-    {
-		rc = KLockAcquire ( self -> pmpr.lock );
-		if ( rc == 0 )
-        {
-			self -> pmpr.state = ePMPR_STATE_EXIT;
-			KConditionSignal ( self -> pmpr.cond );
-			KLockUnlock ( self -> pmpr.lock );
-		}
-		KThreadWait ( self -> pagemap_thread, NULL );
-	}
-
-	KThreadRelease ( self -> pagemap_thread );
-	KConditionRelease ( self -> pmpr.cond );
-	KLockRelease ( self -> pmpr.lock );
-
-    self -> pagemap_thread = NULL;
-    self -> pmpr . cond = NULL;
-    self -> pmpr . lock = NULL;
 
-	return rc;
+/* DecodePool
+ *  pool for background page map deserialization
+ *  or NULL when it is to be done inline
+ */
+VDecodePool *VCursorDecodePool ( const VCursor *self )
+{
+    const VDBManager *mgr = self -> tbl -> mgr;
+    if ( mgr -> disable_pagemap_thread )
+        return NULL;
+    return mgr -> decode_pool;
 }
 
 /* DisablePagemapThread
  *  this can cause difficulties for some clients
+ *  page maps are then deserialized inline by the reading thread
  */
 LIB_EXPORT rc_t CC VDBManagerDisablePagemapThread ( struct VDBManager const *self )
 {
     if ( self == NULL )
         return RC ( rcVDB, rcMgr, rcUpdating, rcSelf, rcNull );
-    s_disable_pagemap_thread = true;
+    ( ( VDBManager* ) self ) -> disable_pagemap_thread = true;
     return 0;
 }
 
@@ -81,9 +81,11 @@ struct KDlset;
 struct VTable;
 struct VCtxId;
 struct VSchema;
+struct STable;
 struct SColumn;
 struct VColumn;
 struct VPhysical;
+struct VFlushPlan;
 
 
 /*--------------------------------------------------------------------------
@@ -172,10 +174,6 @@ struct VCursor
     struct KLock *flush_lock;
     struct KCondition *flush_cond;
 
-    /* background pagemap conversion objects */
-    struct KThread *pagemap_thread;
-    PageMapProcessRequest pmpr;
-
     /* user data */
     void *user;
     void ( CC * user_whack ) ( void *data );
@@ -189,6 +187,14 @@ struct VCursor
     /* read-only blob cache */
     VBlobMRUCache *blob_mru_cache;
 
+    /* blob cache shared with other read cursors ( not-owned )
+       and keys into it by col_idx ( owned ) */
+    VBlobSharedCache *blob_shared_cache;
+    Vector blob_shared_keys;
+
+    /* background fetching for forward scans ( owned ) */
+    struct VCursorReadAhead *read_ahead;
+
     /* external row of VColumn* by ord ( owned ) */
     Vector row;
 
@@ -208,6 +214,11 @@ struct VCursor
     /* trigger productions ( not-owned ) */
     Vector trig;
 
+    /* trigger productions arranged for parallel flush ( owned )
+       and lock serializing kdb updates while it runs */
+    struct VFlushPlan *flush_plan;
+    struct KLock *kdb_lock;
+
     KRefcount refcount;
 
     volatile uint32_t flush_cnt;
@@ -232,6 +243,13 @@ struct VCursor
  */
 rc_t VCursorMake ( struct VCursor **cursp, struct VTable const *tbl );
 
+/* MakeFromTemplate
+ *  make a cursor whose schema is a child of "tmpl",
+ *  with "stbl" an already supplemented table belonging to "tmpl"
+ */
+rc_t VCursorMakeFromTemplate ( struct VCursor **cursp, struct VTable const *tbl,
+    struct VSchema const *tmpl, struct STable const *stbl );
+
 rc_t VTableCreateCursorWriteInt ( struct VTable *self, struct VCursor **cursp, KCreateMode mode, bool create_thread );
 
 /* Whack
@@ -247,6 +265,8 @@ rc_t VCursorDestroy ( struct VCursor *self );
  *  repeat process on static columns, except create complete (fully typed) objects
  */
 rc_t VCursorSupplementSchema ( struct VCursor const *self );
+rc_t VTableSupplementSchema ( struct VTable const *self,
+    struct VSchema const *schema, struct STable *stbl );
 
 /* MakeColumn
  */
@@ -299,9 +319,33 @@ rc_t VCursorOpenRowRead ( struct VCursor *self );
 rc_t VCursorCloseRowRead ( struct VCursor *self );
 
 
-/** pagemap supporting thread **/
-rc_t VCursorLaunchPagemapThread(struct VCursor *self);
-rc_t VCursorTerminatePagemapThread(struct VCursor *self);
+/* DecodePool
+ *  pool for background page map deserialization
+ *  or NULL when it is to be done inline
+ */
+struct VDecodePool *VCursorDecodePool ( const struct VCursor *self );
+
+
+/*--------------------------------------------------------------------------
+ * VCursorReadAhead
+ *  fetches blobs ahead of a forward scan on a shadow cursor
+ */
+typedef struct VCursorReadAhead VCursorReadAhead;
+
+rc_t VCursorReadAheadMake ( VCursorReadAhead **ra, const struct VCursor *curs, uint32_t nblobs );
+void VCursorReadAheadWhack ( VCursorReadAhead *self );
+
+/* Find
+ *  called upon a cache miss: returns a new reference to a blob
+ *  fetched ahead holding "row_id", or NULL
+ *  schedules further fetching when access is sequential
+ */
+const VBlob *VCursorReadAheadFind ( VCursorReadAhead *self, uint32_t col_idx, int64_t row_id );
+
+/* Skip
+ *  tells that "blob" was produced by the reader itself
+ */
+void VCursorReadAheadSkip ( VCursorReadAhead *self, uint32_t col_idx, const VBlob *blob );
 
 
 #ifdef __cplusplus
@@ -0,0 +1,557 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#define KONST const
+#define SKONST
+#include "cursor-template.h"
+#include "cursor-priv.h"
+#include "table-priv.h"
+#include "schema-priv.h"
+#include "schema-parse.h"
+#undef KONST
+#undef SKONST
+
+#include <vdb/cursor.h>
+#include <vdb/vdb-priv.h>
+#include <kdb/table.h>
+#include <kdb/column.h>
+#include <kdb/meta.h>
+#include <kdb/namelist.h>
+#include <klib/namelist.h>
+#include <klib/rc.h>
+#include <klib/checksum.h>
+#include <klib/container.h>
+#include <klib/debug.h>
+#include <kproc/lock.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*--------------------------------------------------------------------------
+ * VCursorTemplate
+ *  a table extended with its implicit columns, identified by the
+ *  table schema, the table declaration and the digest of column names
+ *
+ *  the template schema also holds the declarations stored with every
+ *  physical column, so cursors made from it need not parse them again
+ *
+ *  templates whose implicit members are not all typed cannot be shared,
+ *  since resolution fills in their types from the columns it opens.
+ *  these are kept with a NULL schema to remember the fact.
+ */
+typedef struct VCursorTemplateKey VCursorTemplateKey;
+struct VCursorTemplateKey
+{
+    const VSchema *schema;
+    const STable *stbl;
+    uint8_t digest [ 16 ];
+};
+
+typedef struct VCursorTemplate VCursorTemplate;
+struct VCursorTemplate
+{
+    BSTNode n;
+    DLNode lru;
+    VCursorTemplateKey key;
+
+    /* the table schema is kept alive by this child */
+    const VSchema *schema;
+    const STable *stbl;
+};
+
+static
+int VCursorTemplateKeyCmp ( const VCursorTemplateKey *a, const VCursorTemplateKey *b )
+{
+    if ( a -> schema != b -> schema )
+        return a -> schema < b -> schema ? -1 : 1;
+    if ( a -> stbl != b -> stbl )
+        return a -> stbl < b -> stbl ? -1 : 1;
+    return memcmp ( a -> digest, b -> digest, sizeof a -> digest );
+}
+
+static
+int CC VCursorTemplateCmp ( const void *item, const BSTNode *n )
+{
+    return VCursorTemplateKeyCmp ( item, & ( ( const VCursorTemplate* ) n ) -> key );
+}
+
+static
+int CC VCursorTemplateSort ( const BSTNode *item, const BSTNode *n )
+{
+    return VCursorTemplateKeyCmp ( & ( ( const VCursorTemplate* ) item ) -> key,
+        & ( ( const VCursorTemplate* ) n ) -> key );
+}
+
+static
+void VCursorTemplateWhack ( VCursorTemplate *self )
+{
+    /* the table schema is released with the child */
+    VSchemaRelease ( self -> schema );
+    free ( self );
+}
+
+static
+void CC VCursorTemplateWhackNode ( BSTNode *n, void *ignore )
+{
+    VCursorTemplateWhack ( ( VCursorTemplate* ) n );
+}
+
+/* Typed
+ *  true if every implicit member has a type
+ */
+static
+bool STableImplicitsTyped ( const STable *stbl )
+{
+    uint32_t i = VectorStart ( & stbl -> phys );
+    uint32_t end = i + VectorLength ( & stbl -> phys );
+    for ( ; i < end; ++ i )
+    {
+        const SPhysMember *smbr = ( const SPhysMember* ) VectorGet ( & stbl -> phys, i );
+        if ( smbr != NULL && smbr -> td . type_id == 0 )
+            return false;
+    }
+    return true;
+}
+
+/* Preload
+ *  parse the declarations stored with every physical column,
+ *  so that cursors opening them find nothing new to parse
+ */
+static
+rc_t VCursorTemplatePreload ( const VTable *tbl, VSchema *schema )
+{
+    KNamelist *names;
+    rc_t rc = KTableListCol ( tbl -> ktbl, & names );
+    if ( rc == 0 )
+    {
+        uint32_t i, count;
+        rc = KNamelistCount ( names, & count );
+        for ( i = 0; rc == 0 && i < count; ++ i )
+        {
+            const char *name;
+            const KColumn *kcol;
+            rc = KNamelistGet ( names, i, & name );
+            if ( rc == 0 && KTableOpenColumnRead ( tbl -> ktbl, & kcol, "%s", name ) == 0 )
+            {
+                const KMetadata *meta;
+                if ( KColumnOpenMetadataRead ( kcol, & meta ) == 0 )
+                {
+                    const KMDataNode *node;
+                    if ( KMetadataOpenNodeRead ( meta, & node, "schema" ) == 0 )
+                    {
+                        rc = VSchemaParseNodeOnce ( schema, node, "VCursorTemplatePreload" );
+                        KMDataNodeRelease ( node );
+                    }
+                    KMetadataRelease ( meta );
+                }
+                KColumnRelease ( kcol );
+            }
+        }
+        KNamelistRelease ( names );
+    }
+    return rc;
+}
+
+/* Make
+ *  extend and supplement the table as a read cursor would
+ */
+static
+rc_t VCursorTemplateMake ( VCursorTemplate **tmplp,
+    const VTable *tbl, const VCursorTemplateKey *key )
+{
+    rc_t rc;
+    VCursorTemplate *tmpl = calloc ( 1, sizeof * tmpl );
+    if ( tmpl == NULL )
+        rc = RC ( rcVDB, rcCursor, rcConstructing, rcMemory, rcExhausted );
+    else
+    {
+        VSchema *schema;
+        tmpl -> key = * key;
+        rc = VSchemaMake ( & schema, tbl -> schema );
+        if ( rc == 0 )
+        {
+            STable *stbl;
+            rc = STableCloneExtend ( tbl -> stbl, & stbl, schema );
+            if ( rc == 0 )
+                rc = VTableSupplementSchema ( tbl, schema, stbl );
+            if ( rc == 0 )
+            {
+                /* a column that fails to parse is left to the cursor */
+                if ( STableImplicitsTyped ( stbl ) &&
+                     VCursorTemplatePreload ( tbl, schema ) == 0 )
+                {
+                    tmpl -> schema = schema;
+                    tmpl -> stbl = stbl;
+                }
+                else
+                {
+                    VSchemaRelease ( schema );
+                }
+
+                * tmplp = tmpl;
+                return 0;
+            }
+
+            VSchemaRelease ( schema );
+        }
+
+        free ( tmpl );
+    }
+
+    * tmplp = NULL;
+    return rc;
+}
+
+
+/*--------------------------------------------------------------------------
+ * VCursorTemplateCache
+ */
+struct VCursorTemplateCache
+{
+    KLock *lock;
+    BSTree cache;
+
+    /* most recently used at head */
+    DLList lru;
+    uint32_t count;
+    uint32_t limit;
+
+    /* statistics */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t unshared;
+};
+
+rc_t VCursorTemplateCacheMake ( VCursorTemplateCache **cachep, uint32_t limit )
+{
+    rc_t rc;
+
+    VCursorTemplateCache *self = calloc ( 1, sizeof * self );
+    if ( self == NULL )
+        return RC ( rcVDB, rcMgr, rcConstructing, rcMemory, rcExhausted );
+
+    BSTreeInit ( & self -> cache );
+    DLListInit ( & self -> lru );
+    self -> limit = limit;
+
+    rc = KLockMake ( & self -> lock );
+    if ( rc != 0 )
+    {
+        free ( self );
+        self = NULL;
+    }
+
+    * cachep = self;
+    return rc;
+}
+
+void VCursorTemplateCacheWhack ( VCursorTemplateCache *self )
+{
+    if ( self != NULL )
+    {
+        DBGMSG ( DBG_VDB, DBG_FLAG ( DBG_VDB_VDB ),
+                 ( "VCursorTemplateCache: %u templates, %lu hits, %lu misses, %lu unshared\n",
+                   self -> count, self -> hits, self -> misses, self -> unshared ) );
+
+        BSTreeWhack ( & self -> cache, VCursorTemplateWhackNode, NULL );
+        KLockRelease ( self -> lock );
+        free ( self );
+    }
+}
+
+void VCursorTemplateCacheGetStats ( VCursorTemplateCache *self, VCursorTemplateStats *stats )
+{
+    memset ( stats, 0, sizeof * stats );
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        stats -> entries = self -> count;
+        stats -> hits = self -> hits;
+        stats -> misses = self -> misses;
+        stats -> unshared = self -> unshared;
+        KLockUnlock ( self -> lock );
+    }
+}
+
+/* Digest
+ *  of the physical column names and the static column names and types,
+ *  which determine the implicit members of the extended table
+ */
+static
+rc_t VCursorTemplateDigest ( const VTable *tbl, uint8_t digest [ 16 ] )
+{
+    rc_t rc;
+    uint32_t i, count;
+    KNamelist *names;
+
+    MD5State md5;
+    MD5StateInit ( & md5 );
+
+    rc = KTableListCol ( tbl -> ktbl, & names );
+    if ( rc == 0 )
+    {
+        rc = KNamelistCount ( names, & count );
+        for ( i = 0; rc == 0 && i < count; ++ i )
+        {
+            const char *name;
+            rc = KNamelistGet ( names, i, & name );
+            if ( rc == 0 )
+                MD5StateAppend ( & md5, name, strlen ( name ) + 1 );
+        }
+        KNamelistRelease ( names );
+    }
+
+    /* separate physical from static names */
+    MD5StateAppend ( & md5, "", 1 );
+
+    if ( rc == 0 && tbl -> col_node != NULL )
+    {
+        rc = KMDataNodeListChild ( tbl -> col_node, & names );
+        if ( rc == 0 )
+        {
+            rc = KNamelistCount ( names, & count );
+            for ( i = 0; rc == 0 && i < count; ++ i )
+            {
+                const char *name;
+                rc = KNamelistGet ( names, i, & name );
+                if ( rc == 0 )
+                {
+                    const KMDataNode *node;
+                    MD5StateAppend ( & md5, name, strlen ( name ) + 1 );
+                    if ( KMDataNodeOpenNodeRead ( tbl -> col_node, & node, name ) == 0 )
+                    {
+                        size_t size;
+                        char typedecl [ 256 ];
+                        if ( KMDataNodeReadAttr ( node, "type", typedecl, sizeof typedecl, & size ) == 0 )
+                            MD5StateAppend ( & md5, typedecl, size );
+                        KMDataNodeRelease ( node );
+                    }
+                    MD5StateAppend ( & md5, "", 1 );
+                }
+            }
+            KNamelistRelease ( names );
+        }
+    }
+
+    MD5StateFinish ( & md5, digest );
+    return rc;
+}
+
+/* GetKey
+ *  the column names of a read-only table do not change,
+ *  so their digest is kept on the table
+ */
+static
+rc_t VCursorTemplateCacheGetKey ( VCursorTemplateCache *self,
+    const VTable *tbl, VCursorTemplateKey *key )
+{
+    rc_t rc;
+    uint8_t digest [ 16 ];
+
+    key -> schema = tbl -> schema;
+    key -> stbl = tbl -> stbl;
+
+    rc = KLockAcquire ( self -> lock );
+    if ( rc == 0 )
+    {
+        bool valid = tbl -> cursor_key_valid;
+        if ( valid )
+            memcpy ( key -> digest, tbl -> cursor_key, sizeof key -> digest );
+        KLockUnlock ( self -> lock );
+        if ( valid )
+            return 0;
+
+        rc = VCursorTemplateDigest ( tbl, digest );
+        if ( rc == 0 )
+        {
+            memcpy ( key -> digest, digest, sizeof key -> digest );
+            rc = KLockAcquire ( self -> lock );
+            if ( rc == 0 )
+            {
+                memcpy ( ( ( VTable* ) tbl ) -> cursor_key, digest, sizeof digest );
+                ( ( VTable* ) tbl ) -> cursor_key_valid = true;
+                KLockUnlock ( self -> lock );
+            }
+        }
+    }
+
+    return rc;
+}
+
+/* Find
+ *  look up a template and attach its schema, if it can be shared
+ *  must be called with lock held
+ */
+static
+const VCursorTemplate *VCursorTemplateCacheFind ( VCursorTemplateCache *self,
+    const VCursorTemplateKey *key, const VSchema **schema, const STable **stbl )
+{
+    VCursorTemplate *tmpl = ( VCursorTemplate* )
+        BSTreeFind ( & self -> cache, key, VCursorTemplateCmp );
+    if ( tmpl != NULL )
+    {
+        DLListUnlink ( & self -> lru, & tmpl -> lru );
+        DLListPushHead ( & self -> lru, & tmpl -> lru );
+
+        if ( tmpl -> schema == NULL )
+            ++ self -> unshared;
+        else
+        {
+            VSchemaAddRef ( tmpl -> schema );
+            * schema = tmpl -> schema;
+            * stbl = tmpl -> stbl;
+        }
+    }
+    return tmpl;
+}
+
+/* Insert
+ *  add a template, dropping the least recently used beyond the limit
+ *  the template is whacked if it cannot be added
+ *  must be called with lock held
+ */
+static
+rc_t VCursorTemplateCacheInsert ( VCursorTemplateCache *self, VCursorTemplate *tmpl )
+{
+    rc_t rc = BSTreeInsertUnique ( & self -> cache, & tmpl -> n, NULL, VCursorTemplateSort );
+    if ( rc != 0 )
+    {
+        VCursorTemplateWhack ( tmpl );
+        return rc;
+    }
+
+    DLListPushHead ( & self -> lru, & tmpl -> lru );
+
+    for ( ++ self -> count; self -> count > self -> limit; -- self -> count )
+    {
+        DLNode *n = DLListPopTail ( & self -> lru );
+        VCursorTemplate *lru = ( VCursorTemplate* ) ( ( char* ) n - offsetof ( VCursorTemplate, lru ) );
+        BSTreeUnlink ( & self -> cache, & lru -> n );
+        VCursorTemplateWhack ( lru );
+    }
+
+    return 0;
+}
+
+/* MakePrivate
+ *  extend and supplement the table schema for a single cursor
+ */
+static
+rc_t VCursorMakePrivate ( VCursor **cursp, const VTable *tbl )
+{
+    VCursor *curs;
+    rc_t rc = VCursorMake ( & curs, tbl );
+    if ( rc == 0 )
+    {
+        rc = VCursorSupplementSchema ( curs );
+        if ( rc == 0 )
+        {
+            * cursp = curs;
+            return 0;
+        }
+        VCursorRelease ( curs );
+    }
+
+    * cursp = NULL;
+    return rc;
+}
+
+/* MakeCursor
+ */
+rc_t VCursorTemplateCacheMakeCursor ( VCursorTemplateCache *self,
+    VCursor **cursp, const VTable *tbl )
+{
+    rc_t rc;
+    VCursorTemplateKey key;
+    const VCursorTemplate *found;
+
+    const STable *stbl = NULL;
+    const VSchema *schema = NULL;
+
+    assert ( cursp != NULL );
+    assert ( tbl != NULL );
+
+    if ( self == NULL || ! tbl -> read_only ||
+         VCursorTemplateCacheGetKey ( self, tbl, & key ) != 0 )
+    {
+        return VCursorMakePrivate ( cursp, tbl );
+    }
+
+    rc = KLockAcquire ( self -> lock );
+    if ( rc != 0 )
+        return rc;
+    found = VCursorTemplateCacheFind ( self, & key, & schema, & stbl );
+    if ( found != NULL )
+        ++ self -> hits;
+    else
+        ++ self -> misses;
+    KLockUnlock ( self -> lock );
+
+    if ( found == NULL )
+    {
+        /* extend outside of the lock */
+        VCursorTemplate *tmpl;
+        rc = VCursorTemplateMake ( & tmpl, tbl, & key );
+        if ( rc != 0 )
+            return rc;
+
+        rc = KLockAcquire ( self -> lock );
+        if ( rc != 0 )
+        {
+            VCursorTemplateWhack ( tmpl );
+            return rc;
+        }
+
+        /* another thread may have made the same template meanwhile */
+        found = VCursorTemplateCacheFind ( self, & key, & schema, & stbl );
+        if ( found != NULL )
+            VCursorTemplateWhack ( tmpl );
+        else if ( VCursorTemplateCacheInsert ( self, tmpl ) == 0 )
+        {
+            if ( tmpl -> schema == NULL )
+                ++ self -> unshared;
+            else
+            {
+                VSchemaAddRef ( tmpl -> schema );
+                schema = tmpl -> schema;
+                stbl = tmpl -> stbl;
+            }
+        }
+        KLockUnlock ( self -> lock );
+    }
+
+    if ( schema == NULL )
+        return VCursorMakePrivate ( cursp, tbl );
+
+    rc = VCursorMakeFromTemplate ( cursp, tbl, schema, stbl );
+    VSchemaRelease ( schema );
+    return rc;
+}
@@ -0,0 +1,88 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#ifndef _h_cursor_template_
+#define _h_cursor_template_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * forwards
+ */
+struct VCursor;
+struct VTable;
+struct VCursorTemplateStats;
+
+
+/*--------------------------------------------------------------------------
+ * VCursorTemplateCache
+ *  manager-wide cache of the schema a read cursor builds before
+ *  resolving its columns: a child of the table schema holding the
+ *  table extended with implicit members for its physical and static
+ *  columns, keyed by table schema, table declaration and column names
+ *
+ *  cursors made from a template take the extended table as is,
+ *  with a private child schema for declarations from column metadata
+ */
+typedef struct VCursorTemplateCache VCursorTemplateCache;
+
+/* Make
+ *  "limit" [ IN ] - maximum number of templates held
+ */
+rc_t VCursorTemplateCacheMake ( VCursorTemplateCache **cache, uint32_t limit );
+
+/* Whack
+ *  cursors made from templates keep them alive
+ */
+void VCursorTemplateCacheWhack ( VCursorTemplateCache *self );
+
+/* GetStats
+ */
+void VCursorTemplateCacheGetStats ( VCursorTemplateCache *self,
+    struct VCursorTemplateStats *stats );
+
+/* MakeCursor
+ *  create a read cursor onto a table with its schema supplemented
+ *
+ *  "self" [ IN, NULL OKAY ] - when NULL, or when "tbl" is not
+ *  read-only, the cursor extends its own schema
+ */
+rc_t VCursorTemplateCacheMakeCursor ( VCursorTemplateCache *self,
+    struct VCursor **curs, struct VTable const *tbl );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_cursor_template_ */
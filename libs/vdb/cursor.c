@@ -61,7 +61,6 @@
  */
 rc_t VCursorWhack ( VCursor *self )
 {
-    VCursorTerminatePagemapThread(self);
     return VCursorDestroy ( self );
 }
 
@@ -68,24 +68,18 @@ rc_t VDatabaseLoadSchema ( VDatabase *self )
     rc_t rc = KMetadataOpenNodeRead ( self -> meta, & node, "schema" );
     if ( rc == 0 )
     {
-        /* the node is probably within our 4K buffer,
-           but by using the callback mechanism we don't
-           have buffer or allocation issues. */
-        KMDataNodeSchemaFillData pb;
-        pb . node = node;
-        pb . pos = 0;
-        pb . add_v0 = false;
-
         /* add in schema text. it is not mandatory, but it is
            the design of the system to store object schema with
-           the object so that it is capable of standing alone */
-        rc = VSchemaParseTextCallback ( self -> schema,
-            "VDatabaseLoadSchema", KMDataNodeFillSchema, & pb );
+           the object so that it is capable of standing alone.
+           read-only databases share the parse of identical text. */
+        rc = VSchemaCacheLoadNode ( self -> read_only ? self -> mgr -> schema_cache : NULL,
+            self -> mgr -> schema, & self -> schema, node, "VDatabaseLoadSchema" );
         if ( rc == 0 )
         {
             /* determine database type */
-            rc = KMDataNodeReadAttr ( node, "name",
-                pb . buff, sizeof pb . buff, & pb . pos );
+            size_t size;
+            char buff [ 4096 ];
+            rc = KMDataNodeReadAttr ( node, "name", buff, sizeof buff, & size );
             if ( rc == 0 )
             {
                 uint32_t type;
@@ -93,7 +87,7 @@ rc_t VDatabaseLoadSchema ( VDatabase *self )
 
                 /* find the sdb if possible */
                 self -> sdb = VSchemaFind ( self -> schema,
-                    & name, & type, pb . buff, "VDatabaseLoadSchema", false );
+                    & name, & type, buff, "VDatabaseLoadSchema", false );
 
                 /* the schema must be found in this case */
                 if ( self -> sdb == NULL || type != eDatabase )
@@ -101,7 +95,7 @@ rc_t VDatabaseLoadSchema ( VDatabase *self )
                     self -> sdb = NULL;
                     rc = RC ( rcVDB, rcDatabase, rcLoading, rcSchema, rcCorrupt );
                     PLOGERR ( klogInt, ( klogInt, rc, "failed to establish database type from '$(expr)'",
-                                         "expr=%s", pb . buff ));
+                                         "expr=%s", buff ));
                 }
             }
         }
@@ -35,6 +35,10 @@
 
 #include "schema-priv.h"
 #include "linker-priv.h"
+#include "blob-priv.h"
+#include "blob.h"
+#include "decode-pool.h"
+#include "cursor-template.h"
 
 #include <vdb/manager.h>
 #include <vdb/database.h>
@@ -44,12 +48,14 @@
 #include <kdb/database.h>
 #include <kdb/table.h>
 #include <kdb/meta.h>
+#include <kdb/kdb-priv.h>
 #include <kfg/config.h>
 #include <kfs/directory.h>
 #include <kfs/dyload.h>
 #include <klib/log.h>
 #include <klib/text.h>
 #include <klib/rc.h>
+#include <klib/data-buffer.h>
 #include <sysalloc.h>
 
 #include <stdlib.h>
@@ -88,9 +94,18 @@ rc_t VDBManagerWhack ( VDBManager *self )
             self -> user_whack = NULL;
         }
 
+        VBlobSharedCacheWhack ( self -> blob_cache );
+        VDecodePoolWhack ( self -> decode_pool );
+        VCursorTemplateCacheWhack ( self -> cursor_templates );
+        VSchemaCacheWhack ( self -> schema_cache );
         VSchemaRelease ( self -> schema );
         VLinkerRelease ( self -> linker );
         free ( self );
+
+        /* the pools are process-wide, but most of what
+           they hold was just freed by the caches above */
+        VBlobTrimSlabs ();
+        KDataBufferTrimPool ();
         return 0;
     }
 
@@ -451,6 +466,226 @@ rc_t VDBManagerConfigPaths ( VDBManager *self, bool update )
 }
 
 
+/* MakeBlobCache
+ *  creates the shared blob cache
+ *  budget is taken from configuration, if present
+ */
+rc_t VDBManagerMakeBlobCache ( VDBManager *self, size_t dflt_capacity )
+{
+    uint64_t capacity = dflt_capacity;
+
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        uint64_t value;
+        if ( KConfigReadU64 ( kfg, "vdb/blob-cache/capacity", & value ) == 0 )
+            capacity = value;
+        KConfigRelease ( kfg );
+    }
+
+    return VBlobSharedCacheMake ( & self -> blob_cache, ( size_t ) capacity );
+}
+
+
+/* MakeDecodePool
+ *  creates the decode worker pool
+ *  thread limit is taken from configuration, if present
+ *  failure is not fatal: decoding is then done inline
+ */
+void VDBManagerMakeDecodePool ( VDBManager *self, uint32_t dflt_threads )
+{
+    uint64_t threads = dflt_threads;
+
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        uint64_t value;
+        if ( KConfigReadU64 ( kfg, "vdb/decode-pool/threads", & value ) == 0 )
+            threads = value;
+        KConfigRelease ( kfg );
+    }
+
+    self -> disable_pagemap_thread = false;
+    VDecodePoolMake ( & self -> decode_pool, ( uint32_t ) threads );
+}
+
+
+/* MakeSchemaCache
+ *  creates the parsed schema cache unless disabled in configuration
+ *  failure is not fatal: schemas are then parsed on every open
+ */
+void VDBManagerMakeSchemaCache ( VDBManager *self )
+{
+    bool enabled = true;
+
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        bool value;
+        if ( KConfigReadBool ( kfg, "vdb/schema-cache/enabled", & value ) == 0 )
+            enabled = value;
+        KConfigRelease ( kfg );
+    }
+
+    self -> schema_cache = NULL;
+    if ( enabled )
+        VSchemaCacheMake ( & self -> schema_cache );
+}
+
+
+/* MakeCursorTemplates
+ *  creates the cursor template cache unless disabled in configuration
+ *  failure is not fatal: cursors then extend their own schemas
+ */
+void VDBManagerMakeCursorTemplates ( VDBManager *self, uint32_t dflt_limit )
+{
+    uint64_t limit = dflt_limit;
+
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        uint64_t value;
+        if ( KConfigReadU64 ( kfg, "vdb/cursor-template/limit", & value ) == 0 )
+            limit = value;
+        KConfigRelease ( kfg );
+    }
+
+    self -> cursor_templates = NULL;
+    if ( limit != 0 )
+        VCursorTemplateCacheMake ( & self -> cursor_templates,
+            limit > UINT32_MAX ? UINT32_MAX : ( uint32_t ) limit );
+}
+
+
+/* ConfigBufferPool
+ *  the memory kept for recycling data buffers is process-wide,
+ *  its bound is taken from configuration, if present
+ */
+void VDBManagerConfigBufferPool ( VDBManager *self )
+{
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        uint64_t value;
+        if ( KConfigReadU64 ( kfg, "vdb/buffer-pool/limit", & value ) == 0 )
+            KDataBufferSetPoolLimit ( ( size_t ) value );
+        KConfigRelease ( kfg );
+    }
+}
+
+
+/* ConfigDataMMap
+ *  column data are read through a buffer unless configured otherwise
+ */
+void VDBManagerConfigDataMMap ( VDBManager *self )
+{
+    KConfig *kfg;
+    if ( KConfigMake ( & kfg, NULL ) == 0 )
+    {
+        bool value;
+        if ( KConfigReadBool ( kfg, "vdb/data/mmap", & value ) == 0 )
+            KDBManagerSetDataMMap ( self -> kmgr, value );
+        KConfigRelease ( kfg );
+    }
+}
+
+
+/* SetDecodeThreads
+ *  set the limit on background decoding threads
+ *  shared by all cursors of this manager
+ */
+LIB_EXPORT rc_t CC VDBManagerSetDecodeThreads ( const VDBManager *self, uint32_t count )
+{
+    if ( self == NULL )
+        return RC ( rcVDB, rcMgr, rcUpdating, rcSelf, rcNull );
+    VDecodePoolSetThreads ( self -> decode_pool, count );
+    return 0;
+}
+
+
+/* SetBlobCacheCapacity
+ *  set the memory budget of the blob cache shared among
+ *  cursors created with VTableCreateCachedCursorRead
+ *  a capacity of 0 disables sharing
+ */
+LIB_EXPORT rc_t CC VDBManagerSetBlobCacheCapacity ( const VDBManager *self, size_t capacity )
+{
+    if ( self == NULL )
+        return RC ( rcVDB, rcMgr, rcUpdating, rcSelf, rcNull );
+    VBlobSharedCacheSetCapacity ( self -> blob_cache, capacity );
+    return 0;
+}
+
+
+/* GetBlobCacheStats
+ *  report usage of the shared blob cache
+ */
+LIB_EXPORT rc_t CC VDBManagerGetBlobCacheStats ( const VDBManager *self, VBlobCacheStats *stats )
+{
+    if ( stats == NULL )
+        return RC ( rcVDB, rcMgr, rcAccessing, rcParam, rcNull );
+    if ( self == NULL )
+    {
+        memset ( stats, 0, sizeof * stats );
+        return RC ( rcVDB, rcMgr, rcAccessing, rcSelf, rcNull );
+    }
+    VBlobSharedCacheGetStats ( self -> blob_cache, stats );
+    return 0;
+}
+
+
+/* GetSchemaCacheStats
+ *  report reuse of parsed schemas
+ */
+LIB_EXPORT rc_t CC VDBManagerGetSchemaCacheStats ( const VDBManager *self, VSchemaCacheStats *stats )
+{
+    if ( stats == NULL )
+        return RC ( rcVDB, rcMgr, rcAccessing, rcParam, rcNull );
+    if ( self == NULL )
+    {
+        memset ( stats, 0, sizeof * stats );
+        return RC ( rcVDB, rcMgr, rcAccessing, rcSelf, rcNull );
+    }
+    VSchemaCacheGetStats ( self -> schema_cache, stats );
+    return 0;
+}
+
+
+/* GetCursorTemplateStats
+ *  report reuse of extended table schemas by read cursors
+ */
+LIB_EXPORT rc_t CC VDBManagerGetCursorTemplateStats ( const VDBManager *self, VCursorTemplateStats *stats )
+{
+    if ( stats == NULL )
+        return RC ( rcVDB, rcMgr, rcAccessing, rcParam, rcNull );
+    if ( self == NULL )
+    {
+        memset ( stats, 0, sizeof * stats );
+        return RC ( rcVDB, rcMgr, rcAccessing, rcSelf, rcNull );
+    }
+    VCursorTemplateCacheGetStats ( self -> cursor_templates, stats );
+    return 0;
+}
+
+
+/* GetAllocStats
+ *  report recycling of blob, page map and data buffer memory
+ */
+LIB_EXPORT rc_t CC VDBManagerGetAllocStats ( const VDBManager *self, VDBAllocStats *stats )
+{
+    if ( stats == NULL )
+        return RC ( rcVDB, rcMgr, rcAccessing, rcParam, rcNull );
+    if ( self == NULL )
+    {
+        memset ( stats, 0, sizeof * stats );
+        return RC ( rcVDB, rcMgr, rcAccessing, rcSelf, rcNull );
+    }
+    VBlobGetSlabStats ( & stats -> blobs, & stats -> page_maps );
+    KDataBufferGetPoolStats ( & stats -> buffers );
+    return 0;
+}
+
+
 /* GetUserData
  * SetUserData
  *  store/retrieve an opaque pointer to user data
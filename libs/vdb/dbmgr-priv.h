@@ -59,6 +59,10 @@ extern "C" {
 struct KDBManager;
 struct VSchema;
 struct VLinker;
+struct VBlobSharedCache;
+struct VDecodePool;
+struct VSchemaCache;
+struct VCursorTemplateCache;
 
 
 /*--------------------------------------------------------------------------
@@ -76,6 +80,19 @@ struct VDBManager
     /* intrinsic functions */
     struct VLinker *linker;
 
+    /* decoded blobs shared by cached read cursors */
+    struct VBlobSharedCache *blob_cache;
+
+    /* parsed schemas shared by read-only tables and databases */
+    struct VSchemaCache *schema_cache;
+
+    /* extended table schemas shared by read cursors */
+    struct VCursorTemplateCache *cursor_templates;
+
+    /* workers for background decoding on behalf of all cursors */
+    struct VDecodePool *decode_pool;
+    bool disable_pagemap_thread;
+
     /* user data */
     void *user;
     void ( CC * user_whack ) ( void *data );
@@ -100,6 +117,55 @@ rc_t VDBManagerSever ( const VDBManager *self );
 rc_t VDBManagerConfigPaths ( VDBManager *self, bool update );
 
 
+/* MakeBlobCache
+ *  creates the shared blob cache
+ *  budget is taken from configuration, if present
+ */
+rc_t VDBManagerMakeBlobCache ( VDBManager *self, size_t dflt_capacity );
+
+
+/* MakeDecodePool
+ *  creates the decode worker pool
+ *  thread limit is taken from "vdb/decode-pool/threads" in configuration,
+ *  if present, else VDB_DECODE_POOL_THREADS
+ *  failure is not fatal: decoding is then done inline
+ */
+#define VDB_DECODE_POOL_THREADS 4
+void VDBManagerMakeDecodePool ( VDBManager *self, uint32_t dflt_threads );
+
+
+/* MakeSchemaCache
+ *  creates the parsed schema cache
+ *  unless "vdb/schema-cache/enabled" is false in configuration
+ *  failure is not fatal: schemas are then parsed on every open
+ */
+void VDBManagerMakeSchemaCache ( VDBManager *self );
+
+
+/* MakeCursorTemplates
+ *  creates the cursor template cache
+ *  entry limit is taken from "vdb/cursor-template/limit" in configuration,
+ *  if present, else VDB_CURSOR_TEMPLATE_LIMIT; a limit of 0 disables it
+ *  failure is not fatal: every read cursor then extends its own schema
+ */
+#define VDB_CURSOR_TEMPLATE_LIMIT 64
+void VDBManagerMakeCursorTemplates ( VDBManager *self, uint32_t dflt_limit );
+
+
+/* ConfigBufferPool
+ *  bound the memory kept for recycling data buffers
+ *  if "vdb/buffer-pool/limit" is set in configuration, 0 keeps none
+ */
+void VDBManagerConfigBufferPool ( VDBManager *self );
+
+
+/* ConfigDataMMap
+ *  have column data memory mapped on read
+ *  if "vdb/data/mmap" is set true in configuration
+ */
+void VDBManagerConfigDataMMap ( VDBManager *self );
+
+
 /*--------------------------------------------------------------------------
  * generic whackers
  */
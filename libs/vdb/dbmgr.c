@@ -51,6 +51,11 @@
 #include <stdio.h>
 #include <assert.h>
 
+/* default memory budget of the blob cache shared among read cursors
+ *  overridden by "vdb/blob-cache/capacity" in configuration */
+#define VDB_BLOB_CACHE_CAPACITY ( ( size_t ) 256 * 1024 * 1024 )
+
+
 /*--------------------------------------------------------------------------
  * VDBManager
  *  opaque handle to library
@@ -94,8 +99,15 @@ LIB_EXPORT rc_t CC VDBManagerMakeReadWithVFSManager ( const VDBManager **mgrp,
                     if ( rc == 0 )
                     {
                         rc = VDBManagerConfigPaths ( mgr, false );
+                        if ( rc == 0 )
+                            rc = VDBManagerMakeBlobCache ( mgr, VDB_BLOB_CACHE_CAPACITY );
                         if ( rc == 0 )
                         {
+                            VDBManagerMakeDecodePool ( mgr, VDB_DECODE_POOL_THREADS );
+                            VDBManagerMakeSchemaCache ( mgr );
+                            VDBManagerMakeCursorTemplates ( mgr, VDB_CURSOR_TEMPLATE_LIMIT );
+                            VDBManagerConfigBufferPool ( mgr );
+                            VDBManagerConfigDataMMap ( mgr );
                             mgr -> user = NULL;
                             mgr -> user_whack = NULL;
                             KRefcountInit ( & mgr -> refcount, 1, "VDBManager", "make-read", "vmgr" );
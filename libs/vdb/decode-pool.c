@@ -0,0 +1,385 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#include "decode-pool.h"
+
+#include <klib/rc.h>
+#include <klib/container.h>
+#include <klib/vector.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
+#include <kproc/thread.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*--------------------------------------------------------------------------
+ * VDecodeJob
+ */
+
+void VDecodeJobInit ( VDecodeJob *self, VDecodeJobFunc run )
+{
+    assert ( self != NULL );
+    assert ( run != NULL );
+
+    memset ( & self -> dad, 0, sizeof self -> dad );
+    self -> run = run;
+    self -> rc = 0;
+    self -> state = eDecodeJobIdle;
+}
+
+static
+void VDecodeJobRunInline ( VDecodeJob *self )
+{
+    self -> state = eDecodeJobRunning;
+    self -> rc = ( * self -> run ) ( self );
+    self -> state = eDecodeJobDone;
+}
+
+
+/*--------------------------------------------------------------------------
+ * VDecodePool
+ */
+struct VDecodePool
+{
+    KLock *lock;
+
+    /* signaled when work is queued or on shutdown */
+    KCondition *work;
+
+    /* broadcast whenever a job completes */
+    KCondition *done;
+
+    /* queue of VDecodeJob */
+    DLList queue;
+    uint32_t queued;
+
+    /* KThread* of every worker started */
+    Vector threads;
+
+    uint32_t max_threads;
+    uint32_t nthreads;
+    uint32_t idle;
+
+    bool shutdown;
+};
+
+static
+rc_t CC VDecodePoolWorker ( const KThread *t, void *data )
+{
+    VDecodePool *self = data;
+
+    rc_t rc = KLockAcquire ( self -> lock );
+    if ( rc != 0 )
+        return rc;
+
+    while ( ! self -> shutdown && self -> nthreads <= self -> max_threads )
+    {
+        VDecodeJob *job = ( VDecodeJob* ) DLListPopHead ( & self -> queue );
+        if ( job != NULL )
+        {
+            -- self -> queued;
+            job -> state = eDecodeJobRunning;
+            KLockUnlock ( self -> lock );
+
+            rc = ( * job -> run ) ( job );
+
+            KLockAcquire ( self -> lock );
+            job -> rc = rc;
+            job -> state = eDecodeJobDone;
+            KConditionBroadcast ( self -> done );
+            continue;
+        }
+
+        ++ self -> idle;
+        rc = KConditionWait ( self -> work, self -> lock );
+        -- self -> idle;
+
+        if ( rc != 0 )
+        {
+            /* threads are not really available in this build:
+               any further work will be done inline */
+            self -> max_threads = 0;
+            break;
+        }
+    }
+
+    -- self -> nthreads;
+    KLockUnlock ( self -> lock );
+
+    return 0;
+}
+
+rc_t VDecodePoolMake ( VDecodePool **poolp, uint32_t max_threads )
+{
+    rc_t rc;
+    VDecodePool *pool;
+
+    assert ( poolp != NULL );
+
+    pool = calloc ( 1, sizeof * pool );
+    if ( pool == NULL )
+        rc = RC ( rcVDB, rcMgr, rcConstructing, rcMemory, rcExhausted );
+    else
+    {
+        rc = KLockMake ( & pool -> lock );
+        if ( rc == 0 )
+        {
+            rc = KConditionMake ( & pool -> work );
+            if ( rc == 0 )
+            {
+                rc = KConditionMake ( & pool -> done );
+                if ( rc == 0 )
+                {
+                    DLListInit ( & pool -> queue );
+                    VectorInit ( & pool -> threads, 0, 8 );
+                    pool -> max_threads = max_threads;
+
+                    * poolp = pool;
+                    return 0;
+                }
+
+                KConditionRelease ( pool -> work );
+            }
+
+            KLockRelease ( pool -> lock );
+        }
+
+        free ( pool );
+    }
+
+    * poolp = NULL;
+    return rc;
+}
+
+static
+void CC VDecodePoolJoinWorker ( void *item, void *ignore )
+{
+    KThread *t = item;
+    if ( t != NULL )
+    {
+        KThreadWait ( t, NULL );
+        KThreadRelease ( t );
+    }
+}
+
+void VDecodePoolWhack ( VDecodePool *self )
+{
+    if ( self != NULL )
+    {
+        if ( KLockAcquire ( self -> lock ) == 0 )
+        {
+            self -> shutdown = true;
+            KConditionBroadcast ( self -> work );
+            KLockUnlock ( self -> lock );
+        }
+
+        VectorWhack ( & self -> threads, VDecodePoolJoinWorker, NULL );
+
+        assert ( self -> queued == 0 );
+
+        KConditionRelease ( self -> done );
+        KConditionRelease ( self -> work );
+        KLockRelease ( self -> lock );
+        free ( self );
+    }
+}
+
+void VDecodePoolSetThreads ( VDecodePool *self, uint32_t max_threads )
+{
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        self -> max_threads = max_threads;
+        KConditionBroadcast ( self -> work );
+        KLockUnlock ( self -> lock );
+    }
+}
+
+bool VDecodePoolThreaded ( VDecodePool *self )
+{
+    bool threaded = false;
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        threaded = ! self -> shutdown && self -> max_threads != 0;
+        KLockUnlock ( self -> lock );
+    }
+    return threaded;
+}
+
+rc_t VDecodePoolSubmit ( VDecodePool *self, VDecodeJob *job )
+{
+    rc_t rc;
+    bool spawn;
+    uint32_t idx;
+
+    if ( job == NULL )
+        return RC ( rcVDB, rcMgr, rcExecuting, rcParam, rcNull );
+
+    assert ( job -> state == eDecodeJobIdle );
+
+    if ( self == NULL || self -> max_threads == 0 || KLockAcquire ( self -> lock ) != 0 )
+    {
+        VDecodeJobRunInline ( job );
+        return 0;
+    }
+
+    if ( self -> shutdown || self -> max_threads == 0 )
+    {
+        KLockUnlock ( self -> lock );
+        VDecodeJobRunInline ( job );
+        return 0;
+    }
+
+    job -> state = eDecodeJobQueued;
+    DLListPushTail ( & self -> queue, & job -> dad );
+    ++ self -> queued;
+
+    /* reserve a slot for the new worker while still under lock,
+       so that every thread started can be joined */
+    spawn = false;
+    if ( self -> queued > self -> idle && self -> nthreads < self -> max_threads &&
+         VectorAppend ( & self -> threads, & idx, NULL ) == 0 )
+    {
+        ++ self -> nthreads;
+        spawn = true;
+    }
+    else
+    {
+        KConditionSignal ( self -> work );
+    }
+    KLockUnlock ( self -> lock );
+
+    if ( spawn )
+    {
+        KThread *t;
+        rc = KThreadMake ( & t, VDecodePoolWorker, self );
+
+        KLockAcquire ( self -> lock );
+        if ( rc == 0 )
+        {
+            void *ignore;
+            VectorSwap ( & self -> threads, idx, t, & ignore );
+        }
+        else
+        {
+            /* the job stays queued and will be run by whoever waits on it */
+            -- self -> nthreads;
+            self -> max_threads = self -> nthreads;
+        }
+        KLockUnlock ( self -> lock );
+    }
+
+    return 0;
+}
+
+rc_t VDecodePoolWait ( VDecodePool *self, VDecodeJob *job )
+{
+    rc_t rc;
+
+    if ( job == NULL )
+        return RC ( rcVDB, rcMgr, rcWaiting, rcParam, rcNull );
+
+    /* without a pool every job was run inline by Submit */
+    if ( self == NULL )
+    {
+        if ( job -> state != eDecodeJobDone )
+            return RC ( rcVDB, rcMgr, rcWaiting, rcParam, rcInvalid );
+        return job -> rc;
+    }
+
+    /* workers update the state under lock */
+    rc = KLockAcquire ( self -> lock );
+    if ( rc != 0 )
+        return rc;
+
+    if ( job -> state == eDecodeJobIdle )
+    {
+        KLockUnlock ( self -> lock );
+        return RC ( rcVDB, rcMgr, rcWaiting, rcParam, rcInvalid );
+    }
+
+    if ( job -> state == eDecodeJobQueued )
+    {
+        /* no worker got to it yet - do it ourselves */
+        DLListUnlink ( & self -> queue, & job -> dad );
+        -- self -> queued;
+        KLockUnlock ( self -> lock );
+
+        VDecodeJobRunInline ( job );
+        return job -> rc;
+    }
+
+    while ( job -> state != eDecodeJobDone )
+    {
+        rc = KConditionWait ( self -> done, self -> lock );
+        if ( rc != 0 )
+        {
+            KLockUnlock ( self -> lock );
+            return rc;
+        }
+    }
+
+    rc = job -> rc;
+    KLockUnlock ( self -> lock );
+
+    return rc;
+}
+
+bool VDecodePoolCancel ( VDecodePool *self, VDecodeJob *job )
+{
+    if ( job == NULL )
+        return false;
+
+    if ( self == NULL )
+        return job -> state != eDecodeJobIdle;
+
+    if ( KLockAcquire ( self -> lock ) == 0 )
+    {
+        switch ( job -> state )
+        {
+        case eDecodeJobIdle:
+            KLockUnlock ( self -> lock );
+            return false;
+        case eDecodeJobQueued:
+            DLListUnlink ( & self -> queue, & job -> dad );
+            -- self -> queued;
+            job -> state = eDecodeJobIdle;
+            KLockUnlock ( self -> lock );
+            return false;
+        default:
+            break;
+        }
+        KLockUnlock ( self -> lock );
+    }
+
+    VDecodePoolWait ( self, job );
+    return true;
+}
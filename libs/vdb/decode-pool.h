@@ -0,0 +1,129 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#ifndef _h_decode_pool_
+#define _h_decode_pool_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifndef _h_klib_container_
+#include <klib/container.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * VDecodeJob
+ *  a unit of background work, embedded within the object it decodes
+ *  the embedding object owns the job and must outlive it
+ */
+typedef struct VDecodeJob VDecodeJob;
+typedef rc_t ( * VDecodeJobFunc ) ( VDecodeJob *self );
+
+enum
+{
+    eDecodeJobIdle,
+    eDecodeJobQueued,
+    eDecodeJobRunning,
+    eDecodeJobDone
+};
+
+struct VDecodeJob
+{
+    DLNode dad;
+    VDecodeJobFunc run;
+    rc_t rc;
+    volatile uint32_t state;
+};
+
+/* Init
+ *  prepare a job for submission
+ */
+void VDecodeJobInit ( VDecodeJob *self, VDecodeJobFunc run );
+
+
+/*--------------------------------------------------------------------------
+ * VDecodePool
+ *  manager-wide pool of worker threads
+ *  started on demand up to a configurable limit
+ *
+ *  a NULL pool, or one limited to 0 threads, runs every job inline
+ */
+typedef struct VDecodePool VDecodePool;
+
+/* Make
+ *  "max_threads" [ IN ] - upper limit on worker threads
+ */
+rc_t VDecodePoolMake ( VDecodePool **pool, uint32_t max_threads );
+
+/* Whack
+ *  stops and joins all workers
+ *  no jobs may be outstanding
+ */
+void VDecodePoolWhack ( VDecodePool *self );
+
+/* SetThreads
+ *  change the limit on worker threads
+ *  excess workers exit once idle
+ */
+void VDecodePoolSetThreads ( VDecodePool *self, uint32_t max_threads );
+
+/* Threaded
+ *  true if submitted jobs may run on a worker thread
+ *  rather than inline
+ */
+bool VDecodePoolThreaded ( VDecodePool *self );
+
+/* Submit
+ *  queue a job for a worker
+ *  runs it inline when no worker is available
+ */
+rc_t VDecodePoolSubmit ( VDecodePool *self, VDecodeJob *job );
+
+/* Wait
+ *  wait for job to complete and return its rc
+ *  a job still waiting in the queue is taken over by the caller
+ */
+rc_t VDecodePoolWait ( VDecodePool *self, VDecodeJob *job );
+
+/* Cancel
+ *  withdraw a job that is no longer needed
+ *  a job already running is waited upon
+ *  returns true if the job had been run
+ */
+bool VDecodePoolCancel ( VDecodePool *self, VDecodeJob *job );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_decode_pool_ */
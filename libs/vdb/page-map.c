@@ -34,6 +34,7 @@
 
 #include <klib/pack.h>
 #include <klib/vlen-encode.h>
+#include <klib/slab.h>
 #include <sysalloc.h>
 #include "page-map.h"
 
@@ -362,13 +363,14 @@ static rc_t PageMapFindRegion(const PageMap *cself,uint64_t row,PageMapRegion **
 	} else {
 		i_rgn = 0;
 	}
-	{
+	/** NB - a shared pagemap is read by several threads at once: its search hint stays as it was when published **/
+	if(!cself->shared){
 		PageMap *self = (PageMap *)cself;
 		self->i_rgn_last = i_rgn;
-		self->rgn_last = (PageMapRegion*)self->istorage.base+cself->i_rgn_last;
+		self->rgn_last = (PageMapRegion*)self->istorage.base+i_rgn;
 	}
-	assert(cself->rgn_last->start_row <= row);
-	assert(cself->rgn_last->start_row + cself->rgn_last->numrows > row);
+	assert(((PageMapRegion*)cself->istorage.base + i_rgn)->start_row <= row);
+	assert(((PageMapRegion*)cself->istorage.base + i_rgn)->start_row + ((PageMapRegion*)cself->istorage.base + i_rgn)->numrows > row);
 	if(pmr) *pmr=(PageMapRegion*)cself->istorage.base + i_rgn;
 	return 0;
 }
@@ -550,22 +552,37 @@ rc_t PageMapNewIterator(const PageMap *self, PageMapIterator *lhs, uint64_t firs
 	    rc = PageMapExpand(self,lhs->last_row-1);
 	    if(rc) return rc;
     }
-    rc = PageMapFindRow(self,first_row,NULL,NULL,NULL);
-    if(rc) return rc;
-    lhs->rgns    = (PageMapRegion**) &self->istorage.base;
-    lhs->exp_base = (elem_count_t**) &self->dstorage.base;
-    lhs->cur_rgn  = self->i_rgn_last;
-    lhs->cur_rgn_row = lhs->cur_row - (*lhs->rgns)[self->i_rgn_last].start_row;
-    assert(lhs->cur_rgn_row < (*lhs->rgns)[self->i_rgn_last].numrows);
+    {
+        PageMapRegion *pmr;
+        rc = PageMapFindRegion(self,first_row,&pmr);
+        if(rc) return rc;
+        lhs->rgns    = (PageMapRegion**) &self->istorage.base;
+        lhs->exp_base = (elem_count_t**) &self->dstorage.base;
+        lhs->cur_rgn  = (pm_size_t)(pmr - *lhs->rgns);
+        lhs->cur_rgn_row = lhs->cur_row - pmr->start_row;
+        assert(lhs->cur_rgn_row < pmr->numrows);
+    }
     return  0;
 }
 
+/* every blob carries a page map, so they are recycled */
+static KSlab PageMapSlab = KSLAB_INIT(sizeof(PageMap), 256);
+
+void PageMapGetSlabStats(struct KSlabStats *stats) {
+    KSlabGetStats(&PageMapSlab, stats);
+}
+
+void PageMapTrimSlab(void) {
+    KSlabTrim(&PageMapSlab);
+}
+
 static PageMap *new_PageMap(void) {
 
     PageMap *y;
-    y = malloc(sizeof(*y));
+    y = KSlabAlloc(&PageMapSlab);
     if (y) {
 	memset(y,0,sizeof(*y));
+        y->pooled = true;
         KRefcountInit(&y->refcount, 1, "PageMap", "new", "");
 	y->istorage.elem_bits = sizeof(PageMapRegion)*8;
 	y->dstorage.elem_bits = sizeof(elem_count_t)*8;
@@ -685,7 +702,7 @@ rc_t PageMapNew(PageMap **lhs, uint32_t reserve) {
     if (reserve > 0) {
         rc_t rc = PageMapGrow(y, reserve, reserve);
         if (rc) {
-            free(y);
+            KSlabFree(&PageMapSlab, y);
             return rc;
         }
 #if PAGEMAP_STATISTICS
@@ -1565,7 +1582,10 @@ rc_t PageMapDestroy(PageMap *that)
     KDataBufferWhack(&that->istorage);
     KDataBufferWhack(&that->dstorage);
     KDataBufferWhack(&that->cstorage);
-    free(that);
+    if (that->pooled)
+        KSlabFree(&PageMapSlab, that);
+    else
+        free(that);
     return 0;
 }
 
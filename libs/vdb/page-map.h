@@ -80,6 +80,7 @@ typedef struct PageMap {
      * == storage.base
      */
     bool   random_access;
+    bool   pooled;          /* allocated from the page map slab */
     enum { eBlobPageMapOptimizedNone, eBlobPageMapOptimizedSucceeded, eBlobPageMapOptimizedFailed}  optimized;
     elem_count_t *length;
 
@@ -115,6 +116,7 @@ typedef struct PageMap {
 /** LAST SEARCH CONTROL *****/
     pm_size_t			i_rgn_last; 	/* region index found in previous lookup **/
     PageMapRegion*		rgn_last; 	/* redundant - region found in previous lookup **/
+    bool			shared;		/* read by several threads - hint above is no longer updated **/
 
 /****************************/
 
@@ -375,6 +377,16 @@ static __inline__ row_count_t PageMapIteratorRepeatCount(const PageMapIterator *
 }
 
 elem_count_t PageMapLastLength(const PageMap *cself);
+/* GetSlabStats
+ *  recycling of page map objects, which is process-wide
+ */
+struct KSlabStats;
+void PageMapGetSlabStats(struct KSlabStats *stats);
+/* TrimSlab
+ *  free page map objects kept for recycling
+ */
+void PageMapTrimSlab(void);
+
 bool PageMapHasRows(const PageMap *self);
 rc_t PageMapExpand(const PageMap *cself, row_count_t upto);
 rc_t PageMapExpandFull(const PageMap *cself);
@@ -337,6 +337,37 @@ rc_t VPhysicalOpenRead ( VPhysical *self, VSchema *schema, const VTable *tbl )
     return rc;
 }
 
+/* ReadKColumnDirect
+ *  when column data are memory mapped, the raw blob is a view
+ *  of the mapping that holds a reference to the kblob for its
+ *  lifetime, so blobs needing no decoding are never copied
+ */
+static
+void CC VPhysicalKBlobViewWhack ( void *obj )
+{
+    KColumnBlobRelease ( obj );
+}
+
+static
+rc_t VPhysicalReadKColumnDirect ( const KColumnBlob *kblob, KDataBuffer *buffer )
+{
+    size_t size;
+    const void *addr;
+    rc_t rc = KColumnBlobReadDirect ( kblob, & addr, & size );
+    if ( rc == 0 )
+    {
+        rc = KColumnBlobAddRef ( kblob );
+        if ( rc == 0 )
+        {
+            rc = KDataBufferMakeView ( buffer, addr, size,
+                VPhysicalKBlobViewWhack, ( void* ) kblob );
+            if ( rc != 0 )
+                KColumnBlobRelease ( kblob );
+        }
+    }
+    return rc;
+}
+
 /* ReadKColumn
  *  read a raw blob from kcolumn
  */
@@ -392,6 +423,32 @@ rc_t VPhysicalReadKColumn ( VPhysical *self, VBlob **vblob, int64_t id, uint32_t
     /* find blob in KColumn
        TBD - handle potential merge/update later */
     rc = KColumnOpenBlobRead ( self -> kcol, & kblob, id );
+    if ( rc == 0 && ! self -> no_hdr )
+    {
+        KDataBuffer buffer;
+        if ( VPhysicalReadKColumnDirect ( kblob, & buffer ) == 0 )
+        {
+            uint32_t count;
+            int64_t start_id;
+            rc = KColumnBlobIdRange ( kblob, & start_id, & count );
+            if ( rc == 0 )
+            {
+                rc = VBlobNew ( vblob, start_id, start_id + count - 1, "readkcolumn" );
+                TRACK_BLOB (VBlobNew, *vblob);
+                if ( rc == 0 )
+                {
+                    rc = KDataBufferSub ( & buffer, & ( * vblob ) -> data, 0, UINT64_MAX );
+                    assert ( rc == 0 );
+                }
+            }
+
+            KDataBufferWhack ( & buffer );
+            KColumnBlobRelease ( kblob );
+            return rc;
+        }
+
+        /* not mapped: read into a buffer of its own */
+    }
     if ( rc == 0 )
     {
         /* get blob size */
@@ -558,12 +615,7 @@ rc_t VPhysicalReadBlob ( VPhysical *self, VBlob **vblob, int64_t id, uint32_t el
     /* need to read from kcolumn path */
     rc = VProductionReadBlob ( self -> b2p, vblob, id , 1, NULL);
 	if ( rc == 0 )
-    {
-	    if((*vblob)->pm==NULL)
-        {
-            rc = PageMapProcessGetPagemap(&self->curs->pmpr,&(*vblob)->pm);
-	    }
-    }
+        rc = VBlobResolvePageMap ( * vblob );
 
 	return rc;
 }
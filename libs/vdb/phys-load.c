@@ -237,13 +237,10 @@ rc_t CC VPhysicalLoadSchema ( VPhysical *self,
     rc_t rc;
 
     KMDataNodeSchemaFillData pb;
-    pb . node = node;
-    pb . pos = 0;
-    pb . add_v0 = false;
 
-    /* add stored declaration to cursor schema */
-    rc = VSchemaParseTextCallback ( schema,
-        "VPhysicalLoadSchema", KMDataNodeFillSchema, & pb );
+    /* add stored declaration to cursor schema,
+       which may already hold it from another column */
+    rc = VSchemaParseNodeOnce ( schema, node, "VPhysicalLoadSchema" );
     if ( rc == 0 )
     {
         /* retrieve fully-resolved type attribute */
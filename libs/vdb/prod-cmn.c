@@ -237,18 +237,17 @@ rc_t VSimpleProdSerial2Blob ( VSimpleProd *self, VBlob **rslt, int64_t id, uint3
         {
             /* create a new, fluffy blob having rowmap and headers */
             VBlob *y;
+            struct VDecodePool *pool = NULL;
 #if LAUNCH_PAGEMAP_THREAD
-            if(self->curs->pagemap_thread == NULL){
-                VCursor *curs = (VCursor*) self->curs;
-                if(--curs->launch_cnt<=0){
-                    /* ignoring errors because we operate with or without thread */
-                    VCursorLaunchPagemapThread(curs);
-                }
-            }
+            VCursor *curs = (VCursor*) self->curs;
+            if(curs->launch_cnt > 0)
+                --curs->launch_cnt;
+            else
+                pool = VCursorDecodePool(curs);
 #endif
-		
+
             rc = VBlobCreateFromData ( & y, sblob -> start_id, sblob -> stop_id,
-                & buffer, VTypedescSizeof ( & self -> dad . desc ), self->curs->pagemap_thread?&self->curs->pmpr:NULL );
+                & buffer, VTypedescSizeof ( & self -> dad . desc ), pool );
             KDataBufferWhack ( & buffer );
 
             /* return on success */
@@ -696,6 +695,234 @@ rc_t VFunctionProdCallRowFunc( VFunctionProd *self, VBlob **prslt, int64_t row_i
     return rc;
 }
 
+/* CallRowBatchFunc
+ *  like CallRowFunc, but hands the function every row of the output blob
+ *  in a single call. when reading forward, the output covers all rows
+ *  common to the input blobs; otherwise just the rows requested, cut
+ *  short where an input ends.
+ */
+static
+rc_t VFunctionProdCallRowBatchFunc( VFunctionProd *self, VBlob **prslt, int64_t row_id,
+    uint32_t row_count, const VXformInfo *info, Vector *args )
+{
+    rc_t rc;
+    uint32_t i, j, argc = VectorLength ( args );
+    uint32_t nrows, *row_info;
+    int64_t start_id, stop_id, first, last;
+    VRowBatchResult rslt;
+    VRowBatchData args_os[16], *args_oh, *argv;
+    KDataBuffer scratch, packed;
+    VBlob *blob;
+    const VBlob *in;
+
+    if ( row_count == 0 )
+        row_count = 1;
+
+    /* the rows all inputs have in common */
+    first = -INT64_MAX - 1;
+    last = INT64_MAX;
+    for ( i = 0; i != argc; ++ i )
+    {
+        in = VectorGet ( args, i );
+        if ( first < in -> start_id )
+            first = in -> start_id;
+        if ( last > in -> stop_id )
+            last = in -> stop_id;
+    }
+    if ( row_id < first || row_id > last )
+        return RC ( rcVDB, rcFunction, rcExecuting, rcRange, rcInvalid );
+
+    start_id = row_id;
+    stop_id = row_id + ( row_count - 1 );
+    if ( stop_id > last || stop_id < row_id )
+        stop_id = last;
+
+    if ( row_id == self -> stop_id + 1 &&
+         first != -INT64_MAX - 1 && last != INT64_MAX && last - first < UINT32_MAX )
+    {
+        /* sequential io - take everything the inputs have in common */
+        start_id = first;
+        stop_id = last;
+    }
+    self -> start_id = start_id;
+    self -> stop_id = stop_id;
+    nrows = ( uint32_t ) ( stop_id - start_id + 1 );
+
+#if PROD_NAME
+    rc = VBlobNew ( &blob, start_id, stop_id, self->dad.name );
+#else
+    rc = VBlobNew ( &blob, start_id, stop_id, "VFunctionProdCallRowBatchFunc" );
+#endif
+    TRACK_BLOB ( VBlobNew, blob );
+    if ( rc != 0 )
+        return rc;
+
+    /* per input: first element and length of each row,
+       followed by output row lengths */
+    row_info = malloc ( ( 2 * ( size_t ) argc + 1 ) * nrows * sizeof row_info [ 0 ] );
+    if ( row_info == NULL )
+    {
+        vblob_release ( blob, NULL );
+        return RC ( rcVDB, rcFunction, rcExecuting, rcMemory, rcExhausted );
+    }
+
+    args_oh = NULL;
+    argv = args_os;
+    if ( argc > sizeof args_os / sizeof args_os [ 0 ] )
+    {
+        argv = args_oh = malloc ( argc * sizeof args_oh [ 0 ] );
+        if ( args_oh == NULL )
+            rc = RC ( rcVDB, rcFunction, rcExecuting, rcMemory, rcExhausted );
+    }
+
+    for ( i = 0; i != argc && rc == 0; ++ i )
+    {
+        PageMapIterator iter;
+        uint32_t *first_elem = row_info + 2 * i * nrows;
+        uint32_t *elem_count = first_elem + nrows;
+
+        in = VectorGet ( args, i );
+        if ( in -> start_id == -INT64_MAX - 1 )
+            rc = PageMapNewIterator ( in -> pm, & iter, 0, -1 );
+        else
+            rc = PageMapNewIterator ( in -> pm, & iter, start_id - in -> start_id, nrows );
+        if ( rc != 0 )
+            break;
+
+        for ( j = 0; j != nrows; ++ j )
+        {
+            first_elem [ j ] = PageMapIteratorDataOffset ( & iter );
+            elem_count [ j ] = PageMapIteratorDataLength ( & iter );
+            PageMapIteratorNext ( & iter );
+        }
+
+        argv [ i ] . elem_bits = in -> data . elem_bits;
+        argv [ i ] . base = in -> data . base;
+        argv [ i ] . first_elem = first_elem;
+        argv [ i ] . elem_count = elem_count;
+    }
+
+    memset ( & scratch, 0, sizeof scratch );
+    rslt . data = & scratch;
+    if ( rc == 0 )
+    {
+        rslt . elem_count = 0;
+        rslt . elem_bits = scratch . elem_bits = VTypedescSizeof ( & self -> dad . desc );
+        rslt . row_len = row_info + 2 * argc * nrows;
+        memset ( rslt . row_len, 0, nrows * sizeof rslt . row_len [ 0 ] );
+
+        rc = self -> u . rbf ( self -> fself, info, start_id, nrows, & rslt, argc, argv );
+    }
+
+    if ( rc == 0 )
+    {
+        /* take the output buffer as blob data */
+        KDataBufferWhack ( & blob -> data );
+        rc = KDataBufferSub ( rslt . data, & blob -> data, 0, UINT64_MAX );
+        blob -> byte_order = vboNative;
+    }
+
+    if ( rc == 0 )
+        rc = PageMapNew ( & blob -> pm, nrows );
+    if ( rc == 0 )
+        rc = PageMapPreExpandFull ( blob -> pm, nrows );
+
+    /* rows that are not byte aligned are packed into a new buffer */
+    memset ( & packed, 0, sizeof packed );
+    if ( rc == 0 && ( rslt . elem_bits & 7 ) != 0 && rslt . elem_count != 0 )
+        rc = KDataBufferMake ( & packed, rslt . elem_bits, rslt . elem_count );
+
+    if ( rc == 0 )
+    {
+        /* record row lengths, folding repeated rows into runs.
+           a row whose inputs all repeat the previous row repeats its
+           output as well; other rows are compared with the last one kept */
+        const uint32_t *row_len = rslt . row_len;
+        uint64_t elem_bits = rslt . elem_bits;
+        bool byte_aligned = ( elem_bits & 7 ) == 0;
+        const uint8_t *src = blob -> data . base;
+        uint8_t *dst = byte_aligned ? blob -> data . base : packed . base;
+        uint64_t rd = 0, wr = 0, kept = 0;
+        uint32_t run = 0;
+
+        for ( j = 0; j != nrows && rc == 0; ++ j )
+        {
+            uint64_t len = row_len [ j ];
+            bool same = false;
+
+            if ( rd + len > rslt . elem_count )
+            {
+                rc = RC ( rcVDB, rcFunction, rcExecuting, rcData, rcInconsistent );
+                break;
+            }
+
+            if ( j != 0 && len == row_len [ j - 1 ] )
+            {
+                for ( same = true, i = 0; same && i != argc; ++ i )
+                {
+                    same = argv [ i ] . first_elem [ j ] == argv [ i ] . first_elem [ j - 1 ] &&
+                           argv [ i ] . elem_count [ j ] == argv [ i ] . elem_count [ j - 1 ];
+                }
+                if ( ! same && byte_aligned )
+                    same = memcmp ( dst + ( kept * elem_bits >> 3 ), src + ( rd * elem_bits >> 3 ),
+                        ( size_t ) ( len * elem_bits >> 3 ) ) == 0;
+                else if ( ! same )
+                    same = bitcmp ( dst, kept * elem_bits, src, rd * elem_bits, len * elem_bits ) == 0;
+            }
+
+            if ( ! same )
+            {
+                if ( run != 0 )
+                    rc = PageMapAppendRows ( blob -> pm, row_len [ j - 1 ], run, true );
+                run = 0;
+
+                if ( ! byte_aligned )
+                    bitcpy ( dst, wr * elem_bits, src, rd * elem_bits, len * elem_bits );
+                else if ( wr != rd )
+                    memmove ( dst + ( wr * elem_bits >> 3 ), src + ( rd * elem_bits >> 3 ),
+                        ( size_t ) ( len * elem_bits >> 3 ) );
+                kept = wr;
+                wr += len;
+
+                if ( rc == 0 )
+                    rc = PageMapAppendRows ( blob -> pm, len, 1, false );
+            }
+            else
+            {
+                ++ run;
+            }
+            rd += len;
+        }
+        if ( rc == 0 && run != 0 )
+            rc = PageMapAppendRows ( blob -> pm, row_len [ nrows - 1 ], run, true );
+
+        if ( rc == 0 && ! byte_aligned && packed . base != NULL )
+        {
+            KDataBufferWhack ( & blob -> data );
+            rc = KDataBufferSub ( & packed, & blob -> data, 0, wr );
+        }
+        blob -> data . elem_count = wr;
+    }
+    KDataBufferWhack ( & packed );
+
+    /* drop any new buffer that was returned to us */
+    if ( rslt . data != & scratch )
+        KDataBufferWhack ( rslt . data );
+    KDataBufferWhack ( & scratch );
+    if ( args_oh != NULL )
+        free ( args_oh );
+    free ( row_info );
+
+    if ( rc == 0 )
+    {
+        * prslt = blob;
+        return 0;
+    }
+
+    vblob_release ( blob, NULL );
+    return rc;
+}
+
 static
 rc_t VFunctionProdCallArrayFunc( VFunctionProd *self, VBlob **prslt,
     int64_t id, const VXformInfo *info, Vector *args ) {
@@ -788,10 +1015,8 @@ rc_t VFunctionProdCallPageFunc( VFunctionProd *self, VBlob **rslt, int64_t id,
         const VProduction *prod = (const VProduction *)VectorGet(&self->parms, i);
 
 
-        if(b->pm == NULL){
-            rc=PageMapProcessGetPagemap(&self->curs->pmpr,(PageMap**)(&b->pm));
-            if(rc != 0) return rc;
-        }
+        rc = VBlobResolvePageMap(b);
+        if(rc != 0) return rc;
         
         if (prod->control) {
             param[i].variant = vrdControl;
@@ -1175,11 +1400,8 @@ rc_t VFunctionProdCallBlobNFunc( VFunctionProd *self, VBlob **rslt,
     {
 	int i;
 	for(i=0;i<argc;i++){
-		VBlob const *vb=argv[i];
-		if(vb->pm == NULL){
-			rc=PageMapProcessGetPagemap(&self->curs->pmpr,(PageMap**)(&vb->pm));
-			if(rc != 0) return rc;
-		}
+		rc=VBlobResolvePageMap(argv[i]);
+		if(rc != 0) return rc;
 	}
     }
     rc = self->u.bfN(self->fself, info, id, rslt, argc, argv);
@@ -1679,6 +1901,9 @@ static rc_t VFunctionProdReadNormal ( VFunctionProd *self, VBlob **vblob, int64_
         case vftIdDepRow:
             rc = VFunctionProdCallRowFunc ( self, &vb, id_run, cnt_run, & info, & inputs );
             break;
+        case vftRowBatch:
+            rc = VFunctionProdCallRowBatchFunc ( self, &vb, id_run, ( uint32_t ) cnt_run, & info, & inputs );
+            break;
         case vftArray:
             rc = VFunctionProdCallArrayFunc ( self, &vb, id_run, & info, & inputs );
             break;
@@ -1835,6 +2060,7 @@ uint32_t VFunctionProdFixedRowLength ( const VFunctionProd *self, int64_t row_id
         case vftRow:
         case vftNonDetRow:
         case vftIdDepRow:
+        case vftRowBatch:
             return 0;
         }
     }
@@ -567,7 +567,7 @@ rc_t VProdResolveInvokeFactory ( const VProdResolve *self, const VXfactInfo *inf
     /* TBD - validate the returned value */
     else if ( external &&
         ( desc . variant == vftInvalid ||
-          desc . variant > vftBlob ||
+          desc . variant > vftRowBatch ||
           desc . u . bf == NULL ) )
     {
         rc = RC ( rcVDB, rcFunction, rcConstructing, rcType, rcInvalid );
@@ -317,6 +317,7 @@ struct VFunctionProd
         VArrayFunc af;
         VFixedRowFunc pf;
         VBlobFunc bf;
+        VRowBatchFunc rbf;
 
         /* merge type */
         VBlobFuncN bfN;
@@ -0,0 +1,439 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#include "cursor-priv.h"
+#include "column-priv.h"
+#include "table-priv.h"
+#include "dbmgr-priv.h"
+#include "schema-priv.h"
+#include "blob-priv.h"
+#include "phys-priv.h"
+#include "decode-pool.h"
+
+#include <vdb/cursor.h>
+#include <vdb/schema.h>
+#include <kdb/column.h>
+#include <klib/symbol.h>
+#include <klib/rc.h>
+#include <klib/container.h>
+#include <kproc/lock.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+/* forward misses needed before fetching ahead */
+#define READ_AHEAD_MIN_SEQ 2
+
+
+/*--------------------------------------------------------------------------
+ * VReadAheadBlob
+ *  a blob fetched ahead of the reader
+ */
+typedef struct VReadAheadBlob VReadAheadBlob;
+struct VReadAheadBlob
+{
+    DLNode dad;
+    const VBlob *blob;
+};
+
+static
+void CC VReadAheadBlobWhack ( DLNode *n, void *ignore )
+{
+    VReadAheadBlob *self = ( VReadAheadBlob* ) n;
+    VBlobRelease ( ( VBlob* ) self -> blob );
+    free ( self );
+}
+
+
+/*--------------------------------------------------------------------------
+ * VReadAheadColumn
+ *  state kept per column of the reading cursor
+ */
+typedef struct VReadAheadColumn VReadAheadColumn;
+struct VReadAheadColumn
+{
+    /* blobs fetched but not yet consumed, in row order */
+    DLList ready;
+    uint32_t count;
+
+    /* column index on shadow cursor, 0 if not fetched */
+    uint32_t idx;
+
+    /* last row fetched */
+    int64_t horizon;
+};
+
+
+/*--------------------------------------------------------------------------
+ * VCursorReadAhead
+ *  fetches the next few blobs of every column of a read cursor
+ *  that is being scanned forward, using a private shadow cursor
+ *  on the same table driven from the manager's decode pool
+ */
+struct VCursorReadAhead
+{
+    /* MUST be first */
+    VDecodeJob dad;
+
+    VDecodePool *pool;
+    const VCursor *shadow;
+    KLock *lock;
+
+    /* indexed by reader column index */
+    VReadAheadColumn *col;
+    uint32_t ncol;
+
+    /* blobs to keep ahead per column */
+    uint32_t nblobs;
+
+    /* last row to fetch */
+    int64_t row_stop;
+
+    /* row the reader needed at time of scheduling */
+    int64_t target;
+
+    /* sequential access detection */
+    int64_t last_row;
+    uint32_t seq;
+
+    /* bumped whenever fetched blobs are abandoned */
+    uint32_t gen;
+};
+
+static
+void VCursorReadAheadResetColumns ( VCursorReadAhead *self )
+{
+    uint32_t i;
+    for ( i = 0; i < self -> ncol; ++ i )
+    {
+        VReadAheadColumn *col = & self -> col [ i ];
+        DLListWhack ( & col -> ready, VReadAheadBlobWhack, NULL );
+        col -> count = 0;
+        col -> horizon = 0;
+    }
+}
+
+/* Run
+ *  on a pool thread: top up every column to "nblobs" blobs past target
+ */
+static
+rc_t VCursorReadAheadRun ( VDecodeJob *job )
+{
+    VCursorReadAhead *self = ( VCursorReadAhead* ) job;
+    uint32_t i, gen;
+    int64_t target;
+
+    rc_t rc = KLockAcquire ( self -> lock );
+    if ( rc != 0 )
+        return rc;
+    gen = self -> gen;
+    target = self -> target;
+    KLockUnlock ( self -> lock );
+
+    for ( i = 0; i < self -> ncol; ++ i )
+    {
+        VReadAheadColumn *col = & self -> col [ i ];
+        uint32_t idx = col -> idx;
+
+        while ( idx != 0 )
+        {
+            int64_t row;
+            const VBlob *blob;
+            VReadAheadBlob *rab;
+
+            rc = KLockAcquire ( self -> lock );
+            if ( rc != 0 )
+                return rc;
+            row = col -> horizon >= target ? col -> horizon + 1 : target;
+            if ( self -> gen != gen || col -> count >= self -> nblobs || row > self -> row_stop )
+                idx = 0;
+            KLockUnlock ( self -> lock );
+            if ( idx == 0 )
+                break;
+
+            rc = VCursorGetBlobDirect ( self -> shadow, & blob, row, idx );
+            if ( rc == 0 )
+            {
+                rc = VBlobExpandPageMap ( blob );
+                if ( rc == 0 )
+                {
+                    rab = malloc ( sizeof * rab );
+                    if ( rab == NULL )
+                        rc = RC ( rcVDB, rcCursor, rcReading, rcMemory, rcExhausted );
+                }
+                if ( rc != 0 )
+                    VBlobRelease ( ( VBlob* ) blob );
+            }
+            if ( rc != 0 )
+            {
+                /* the reader will run into the same problem and report it */
+                KLockAcquire ( self -> lock );
+                col -> idx = 0;
+                KLockUnlock ( self -> lock );
+                break;
+            }
+
+            rab -> blob = blob;
+
+            KLockAcquire ( self -> lock );
+            if ( self -> gen == gen )
+            {
+                DLListPushTail ( & col -> ready, & rab -> dad );
+                ++ col -> count;
+                col -> horizon = blob -> stop_id;
+                rab = NULL;
+            }
+            KLockUnlock ( self -> lock );
+
+            if ( rab != NULL )
+            {
+                VReadAheadBlobWhack ( & rab -> dad, NULL );
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* AdviseSequential
+ *  the shadow only ever moves forward: let the system read ahead
+ *  of it on any physical column that is memory mapped
+ */
+static
+void CC VPhysicalAdviseSequential ( void *item, void *ignore )
+{
+    const VPhysical *phys = item;
+    if ( phys != NULL && phys -> kcol != NULL )
+        KColumnAdviseAccess ( phys -> kcol, kcaSequential );
+}
+
+static
+void VCursorReadAheadAdviseSequential ( const VCursor *shadow )
+{
+    uint32_t i = VectorStart ( & shadow -> phys . cache );
+    uint32_t end = i + VectorLength ( & shadow -> phys . cache );
+    for ( ; i < end; ++ i )
+    {
+        const Vector *ctx = VectorGet ( & shadow -> phys . cache, i );
+        if ( ctx != NULL )
+            VectorForEach ( ctx, false, VPhysicalAdviseSequential, NULL );
+    }
+}
+
+/* Make
+ *  creates a shadow cursor over the open columns of "curs"
+ */
+rc_t VCursorReadAheadMake ( VCursorReadAhead **rap, const VCursor *curs, uint32_t nblobs )
+{
+    rc_t rc;
+    VCursorReadAhead *ra;
+    uint32_t i, end, added;
+    int64_t first;
+    uint64_t count;
+
+    assert ( rap != NULL );
+    assert ( curs != NULL );
+    assert ( nblobs != 0 );
+
+    end = VectorStart ( & curs -> row ) + VectorLength ( & curs -> row );
+
+    ra = calloc ( 1, sizeof * ra );
+    if ( ra == NULL )
+        return RC ( rcVDB, rcCursor, rcConstructing, rcMemory, rcExhausted );
+
+    ra -> col = calloc ( end, sizeof ra -> col [ 0 ] );
+    if ( ra -> col == NULL )
+        rc = RC ( rcVDB, rcCursor, rcConstructing, rcMemory, rcExhausted );
+    else
+    {
+        VDecodeJobInit ( & ra -> dad, VCursorReadAheadRun );
+        ra -> pool = curs -> tbl -> mgr -> decode_pool;
+        ra -> ncol = end;
+        ra -> nblobs = nblobs;
+        ra -> last_row = INT64_MIN;
+        for ( i = 0; i < end; ++ i )
+            DLListInit ( & ra -> col [ i ] . ready );
+
+        rc = KLockMake ( & ra -> lock );
+        if ( rc == 0 )
+            rc = VTableCreateCursorRead ( curs -> tbl, & ra -> shadow );
+        for ( added = 0, i = VectorStart ( & curs -> row ); rc == 0 && i < end; ++ i )
+        {
+            char td [ 256 ];
+            const VColumn *col = VectorGet ( & curs -> row, i );
+            if ( col == NULL )
+                continue;
+
+            /* a column the shadow cannot resolve is left to the reader */
+            if ( VTypedeclToText ( & col -> td, curs -> schema, td, sizeof td ) == 0 &&
+                 VCursorAddColumn ( ra -> shadow, & ra -> col [ i ] . idx, "(%s)%.*s", td,
+                     ( int ) col -> scol -> name -> name . size, col -> scol -> name -> name . addr ) == 0 )
+            {
+                ++ added;
+            }
+            else
+            {
+                ra -> col [ i ] . idx = 0;
+            }
+        }
+        if ( rc == 0 && added == 0 )
+            rc = RC ( rcVDB, rcCursor, rcConstructing, rcColumn, rcNotFound );
+        if ( rc == 0 )
+            rc = VCursorOpen ( ra -> shadow );
+        if ( rc == 0 )
+            rc = VCursorIdRange ( ra -> shadow, 0, & first, & count );
+        if ( rc == 0 )
+        {
+            VCursorReadAheadAdviseSequential ( ra -> shadow );
+            ra -> row_stop = first + ( int64_t ) count - 1;
+            * rap = ra;
+            return 0;
+        }
+
+        VCursorRelease ( ra -> shadow );
+        KLockRelease ( ra -> lock );
+        free ( ra -> col );
+    }
+
+    free ( ra );
+    * rap = NULL;
+    return rc;
+}
+
+/* Whack
+ *  withdraws or waits for background work and releases all blobs
+ */
+void VCursorReadAheadWhack ( VCursorReadAhead *self )
+{
+    if ( self != NULL )
+    {
+        VDecodePoolCancel ( self -> pool, & self -> dad );
+        VCursorReadAheadResetColumns ( self );
+        VCursorRelease ( self -> shadow );
+        KLockRelease ( self -> lock );
+        free ( self -> col );
+        free ( self );
+    }
+}
+
+/* Find
+ *  called by reader upon a cache miss on "col_idx" at "row_id"
+ *  returns a new reference to blob fetched ahead, or NULL
+ *  and schedules further fetching if access looks sequential
+ */
+const VBlob *VCursorReadAheadFind ( VCursorReadAhead *self, uint32_t col_idx, int64_t row_id )
+{
+    const VBlob *blob = NULL;
+    bool submit = false;
+    DLList dead;
+
+    if ( self == NULL || col_idx >= self -> ncol )
+        return NULL;
+
+    DLListInit ( & dead );
+
+    if ( KLockAcquire ( self -> lock ) != 0 )
+        return NULL;
+
+    if ( row_id < self -> last_row )
+    {
+        /* reader went back: abandon whatever was fetched */
+        ++ self -> gen;
+        self -> seq = 0;
+        VCursorReadAheadResetColumns ( self );
+    }
+    else if ( self -> seq < READ_AHEAD_MIN_SEQ )
+    {
+        ++ self -> seq;
+    }
+    self -> last_row = row_id;
+
+    {
+        VReadAheadColumn *col = & self -> col [ col_idx ];
+        VReadAheadBlob *rab;
+        while ( ( rab = ( VReadAheadBlob* ) DLListHead ( & col -> ready ) ) != NULL )
+        {
+            if ( rab -> blob -> stop_id >= row_id )
+            {
+                if ( rab -> blob -> start_id <= row_id )
+                {
+                    DLListUnlink ( & col -> ready, & rab -> dad );
+                    -- col -> count;
+                    blob = rab -> blob;
+                    free ( rab );
+                }
+                break;
+            }
+
+            /* reader has moved past it */
+            DLListUnlink ( & col -> ready, & rab -> dad );
+            -- col -> count;
+            DLListPushTail ( & dead, & rab -> dad );
+        }
+    }
+
+    if ( self -> seq >= READ_AHEAD_MIN_SEQ &&
+         ( self -> dad . state == eDecodeJobIdle || self -> dad . state == eDecodeJobDone ) )
+    {
+        self -> target = row_id;
+        submit = true;
+    }
+
+    KLockUnlock ( self -> lock );
+
+    DLListWhack ( & dead, VReadAheadBlobWhack, NULL );
+
+    /* read-ahead run inline would only stall the reader */
+    if ( submit && VDecodePoolThreaded ( self -> pool ) )
+    {
+        VDecodeJobInit ( & self -> dad, VCursorReadAheadRun );
+        VDecodePoolSubmit ( self -> pool, & self -> dad );
+    }
+
+    return blob;
+}
+
+/* Skip
+ *  called by reader after producing "blob" itself,
+ *  so that it will not be fetched again in background
+ */
+void VCursorReadAheadSkip ( VCursorReadAhead *self, uint32_t col_idx, const VBlob *blob )
+{
+    if ( self != NULL && col_idx < self -> ncol && KLockAcquire ( self -> lock ) == 0 )
+    {
+        VReadAheadColumn *col = & self -> col [ col_idx ];
+        if ( col -> horizon < blob -> stop_id )
+            col -> horizon = blob -> stop_id;
+        KLockUnlock ( self -> lock );
+    }
+}
@@ -0,0 +1,362 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#include "schema-priv.h"
+
+#include <vdb/vdb-priv.h>
+#include <kdb/meta.h>
+#include <klib/rc.h>
+#include <klib/checksum.h>
+#include <klib/container.h>
+#include <klib/debug.h>
+#include <kproc/lock.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*--------------------------------------------------------------------------
+ * VSchemaCacheEntry
+ *  a parsed schema, identified by its parent
+ *  and by the digest of the text it was parsed from
+ */
+typedef struct VSchemaCacheKey VSchemaCacheKey;
+struct VSchemaCacheKey
+{
+    const VSchema *dad;
+    uint64_t size;
+    uint8_t digest [ 16 ];
+};
+
+typedef struct VSchemaCacheEntry VSchemaCacheEntry;
+struct VSchemaCacheEntry
+{
+    BSTNode n;
+    VSchemaCacheKey key;
+    const VSchema *schema;
+};
+
+static
+int VSchemaCacheKeyCmp ( const VSchemaCacheKey *a, const VSchemaCacheKey *b )
+{
+    if ( a -> dad != b -> dad )
+        return a -> dad < b -> dad ? -1 : 1;
+    if ( a -> size != b -> size )
+        return a -> size < b -> size ? -1 : 1;
+    return memcmp ( a -> digest, b -> digest, sizeof a -> digest );
+}
+
+static
+int CC VSchemaCacheEntryCmp ( const void *item, const BSTNode *n )
+{
+    return VSchemaCacheKeyCmp ( item, & ( ( const VSchemaCacheEntry* ) n ) -> key );
+}
+
+static
+int CC VSchemaCacheEntrySort ( const BSTNode *item, const BSTNode *n )
+{
+    return VSchemaCacheKeyCmp ( & ( ( const VSchemaCacheEntry* ) item ) -> key,
+        & ( ( const VSchemaCacheEntry* ) n ) -> key );
+}
+
+static
+bool CC VSchemaCacheEntryHolds ( BSTNode *n, void *data )
+{
+    return ( ( const VSchemaCacheEntry* ) n ) -> schema == data;
+}
+
+static
+void CC VSchemaCacheEntryWhack ( BSTNode *n, void *ignore )
+{
+    VSchemaCacheEntry *self = ( VSchemaCacheEntry* ) n;
+    VSchemaRelease ( self -> schema );
+    free ( self );
+}
+
+
+/*--------------------------------------------------------------------------
+ * VSchemaCache
+ *  schemas parsed from the metadata of read-only tables and databases,
+ *  shared by all objects of a manager that store identical text
+ *
+ *  a schema is only cached when its parent is the intrinsic schema
+ *  or itself a cached schema, since neither changes after parsing.
+ */
+struct VSchemaCache
+{
+    KLock *lock;
+    BSTree cache;
+
+    /* statistics */
+    uint64_t entries;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytes_saved;
+};
+
+rc_t VSchemaCacheMake ( VSchemaCache **cachep )
+{
+    rc_t rc;
+
+    VSchemaCache *self = calloc ( 1, sizeof * self );
+    if ( self == NULL )
+        return RC ( rcVDB, rcMgr, rcConstructing, rcMemory, rcExhausted );
+
+    BSTreeInit ( & self -> cache );
+    rc = KLockMake ( & self -> lock );
+    if ( rc != 0 )
+    {
+        free ( self );
+        self = NULL;
+    }
+
+    * cachep = self;
+    return rc;
+}
+
+void VSchemaCacheWhack ( VSchemaCache *self )
+{
+    if ( self != NULL )
+    {
+        DBGMSG ( DBG_VDB, DBG_FLAG ( DBG_VDB_VDB ),
+                 ( "VSchemaCache: %lu schemas, %lu hits, %lu misses, %lu bytes of text not parsed\n",
+                   self -> entries, self -> hits, self -> misses, self -> bytes_saved ) );
+
+        BSTreeWhack ( & self -> cache, VSchemaCacheEntryWhack, NULL );
+        KLockRelease ( self -> lock );
+        free ( self );
+    }
+}
+
+void VSchemaCacheGetStats ( VSchemaCache *self, VSchemaCacheStats *stats )
+{
+    memset ( stats, 0, sizeof * stats );
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        stats -> entries = self -> entries;
+        stats -> hits = self -> hits;
+        stats -> misses = self -> misses;
+        stats -> bytes_saved = self -> bytes_saved;
+        KLockUnlock ( self -> lock );
+    }
+}
+
+/* Digest
+ *  the key of the schema text stored in a node
+ */
+static
+rc_t VSchemaCacheDigest ( const KMDataNode *node, VSchemaCacheKey *key )
+{
+    rc_t rc;
+    MD5State md5;
+    char buff [ 16 * 1024 ];
+
+    MD5StateInit ( & md5 );
+    for ( key -> size = 0; ; )
+    {
+        size_t num_read;
+        rc = KMDataNodeRead ( node, ( size_t ) key -> size, buff, sizeof buff, & num_read, NULL );
+        if ( rc != 0 || num_read == 0 )
+            break;
+        MD5StateAppend ( & md5, buff, num_read );
+        key -> size += num_read;
+    }
+    MD5StateFinish ( & md5, key -> digest );
+
+    return rc;
+}
+
+/* LoadNode
+ *  parse the schema text of a node into "schema", an empty child of
+ *  its eventual parent, or replace it with a matching cached schema
+ *
+ *  "intrinsic" [ IN ] - the intrinsic schema of the manager
+ *
+ *  "schema" [ IN/OUT ] - the schema of the table or database
+ */
+rc_t VSchemaCacheLoadNode ( VSchemaCache *self, const VSchema *intrinsic,
+    VSchema **schema, const KMDataNode *node, const char *name )
+{
+    rc_t rc;
+    VSchemaCacheKey key;
+    KMDataNodeSchemaFillData pb;
+
+    key . dad = ( * schema ) -> dad;
+    if ( self != NULL && key . dad != intrinsic )
+    {
+        /* the parent may be user-supplied, and open to changes */
+        bool cached = false;
+        if ( KLockAcquire ( self -> lock ) == 0 )
+        {
+            cached = BSTreeDoUntil ( & self -> cache, false,
+                VSchemaCacheEntryHolds, ( void* ) key . dad );
+            KLockUnlock ( self -> lock );
+        }
+        if ( ! cached )
+            self = NULL;
+    }
+
+    if ( self != NULL && VSchemaCacheDigest ( node, & key ) == 0 )
+    {
+        rc = KLockAcquire ( self -> lock );
+        if ( rc == 0 )
+        {
+            const VSchemaCacheEntry *entry = ( const VSchemaCacheEntry* )
+                BSTreeFind ( & self -> cache, & key, VSchemaCacheEntryCmp );
+            if ( entry != NULL )
+            {
+                VSchemaAddRef ( entry -> schema );
+                VSchemaRelease ( * schema );
+                * schema = ( VSchema* ) entry -> schema;
+
+                ++ self -> hits;
+                self -> bytes_saved += key . size;
+                KLockUnlock ( self -> lock );
+                return 0;
+            }
+
+            ++ self -> misses;
+            KLockUnlock ( self -> lock );
+        }
+    }
+    else
+    {
+        self = NULL;
+    }
+
+    pb . node = node;
+    pb . pos = 0;
+    pb . add_v0 = false;
+
+    rc = VSchemaParseTextCallback ( * schema, name, KMDataNodeFillSchema, & pb );
+
+    if ( rc == 0 && self != NULL )
+    {
+        VSchemaCacheEntry *entry = malloc ( sizeof * entry );
+        if ( entry != NULL )
+        {
+            entry -> key = key;
+            entry -> schema = * schema;
+            if ( KLockAcquire ( self -> lock ) != 0 )
+                free ( entry );
+            else
+            {
+                /* another thread may have parsed the same text meanwhile */
+                if ( BSTreeInsertUnique ( & self -> cache, & entry -> n, NULL, VSchemaCacheEntrySort ) != 0 )
+                    free ( entry );
+                else
+                {
+                    VSchemaAddRef ( * schema );
+                    ++ self -> entries;
+                }
+                KLockUnlock ( self -> lock );
+            }
+        }
+    }
+
+    return rc;
+}
+
+
+/*--------------------------------------------------------------------------
+ * VSchemaText
+ *  digest of schema text from metadata parsed into a schema
+ *  columns usually store the same declarations as their neighbors
+ */
+typedef struct VSchemaText VSchemaText;
+struct VSchemaText
+{
+    BSTNode n;
+    VSchemaCacheKey key;
+};
+
+static
+int CC VSchemaTextCmp ( const void *item, const BSTNode *n )
+{
+    return VSchemaCacheKeyCmp ( item, & ( ( const VSchemaText* ) n ) -> key );
+}
+
+static
+int CC VSchemaTextSort ( const BSTNode *item, const BSTNode *n )
+{
+    return VSchemaCacheKeyCmp ( & ( ( const VSchemaText* ) item ) -> key,
+        & ( ( const VSchemaText* ) n ) -> key );
+}
+
+static
+void CC VSchemaTextWhack ( BSTNode *n, void *ignore )
+{
+    free ( n );
+}
+
+void VSchemaTextsWhack ( BSTree *texts )
+{
+    BSTreeWhack ( texts, VSchemaTextWhack, NULL );
+}
+
+/* ParseNodeOnce
+ */
+rc_t VSchemaParseNodeOnce ( VSchema *self, const KMDataNode *node, const char *name )
+{
+    rc_t rc;
+    bool known;
+    const VSchema *s;
+    VSchemaCacheKey key;
+    KMDataNodeSchemaFillData pb;
+
+    key . dad = NULL;
+    known = VSchemaCacheDigest ( node, & key ) == 0;
+    if ( known )
+    {
+        for ( s = self; s != NULL; s = s -> dad )
+        {
+            if ( BSTreeFind ( & s -> texts, & key, VSchemaTextCmp ) != NULL )
+                return 0;
+        }
+    }
+
+    pb . node = node;
+    pb . pos = 0;
+    pb . add_v0 = false;
+
+    rc = VSchemaParseTextCallback ( self, name, KMDataNodeFillSchema, & pb );
+    if ( rc == 0 && known )
+    {
+        VSchemaText *text = malloc ( sizeof * text );
+        if ( text != NULL )
+        {
+            text -> key = key;
+            if ( BSTreeInsertUnique ( & self -> texts, & text -> n, NULL, VSchemaTextSort ) != 0 )
+                free ( text );
+        }
+    }
+
+    return rc;
+}
@@ -107,6 +107,7 @@ struct String;
 struct KSymbol;
 struct KTokenText;
 struct KMDataNode;
+struct VSchemaCacheStats;
 struct SFunction;
 struct SDatabase;
 struct VDBManager;
@@ -180,6 +181,43 @@ struct KMDataNodeSchemaFillData
 rc_t CC KMDataNodeFillSchema ( void *data, struct KTokenText *tt, size_t save );
 
 
+/*--------------------------------------------------------------------------
+ * VSchemaCache
+ *  schemas parsed from the metadata of read-only objects,
+ *  keyed by parent schema and digest of the text
+ */
+typedef struct VSchemaCache VSchemaCache;
+
+rc_t VSchemaCacheMake ( VSchemaCache **cache );
+void VSchemaCacheWhack ( VSchemaCache *self );
+void VSchemaCacheGetStats ( VSchemaCache *self, struct VSchemaCacheStats *stats );
+
+/* LoadNode
+ *  parse the schema text stored in "node" into "schema",
+ *  or replace "schema" with an equivalent cached one
+ *
+ *  "self" [ IN, NULL OKAY ] - when NULL, the text is always parsed
+ *
+ *  "intrinsic" [ IN ] - intrinsic schema of the manager
+ *
+ *  "schema" [ IN/OUT ] - empty child of the parent schema
+ */
+rc_t VSchemaCacheLoadNode ( VSchemaCache *self, const VSchema *intrinsic,
+    VSchema **schema, struct KMDataNode const *node, const char *name );
+
+/* ParseNodeOnce
+ *  parse the schema text stored in "node" into "self", unless
+ *  identical text was parsed into it or one of its parents before
+ */
+rc_t VSchemaParseNodeOnce ( VSchema *self,
+    struct KMDataNode const *node, const char *name );
+
+/* TextsWhack
+ *  release the digests of parsed texts
+ */
+void VSchemaTextsWhack ( BSTree *texts );
+
+
 /*--------------------------------------------------------------------------
  * VTypedecl
  * VFormatdecl
@@ -245,6 +283,9 @@ struct VSchema
     /* paths of opened files */
     BSTree paths;
 
+    /* digests of schema text from metadata parsed into this schema */
+    BSTree texts;
+
     /* include path - vector of KDirectory references
        ordered by precedence */
     Vector inc;
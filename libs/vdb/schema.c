@@ -498,6 +498,7 @@ void CC VSchemaDestroy ( VSchema *self )
     
     BSTreeWhack ( & self -> scope, KSymbolWhack, NULL );
     BSTreeWhack ( & self -> paths, BSTreeMbrWhack, NULL );
+    VSchemaTextsWhack ( & self -> texts );
     VectorWhack ( & self -> inc, KDirRefRelease, NULL );
     VectorWhack ( & self -> alias, NULL, NULL );
     VectorWhack ( & self -> fmt, SFormatWhack, NULL );
@@ -635,6 +636,7 @@ rc_t VSchemaMake ( VSchema **sp,  const VSchema *dad )
     schema -> dad = VSchemaAttach ( dad );
     BSTreeInit ( & schema -> scope );
     BSTreeInit ( & schema -> paths );
+    BSTreeInit ( & schema -> texts );
 
     /* datatypes, typesets and parameterized types all shared
        the same type_id space from 0..0xFFFFFFFF. each is
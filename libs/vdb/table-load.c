@@ -133,26 +133,18 @@ rc_t VTableFindType ( VTable *self )
 static
 rc_t VTableLoadSchemaNode ( VTable *self, const KMDataNode *node )
 {
-    rc_t rc;
-    
-    /* the node is probably within our 4K buffer,
-     but by using the callback mechanism we don't
-     have buffer or allocation issues. */
-    KMDataNodeSchemaFillData pb;
-    pb . node = node;
-    pb . pos = 0;
-    pb . add_v0 = false;
-    
     /* add in schema text. it is not mandatory, but it is
      the design of the system to store object schema with
-     the object so that it is capable of standing alone */
-    rc = VSchemaParseTextCallback ( self -> schema,
-        "VTableLoadSchema", KMDataNodeFillSchema, & pb );
+     the object so that it is capable of standing alone.
+     read-only tables share the parse of identical text. */
+    rc_t rc = VSchemaCacheLoadNode ( self -> read_only ? self -> mgr -> schema_cache : NULL,
+        self -> mgr -> schema, & self -> schema, node, "VTableLoadSchema" );
     if ( rc == 0 )
     {
         /* determine table type */
-        rc = KMDataNodeReadAttr ( node, "name",
-            pb . buff, sizeof pb . buff, & pb . pos );
+        size_t size;
+        char buff [ 4096 ];
+        rc = KMDataNodeReadAttr ( node, "name", buff, sizeof buff, & size );
         if ( rc == 0 )
         {
             uint32_t type;
@@ -160,7 +152,7 @@ rc_t VTableLoadSchemaNode ( VTable *self, const KMDataNode *node )
             
             /* find the stbl if possible */
             self -> stbl = VSchemaFind ( self -> schema,
-                & name, & type, pb . buff, "VTableLoadSchema", false );
+                & name, & type, buff, "VTableLoadSchema", false );
             
             /* the schema must be found in this case */
             if ( self -> stbl == NULL || type != eTable )
@@ -168,7 +160,7 @@ rc_t VTableLoadSchemaNode ( VTable *self, const KMDataNode *node )
                 self -> stbl = NULL;
                 rc = RC ( rcVDB, rcTable, rcLoading, rcSchema, rcCorrupt );
                 PLOGERR ( klogInt, ( klogInt, rc, "failed to establish table type from '$(expr)'",
-                                     "expr=%s", pb . buff ));
+                                     "expr=%s", buff ));
             }
         }
     }
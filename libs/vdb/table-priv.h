@@ -139,6 +139,11 @@ struct VTable
     /* cache validity */
     bool read_col_cache_valid;
     bool write_col_cache_valid;
+
+    /* digest of physical and static column names,
+       valid once a read cursor has looked up its template */
+    uint8_t cursor_key [ 16 ];
+    bool cursor_key_valid;
 };
 
 
@@ -51,6 +51,8 @@
 
 #if VCURSOR_FLUSH_THREAD
 
+#include "decode-pool.h"
+
 #include <kproc/lock.h>
 #include <kproc/cond.h>
 #include <kproc/thread.h>
@@ -79,6 +81,10 @@
  */
 static
 rc_t VCursorFlushPageInt ( VCursor *self );
+#if VCURSOR_FLUSH_THREAD
+static
+void VFlushPlanWhack ( struct VFlushPlan *self );
+#endif
 
 
 /* Whack
@@ -109,8 +115,10 @@ rc_t VCursorWhack ( VCursor *self )
     KThreadRelease ( self -> flush_thread );
     KConditionRelease ( self -> flush_cond );
     KLockRelease ( self -> flush_lock );
+
+    VFlushPlanWhack ( self -> flush_plan );
+    KLockRelease ( self -> kdb_lock );
 #endif
-    VCursorTerminatePagemapThread(self);
     return VCursorDestroy ( self );
 }
 
@@ -854,6 +862,403 @@ bool CC run_trigger_prods ( void *item, void *data )
 }
 
 #if VCURSOR_FLUSH_THREAD
+
+/*--------------------------------------------------------------------------
+ * VFlushPlan
+ *  column encode chains are independent of one another unless they
+ *  share a production, and may then be run on the manager's worker pool.
+ *  trigger productions are partitioned into groups that share nothing;
+ *  each group is run in trigger order by a single thread.
+ *
+ *  schema-declared triggers typically read several columns and update
+ *  table metadata, so they are run afterward by the flush thread.
+ */
+typedef struct VFlushGroup VFlushGroup;
+struct VFlushGroup
+{
+    VDecodeJob dad;
+
+    /* trigger productions ( not-owned ) */
+    Vector prods;
+
+    int64_t id;
+    uint32_t cnt;
+};
+
+typedef struct VFlushPlan VFlushPlan;
+struct VFlushPlan
+{
+    VFlushGroup *group;
+    uint32_t num_groups;
+
+    /* triggers other than column roots ( not-owned ) */
+    Vector serial;
+
+    /* length of cursor trigger vector when planned */
+    uint32_t num_trig;
+};
+
+static
+void VFlushPlanWhack ( VFlushPlan *self )
+{
+    if ( self != NULL )
+    {
+        uint32_t i;
+        for ( i = 0; i < self -> num_groups; ++ i )
+            VectorWhack ( & self -> group [ i ] . prods, NULL, NULL );
+        VectorWhack ( & self -> serial, NULL, NULL );
+        free ( self -> group );
+        free ( self );
+    }
+}
+
+/* VFlushPlanBuild
+ *  maps every object reachable from a column root
+ *  to the first root that reached it, merging roots
+ *  that meet into a single group
+ */
+typedef struct VFlushPlanNode VFlushPlanNode;
+struct VFlushPlanNode
+{
+    BSTNode n;
+    const void *obj;
+    uint32_t root;
+};
+
+typedef struct VFlushPlanBuild VFlushPlanBuild;
+struct VFlushPlanBuild
+{
+    BSTree nodes;
+
+    /* group parent by trigger index */
+    uint32_t *dad;
+
+    /* trigger being walked */
+    uint32_t root;
+
+    rc_t rc;
+};
+
+static
+int CC VFlushPlanNodeSort ( const BSTNode *item, const BSTNode *n )
+{
+    const VFlushPlanNode *a = ( const VFlushPlanNode* ) item;
+    const VFlushPlanNode *b = ( const VFlushPlanNode* ) n;
+    if ( a -> obj < b -> obj )
+        return -1;
+    return a -> obj > b -> obj;
+}
+
+static
+void CC VFlushPlanNodeWhack ( BSTNode *n, void *ignore )
+{
+    free ( n );
+}
+
+static
+uint32_t VFlushPlanBuildFind ( VFlushPlanBuild *self, uint32_t i )
+{
+    while ( self -> dad [ i ] != i )
+    {
+        self -> dad [ i ] = self -> dad [ self -> dad [ i ] ];
+        i = self -> dad [ i ];
+    }
+    return i;
+}
+
+static
+void VFlushPlanBuildJoin ( VFlushPlanBuild *self, uint32_t a, uint32_t b )
+{
+    a = VFlushPlanBuildFind ( self, a );
+    b = VFlushPlanBuildFind ( self, b );
+
+    /* the earlier trigger leads the group */
+    if ( a < b )
+        self -> dad [ b ] = a;
+    else
+        self -> dad [ a ] = b;
+}
+
+/* Visit
+ *  returns true if object is reached for the first time
+ */
+static
+bool VFlushPlanBuildVisit ( VFlushPlanBuild *self, const void *obj )
+{
+    BSTNode *exist;
+    VFlushPlanNode *node = malloc ( sizeof * node );
+    if ( node == NULL )
+    {
+        self -> rc = RC ( rcVDB, rcCursor, rcFlushing, rcMemory, rcExhausted );
+        return false;
+    }
+
+    node -> obj = obj;
+    node -> root = self -> root;
+    if ( BSTreeInsertUnique ( & self -> nodes, & node -> n, & exist, VFlushPlanNodeSort ) != 0 )
+    {
+        /* everything below was seen from that root */
+        VFlushPlanBuildJoin ( self, self -> root, ( ( const VFlushPlanNode* ) exist ) -> root );
+        free ( node );
+        return false;
+    }
+
+    return true;
+}
+
+static
+void VFlushPlanBuildWalk ( VFlushPlanBuild *self, const VProduction *prod )
+{
+    uint32_t i, end;
+
+    if ( prod <= FAILED_PRODUCTION || self -> rc != 0 )
+        return;
+    if ( ! VFlushPlanBuildVisit ( self, prod ) )
+        return;
+
+    switch ( prod -> var )
+    {
+    case prodSimple:
+        VFlushPlanBuildWalk ( self, ( ( const VSimpleProd* ) prod ) -> in );
+        break;
+    case prodFunc:
+    {
+        const Vector *parms = & ( ( const VFunctionProd* ) prod ) -> parms;
+        end = VectorStart ( parms ) + VectorLength ( parms );
+        for ( i = VectorStart ( parms ); i < end; ++ i )
+            VFlushPlanBuildWalk ( self, VectorGet ( parms, i ) );
+        break;
+    }
+    case prodScript:
+        VFlushPlanBuildWalk ( self, ( ( const VScriptProd* ) prod ) -> rtn );
+        break;
+    case prodPhysical:
+    {
+        const VPhysical *phys = ( ( const VPhysicalProd* ) prod ) -> phys;
+        if ( phys != NULL && VFlushPlanBuildVisit ( self, phys ) )
+        {
+            VFlushPlanBuildWalk ( self, phys -> in );
+            VFlushPlanBuildWalk ( self, phys -> b2s );
+            VFlushPlanBuildWalk ( self, phys -> out );
+            VFlushPlanBuildWalk ( self, phys -> b2p );
+        }
+        break;
+    }
+    case prodColumn:
+    {
+        /* column page buffers are read directly */
+        const VColumn *col = ( ( const VColumnProd* ) prod ) -> col;
+        if ( col != NULL )
+            VFlushPlanBuildVisit ( self, col );
+        break;
+    }
+    }
+}
+
+/* IsColumnRoot
+ *  true if trigger production is the root of a column's write chain
+ */
+static
+bool VCursorIsColumnRoot ( const VCursor *self, const VProduction *prod )
+{
+    uint32_t i = VectorStart ( & self -> row );
+    uint32_t end = i + VectorLength ( & self -> row );
+    for ( ; i < end; ++ i )
+    {
+        const WColumn *wcol = VectorGet ( & self -> row, i );
+        if ( wcol != NULL && wcol -> val == prod )
+            return true;
+    }
+    return false;
+}
+
+static
+rc_t VFlushPlanMake ( VFlushPlan **planp, const VCursor *curs )
+{
+    rc_t rc;
+    uint32_t i, num_groups;
+    VFlushPlan *plan;
+    VFlushPlanBuild pb;
+
+    uint32_t start = VectorStart ( & curs -> trig );
+    uint32_t num_trig = VectorLength ( & curs -> trig );
+
+    /* per trigger: group parent, then group number */
+    uint32_t *grp = malloc ( num_trig * 2 * sizeof * grp );
+    if ( grp == NULL )
+        return RC ( rcVDB, rcCursor, rcFlushing, rcMemory, rcExhausted );
+
+    BSTreeInit ( & pb . nodes );
+    pb . dad = grp;
+    pb . rc = 0;
+
+    for ( i = 0; i < num_trig; ++ i )
+        grp [ i ] = i;
+
+    for ( i = 0; i < num_trig && pb . rc == 0; ++ i )
+    {
+        const VProduction *prod = VectorGet ( & curs -> trig, start + i );
+        if ( VCursorIsColumnRoot ( curs, prod ) )
+        {
+            pb . root = i;
+            VFlushPlanBuildWalk ( & pb, prod );
+        }
+        else
+        {
+            /* mark as not belonging to any group */
+            grp [ num_trig + i ] = num_trig;
+        }
+    }
+
+    BSTreeWhack ( & pb . nodes, VFlushPlanNodeWhack, NULL );
+
+    rc = pb . rc;
+    if ( rc == 0 )
+    {
+        /* number the groups by their leading trigger */
+        for ( num_groups = i = 0; i < num_trig; ++ i )
+        {
+            if ( grp [ num_trig + i ] != num_trig && VFlushPlanBuildFind ( & pb, i ) == i )
+                grp [ num_trig + i ] = num_groups ++;
+        }
+
+        plan = calloc ( 1, sizeof * plan );
+        if ( plan == NULL )
+            rc = RC ( rcVDB, rcCursor, rcFlushing, rcMemory, rcExhausted );
+        else
+        {
+            plan -> group = calloc ( num_groups + 1, sizeof plan -> group [ 0 ] );
+            if ( plan -> group == NULL )
+                rc = RC ( rcVDB, rcCursor, rcFlushing, rcMemory, rcExhausted );
+            else
+            {
+                plan -> num_groups = num_groups;
+                plan -> num_trig = num_trig;
+                for ( i = 0; i < num_groups; ++ i )
+                    VectorInit ( & plan -> group [ i ] . prods, 0, 8 );
+                VectorInit ( & plan -> serial, 0, 8 );
+
+                for ( i = 0; rc == 0 && i < num_trig; ++ i )
+                {
+                    VProduction *prod = VectorGet ( & curs -> trig, start + i );
+                    if ( grp [ num_trig + i ] == num_trig )
+                        rc = VectorAppend ( & plan -> serial, NULL, prod );
+                    else
+                    {
+                        uint32_t g = grp [ num_trig + VFlushPlanBuildFind ( & pb, i ) ];
+                        rc = VectorAppend ( & plan -> group [ g ] . prods, NULL, prod );
+                    }
+                }
+
+                if ( rc == 0 )
+                {
+                    MTCURSOR_DBG (( "VFlushPlanMake: %u triggers in %u groups\n", num_trig, num_groups ));
+                    free ( grp );
+                    * planp = plan;
+                    return 0;
+                }
+            }
+
+            VFlushPlanWhack ( plan );
+        }
+    }
+
+    free ( grp );
+    return rc;
+}
+
+/* UpdateFlushPlan
+ *  plan is made on first flush and again if triggers were added
+ */
+static
+rc_t VCursorUpdateFlushPlan ( VCursor *self )
+{
+    rc_t rc;
+    VFlushPlan *plan;
+
+    if ( self -> flush_plan != NULL &&
+         self -> flush_plan -> num_trig == VectorLength ( & self -> trig ) )
+        return 0;
+
+    rc = VFlushPlanMake ( & plan, self );
+    if ( rc == 0 )
+    {
+        if ( plan -> num_groups > 1 && self -> kdb_lock == NULL )
+            rc = KLockMake ( & self -> kdb_lock );
+        if ( rc != 0 )
+            VFlushPlanWhack ( plan );
+        else
+        {
+            VFlushPlanWhack ( self -> flush_plan );
+            self -> flush_plan = plan;
+        }
+    }
+
+    return rc;
+}
+
+static
+rc_t VFlushGroupRun ( VDecodeJob *job )
+{
+    VFlushGroup *self = ( VFlushGroup* ) job;
+
+    run_trigger_prod_data pb;
+    pb . id = self -> id;
+    pb . cnt = self -> cnt;
+    pb . rc = 0;
+
+    VectorDoUntil ( & self -> prods, false, run_trigger_prods, & pb );
+    return pb . rc;
+}
+
+/* RunTriggers
+ *  runs all trigger productions for the page described by "pb"
+ *  returns true on failure, with rc in "pb"
+ */
+static
+bool VCursorRunTriggers ( VCursor *self, run_trigger_prod_data *pb )
+{
+    uint32_t i;
+    VFlushPlan *plan;
+    VDecodePool *pool = self -> tbl -> mgr -> decode_pool;
+
+    /* without a plan, fall back upon running in sequence */
+    if ( pool == NULL || VectorLength ( & self -> trig ) < 2 ||
+         VCursorUpdateFlushPlan ( self ) != 0 ||
+         self -> flush_plan -> num_groups < 2 )
+    {
+        return VectorDoUntil ( & self -> trig, false, run_trigger_prods, pb );
+    }
+
+    plan = self -> flush_plan;
+    for ( i = 0; i < plan -> num_groups; ++ i )
+    {
+        VFlushGroup *g = & plan -> group [ i ];
+        VDecodeJobInit ( & g -> dad, VFlushGroupRun );
+        g -> id = pb -> id;
+        g -> cnt = pb -> cnt;
+    }
+
+    /* hand out all but the first group, which is run here */
+    for ( i = 1; i < plan -> num_groups; ++ i )
+        VDecodePoolSubmit ( pool, & plan -> group [ i ] . dad );
+
+    pb -> rc = VFlushGroupRun ( & plan -> group [ 0 ] . dad );
+
+    /* every group must finish before page buffers can be dropped */
+    for ( i = 1; i < plan -> num_groups; ++ i )
+    {
+        rc_t rc = VDecodePoolWait ( pool, & plan -> group [ i ] . dad );
+        if ( pb -> rc == 0 )
+            pb -> rc = rc;
+    }
+
+    if ( pb -> rc != 0 )
+        return true;
+
+    return VectorDoUntil ( & plan -> serial, false, run_trigger_prods, pb );
+}
+
 static
 rc_t CC run_flush_thread ( const KThread *t, void *data )
 {
@@ -895,7 +1300,7 @@ rc_t CC run_flush_thread ( const KThread *t, void *data )
             KLockUnlock ( self -> flush_lock );
 
             /* run productions from trigger roots */
-            failed = VectorDoUntil ( & self -> trig, false, run_trigger_prods, & pb );
+            failed = VCursorRunTriggers ( self, & pb );
 
             /* drop page buffers */
             MTCURSOR_DBG (( "run_flush_thread: dropping page buffers\n" ));
@@ -82,8 +82,14 @@ LIB_EXPORT rc_t CC VDBManagerMakeUpdate ( VDBManager **mgrp,  KDirectory *wd )
                     if ( rc == 0 )
                     {
                         rc = VDBManagerConfigPaths ( mgr, true );
+                        if ( rc == 0 )
+                            rc = VDBManagerMakeBlobCache ( mgr, 0 );
                         if ( rc == 0 )
                         {
+                            VDBManagerMakeDecodePool ( mgr, VDB_DECODE_POOL_THREADS );
+                            VDBManagerMakeSchemaCache ( mgr );
+                            VDBManagerMakeCursorTemplates ( mgr, VDB_CURSOR_TEMPLATE_LIMIT );
+                            VDBManagerConfigBufferPool ( mgr );
                             mgr -> user = NULL;
                             mgr -> user_whack = NULL;
                             KRefcountInit ( & mgr -> refcount, 1, "VDBManager", "make-update", "vmgr" );
@@ -51,6 +51,7 @@
 #include <klib/symbol.h>
 #include <klib/log.h>
 #include <klib/rc.h>
+#include <kproc/lock.h>
 #include <bitstr.h>
 #include <sysalloc.h>
 
@@ -792,6 +793,29 @@ rc_t VPhysicalSetStaticId ( VPhysical *self )
     return rc;
 }
 
+/* LockKdb
+ *  a parallel flush may run the encoding of several columns at once,
+ *  but the kdb objects they share are updated by one column at a time
+ */
+static
+rc_t VPhysicalLockKdb ( const VPhysical *self )
+{
+#if VCURSOR_FLUSH_THREAD
+    if ( self -> curs -> kdb_lock != NULL )
+        return KLockAcquire ( self -> curs -> kdb_lock );
+#endif
+    return 0;
+}
+
+static
+void VPhysicalUnlockKdb ( const VPhysical *self )
+{
+#if VCURSOR_FLUSH_THREAD
+    if ( self -> curs -> kdb_lock != NULL )
+        KLockUnlock ( self -> curs -> kdb_lock );
+#endif
+}
+
 static
 rc_t VPhysicalWrite ( VPhysical *self, int64_t id, uint32_t cnt )
 {
@@ -807,11 +831,16 @@ rc_t VPhysicalWrite ( VPhysical *self, int64_t id, uint32_t cnt )
             /* new column */
             if ( self -> knode == NULL && self -> kcol == NULL )
             {
-                rc = VPhysicalCreateStatic ( self, vblob );
+                rc = VPhysicalLockKdb ( self );
+                if ( rc == 0 )
+                {
+                    rc = VPhysicalCreateStatic ( self, vblob );
+                    if ( rc == 0 )
+                        rc = VPhysicalSetStaticId ( self );
+                    VPhysicalUnlockKdb ( self );
+                }
                 TRACK_BLOB ( VBlobRelease, vblob );
                 ( void ) VBlobRelease ( vblob );
-                if ( rc == 0 )
-                    rc = VPhysicalSetStaticId ( self );
                 return rc;
             }
 
@@ -844,7 +873,13 @@ rc_t VPhysicalWrite ( VPhysical *self, int64_t id, uint32_t cnt )
                             TRACK_BLOB ( VBlobRelease, vblob );
                             ( void ) VBlobRelease ( vblob );
 
-                            return VPhysicalSetStaticId ( self );
+                            rc = VPhysicalLockKdb ( self );
+                            if ( rc == 0 )
+                            {
+                                rc = VPhysicalSetStaticId ( self );
+                                VPhysicalUnlockKdb ( self );
+                            }
+                            return rc;
                         }
                     }
                 }
@@ -854,29 +889,40 @@ rc_t VPhysicalWrite ( VPhysical *self, int64_t id, uint32_t cnt )
         /* At this point we can no longer be a static row:
          * the current blob might have been more than a single row, or
          * it might have been unable to extend range of static as a single row */
-        if ( self -> knode != NULL )
-            rc = VPhysicalConvertStatic ( self );
+        if ( self -> knode != NULL || self -> kcol == NULL )
+        {
+            rc = VPhysicalLockKdb ( self );
+            if ( rc == 0 )
+            {
+                if ( self -> knode != NULL )
+                    rc = VPhysicalConvertStatic ( self );
+
+                /* not allowing both knode and kcol to be active at the same time */
+                assert ( rc != 0 || self -> knode == NULL );
+
+                /* create KColumn if necessary */
+                if ( rc == 0 && self -> kcol == NULL )
+                    rc = VPhysicalCreateKColumn ( self );
+
+                VPhysicalUnlockKdb ( self );
+            }
+        }
 
         /* need to write to KColumn */
         if ( rc == 0 )
         {
-            /* not allowing both knode and kcol to be active at the same time */
-            assert ( self -> knode == NULL );
-
-            /* create KColumn if necessary */
-            if ( self -> kcol == NULL )
-                rc = VPhysicalCreateKColumn ( self );
-
             /* pull through encoding */
+            TRACK_BLOB ( VBlobRelease, vblob );
+            ( void ) VBlobRelease ( vblob );
+            rc = VProductionReadBlob ( self -> b2s, & vblob, id, cnt,NULL );
             if ( rc == 0 )
             {
-                TRACK_BLOB ( VBlobRelease, vblob );
-                ( void ) VBlobRelease ( vblob );
-                rc = VProductionReadBlob ( self -> b2s, & vblob, id, cnt,NULL );
+                /* write encoded blob to physical */
+                rc = VPhysicalLockKdb ( self );
                 if ( rc == 0 )
                 {
-                    /* write encoded blob to physical */
                     rc = VPhysicalWriteKColumn ( self, vblob );
+                    VPhysicalUnlockKdb ( self );
                 }
             }
         }
@@ -42,7 +42,7 @@ struct VBlob;
 
 enum
 {
-    vftBlobN = vftBlob + 1,
+    vftBlobN = vftRowBatch + 1,
     vftSelect,
 
     vftLastFuncProto
@@ -65,6 +65,7 @@ union VFuncDescInternalFuncs
     VFixedRowFunc    pf;
     VArrayFunc       af;
     VBlobFunc        bf;
+    VRowBatchFunc    rbf;
     VBlobFuncN       bfN;
     VBlobCompareFunc cf;
 };
@@ -87,6 +87,7 @@
 
 #define DEFAULT_CACHE_BLOCKSIZE ( 32768 * 4 )
 #define DEFAULT_CACHE_CLUSTER 1
+#define DEFAULT_HTTP_READ_AHEAD ( 8 * 1024 * 1024 )
 
 #define VFS_KRYPTO_PASSWORD_MAX_SIZE 4096
 
@@ -2098,6 +2099,27 @@ LIB_EXPORT rc_t CC VFSManagerRemove ( const VFSManager *self, bool force,
     return rc;
 }
 
+/* ConfigHttpReads
+ *  apply "/http/reads/connections" and "/http/reads/read-ahead"
+ *  to the network manager
+ */
+static
+void VFSManagerConfigHttpReads ( VFSManager *self )
+{
+    uint64_t connections, read_ahead;
+
+    if ( KConfigReadU64 ( self -> cfg, "/http/reads/connections", & connections ) != 0 )
+        return;
+    if ( KConfigReadU64 ( self -> cfg, "/http/reads/read-ahead", & read_ahead ) != 0 )
+        read_ahead = DEFAULT_HTTP_READ_AHEAD;
+
+    if ( connections > UINT32_MAX )
+        connections = UINT32_MAX;
+
+    KNSManagerSetHTTPReads ( self -> kns, ( uint32_t ) connections, ( size_t ) read_ahead );
+}
+
+
 /* Make
  */
 LIB_EXPORT rc_t CC VFSManagerMake ( VFSManager ** pmanager )
@@ -2166,6 +2188,10 @@ LIB_EXPORT rc_t CC VFSManagerMakeFromKfg ( struct VFSManager ** pmanager,
                                 LOGERR ( klogWarn, rc, "could not build network manager" );
                                 rc = 0;
                             }
+                            else
+                            {
+                                VFSManagerConfigHttpReads ( obj );
+                            }
 
                             *pmanager = singleton = obj;
        DBGMSG(DBG_KNS, DBG_FLAG(DBG_KNS_MGR),  ("%s(%p)\n", __FUNCTION__, cfg));
@@ -0,0 +1,529 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * =============================================================================
+ *
+ */
+
+#include <vfs/extern.h>
+#include "names-cache.h"
+
+#include <vfs/path.h>
+#include <kfs/file.h>
+#include <kfs/directory.h>
+#include <kfg/config.h>
+#include <kproc/lock.h>
+
+#include <klib/text.h>
+#include <klib/container.h>
+#include <klib/printf.h>
+#include <klib/time.h>
+#include <klib/debug.h>
+#include <klib/log.h>
+#include <klib/rc.h>
+
+#include <sysalloc.h>
+
+#include "path-priv.h"
+#include "resolver-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define NAMES_CACHE_DEFAULT_TTL 3600
+#define NAMES_CACHE_MAGIC "names-cache 1\n"
+
+
+/*--------------------------------------------------------------------------
+ * VNamesCacheEntry
+ */
+typedef struct VNamesCacheEntry VNamesCacheEntry;
+struct VNamesCacheEntry
+{
+    BSTNode dad;
+    const VPath * path;
+    const VPath * mapping;
+    KTime_t expires;
+    bool persist;
+    String key;
+    char key_text [ 1 ];
+};
+
+static
+int CC VNamesCacheEntryCmp ( const void *item, const BSTNode *n )
+{
+    const VNamesCacheEntry *e = ( const VNamesCacheEntry* ) n;
+    return StringCompare ( ( const String* ) item, & e -> key );
+}
+
+static
+int CC VNamesCacheEntrySort ( const BSTNode *item, const BSTNode *n )
+{
+    const VNamesCacheEntry *e = ( const VNamesCacheEntry* ) item;
+    return VNamesCacheEntryCmp ( & e -> key, n );
+}
+
+static
+void CC VNamesCacheEntryWhack ( BSTNode *n, void *ignore )
+{
+    VNamesCacheEntry *e = ( VNamesCacheEntry* ) n;
+    VPathRelease ( e -> path );
+    VPathRelease ( e -> mapping );
+    free ( e );
+}
+
+
+/*--------------------------------------------------------------------------
+ * VNamesCache
+ */
+struct VNamesCache
+{
+    BSTree entries;
+    KLock *lock;
+    char *file_path;
+    KTime_t ttl;
+    bool loaded;
+    bool dirty;
+};
+
+
+/* Make
+ */
+rc_t VNamesCacheMake ( VNamesCache ** cache, const KConfig * kfg )
+{
+    rc_t rc;
+    uint64_t ttl = NAMES_CACHE_DEFAULT_TTL;
+    String *path = NULL;
+    VNamesCache *obj;
+
+    assert ( cache != NULL );
+    * cache = NULL;
+
+    if ( kfg != NULL )
+    {
+        KConfigReadU64 ( kfg, "/repository/names-cache/ttl", & ttl );
+        if ( ttl == 0 )
+            return 0;
+
+        rc = KConfigReadString ( kfg, "/repository/names-cache/path", & path );
+        if ( rc != 0 )
+        {
+            String *home;
+            rc = KConfigReadString ( kfg, "NCBI_HOME", & home );
+            if ( rc == 0 )
+            {
+                rc = StringConcat ( ( const String** ) & path, home, NULL );
+                StringWhack ( home );
+                if ( rc == 0 )
+                {
+                    char buffer [ 4096 ];
+                    size_t num_writ;
+                    rc = string_printf ( buffer, sizeof buffer, & num_writ, "%S/names-cache", path );
+                    StringWhack ( path );
+                    path = NULL;
+                    if ( rc == 0 )
+                    {
+                        String p;
+                        StringInit ( & p, buffer, num_writ, ( uint32_t ) num_writ );
+                        rc = StringCopy ( ( const String** ) & path, & p );
+                    }
+                }
+            }
+        }
+        if ( rc != 0 )
+            path = NULL;
+    }
+
+    obj = calloc ( 1, sizeof * obj );
+    if ( obj == NULL )
+        rc = RC ( rcVFS, rcResolver, rcConstructing, rcMemory, rcExhausted );
+    else
+    {
+        rc = KLockMake ( & obj -> lock );
+        if ( rc == 0 )
+        {
+            BSTreeInit ( & obj -> entries );
+            obj -> ttl = ( KTime_t ) ttl;
+
+            /* without a file, the cache lives as long as the resolver */
+            if ( path != NULL )
+            {
+                obj -> file_path = string_dup ( path -> addr, path -> size );
+                if ( obj -> file_path == NULL )
+                    rc = RC ( rcVFS, rcResolver, rcConstructing, rcMemory, rcExhausted );
+            }
+
+            if ( rc == 0 )
+            {
+                if ( path != NULL )
+                    StringWhack ( path );
+                * cache = obj;
+                return 0;
+            }
+
+            KLockRelease ( obj -> lock );
+        }
+        free ( obj );
+    }
+
+    if ( path != NULL )
+        StringWhack ( path );
+
+    return rc;
+}
+
+
+/* Insert
+ *  called with the lock held
+ */
+static
+rc_t VNamesCacheInsert ( VNamesCache * self, const String * key,
+    const VPath * path, const VPath * mapping, KTime_t expires, bool persist )
+{
+    VNamesCacheEntry *e = ( VNamesCacheEntry* )
+        BSTreeFind ( & self -> entries, key, VNamesCacheEntryCmp );
+    if ( e == NULL )
+    {
+        e = malloc ( sizeof * e + key -> size );
+        if ( e == NULL )
+            return RC ( rcVFS, rcResolver, rcInserting, rcMemory, rcExhausted );
+
+        memmove ( e -> key_text, key -> addr, key -> size );
+        e -> key_text [ key -> size ] = 0;
+        StringInit ( & e -> key, e -> key_text, key -> size, key -> len );
+        e -> path = e -> mapping = NULL;
+
+        BSTreeInsert ( & self -> entries, & e -> dad, VNamesCacheEntrySort );
+    }
+
+    VPathAddRef ( path );
+    VPathRelease ( e -> path );
+    e -> path = path;
+
+    if ( mapping != NULL )
+        VPathAddRef ( mapping );
+    VPathRelease ( e -> mapping );
+    e -> mapping = mapping;
+
+    e -> expires = expires;
+    e -> persist = persist;
+
+    return 0;
+}
+
+
+/* Load
+ *  read the unexpired entries from the file
+ *  called with the lock held
+ *
+ *  each line holds one entry:
+ *    <expires> TAB <key> TAB <path> TAB <mapping or '-'>
+ */
+static
+void VNamesCacheLoad ( VNamesCache * self )
+{
+    KDirectory *dir;
+
+    self -> loaded = true;
+    if ( self -> file_path == NULL )
+        return;
+
+    if ( KDirectoryNativeDir ( & dir ) == 0 )
+    {
+        const KFile *f;
+        if ( KDirectoryOpenFileRead ( dir, & f, "%s", self -> file_path ) == 0 )
+        {
+            uint64_t size;
+            if ( KFileSize ( f, & size ) == 0 && size > sizeof NAMES_CACHE_MAGIC - 1 )
+            {
+                char *text = malloc ( ( size_t ) size );
+                if ( text != NULL )
+                {
+                    size_t num_read;
+                    if ( KFileReadAll ( f, 0, text, ( size_t ) size, & num_read ) == 0 &&
+                         num_read == size &&
+                         memcmp ( text, NAMES_CACHE_MAGIC, sizeof NAMES_CACHE_MAGIC - 1 ) == 0 )
+                    {
+                        KTime_t now = KTimeStamp ();
+                        const char *start = text + sizeof NAMES_CACHE_MAGIC - 1;
+                        const char *end = text + num_read;
+
+                        while ( start < end )
+                        {
+                            String fld [ 4 ];
+                            uint32_t i;
+                            const char *sep, *eol = string_chr ( start, end - start, '\n' );
+                            if ( eol == NULL )
+                                break;
+
+                            for ( i = 0, sep = start; i < 4; ++ i )
+                            {
+                                const char *next = string_chr ( sep, eol - sep, '\t' );
+                                if ( next == NULL )
+                                    next = eol;
+                                StringInit ( & fld [ i ], sep, next - sep, ( uint32_t ) ( next - sep ) );
+                                sep = next < eol ? next + 1 : eol;
+                            }
+
+                            if ( fld [ 3 ] . size != 0 )
+                            {
+                                char *expires_end;
+                                KTime_t expires = strtoll ( fld [ 0 ] . addr, & expires_end, 10 );
+                                if ( expires_end == fld [ 0 ] . addr + fld [ 0 ] . size && expires > now )
+                                {
+                                    VPath *path, *mapping = NULL;
+                                    if ( VPathMakeFmt ( & path, "%S", & fld [ 2 ] ) == 0 )
+                                    {
+                                        if ( ( fld [ 3 ] . size == 1 && fld [ 3 ] . addr [ 0 ] == '-' ) ||
+                                             VPathMakeFmt ( & mapping, "%S", & fld [ 3 ] ) == 0 )
+                                        {
+                                            VNamesCacheInsert ( self, & fld [ 1 ], path, mapping, expires, true );
+                                            VPathRelease ( mapping );
+                                        }
+                                        VPathRelease ( path );
+                                    }
+                                }
+                            }
+
+                            start = eol + 1;
+                        }
+                    }
+                    free ( text );
+                }
+            }
+            KFileRelease ( f );
+        }
+        KDirectoryRelease ( dir );
+    }
+}
+
+
+/* Write
+ *  write the persistent entries to a temporary file and rename it into place
+ */
+typedef struct VNamesCacheSaveData VNamesCacheSaveData;
+struct VNamesCacheSaveData
+{
+    KFile *f;
+    uint64_t pos;
+    KTime_t now;
+    rc_t rc;
+};
+
+static
+void CC VNamesCacheEntrySave ( BSTNode *n, void *data )
+{
+    const VNamesCacheEntry *e = ( const VNamesCacheEntry* ) n;
+    VNamesCacheSaveData *pb = data;
+
+    if ( pb -> rc == 0 && e -> persist && e -> expires > pb -> now )
+    {
+        const String *path, *mapping = NULL;
+        rc_t rc = VPathMakeString ( e -> path, & path );
+        if ( rc == 0 )
+        {
+            if ( e -> mapping != NULL )
+                rc = VPathMakeString ( e -> mapping, & mapping );
+            if ( rc == 0 )
+            {
+                char line [ 8192 ];
+                size_t num_writ;
+
+                /* "-" marks a missing mapping */
+                if ( mapping == NULL )
+                    rc = string_printf ( line, sizeof line, & num_writ, "%ld\t%S\t%S\t-\n",
+                                         e -> expires, & e -> key, path );
+                else
+                    rc = string_printf ( line, sizeof line, & num_writ, "%ld\t%S\t%S\t%S\n",
+                                         e -> expires, & e -> key, path, mapping );
+
+                if ( rc == 0 )
+                {
+                    rc = KFileWriteAll ( pb -> f, pb -> pos, line, num_writ, & num_writ );
+                    pb -> pos += num_writ;
+                }
+                else
+                {
+                    /* an entry too long for a line is not worth keeping */
+                    rc = 0;
+                }
+
+                if ( mapping != NULL )
+                    StringWhack ( mapping );
+            }
+            StringWhack ( path );
+        }
+        pb -> rc = rc;
+    }
+}
+
+static
+void VNamesCacheWrite ( VNamesCache * self )
+{
+    KDirectory *dir;
+    rc_t rc = KDirectoryNativeDir ( & dir );
+    if ( rc == 0 )
+    {
+        VNamesCacheSaveData pb;
+        rc = KDirectoryCreateFile ( dir, & pb . f, false, 0664, kcmInit | kcmParents,
+                                    "%s.tmp", self -> file_path );
+        if ( rc == 0 )
+        {
+            size_t num_writ;
+            rc = KFileWriteAll ( pb . f, 0, NAMES_CACHE_MAGIC, sizeof NAMES_CACHE_MAGIC - 1, & num_writ );
+            if ( rc == 0 )
+            {
+                pb . pos = num_writ;
+                pb . now = KTimeStamp ();
+                pb . rc = 0;
+                BSTreeForEach ( & self -> entries, false, VNamesCacheEntrySave, & pb );
+                rc = pb . rc;
+            }
+            KFileRelease ( pb . f );
+
+            if ( rc == 0 )
+            {
+                char tmp [ 4096 ];
+                rc = string_printf ( tmp, sizeof tmp, NULL, "%s.tmp", self -> file_path );
+                if ( rc == 0 )
+                    rc = KDirectoryRename ( dir, true, tmp, self -> file_path );
+            }
+            if ( rc != 0 )
+                KDirectoryRemove ( dir, false, "%s.tmp", self -> file_path );
+        }
+        KDirectoryRelease ( dir );
+    }
+
+    if ( rc != 0 )
+    {
+        DBGMSG ( DBG_VFS, DBG_FLAG ( DBG_VFS ),
+                 ( "cannot save names cache '%s': %R\n", self -> file_path, rc ) );
+    }
+}
+
+
+/* Flush
+ */
+void VNamesCacheFlush ( VNamesCache * self )
+{
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        if ( self -> dirty && self -> file_path != NULL )
+        {
+            /* merge with what other processes saved meanwhile,
+               our own entries are newer and win */
+            BSTree mine = self -> entries;
+            BSTreeInit ( & self -> entries );
+            VNamesCacheLoad ( self );
+            while ( mine . root != NULL )
+            {
+                VNamesCacheEntry *e = ( VNamesCacheEntry* ) mine . root;
+                BSTreeUnlink ( & mine, & e -> dad );
+                VNamesCacheInsert ( self, & e -> key, e -> path, e -> mapping, e -> expires, e -> persist );
+                VNamesCacheEntryWhack ( & e -> dad, NULL );
+            }
+            VNamesCacheWrite ( self );
+            self -> dirty = false;
+        }
+
+        KLockUnlock ( self -> lock );
+    }
+}
+
+
+/* Whack
+ */
+void VNamesCacheWhack ( VNamesCache * self )
+{
+    if ( self != NULL )
+    {
+        VNamesCacheFlush ( self );
+
+        BSTreeWhack ( & self -> entries, VNamesCacheEntryWhack, NULL );
+        KLockRelease ( self -> lock );
+        free ( self -> file_path );
+        free ( self );
+    }
+}
+
+
+/* Get
+ */
+bool VNamesCacheGet ( VNamesCache * self, const String * key,
+    const VPath ** path, const VPath ** mapping )
+{
+    bool found = false;
+
+    if ( self != NULL && KLockAcquire ( self -> lock ) == 0 )
+    {
+        const VNamesCacheEntry *e;
+
+        if ( ! self -> loaded )
+            VNamesCacheLoad ( self );
+
+        e = ( const VNamesCacheEntry* ) BSTreeFind ( & self -> entries, key, VNamesCacheEntryCmp );
+        if ( e != NULL && e -> expires > KTimeStamp () )
+        {
+            VPathAddRef ( e -> path );
+            * path = e -> path;
+            if ( mapping != NULL )
+            {
+                if ( e -> mapping != NULL )
+                    VPathAddRef ( e -> mapping );
+                * mapping = e -> mapping;
+            }
+            found = true;
+        }
+
+        KLockUnlock ( self -> lock );
+    }
+
+    return found;
+}
+
+
+/* Put
+ */
+rc_t VNamesCachePut ( VNamesCache * self, const String * key,
+    const VPath * path, const VPath * mapping, bool persist )
+{
+    rc_t rc = 0;
+
+    if ( self != NULL )
+    {
+        rc = KLockAcquire ( self -> lock );
+        if ( rc == 0 )
+        {
+            if ( ! self -> loaded )
+                VNamesCacheLoad ( self );
+
+            rc = VNamesCacheInsert ( self, key, path, mapping, KTimeStamp () + self -> ttl, persist );
+            if ( rc == 0 && persist )
+                self -> dirty = true;
+
+            KLockUnlock ( self -> lock );
+        }
+    }
+
+    return rc;
+}
@@ -0,0 +1,107 @@
+/*===========================================================================
+*
+*                            Public Domain Notice
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#ifndef _h_names_cache_
+#define _h_names_cache_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * forwards
+ */
+struct String;
+struct VPath;
+struct KConfig;
+
+
+/*--------------------------------------------------------------------------
+ * VNamesCache
+ *  remembers answers of the name resolver CGI for a limited time
+ *
+ *  entries are keyed by a string that identifies the CGI, the request
+ *  parameters and the accession. entries made with "persist" are kept
+ *  in a file under NCBI_HOME and reloaded by the next process
+ *
+ *  configuration:
+ *    "/repository/names-cache/ttl"  - lifetime of an entry in seconds,
+ *                                     0 disables the cache, default 3600
+ *    "/repository/names-cache/path" - the file, default is
+ *                                     "$(NCBI_HOME)/names-cache"
+ */
+typedef struct VNamesCache VNamesCache;
+
+
+/* Make
+ *  returns NULL in "cache" when disabled by configuration
+ */
+rc_t VNamesCacheMake ( VNamesCache ** cache, struct KConfig const * kfg );
+
+
+/* Flush
+ *  write changed persistent entries back to the file
+ */
+void VNamesCacheFlush ( VNamesCache * self );
+
+
+/* Whack
+ *  flushes before releasing memory
+ */
+void VNamesCacheWhack ( VNamesCache * self );
+
+
+/* Get
+ *  look up an unexpired entry
+ *  returns new references to the stored paths in "path" and - if not NULL - "mapping"
+ *  "mapping" may be returned as NULL if none was stored
+ */
+bool VNamesCacheGet ( VNamesCache * self, struct String const * key,
+    struct VPath const ** path, struct VPath const ** mapping );
+
+
+/* Put
+ *  store an answer, replacing any previous entry for "key"
+ *
+ *  "mapping" [ IN, NULL OKAY ]
+ *
+ *  "persist" [ IN ] - false for answers that must not be written to disk,
+ *  e.g. when they carry a download ticket
+ */
+rc_t VNamesCachePut ( VNamesCache * self, struct String const * key,
+    struct VPath const * path, struct VPath const * mapping, bool persist );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_names_cache_ */
@@ -27,6 +27,7 @@
 
 #include <vfs/extern.h>
 #include "resolver-priv.h"
+#include "names-cache.h"
 
 #include <vfs/manager.h>
 #include <vfs/path.h>
@@ -78,6 +79,9 @@
 #define NAME_SERVICE_VERS \
     ( ( NAME_SERVICE_MAJ_VERS << 24 ) | ( NAME_SERVICE_MIN_VERS << 16 ) )
 
+/* most accessions sent to the resolver CGI in one batch request */
+#define NAME_SERVICE_BATCH_SIZE 256
+
 
 /*--------------------------------------------------------------------------
  * String
@@ -1246,20 +1250,21 @@ rc_t VResolverAlgParseResolverCGIResponse ( const KDataBuffer *result,
     return RC ( rcVFS, rcResolver, rcResolving, rcName, rcNotFound );
 }
 
-/* RemoteProtectedResolve
- *  use NCBI CGI to resolve accession into URL
+/* CallResolverCGI
+ *  POST a request for one or more comma-separated accessions
+ *  to the resolver CGI and collect its textual response
  */
 static
-rc_t VResolverAlgRemoteProtectedResolveImpl ( const VResolverAlg *self,
+rc_t VResolverAlgCallResolverCGI ( const VResolverAlg *self,
     const KNSManager *kns, VRemoteProtocols protocols, const String *acc,
-    const VPath ** path, const VPath ** mapping, bool legacy_wgs_refseq,
-    bool *canRetry )
+    bool legacy_wgs_refseq, KDataBuffer *result, bool *canRetry )
 {
     rc_t rc;
     KHttpRequest *req;
 
-    assert(path && canRetry);
+    assert(result && canRetry);
     *canRetry = true;
+    memset ( result, 0, sizeof * result );
 
     DBGMSG(DBG_VFS, DBG_FLAG(DBG_VFS), ("names.cgi = %S\n", self -> root));
     rc = KNSManagerMakeRequest ( kns, & req, 0x01000000, NULL, self -> root -> addr );
@@ -1338,23 +1343,21 @@ rc_t VResolverAlgRemoteProtectedResolveImpl ( const VResolverAlg *self,
                         size_t num_read;
                         size_t total = 0;
                         
-                        KDataBuffer result;
-                        memset ( & result, 0, sizeof result );
-                        KDataBufferMakeBytes ( & result, 4096 );
+                        KDataBufferMakeBytes ( result, 4096 );
 
                         while ( 1 )
                         {
                             uint8_t *base;
-                            uint64_t avail = result . elem_count - total;
+                            uint64_t avail = result -> elem_count - total;
                             if ( avail < 256 )
                             {
-                                rc = KDataBufferResize ( & result, result . elem_count + 4096 );
+                                rc = KDataBufferResize ( result, result -> elem_count + 4096 );
                                 if ( rc != 0 )
                                     break;
                             }
                             
-                            base = result . base;
-                            rc = KStreamRead ( response, & base [ total ], result . elem_count - total, & num_read );
+                            base = result -> base;
+                            rc = KStreamRead ( response, & base [ total ], result -> elem_count - total, & num_read );
                             if ( rc != 0 )
                             {
                                 /* TBD - look more closely at rc */
@@ -1371,23 +1374,51 @@ rc_t VResolverAlgRemoteProtectedResolveImpl ( const VResolverAlg *self,
                         }
 
                         if ( rc == 0 )
-                        {
-                            result.elem_count = total;
-
-                            rc = VResolverAlgParseResolverCGIResponse(&result,
-                                path, mapping, acc, self->ticket, canRetry);
-                            KDataBufferWhack ( &result );
-                        }
+                            result -> elem_count = total;
+                        else
+                            KDataBufferWhack ( result );
 
                         KStreamRelease ( response );
                     }
                 }
+                else if ( rc == 0 )
+                {
+                    /* no answer to parse, worth another try */
+                    *canRetry = true;
+                    rc = RC(rcVFS, rcResolver, rcResolving, rcName, rcNull);
+                }
                 KHttpResultRelease ( rslt );
             }
         }
         KHttpRequestRelease ( req );
     }
 
+    return rc;
+}
+
+/* RemoteProtectedResolve
+ *  use NCBI CGI to resolve accession into URL
+ */
+static
+rc_t VResolverAlgRemoteProtectedResolveImpl ( const VResolverAlg *self,
+    const KNSManager *kns, VRemoteProtocols protocols, const String *acc,
+    const VPath ** path, const VPath ** mapping, bool legacy_wgs_refseq,
+    bool *canRetry )
+{
+    KDataBuffer result;
+    rc_t rc;
+
+    assert(path && canRetry);
+
+    rc = VResolverAlgCallResolverCGI ( self, kns, protocols, acc,
+        legacy_wgs_refseq, & result, canRetry );
+    if ( rc == 0 )
+    {
+        rc = VResolverAlgParseResolverCGIResponse(&result,
+            path, mapping, acc, self->ticket, canRetry);
+        KDataBufferWhack ( &result );
+    }
+
     assert(*path != NULL || rc != 0);
 
     if (rc == 0 && *path == NULL) {
@@ -1398,16 +1429,53 @@ rc_t VResolverAlgRemoteProtectedResolveImpl ( const VResolverAlg *self,
     return rc;
 }
 
+/* MakeNamesKey
+ *  the key of a resolver CGI answer in the names cache
+ *  returns false if there is no cache
+ */
+static
+bool VResolverAlgMakeNamesKey ( const VResolverAlg *self, const VNamesCache *names,
+    VRemoteProtocols protocols, const String *acc, bool legacy_wgs_refseq,
+    char *buffer, size_t bsize, String *key )
+{
+    size_t size;
+    String empty;
+
+    if ( names == NULL )
+        return false;
+
+    CONST_STRING ( & empty, "" );
+    if ( string_printf ( buffer, bsize, & size, "%S|%S|%u|%s|%S",
+                         self -> root, self -> ticket != NULL ? self -> ticket : & empty,
+                         protocols, legacy_wgs_refseq ? "refseq" : "", acc ) != 0 )
+    {
+        return false;
+    }
+
+    StringInit ( key, buffer, size, string_len ( buffer, size ) );
+    return true;
+}
+
 static rc_t VResolverAlgRemoteProtectedResolve ( const VResolverAlg *self,
-    const KNSManager *kns, VRemoteProtocols protocols, const String *acc,
+    const KNSManager *kns, VNamesCache *names, VRemoteProtocols protocols, const String *acc,
     const VPath ** path, const VPath ** mapping, bool legacy_wgs_refseq )
 {
     rc_t rc = 0;
     int i = 0, retryOnFailure = 3;
+    const VPath *mapped = NULL;
+    char key_text [ 4096 ];
+    String key;
+
+    /* an earlier answer - possibly from a batch request - saves the round trip */
+    bool cached = VResolverAlgMakeNamesKey ( self, names, protocols, acc,
+        legacy_wgs_refseq, key_text, sizeof key_text, & key );
+    if ( cached && VNamesCacheGet ( names, & key, path, mapping ) )
+        return 0;
+
     for (i = 0; i < retryOnFailure; ++i) {
         bool canRetry = false;
         rc = VResolverAlgRemoteProtectedResolveImpl(self, kns, protocols,
-            acc, path, mapping, legacy_wgs_refseq, &canRetry);
+            acc, path, &mapped, legacy_wgs_refseq, &canRetry);
         if (rc == 0) {
             break;
         }
@@ -1426,6 +1494,17 @@ static rc_t VResolverAlgRemoteProtectedResolve ( const VResolverAlg *self,
         DBGMSG(DBG_KNS, DBG_FLAG(DBG_KNS_ERR), (
             "@@@@@@@@2 %s: returning %R\n", __FUNCTION__, rc));
     }
+    else
+    {
+        /* answers carrying a download ticket are not written to disk */
+        if ( cached )
+            VNamesCachePut ( names, & key, * path, mapped, self -> ticket == NULL );
+
+        if ( mapping != NULL )
+            * mapping = mapped;
+        else
+            VPathRelease ( mapped );
+    }
 
     return rc == 0 ? 0 : RC(rcVFS, rcResolver, rcResolving, rcName, rcNotFound);
 }    
@@ -1439,7 +1518,7 @@ static rc_t VResolverAlgRemoteProtectedResolve ( const VResolverAlg *self,
  */
 static
 rc_t VResolverAlgRemoteResolve ( const VResolverAlg *self,
-    const KNSManager *kns, VRemoteProtocols protocols, const VResolverAccToken *tok,
+    const KNSManager *kns, VNamesCache *names, VRemoteProtocols protocols, const VResolverAccToken *tok,
     const VPath ** path, const VPath ** mapping, const KFile ** opt_file_rtn, bool legacy_wgs_refseq )
 {
     rc_t rc;
@@ -1460,7 +1539,7 @@ rc_t VResolverAlgRemoteResolve ( const VResolverAlg *self,
         )
     {
         rc = VResolverAlgRemoteProtectedResolve ( self,
-            kns, protocols, & tok -> acc, path, mapping, legacy_wgs_refseq );
+            kns, names, protocols, & tok -> acc, path, mapping, legacy_wgs_refseq );
 
         if (rc == 0 && path != NULL && *path != NULL &&
             opt_file_rtn != NULL && *opt_file_rtn == NULL &&
@@ -1535,6 +1614,132 @@ rc_t VResolverAlgRemoteResolve ( const VResolverAlg *self,
 }
 
 
+/* CGIRowSucceeded
+ *  look at the result code of a version 1.1 row
+ *  "sep" is the separator after the accession
+ */
+static
+bool VResolverCGIRowSucceeded ( const char *sep, const char *eol )
+{
+    uint32_t i;
+    for ( i = 1; sep != NULL && i < 8; ++ i )
+        sep = string_chr ( sep + 1, eol - sep - 1, '|' );
+    return sep != NULL && eol - sep > 4 && memcmp ( sep + 1, "200|", 4 ) == 0;
+}
+
+/* ParseResolverCGIBatchResponse
+ *  expect a version 1.1 table with a row per accession
+ *  every row that resolves is entered into the names cache
+ */
+static
+rc_t VResolverAlgParseResolverCGIBatchResponse ( const VResolverAlg *self,
+    const KDataBuffer *result, VNamesCache *names, VRemoteProtocols protocols )
+{
+    const char *start = ( const void* ) result -> base;
+    const char *end;
+    size_t i, size = KDataBufferBytes ( result );
+
+    DBGMSG(DBG_VFS, DBG_FLAG(DBG_VFS), (" Response = %.*s\n", ( int ) size, start));
+
+    /* peel back buffer to significant bytes */
+    while ( size > 0 && start [ size - 1 ] == 0 )
+        -- size;
+
+    /* skip over blanks */
+    for ( i = 0; i < size; ++ i )
+    {
+        if ( ! isspace ( start [ i ] ) )
+            break;
+    }
+
+    /* only version 1.1 carries enough columns to tell rows apart */
+    if ( string_cmp ( & start [ i ], size - i, "#1.1", sizeof "#1.1" - 1, sizeof "#1.1" - 1 ) != 0 )
+        return RC ( rcVFS, rcResolver, rcResolving, rcMessage, rcUnsupported );
+
+    end = start + size;
+    for ( start += i + sizeof "#1.1" - 1; start < end; )
+    {
+        const char *eol = string_chr ( start, end - start, '\n' );
+        const char *sep;
+        if ( eol == NULL )
+            eol = end;
+
+        /* the accession leads the row, the result code is the 9th column
+           failures are left for the single query to report */
+        sep = string_chr ( start, eol - start, '|' );
+        if ( sep != NULL && sep != start && VResolverCGIRowSucceeded ( sep, eol ) )
+        {
+            String acc;
+            bool canRetry;
+            const VPath *path = NULL, *mapping = NULL;
+
+            StringInit ( & acc, start, sep - start, ( uint32_t ) ( sep - start ) );
+            if ( VResolverAlgParseResolverCGIResponse_1_1 ( start, eol - start,
+                     & path, & mapping, & acc, self -> ticket, & canRetry ) == 0 )
+            {
+                char key_text [ 4096 ];
+                String key;
+                if ( VResolverAlgMakeNamesKey ( self, names, protocols, & acc, false,
+                                                key_text, sizeof key_text, & key ) )
+                {
+                    VNamesCachePut ( names, & key, path, mapping, self -> ticket == NULL );
+                }
+                VPathRelease ( path );
+                VPathRelease ( mapping );
+            }
+        }
+
+        start = eol + 1;
+    }
+
+    return 0;
+}
+
+/* RemoteBatchResolve
+ *  ask the resolver CGI about "count" accessions at once
+ */
+static
+rc_t VResolverAlgRemoteBatchResolve ( const VResolverAlg *self,
+    const KNSManager *kns, VNamesCache *names, VRemoteProtocols protocols,
+    const String *accs, uint32_t count )
+{
+    rc_t rc;
+    uint32_t i;
+    String list;
+    KDataBuffer text;
+
+    rc = KDataBufferMakeBytes ( & text, 0 );
+    for ( i = 0; rc == 0 && i < count; ++ i )
+        rc = KDataBufferPrintf ( & text, i == 0 ? "%S" : ",%S", & accs [ i ] );
+
+    if ( rc == 0 )
+    {
+        int attempt;
+        StringInit ( & list, text . base, ( size_t ) text . elem_count - 1,
+            ( uint32_t ) text . elem_count - 1 );
+
+        for ( attempt = 0; attempt < 3; ++ attempt )
+        {
+            KDataBuffer result;
+            bool canRetry = false;
+
+            rc = VResolverAlgCallResolverCGI ( self, kns, protocols, & list, false, & result, & canRetry );
+            if ( rc == 0 )
+            {
+                rc = VResolverAlgParseResolverCGIBatchResponse ( self, & result, names, protocols );
+                KDataBufferWhack ( & result );
+                break;
+            }
+            if ( ! canRetry )
+                break;
+        }
+    }
+
+    KDataBufferWhack ( & text );
+    return rc;
+}
+
+
 /* CacheResolve
  *  try to resolve accession for currently cached file
  */
@@ -1670,6 +1875,9 @@ struct VResolver
     /* counters for various app volumes */
     uint32_t num_app_vols [ appCount ];
 
+    /* answers of the resolver CGI, NULL if disabled */
+    VNamesCache *names;
+
     /* preferred protocols preferences. Default: HTTP */
     VRemoteProtocols protocols;
 };
@@ -1705,6 +1913,9 @@ rc_t VResolverWhack ( VResolver *self )
     if ( self -> kns != NULL )
         KNSManagerRelease ( self -> kns );
 
+    /* save and drop resolver CGI answers */
+    VNamesCacheWhack ( self -> names );
+
     /* release directory onto local file system */
     KDirectoryRelease ( self -> wd );
 
@@ -2333,7 +2544,7 @@ rc_t VResolverRemoteResolve ( const VResolver *self,
             const VResolverAlg *alg = VectorGet ( & self -> remote, i );
             if ( alg -> app_id == app || alg -> app_id == wildCard )
             {
-                try_rc = VResolverAlgRemoteResolve ( alg, self -> kns, protocols, & tok, path, mapping, opt_file_rtn, legacy_wgs_refseq );
+                try_rc = VResolverAlgRemoteResolve ( alg, self -> kns, self -> names, protocols, & tok, path, mapping, opt_file_rtn, legacy_wgs_refseq );
                 if ( try_rc == 0 )
                     return 0;
                 if ( rc == 0 )
@@ -2348,7 +2559,7 @@ rc_t VResolverRemoteResolve ( const VResolver *self,
             const VResolverAlg *alg = VectorGet ( & self -> remote, i );
             if ( ( alg -> app_id == app || alg -> app_id == wildCard ) && ! alg -> disabled )
             {
-                try_rc = VResolverAlgRemoteResolve ( alg, self -> kns, protocols, & tok, path, mapping, opt_file_rtn, legacy_wgs_refseq );
+                try_rc = VResolverAlgRemoteResolve ( alg, self -> kns, self -> names, protocols, & tok, path, mapping, opt_file_rtn, legacy_wgs_refseq );
                 if ( try_rc == 0 )
                     return 0;
                 if ( rc == 0 )
@@ -3256,6 +3467,127 @@ rc_t CC VResolverQuery ( const VResolver * self, VRemoteProtocols protocols,
 }
 
 
+/* LooksLikeAccession
+ */
+static
+bool VResolverLooksLikeAccession ( const char *name )
+{
+    size_t i;
+    if ( ! isalpha ( name [ 0 ] ) )
+        return false;
+    for ( i = 1; name [ i ] != 0; ++ i )
+    {
+        if ( ! isalnum ( name [ i ] ) && name [ i ] != '_' && name [ i ] != '.' )
+            return false;
+    }
+    return true;
+}
+
+/* QueryBatch
+ *  resolve a list of accessions through the resolver CGI ahead of time
+ */
+LIB_EXPORT
+rc_t CC VResolverQueryBatch ( const VResolver * self,
+    VRemoteProtocols protocols, const KNamelist * accessions )
+{
+    rc_t rc;
+    uint32_t i, count, num_algs;
+    String *accs;
+    VResolverEnableState remote_state;
+
+    if ( self == NULL )
+        return RC ( rcVFS, rcResolver, rcResolving, rcSelf, rcNull );
+    if ( accessions == NULL )
+        return RC ( rcVFS, rcResolver, rcResolving, rcParam, rcNull );
+    if ( protocols >= eProtocolLastDefined )
+        return RC ( rcVFS, rcResolver, rcResolving, rcParam, rcInvalid );
+
+    /* there is nothing to gain when answers are not remembered */
+    remote_state = atomic32_read ( & enable_remote );
+    if ( self -> names == NULL || remote_state == vrAlwaysDisable )
+        return 0;
+
+    rc = KNamelistCount ( accessions, & count );
+    if ( rc != 0 || count == 0 )
+        return rc;
+
+    accs = malloc ( count * sizeof * accs );
+    if ( accs == NULL )
+        return RC ( rcVFS, rcResolver, rcResolving, rcMemory, rcExhausted );
+
+    num_algs = VectorLength ( & self -> remote );
+    for ( i = 0; rc == 0 && i < num_algs; ++ i )
+    {
+        uint32_t j, pending;
+        const VResolverAlg *alg = VectorGet ( & self -> remote, i );
+
+        if ( alg -> alg_id != algCGI )
+            continue;
+        if ( alg -> disabled && remote_state != vrAlwaysEnable )
+            continue;
+
+        /* collect the accessions this CGI would be asked about
+           and that have no answer yet */
+        for ( j = pending = 0; j < count; ++ j )
+        {
+            const char *name;
+            String acc;
+            VResolverAccToken tok;
+            VResolverAppID app;
+            bool legacy_wgs_refseq = false;
+
+            if ( KNamelistGet ( accessions, j, & name ) != 0 )
+                continue;
+
+            /* leave paths, urls and object ids to the single query */
+            if ( ! VResolverLooksLikeAccession ( name ) )
+                continue;
+
+            StringInitCString ( & acc, name );
+            app = get_accession_app ( & acc, false, & tok, & legacy_wgs_refseq );
+            if ( legacy_wgs_refseq )
+                continue;
+            if ( alg -> app_id == app || alg -> app_id == appAny )
+            {
+                char key_text [ 4096 ];
+                String key;
+                const VPath *path;
+
+                if ( VResolverAlgMakeNamesKey ( alg, self -> names, protocols,
+                         & tok . acc, false, key_text, sizeof key_text, & key ) )
+                {
+                    if ( VNamesCacheGet ( self -> names, & key, & path, NULL ) )
+                        VPathRelease ( path );
+                    else
+                        accs [ pending ++ ] = tok . acc;
+                }
+            }
+        }
+
+        /* a failed batch is not an error,
+           the accessions will be resolved one by one when queried */
+        for ( j = 0; j < pending; j += NAME_SERVICE_BATCH_SIZE )
+        {
+            uint32_t n = pending - j;
+            if ( n > NAME_SERVICE_BATCH_SIZE )
+                n = NAME_SERVICE_BATCH_SIZE;
+
+            if ( VResolverAlgRemoteBatchResolve ( alg, self -> kns,
+                     self -> names, protocols, & accs [ j ], n ) != 0 )
+            {
+                break;
+            }
+        }
+    }
+
+    free ( accs );
+
+    /* make the answers available to other processes right away */
+    VNamesCacheFlush ( self -> names );
+
+    return rc;
+}
+
 
 /* LoadVolume
  *  capture volume path and other information
@@ -4287,6 +4619,9 @@ rc_t VResolverMake ( VResolver ** objp, const KDirectory *wd,
         rc = VResolverLoad ( obj, protected, kfg );
         if ( rc == 0 )
         {
+            /* the resolver works without remembering answers */
+            VNamesCacheMake ( & obj -> names, kfg );
+
             * objp = obj;
             return 0;
         }
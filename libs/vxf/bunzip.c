@@ -32,6 +32,8 @@
 #include <klib/data-buffer.h>
 #include <sysalloc.h>
 
+#include "segments.h"
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <endian.h>
@@ -39,7 +41,16 @@
 #include <string.h>
 #include <bzlib.h>
 
-static rc_t invoke_bzip2 ( void *dst, size_t dsize, const void *src, size_t ssize )
+/* segmented blobs are expanded on this many threads unless configured */
+#define BUNZIP_DFLT_THREADS 4
+
+typedef struct bunzip_t bunzip_t;
+struct bunzip_t
+{
+    uint32_t threads;
+};
+
+static rc_t invoke_bzip2 ( void *dst, size_t dsize, size_t *psize, const void *src, size_t ssize )
 {
     int bzerr;
 
@@ -55,6 +66,8 @@ static rc_t invoke_bzip2 ( void *dst, size_t dsize, const void *src, size_t ssiz
     s.avail_out = dsize;
     
     bzerr = BZ2_bzDecompress(&s);
+    if ( psize != NULL )
+        * psize = s.total_out_lo32;
     BZ2_bzDecompressEnd ( & s );
 
     switch ( bzerr )
@@ -73,7 +86,7 @@ static
 rc_t bunzip_func_v1 ( const VXformInfo *info, VBlobResult *dst, const VBlobData *src )
 {
     dst->byte_order = src->byte_order;
-    return invoke_bzip2 ( dst->data, (((size_t)dst->elem_count * dst->elem_bits + 7) >> 3),
+    return invoke_bzip2 ( dst->data, (((size_t)dst->elem_count * dst->elem_bits + 7) >> 3), NULL,
                           src->data, (((size_t)src->elem_count * src->elem_bits + 7) >> 3));
 }
 
@@ -89,7 +102,7 @@ rc_t bunzip_func_v2 ( const VXformInfo *info,
         dst -> byte_order = src -> byte_order;
         dst -> elem_bits = 1;
 
-        rc = invoke_bzip2 ( dst->data, (((size_t)dst->elem_count + 7) >> 3),
+        rc = invoke_bzip2 ( dst->data, (((size_t)dst->elem_count + 7) >> 3), NULL,
                             src->data, (((size_t)src->elem_count * src->elem_bits + 7) >> 3));
         if ( rc == 0 )
         {
@@ -101,6 +114,35 @@ rc_t bunzip_func_v2 ( const VXformInfo *info,
     return rc;
 }
 
+static
+rc_t bunzip_segment ( void *self, void *dst, size_t *dsize, const void *src, size_t ssize )
+{
+    return invoke_bzip2 ( dst, * dsize, dsize, src, ssize );
+}
+
+static
+rc_t bunzip_func_v3 ( const bunzip_t *self,
+    VBlobResult *dst, const VBlobData *src, VBlobHeader *hdr )
+{
+    int64_t trailing;
+    rc_t rc = VBlobHeaderArgPopHead ( hdr, & trailing );
+    if ( rc == 0 )
+    {
+        dst -> elem_count *= dst -> elem_bits;
+        dst -> byte_order = src -> byte_order;
+        dst -> elem_bits = 1;
+
+        rc = VXfSegmentedDecode ( bunzip_segment, NULL, self -> threads,
+                                  dst -> data, ( ( size_t ) dst -> elem_count + 7 ) >> 3,
+                                  src -> data, ( ( size_t ) src -> elem_count * src -> elem_bits + 7 ) >> 3,
+                                  hdr );
+
+        if ( rc == 0 && trailing != 0 )
+            dst -> elem_count -= 8 - trailing;
+    }
+
+    return rc;
+}
 
 static
 rc_t CC bunzip_func ( void *Self, const VXformInfo *info,
@@ -112,6 +154,8 @@ rc_t CC bunzip_func ( void *Self, const VXformInfo *info,
         return bunzip_func_v1(info, dst, src);
     case 2:
         return bunzip_func_v2(info, dst, src, hdr);
+    case 3:
+        return bunzip_func_v3(Self, dst, src, hdr);
     }
 
     return RC(rcXF, rcFunction, rcExecuting, rcParam, rcBadVersion);
@@ -123,6 +167,13 @@ rc_t CC bunzip_func ( void *Self, const VXformInfo *info,
 VTRANSFACT_IMPL ( vdb_bunzip, 1, 0, 0 ) ( const void *self, const VXfactInfo *info,
     VFuncDesc *rslt, const VFactoryParams *cp, const VFunctionParams *dp )
 {
+    bunzip_t *fself = malloc ( sizeof *fself );
+    if ( fself == NULL )
+        return RC ( rcXF, rcFunction, rcConstructing, rcMemory, rcExhausted );
+    fself -> threads = VXfSegmentThreads ( BUNZIP_DFLT_THREADS );
+
+    rslt->self = fself;
+    rslt->whack = free;
     rslt->variant = vftBlob;
     rslt->u.bf = bunzip_func;
 
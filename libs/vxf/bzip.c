@@ -33,6 +33,8 @@
 #include <klib/data-buffer.h>
 #include <sysalloc.h>
 
+#include "segments.h"
+
 #include <string.h>
 #include <bzlib.h>
 #include <stdint.h>
@@ -48,6 +50,7 @@ struct bzip_t
 {
     int32_t blockSize100k;
     int32_t workFactor;
+    uint32_t threads;
 };
 
 #if _DEBUGGING
@@ -82,11 +85,14 @@ rc_t invoke_bzip2 ( bzip_t *self, void *dst, uint32_t *dsize, const void *src, u
     bzerr = BZ2_bzCompress(&s, BZ_FINISH);
     switch (bzerr)
     {
+    case BZ_STREAM_END:
+        break;
     case BZ_OK:
     case BZ_RUN_OK:
     case BZ_FINISH_OK:
-    case BZ_STREAM_END:
-        break;
+        /* ran out of output */
+        BZ2_bzCompressEnd ( & s );
+        return 0;
     default:
 #if _DEBUGGING
         fprintf(stderr, "BZ2_bzCompress: unexpected bzip2 error %i\n", bzerr);
@@ -104,12 +110,22 @@ rc_t invoke_bzip2 ( bzip_t *self, void *dst, uint32_t *dsize, const void *src, u
     return 0;
 }
 
+static
+rc_t bzip_segment ( void *self, void *dst, size_t *dsize, const void *src, size_t ssize )
+{
+    uint32_t size = ( uint32_t ) * dsize;
+    rc_t rc = invoke_bzip2 ( self, dst, & size, src, ( uint32_t ) ssize );
+    * dsize = size;
+    return rc;
+}
+
 static
 rc_t CC bzip_func ( void *Self, const VXformInfo *info,
     VBlobResult *dst, const VBlobData *src, VBlobHeader *hdr )
 {
     rc_t rc;
     bzip_t *self = Self;
+    size_t seg_size;
 
     /* input bits */
     uint64_t sbits = ( uint64_t) src -> elem_count * src -> elem_bits;
@@ -120,16 +136,34 @@ rc_t CC bzip_func ( void *Self, const VXformInfo *info,
     /* required output size */
     uint32_t dsize = ( uint32_t ) ( ( ( size_t ) dst -> elem_count * dst->elem_bits + 7 ) >> 3 );
 
-    if ( ( sbits & 7 ) == 0 )
-        /* version 1 is byte-aligned */
-        VBlobHeaderSetVersion ( hdr, 1 );
-    else
+    /* segments follow bzip2's own blocks, costing no compression */
+    seg_size = ( size_t ) self -> blockSize100k * 100000;
+
+    if ( self -> threads > 1 && ssize >= 2 * seg_size )
     {
-        VBlobHeaderSetVersion ( hdr, 2 );
-        VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        /* version 3 is segmented, trailing bits are always given */
+        size_t used = dsize;
+
+        VBlobHeaderSetVersion ( hdr, 3 );
+        rc = VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        if ( rc == 0 )
+            rc = VXfSegmentedEncode ( bzip_segment, self, self -> threads,
+                dst -> data, & used, src -> data, ssize, seg_size, hdr );
+        dsize = rc == 0 ? ( uint32_t ) used : 0;
     }
+    else
+    {
+        if ( ( sbits & 7 ) == 0 )
+            /* version 1 is byte-aligned */
+            VBlobHeaderSetVersion ( hdr, 1 );
+        else
+        {
+            VBlobHeaderSetVersion ( hdr, 2 );
+            VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        }
 
-    rc = invoke_bzip2 ( self, dst -> data, & dsize, src -> data, ssize);
+        rc = invoke_bzip2 ( self, dst -> data, & dsize, src -> data, ssize);
+    }
     if (rc == 0)
     {
         dst->elem_bits = 1;
@@ -172,6 +206,7 @@ VTRANSFACT_IMPL ( vdb_bzip, 1, 0, 0 ) ( const void *self, const VXfactInfo *info
         return RC ( rcXF, rcFunction, rcConstructing, rcMemory, rcExhausted );
     fself -> blockSize100k = blockSize100k;
     fself -> workFactor = workFactor;
+    fself -> threads = VXfSegmentThreads ( 0 );
 
     rslt->self = fself;
     rslt->whack = free;
@@ -32,6 +32,8 @@
 #include <vdb/schema.h>
 #include <sysalloc.h>
 
+#include "segments.h"
+
 #include <byteswap.h>
 #include <os-native.h>
 
@@ -141,6 +143,83 @@ static rc_t zlib_decompress(void *dst, size_t dsize, size_t *psize, const void *
     return rc == 0 ? RC(rcVDB, rcFunction, rcExecuting, rcData, rcCorrupt) : rc;
 }
 
+/* byte planes of at least this many bytes are deflated in parallel
+   when "vdb/zip/threads" allows it; the planes are stored one after
+   another just the same, so the format does not change */
+#define IRZIP_PARALLEL_PLANE (64 * 1024)
+
+static uint32_t irzip_threads;
+
+typedef struct {
+    const uint8_t *scratch;
+    unsigned N;
+    uint8_t *buf;
+    size_t slot;
+    unsigned plane[8];
+    size_t used[8];
+} zplanes;
+
+static rc_t zlib_compress_plane(void *data, uint32_t idx) {
+    zplanes *self = data;
+    szbuf s2;
+    rc_t rc;
+
+    s2.used = 0;
+    s2.size = self->slot;
+    s2.buf  = self->buf + idx * self->slot;
+    rc = zlib_compress(&s2, self->scratch + self->plane[idx] * self->N, self->N, Z_RLE, Z_BEST_SPEED);
+    if (rc == 0 && s2.used == 0) /*** skip zipping **/
+        rc = RC(rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient);
+    self->used[idx] = s2.used;
+    return rc;
+}
+
+static rc_t zlib_compress_planes(uint8_t dst[], size_t dsize, size_t *used, const uint8_t scratch[], unsigned N, unsigned width, uint8_t planes) {
+    zplanes z;
+    unsigned k, count;
+    rc_t rc = 0;
+
+    for (k = count = 0; k < width; k++) {
+        if (planes & (1<<k))
+            z.plane[count++] = k;
+    }
+
+    if (irzip_threads < 2 || count < 2 || N < IRZIP_PARALLEL_PLANE) {
+        for (k = 0; k < count && rc == 0; k++) {
+            szbuf s2;
+            s2.used = 0;
+            s2.size = dsize - *used;
+            s2.buf  = dst + *used;
+            rc = zlib_compress(&s2, scratch + z.plane[k] * N, N, Z_RLE, Z_BEST_SPEED);
+            if ( rc == 0 ) {
+                *used += s2.used;
+                if (s2.used == 0) /*** skip zipping **/
+                    rc = RC(rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient);
+            }
+        }
+        return rc;
+    }
+
+    z.scratch = scratch;
+    z.N = N;
+    z.slot = N + (N >> 3) + 64;
+    z.buf = malloc(count * z.slot);
+    if (z.buf == NULL)
+        return RC(rcXF, rcFunction, rcExecuting, rcMemory, rcExhausted);
+
+    rc = VXfRunParallel(count, irzip_threads, zlib_compress_plane, &z);
+    for (k = 0; k < count && rc == 0; k++) {
+        if (z.used[k] > dsize - *used)
+            rc = RC(rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient);
+        else {
+            memmove(dst + *used, z.buf + k * z.slot, z.used[k]);
+            *used += z.used[k];
+        }
+    }
+    free(z.buf);
+    return rc;
+}
+
 
 #define STYPE int8_t
 #define USTYPE uint8_t
@@ -319,6 +398,9 @@ VTRANSFACT_IMPL(vdb_izip, 2, 1, 1) (const void *Self, const VXfactInfo *info,
         return RC(rcVDB, rcFunction, rcConstructing, rcParam, rcInvalid);
     }
 
+    /* every factory reads the same configuration */
+    irzip_threads = VXfSegmentThreads(0);
+
     rslt->variant = vftBlob;
     rslt->u.bf = irzip;
 
@@ -291,20 +291,8 @@ static rc_t ENCODE(uint8_t dst[], size_t dsize, size_t *used, int64_t *Min, int6
     }
 
     /*** record the arrays ***/
-    for(k=0;k<sizeof(STYPE) && rc == 0; k++){
-	if (*planes & (1<<k)) {
-		szbuf s2;
-		s2.used = 0;
-		s2.size = dsize - *used;
-		s2.buf  = dst + *used;
-		rc = zlib_compress(&s2, scratch+k*N, N,Z_RLE, Z_BEST_SPEED);
-		if ( rc == 0 ) {
-			*used += s2.used;
-			if (s2.used == 0) /*** skip zipping **/
-				 rc=RC(rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient);
-		}
-	}
-    }
+    if (rc == 0)
+	rc = zlib_compress_planes(dst, dsize, used, scratch, N, sizeof(STYPE), *planes);
     if(scratch) free(scratch);
 #ifdef TRY2SERIES
     if(series) free(series);
@@ -0,0 +1,369 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#include <vdb/extern.h>
+
+#include "segments.h"
+
+#include <klib/rc.h>
+#include <kfg/config.h>
+#include <kproc/thread.h>
+#include <atomic32.h>
+#include <vdb/xform.h>
+#include <sysalloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* no point in more threads than a machine is likely to have */
+#define MAX_SEGMENT_THREADS 64
+
+
+/*--------------------------------------------------------------------------
+ * SegmentThreads
+ *  configuration is read once, since every blob-compressing
+ *  function is instantiated anew for each cursor that reads it
+ *
+ *  0 = not yet read, 1 = not configured, else configured count + 2
+ */
+static atomic32_t s_segment_threads;
+
+uint32_t VXfSegmentThreads ( uint32_t dflt )
+{
+    uint32_t cached = atomic32_read ( & s_segment_threads );
+    if ( cached == 0 )
+    {
+        KConfig *kfg;
+        cached = 1;
+        if ( KConfigMake ( & kfg, NULL ) == 0 )
+        {
+            uint64_t value;
+            if ( KConfigReadU64 ( kfg, "vdb/zip/threads", & value ) == 0 )
+                cached = ( uint32_t ) ( value > MAX_SEGMENT_THREADS ? MAX_SEGMENT_THREADS : value ) + 2;
+            KConfigRelease ( kfg );
+        }
+        atomic32_set ( & s_segment_threads, cached );
+    }
+
+    if ( cached > 1 )
+        return cached - 2;
+
+    return dflt > MAX_SEGMENT_THREADS ? MAX_SEGMENT_THREADS : dflt;
+}
+
+
+/*--------------------------------------------------------------------------
+ * RunParallel
+ *  every thread takes a stripe of the indices and stops at its first error
+ */
+typedef struct VXfStripe VXfStripe;
+struct VXfStripe
+{
+    rc_t ( * f ) ( void *data, uint32_t idx );
+    void *data;
+    uint32_t count;
+    uint32_t first;
+    uint32_t stride;
+
+    /* index of the failed call and its rc */
+    uint32_t failed;
+    rc_t rc;
+};
+
+static
+void VXfStripeRun ( VXfStripe *self )
+{
+    uint32_t idx;
+    for ( idx = self -> first; idx < self -> count; idx += self -> stride )
+    {
+        rc_t rc = ( * self -> f ) ( self -> data, idx );
+        if ( rc != 0 )
+        {
+            self -> failed = idx;
+            self -> rc = rc;
+            break;
+        }
+    }
+}
+
+static
+rc_t CC VXfStripeThread ( const KThread *t, void *data )
+{
+    VXfStripeRun ( data );
+    return 0;
+}
+
+rc_t VXfRunParallel ( uint32_t count, uint32_t threads,
+    rc_t ( * f ) ( void *data, uint32_t idx ), void *data )
+{
+    uint32_t i;
+    rc_t rc = 0;
+    uint32_t failed = count;
+
+    VXfStripe stripe [ MAX_SEGMENT_THREADS ];
+    KThread *t [ MAX_SEGMENT_THREADS ];
+
+    if ( threads > count )
+        threads = count;
+    if ( threads > MAX_SEGMENT_THREADS )
+        threads = MAX_SEGMENT_THREADS;
+
+    if ( threads < 2 )
+    {
+        for ( i = 0; i < count && rc == 0; ++ i )
+            rc = ( * f ) ( data, i );
+        return rc;
+    }
+
+    for ( i = 0; i < threads; ++ i )
+    {
+        stripe [ i ] . f = f;
+        stripe [ i ] . data = data;
+        stripe [ i ] . count = count;
+        stripe [ i ] . first = i;
+        stripe [ i ] . stride = threads;
+        stripe [ i ] . failed = count;
+        stripe [ i ] . rc = 0;
+
+        /* the caller takes stripe 0, and any stripe no thread could be made for */
+        t [ i ] = NULL;
+        if ( i != 0 && KThreadMake ( & t [ i ], VXfStripeThread, & stripe [ i ] ) != 0 )
+            t [ i ] = NULL;
+    }
+
+    for ( i = 0; i < threads; ++ i )
+    {
+        if ( t [ i ] == NULL )
+            VXfStripeRun ( & stripe [ i ] );
+    }
+
+    for ( i = 0; i < threads; ++ i )
+    {
+        if ( t [ i ] != NULL )
+        {
+            rc_t status;
+            KThreadWait ( t [ i ], & status );
+            KThreadRelease ( t [ i ] );
+        }
+        if ( stripe [ i ] . rc != 0 && stripe [ i ] . failed < failed )
+        {
+            failed = stripe [ i ] . failed;
+            rc = stripe [ i ] . rc;
+        }
+    }
+
+    return rc;
+}
+
+
+/*--------------------------------------------------------------------------
+ * segment jobs
+ */
+typedef struct VXfSegments VXfSegments;
+struct VXfSegments
+{
+    VXfSegmentFunc f;
+    void *self;
+
+    uint8_t *dst;
+    const uint8_t *src;
+
+    /* uncompressed size */
+    size_t total;
+    size_t seg_size;
+
+    /* encoding: capacity of each scratch slot */
+    size_t slot;
+
+    /* compressed size and offset of each segment */
+    size_t *size;
+    size_t *offset;
+};
+
+static
+size_t VXfSegmentsBytes ( const VXfSegments *self, uint32_t idx )
+{
+    size_t start = ( size_t ) idx * self -> seg_size;
+    size_t bytes = self -> total - start;
+    return bytes < self -> seg_size ? bytes : self -> seg_size;
+}
+
+static
+rc_t VXfSegmentEncode ( void *data, uint32_t idx )
+{
+    VXfSegments *self = data;
+
+    size_t dsize = self -> slot;
+    rc_t rc = ( * self -> f ) ( self -> self, self -> dst + ( size_t ) idx * self -> slot, & dsize,
+        self -> src + ( size_t ) idx * self -> seg_size, VXfSegmentsBytes ( self, idx ) );
+    if ( rc == 0 && dsize == 0 )
+        rc = RC ( rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient );
+
+    self -> size [ idx ] = dsize;
+    return rc;
+}
+
+static
+rc_t VXfSegmentDecode ( void *data, uint32_t idx )
+{
+    VXfSegments *self = data;
+
+    size_t expected = VXfSegmentsBytes ( self, idx );
+    size_t dsize = expected;
+    rc_t rc = ( * self -> f ) ( self -> self, self -> dst + ( size_t ) idx * self -> seg_size, & dsize,
+        self -> src + self -> offset [ idx ], self -> size [ idx ] );
+    if ( rc == 0 && dsize != expected )
+        rc = RC ( rcXF, rcFunction, rcExecuting, rcData, rcCorrupt );
+
+    return rc;
+}
+
+
+/*--------------------------------------------------------------------------
+ * SegmentedEncode
+ */
+rc_t VXfSegmentedEncode ( VXfSegmentFunc f, void *self, uint32_t threads,
+    void *dst, size_t *dsize, const void *src, size_t ssize,
+    size_t seg_size, VBlobHeader *hdr )
+{
+    rc_t rc;
+    uint32_t i, count;
+    size_t used;
+    VXfSegments segs;
+
+    assert ( seg_size != 0 );
+    count = ( uint32_t ) ( ( ssize + seg_size - 1 ) / seg_size );
+
+    segs . f = f;
+    segs . self = self;
+    segs . src = src;
+    segs . total = ssize;
+    segs . seg_size = seg_size;
+    segs . offset = NULL;
+
+    /* a segment that does not shrink may still grow a little */
+    segs . slot = seg_size + ( seg_size >> 3 ) + 64;
+
+    segs . size = malloc ( count * sizeof segs . size [ 0 ] );
+    if ( segs . size == NULL )
+        return RC ( rcXF, rcFunction, rcExecuting, rcMemory, rcExhausted );
+
+    segs . dst = malloc ( count * segs . slot );
+    if ( segs . dst == NULL )
+    {
+        free ( segs . size );
+        return RC ( rcXF, rcFunction, rcExecuting, rcMemory, rcExhausted );
+    }
+
+    rc = VXfRunParallel ( count, threads, VXfSegmentEncode, & segs );
+    if ( rc == 0 )
+    {
+        for ( used = 0, i = 0; i < count; ++ i )
+            used += segs . size [ i ];
+        if ( used > * dsize )
+            rc = RC ( rcXF, rcFunction, rcExecuting, rcBuffer, rcInsufficient );
+    }
+
+    if ( rc == 0 )
+        rc = VBlobHeaderArgPushTail ( hdr, ( int64_t ) seg_size );
+    for ( i = 0; rc == 0 && i < count; ++ i )
+        rc = VBlobHeaderArgPushTail ( hdr, ( int64_t ) segs . size [ i ] );
+
+    if ( rc == 0 )
+    {
+        uint8_t *out = dst;
+        for ( used = 0, i = 0; i < count; ++ i )
+        {
+            memmove ( out + used, segs . dst + ( size_t ) i * segs . slot, segs . size [ i ] );
+            used += segs . size [ i ];
+        }
+        * dsize = used;
+    }
+
+    free ( segs . dst );
+    free ( segs . size );
+
+    return rc;
+}
+
+
+/*--------------------------------------------------------------------------
+ * SegmentedDecode
+ */
+rc_t VXfSegmentedDecode ( VXfSegmentFunc f, void *self, uint32_t threads,
+    void *dst, size_t dsize, const void *src, size_t ssize,
+    const VBlobHeader *hdr )
+{
+    rc_t rc;
+    int64_t arg;
+    uint32_t i, count;
+    size_t used;
+    VXfSegments segs;
+
+    rc = VBlobHeaderArgPopHead ( hdr, & arg );
+    if ( rc != 0 )
+        return rc;
+    if ( arg <= 0 )
+        return RC ( rcXF, rcFunction, rcExecuting, rcHeader, rcInvalid );
+
+    segs . f = f;
+    segs . self = self;
+    segs . dst = dst;
+    segs . src = src;
+    segs . total = dsize;
+    segs . seg_size = ( size_t ) arg;
+    segs . slot = 0;
+
+    count = dsize == 0 ? 0 : ( uint32_t ) ( ( dsize - 1 ) / segs . seg_size + 1 );
+
+    segs . size = malloc ( 2 * ( size_t ) ( count + 1 ) * sizeof segs . size [ 0 ] );
+    if ( segs . size == NULL )
+        return RC ( rcXF, rcFunction, rcExecuting, rcMemory, rcExhausted );
+    segs . offset = segs . size + count + 1;
+
+    for ( used = 0, i = 0; i < count; ++ i )
+    {
+        rc = VBlobHeaderArgPopHead ( hdr, & arg );
+        if ( rc != 0 )
+            break;
+        if ( arg < 0 || ( uint64_t ) arg > ssize - used )
+        {
+            rc = RC ( rcXF, rcFunction, rcExecuting, rcData, rcCorrupt );
+            break;
+        }
+        segs . size [ i ] = ( size_t ) arg;
+        segs . offset [ i ] = used;
+        used += ( size_t ) arg;
+    }
+
+    if ( rc == 0 )
+        rc = VXfRunParallel ( count, threads, VXfSegmentDecode, & segs );
+
+    free ( segs . size );
+
+    return rc;
+}
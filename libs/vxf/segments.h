@@ -0,0 +1,110 @@
+/*===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ */
+
+#ifndef _h_vxf_segments_
+#define _h_vxf_segments_
+
+#ifndef _h_klib_defs_
+#include <klib/defs.h>
+#endif
+
+#ifndef _h_vdb_xform_
+#include <vdb/xform.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*--------------------------------------------------------------------------
+ * segmented blobs
+ *  a compressor may split a large blob into segments that are compressed
+ *  independently and stored back to back. the segment size and the size
+ *  of each compressed segment are recorded as header arguments, so the
+ *  segments can be expanded independently as well.
+ *
+ *  the segmented form is only written when "vdb/zip/threads" in
+ *  configuration allows more than one thread, since older readers do not
+ *  know it. reading it is always possible.
+ */
+
+
+/* SegmentFunc
+ *  compress or expand a single segment
+ *
+ *  "dsize" [ IN/OUT ] - capacity of "dst" on input,
+ *  number of bytes produced on output. a compressor returns 0 bytes
+ *  when the result does not fit.
+ */
+typedef rc_t ( * VXfSegmentFunc ) ( void *self,
+    void *dst, size_t *dsize, const void *src, size_t ssize );
+
+
+/* SegmentThreads
+ *  thread limit from "vdb/zip/threads" in configuration
+ *  or "dflt" when not configured
+ */
+uint32_t VXfSegmentThreads ( uint32_t dflt );
+
+
+/* RunParallel
+ *  runs "f" once for every index below "count"
+ *  on up to "threads" threads including the caller
+ *
+ *  returns the first non-zero rc by index
+ */
+rc_t VXfRunParallel ( uint32_t count, uint32_t threads,
+    rc_t ( * f ) ( void *data, uint32_t idx ), void *data );
+
+
+/* SegmentedEncode
+ *  compresses "src" in segments of "seg_size" bytes into "dst"
+ *  pushes segment size and compressed sizes onto "hdr"
+ *
+ *  "dsize" [ IN/OUT ] - capacity of "dst" on input, bytes written on output
+ *
+ *  fails with rcBuffer, rcInsufficient when the result does not fit
+ */
+rc_t VXfSegmentedEncode ( VXfSegmentFunc f, void *self, uint32_t threads,
+    void *dst, size_t *dsize, const void *src, size_t ssize,
+    size_t seg_size, VBlobHeader *hdr );
+
+
+/* SegmentedDecode
+ *  expands segments written by SegmentedEncode into exactly "dsize" bytes
+ *  pops segment size and compressed sizes from "hdr"
+ */
+rc_t VXfSegmentedDecode ( VXfSegmentFunc f, void *self, uint32_t threads,
+    void *dst, size_t dsize, const void *src, size_t ssize,
+    const VBlobHeader *hdr );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _h_vxf_segments_ */
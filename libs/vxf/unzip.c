@@ -32,6 +32,8 @@
 #include <klib/data-buffer.h>
 #include <sysalloc.h>
 
+#include "segments.h"
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <endian.h>
@@ -40,7 +42,16 @@
 #include <zlib.h>
 #include <assert.h>
 
-static rc_t invoke_zlib(void *dst, size_t dsize, const void *src, size_t ssize, int windowBits)
+/* segmented blobs are inflated on this many threads unless configured */
+#define UNZIP_DFLT_THREADS 4
+
+typedef struct unzip_t unzip_t;
+struct unzip_t
+{
+    uint32_t threads;
+};
+
+static rc_t invoke_zlib(void *dst, size_t dsize, size_t *psize, const void *src, size_t ssize, int windowBits)
 {
     int zr;
     rc_t rc = 0;
@@ -83,6 +94,8 @@ static rc_t invoke_zlib(void *dst, size_t dsize, const void *src, size_t ssize,
         rc = RC(rcXF, rcFunction, rcExecuting, rcNoObj, rcUnexpected);
         break;
     }
+    if (psize != NULL)
+        *psize = s.total_out;
     zr = inflateEnd(&s);
     switch (zr)
     {
@@ -96,6 +109,11 @@ static rc_t invoke_zlib(void *dst, size_t dsize, const void *src, size_t ssize,
     return rc;
 }
 
+static rc_t unzip_segment(void *self, void *dst, size_t *dsize, const void *src, size_t ssize)
+{
+    return invoke_zlib(dst, *dsize, dsize, src, ssize, -15);
+}
+
 static
 rc_t unzip_func_v1(
                    const VXformInfo *info,
@@ -103,7 +121,7 @@ rc_t unzip_func_v1(
                    const VBlobData *src
 ) {
     dst->byte_order = src->byte_order;
-    return invoke_zlib(dst->data, (((size_t)dst->elem_count * dst->elem_bits + 7) >> 3),
+    return invoke_zlib(dst->data, (((size_t)dst->elem_count * dst->elem_bits + 7) >> 3), NULL,
                        src->data, (((size_t)src->elem_count * src->elem_bits + 7) >> 3),
                        -15);
 }
@@ -126,7 +144,7 @@ rc_t unzip_func_v2(
         /* the feed to zlib MUST be byte aligned
            so the output must be as well */
         assert ( ( dst -> elem_count & 7 ) == 0 );
-        rc = invoke_zlib(dst->data, (((size_t)dst->elem_count) >> 3),
+        rc = invoke_zlib(dst->data, (((size_t)dst->elem_count) >> 3), NULL,
                          src->data, (((size_t)src->elem_count * src->elem_bits + 7) >> 3),
                          -15);
 
@@ -139,6 +157,35 @@ rc_t unzip_func_v2(
     return rc;
 }
 
+static
+rc_t unzip_func_v3(
+                   const unzip_t *self,
+                   VBlobResult *dst,
+                   const VBlobData *src,
+                   VBlobHeader *hdr
+) {
+    int64_t trailing;
+    rc_t rc = VBlobHeaderArgPopHead ( hdr, & trailing );
+    if ( rc == 0 )
+    {
+        dst -> elem_count *= dst -> elem_bits;
+        dst -> byte_order = src -> byte_order;
+        dst -> elem_bits = 1;
+
+        /* segments are inflated independently into their own ranges */
+        assert ( ( dst -> elem_count & 7 ) == 0 );
+        rc = VXfSegmentedDecode ( unzip_segment, NULL, self -> threads,
+                                  dst -> data, ( ( size_t ) dst -> elem_count ) >> 3,
+                                  src -> data, ( ( size_t ) src -> elem_count * src -> elem_bits + 7 ) >> 3,
+                                  hdr );
+
+        if ( rc == 0 && trailing != 0 )
+            dst -> elem_count -= 8 - trailing;
+    }
+
+    return rc;
+}
+
 static
 rc_t CC legacy_unzip_func ( void *self, const VXformInfo *info,
     VLegacyBlobResult *rslt, const KDataBuffer *src )
@@ -167,7 +214,7 @@ rc_t CC legacy_unzip_func ( void *self, const VXformInfo *info,
         if ( rc != 0 )
             break;
 
-        rc = invoke_zlib ( dst -> base, bytes, & in [ 1 ], (size_t)KDataBufferBytes ( src ) - 4, 15 );
+        rc = invoke_zlib ( dst -> base, bytes, NULL, & in [ 1 ], (size_t)KDataBufferBytes ( src ) - 4, 15 );
         if ( rc == 0 )
         {
             dst -> elem_bits = 1;
@@ -203,6 +250,9 @@ rc_t CC unzip_func(
     case 2:
         return unzip_func_v2(info, dst, src, hdr);
         break;
+    case 3:
+        return unzip_func_v3(Self, dst, src, hdr);
+        break;
     default:
         return RC(rcXF, rcFunction, rcExecuting, rcParam, rcBadVersion);
     }
@@ -214,6 +264,13 @@ rc_t CC unzip_func(
 VTRANSFACT_IMPL ( vdb_unzip, 1, 0, 0 ) ( const void *self, const VXfactInfo *info,
     VFuncDesc *rslt, const VFactoryParams *cp, const VFunctionParams *dp )
 {
+    unzip_t *fself = malloc ( sizeof *fself );
+    if ( fself == NULL )
+        return RC ( rcXF, rcFunction, rcConstructing, rcMemory, rcExhausted );
+    fself -> threads = VXfSegmentThreads ( UNZIP_DFLT_THREADS );
+
+    rslt->self = fself;
+    rslt->whack = free;
     rslt->variant = vftBlob;
     rslt->u.bf = unzip_func;
 
@@ -33,6 +33,8 @@
 #include <klib/data-buffer.h>
 #include <sysalloc.h>
 
+#include "segments.h"
+
 #include <string.h>
 #include <zlib.h>
 #include <stdint.h>
@@ -59,9 +61,14 @@
 
 #define BUFFER_GROWTH_RATE (64 * 1024)
 
+/* blobs of at least two segments are deflated in parallel
+   when "vdb/zip/threads" allows it */
+#define ZIP_SEGMENT_SIZE (256 * 1024)
+
 struct self_t {
     int32_t strategy;
     int32_t level;
+    uint32_t threads;
 };
 
 #if _DEBUGGING
@@ -128,6 +135,14 @@ static rc_t invoke_zlib(void *dst, uint32_t *dsize, const void *src, uint32_t ss
     return rc;
 }
 
+static rc_t zip_segment(void *Self, void *dst, size_t *dsize, const void *src, size_t ssize) {
+    const struct self_t *self = Self;
+    uint32_t size = (uint32_t)*dsize;
+    rc_t rc = invoke_zlib(dst, &size, src, (uint32_t)ssize, self->strategy, self->level);
+    *dsize = size;
+    return rc;
+}
+
 static
 rc_t CC zip_func(
               void *Self,
@@ -148,16 +163,31 @@ rc_t CC zip_func(
     /* required output size */
     uint32_t dsize = ( uint32_t ) ( ( ( size_t ) dst -> elem_count * dst->elem_bits + 7 ) >> 3 );
 
-    if ( ( sbits & 7 ) == 0 )
-        /* version 1 is byte-aligned */
-        VBlobHeaderSetVersion ( hdr, 1 );
-    else
+    if ( self -> threads > 1 && ssize >= 2 * ZIP_SEGMENT_SIZE )
     {
-        VBlobHeaderSetVersion ( hdr, 2 );
-        VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        /* version 3 is segmented, trailing bits are always given */
+        size_t used = dsize;
+
+        VBlobHeaderSetVersion ( hdr, 3 );
+        rc = VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        if ( rc == 0 )
+            rc = VXfSegmentedEncode ( zip_segment, self, self -> threads,
+                dst -> data, & used, src -> data, ssize, ZIP_SEGMENT_SIZE, hdr );
+        dsize = rc == 0 ? ( uint32_t ) used : 0;
     }
+    else
+    {
+        if ( ( sbits & 7 ) == 0 )
+            /* version 1 is byte-aligned */
+            VBlobHeaderSetVersion ( hdr, 1 );
+        else
+        {
+            VBlobHeaderSetVersion ( hdr, 2 );
+            VBlobHeaderArgPushTail ( hdr, ( int64_t ) ( sbits & 7 ) );
+        }
 
-    rc = invoke_zlib ( dst -> data, & dsize, src -> data, ssize, self->strategy, self->level);
+        rc = invoke_zlib ( dst -> data, & dsize, src -> data, ssize, self->strategy, self->level);
+    }
     if (rc == 0) {
         dst->elem_bits = 1;
         dst->byte_order = src->byte_order;
@@ -202,6 +232,7 @@ VTRANSFACT_IMPL(vdb_zip, 1, 0, 0) (const void *self, const VXfactInfo *info, VFu
     if (ctx) {
         ctx->strategy = strategy;
         ctx->level = level;
+        ctx->threads = VXfSegmentThreads(0);
        
         rslt->self = ctx;
         rslt->whack = vxf_zip_wrapper;
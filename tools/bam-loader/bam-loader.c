@@ -38,6 +38,7 @@
 #include <kfs/file.h>
 #include <kapp/log-xml.h>
 #include <align/writer-refseq.h>
+#include <align/bam.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -79,6 +80,7 @@ static char const option_ref_file[] = "ref-file";
 static char const option_TI[] = "TI";
 static char const option_max_warn_dup_flag[] = "max-warning-dup-flag";
 static char const option_accept_hard_clip[] = "accept-hard-clip";
+static char const option_threads[] = "threads";
 
 #define OPTION_INPUT option_input
 #define OPTION_OUTPUT option_output
@@ -101,6 +103,7 @@ static char const option_accept_hard_clip[] = "accept-hard-clip";
 #define OPTION_TI option_TI
 #define OPTION_MAX_WARN_DUP_FLAG option_max_warn_dup_flag
 #define OPTION_ACCEPT_HARD_CLIP option_accept_hard_clip
+#define OPTION_THREADS option_threads
 
 #define ALIAS_INPUT  "i"
 #define ALIAS_OUTPUT "o"
@@ -321,6 +324,13 @@ char const * use_accept_hard_clip[] =
     NULL
 };
 
+static
+char const * use_threads[] = 
+{
+    "number of threads used to decompress the BAM file, default 0",
+    NULL
+};
+
 OptDef Options[] = 
 {
     /* order here is same as in param array below!!! */
@@ -352,7 +362,8 @@ OptDef Options[] =
     { OPTION_REF_FILE, ALIAS_REF_FILE, NULL, use_ref_file, 0, true, false },
     { OPTION_TI, NULL, NULL, use_TI, 1, false, false },
     { OPTION_MAX_WARN_DUP_FLAG, NULL, NULL, use_max_dup_warnings, 1, true, false },
-    { OPTION_ACCEPT_HARD_CLIP, NULL, NULL, use_accept_hard_clip, 1, false, false }
+    { OPTION_ACCEPT_HARD_CLIP, NULL, NULL, use_accept_hard_clip, 1, false, false },
+    { OPTION_THREADS, NULL, NULL, use_threads, 1, true, false }
 };
 
 const char* OptHelpParam[] =
@@ -386,7 +397,8 @@ const char* OptHelpParam[] =
     "path-to-file",
     NULL,
     "count",
-    NULL
+    NULL,
+    "count"
 };
 
 rc_t UsageSummary (char const * progname)
@@ -805,6 +817,17 @@ rc_t CC KMain (int argc, char * argv[])
             G.maxErrCount = strtoul(value, &dummy, 0);
         }
         
+        rc = ArgsOptionCount (args, OPTION_THREADS, &pcount);
+        if (rc)
+            break;
+        if (pcount == 1)
+        {
+            rc = ArgsOptionValue (args, OPTION_THREADS, 0, &value);
+            if (rc)
+                break;
+            BAMFileSetDecompressionThreads(strtoul(value, &dummy, 0));
+        }
+        
         rc = ArgsOptionCount (args, OPTION_MIN_MATCH, &pcount);
         if (rc)
             break;
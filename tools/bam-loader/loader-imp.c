@@ -41,7 +41,7 @@
 #include <kfs/mmap.h>
 #include <kfs/pagefile.h>
 #include <kfs/pmem.h>
-#include <kdb/btree.h>
+#include <kproc/lock.h>
 #include <kdb/manager.h>
 #include <kdb/database.h>
 #include <kdb/table.h>
@@ -64,6 +64,7 @@
 #include <kapp/loader-meta.h>
 #include <kapp/log-xml.h>
 #include <kapp/progressbar.h>
+#include <kapp/key-index.h>
 
 #include <sysalloc.h>
 #include <atomic32.h>
@@ -137,7 +138,8 @@ typedef struct FragmentInfo {
 
 typedef struct context_t {
     const KLoadProgressbar *progress[4];
-    KBTree *key2id[NUM_ID_SPACES];
+    struct KeyIndex *key2id[NUM_ID_SPACES];
+    KLock *key2id_lock; /* guards the read group table and idCount */
     char *key2id_names;
     MMArray *id2value;
     KMemBank *fragsBoth; /*** mate will be there soon ***/
@@ -251,38 +253,29 @@ static void MMArrayWhack(MMArray *self)
     free(self);
 }
 
-static rc_t OpenKBTree(KBTree **const rslt, unsigned n, unsigned max)
+static rc_t OpenKeyIndex(struct KeyIndex **const rslt, unsigned n, unsigned max)
 {
-    size_t const cacheSize = (((G.cache_size - (G.cache_size / 2) - (G.cache_size / 8)) / max)
-                            + 0xFFFFF) & ~((size_t)0xFFFFF);
-    KFile *file = NULL;
-    KDirectory *dir;
-    char fname[4096];
-    rc_t rc;
-    
-    rc = KDirectoryNativeDir(&dir);
-    if (rc)
-        return rc;
-    
-    rc = string_printf(fname, sizeof(fname), NULL, "%s/key2id.%u.%u", G.tmpfs, G.pid, n); if (rc) return rc;
-    rc = KDirectoryCreateFile(dir, &file, true, 0600, kcmInit, fname);
-    KDirectoryRemove(dir, 0, fname);
-    KDirectoryRelease(dir);
-    if (rc == 0) {
-        rc = KBTreeMakeUpdate(rslt, file, cacheSize,
-                              false, kbtOpaqueKey,
-                              1, 255, sizeof ( uint32_t ),
-                              NULL
-                              );
-        KFileRelease(file);
+    size_t const memLimit = (((G.cache_size - (G.cache_size / 2) - (G.cache_size / 8)) / max)
+                          + 0xFFFFF) & ~((size_t)0xFFFFF);
+    rc_t const rc = KeyIndexMake(rslt, G.tmpfs, G.pid, n, memLimit);
 #if PERF
-        if (rc == 0) {
-            static unsigned treecount = 0;
+    if (rc == 0) {
+        static unsigned indexcount = 0;
 
-            (void)PLOGMSG(klogInfo, (klogInfo, "Number of trees: $(cnt)", "cnt=%u", ++treecount));
-        }
-#endif
+        (void)PLOGMSG(klogInfo, (klogInfo, "Number of key indices: $(cnt)", "cnt=%u", ++indexcount));
     }
+#endif
+    return rc;
+}
+
+/* names in the next file are looked up against one run per index */
+static rc_t MergeKeyIndices(context_t *const ctx)
+{
+    unsigned i;
+    rc_t rc = 0;
+
+    for (i = 0; rc == 0 && i != ctx->key2id_count; ++i)
+        rc = KeyIndexMerge(ctx->key2id[i]);
     return rc;
 }
 
@@ -290,17 +283,16 @@ static rc_t GetKeyIDOld(context_t *const ctx, uint64_t *const rslt, bool *const
 {
     unsigned const keylen = strlen(key);
     rc_t rc;
-    uint64_t tmpKey;
+    uint32_t tmpKey;
 
     if (ctx->key2id_count == 0) {
-        rc = OpenKBTree(&ctx->key2id[0], 1, 1);
+        rc = OpenKeyIndex(&ctx->key2id[0], 1, 1);
         if (rc) return rc;
         ctx->key2id_count = 1;
     }
     if (memcmp(key, name, keylen) == 0) {
         /* qname starts with read group; no append */
-        tmpKey = ctx->idCount[0];
-        rc = KBTreeEntry(ctx->key2id[0], &tmpKey, wasInserted, name, namelen);
+        rc = KeyIndexEntry(ctx->key2id[0], &tmpKey, wasInserted, name, namelen);
     }
     else {
         char sbuf[4096];
@@ -317,8 +309,7 @@ static rc_t GetKeyIDOld(context_t *const ctx, uint64_t *const rslt, bool *const
         }
         rc = string_printf(buf, bsize, &actsize, "%s\t%.*s", key, (int)namelen, name);
         
-        tmpKey = ctx->idCount[0];
-        rc = KBTreeEntry(ctx->key2id[0], &tmpKey, wasInserted, buf, actsize);
+        rc = KeyIndexEntry(ctx->key2id[0], &tmpKey, wasInserted, buf, actsize);
         if (hbuf)
             free(hbuf);
     }
@@ -377,7 +368,7 @@ static size_t GetFixedNameLength(char const name[], size_t const namelen)
 }
 
 static
-rc_t GetKeyID(context_t *const ctx,
+rc_t GetKeyIDLocked(context_t *const ctx,
               uint64_t *const rslt,
               bool *const wasInserted,
               char const key[],
@@ -393,7 +384,7 @@ rc_t GetKeyID(context_t *const ctx,
         unsigned const h = HashKey(key, keylen);
         unsigned f;
         unsigned e = ctx->key2id_count;
-        uint64_t tmpKey;
+        uint32_t tmpKey;
         
         *rslt = 0;
         {{
@@ -438,8 +429,8 @@ rc_t GetKeyID(context_t *const ctx,
         }
         if (ctx->key2id_count < ctx->key2id_max) {
             unsigned const name_max = ctx->key2id_name_max + keylen + 1;
-            KBTree *tree;
-            rc_t rc = OpenKBTree(&tree, ctx->key2id_count + 1, 1); /* ctx->key2id_max); */
+            struct KeyIndex *tree;
+            rc_t rc = OpenKeyIndex(&tree, ctx->key2id_count + 1, 1); /* ctx->key2id_max); */
             
             if (rc) return rc;
             
@@ -481,8 +472,7 @@ rc_t GetKeyID(context_t *const ctx,
                 ctx->key2id_hash[h] = (((ctx->key2id_hash[h] & ~(0xFFu)) | f) << 8) | 3;
             }
         GET_ID:
-            tmpKey = ctx->idCount[f];
-            rc = KBTreeEntry(ctx->key2id[f], &tmpKey, wasInserted, name, namelen);
+            rc = KeyIndexEntry(ctx->key2id[f], &tmpKey, wasInserted, name, namelen);
             if (rc == 0) {
               /*              fprintf(stderr, "GetKeyID: { Key: '%s', Name: '%.*s', id: '%u:%x', new: %s }\n", key, (int)namelen, name, (unsigned)f, (unsigned)tmpKey, *wasInserted ? "true" : "false"); */
                 *rslt = (((uint64_t)f) << 32) | tmpKey;
@@ -496,6 +486,23 @@ rc_t GetKeyID(context_t *const ctx,
     }
 }
 
+static
+rc_t GetKeyID(context_t *const ctx,
+              uint64_t *const rslt,
+              bool *const wasInserted,
+              char const key[],
+              char const name[],
+              size_t const o_namelen)
+{
+    rc_t rc = KLockAcquire(ctx->key2id_lock);
+    
+    if (rc == 0) {
+        rc = GetKeyIDLocked(ctx, rslt, wasInserted, key, name, o_namelen);
+        KLockUnlock(ctx->key2id_lock);
+    }
+    return rc;
+}
+
 static rc_t OpenMMapFile(context_t *const ctx, KDirectory *const dir)
 {
     KFile *file = NULL;
@@ -545,6 +552,9 @@ static rc_t SetupContext(context_t *ctx, unsigned numfiles)
 
     memset(ctx, 0, sizeof(*ctx));
     
+    rc = KLockMake(&ctx->key2id_lock);
+    if (rc) return rc;
+    
     if (G.mode == mode_Archive) {
         KDirectory *dir;
         size_t fragSizeBoth; /*** temporary hold for first side of mate pair with both sides aligned**/
@@ -587,6 +597,7 @@ static void ContextRelease(context_t *ctx)
     KLoadProgressbar_Release(ctx->progress[2], true);
     KLoadProgressbar_Release(ctx->progress[3], true);
     MMArrayWhack(ctx->id2value);
+    KLockRelease(ctx->key2id_lock);
 }
 
 static
@@ -1237,7 +1248,7 @@ static rc_t ProcessBAM(char const bamFile[], context_t *ctx, VDatabase *db,
         
         rc = GetKeyID(ctx, &keyId, &wasInserted, spotGroup, name, namelen);
         if (rc) {
-            (void)PLOGERR(klogErr, (klogErr, rc, "KBTreeEntry: failed on key '$(key)'", "key=%.*s", namelen, name));
+            (void)PLOGERR(klogErr, (klogErr, rc, "KeyIndexEntry: failed on key '$(key)'", "key=%.*s", namelen, name));
             goto LOOP_END;
         }
         rc = MMArrayGet(ctx->id2value, (void **)&value, keyId);
@@ -1937,6 +1948,8 @@ static rc_t ArchiveBAM(VDBManager *mgr, VDatabase *db,
         bool this_has_sequences = false;
         
         rc = ProcessBAM(bamFile[i], &ctx, db, &ref, &seq, align, &this_has_alignments, &this_has_sequences);
+        if (rc == 0)
+            rc = MergeKeyIndices(&ctx);
         *has_alignments |= this_has_alignments;
         has_sequences |= this_has_sequences;
     }
@@ -1945,13 +1958,14 @@ static rc_t ArchiveBAM(VDBManager *mgr, VDatabase *db,
         bool this_has_sequences = false;
         
         rc = ProcessBAM(seqFile[i], &ctx, db, &ref, &seq, align, &this_has_alignments, &this_has_sequences);
+        if (rc == 0)
+            rc = MergeKeyIndices(&ctx);
         *has_alignments |= this_has_alignments;
         has_sequences |= this_has_sequences;
     }
 /*** No longer need memory for key2id ***/
     for (i = 0; i != ctx.key2id_count; ++i) {
-        KBTreeDropBacking(ctx.key2id[i]);
-        KBTreeRelease(ctx.key2id[i]);
+        KeyIndexWhack(ctx.key2id[i]);
         ctx.key2id[i] = NULL;
     }
     free(ctx.key2id_names);
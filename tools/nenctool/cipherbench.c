@@ -0,0 +1,316 @@
+/*==============================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include "cipherbench.vers.h"
+
+#include <kapp/main.h>
+#include <kapp/args.h>
+
+#include <krypto/cipher.h>
+#include <krypto/ciphermgr.h>
+#include <krypto/cipher-test.h>
+
+#include <klib/log.h>
+#include <klib/out.h>
+#include <klib/rc.h>
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+/* Version  EXTERN
+ *  return 4-part version code: 0xMMmmrrrr, where
+ *      MM = major release
+ *      mm = minor release
+ *    rrrr = bug-fix release
+ */
+ver_t CC KAppVersion ( void )
+{
+    return CIPHERBENCH_VERS;
+}
+
+
+#define OPTION_SIZE   "size"
+#define ALIAS_SIZE    "s"
+static
+const char * size_usage[] = 
+{ "megabytes to run through each mode of each implementation",
+  "default 64", NULL };
+
+static
+OptDef Options[] = 
+{
+    /* name            alias max times oparam required fmtfunc help text loc */
+    { OPTION_SIZE,   ALIAS_SIZE,   NULL, size_usage,   1, true,  false }
+};
+
+
+/* Usage
+ */
+const char UsageDefaultName [] = "cipherbench";
+
+rc_t CC UsageSummary (const char * progname)
+{
+    return KOutMsg (
+        "\n"
+        "Usage:\n"
+        "  %s [options]\n"
+        "\n"
+        "Summary:\n"
+        "  Report the throughput in MB/s of each AES implementation this\n"
+        "  processor supports for ECB and CBC encryption and decryption.\n"
+        "  The implementation picked by the cipher manager is also run.\n"
+        "\n", progname);
+}
+
+
+rc_t CC Usage (const Args * args)
+{
+    const char * progname = UsageDefaultName;
+    const char * fullpath = UsageDefaultName;
+    rc_t rc;
+
+    if (args == NULL)
+        rc = RC (rcApp, rcArgv, rcAccessing, rcSelf, rcNull);
+    else
+        rc = ArgsProgram (args, &fullpath, &progname);
+
+    UsageSummary (progname);
+
+    KOutMsg ("Options:\n");
+
+    HelpOptionLine (ALIAS_SIZE, OPTION_SIZE, "megabytes", size_usage);
+
+    HelpOptionsStandard ();
+
+    HelpVersion (fullpath, KAppVersion());
+
+    return rc;
+}
+
+
+#define BENCH_BUFFER_SIZE (1024 * 1024)
+
+typedef rc_t (CC * bench_func) (KCipher * self, const void * in, void * out,
+                                uint32_t block_count);
+
+static
+double elapsed (const struct timeval * start)
+{
+    struct timeval now;
+
+    gettimeofday (&now, NULL);
+    return (double)(now.tv_sec - start->tv_sec) +
+        (double)(now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+
+/* run one mode over size_mb megabytes and report MB/s */
+static
+rc_t bench_mode (KCipher * cipher, bench_func func, bool decrypt,
+                 uint8_t * buffer, uint32_t size_mb, double * mbps)
+{
+    static const uint8_t ivec [16] = { 0 };
+    struct timeval start;
+    double secs;
+    uint32_t ix;
+    rc_t rc;
+
+    rc = decrypt
+        ? KCipherSetDecryptIVec (cipher, ivec)
+        : KCipherSetEncryptIVec (cipher, ivec);
+
+    gettimeofday (&start, NULL);
+    for (ix = 0; (rc == 0) && (ix < size_mb); ++ ix)
+        rc = func (cipher, buffer, buffer, BENCH_BUFFER_SIZE / sizeof ivec);
+
+    secs = elapsed (&start);
+    *mbps = (secs > 0) ? size_mb / secs : 0;
+    return rc;
+}
+
+
+static
+rc_t bench_cipher (const char * name, KCipher * cipher, uint8_t * buffer,
+                   uint32_t size_mb)
+{
+    static const uint8_t user_key [32] =
+    {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+        0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+        0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+    double ecb_enc, ecb_dec, cbc_enc, cbc_dec;
+    rc_t rc;
+
+    rc = KCipherSetEncryptKey (cipher, user_key, sizeof user_key);
+    if (rc == 0)
+        rc = KCipherSetDecryptKey (cipher, user_key, sizeof user_key);
+    if (rc == 0)
+        rc = bench_mode (cipher, KCipherEncryptECB, false, buffer, size_mb, &ecb_enc);
+    if (rc == 0)
+        rc = bench_mode (cipher, KCipherDecryptECB, true, buffer, size_mb, &ecb_dec);
+    if (rc == 0)
+        rc = bench_mode (cipher, KCipherEncryptCBC, false, buffer, size_mb, &cbc_enc);
+    if (rc == 0)
+        rc = bench_mode (cipher, KCipherDecryptCBC, true, buffer, size_mb, &cbc_dec);
+
+    if (rc)
+        PLOGERR (klogErr, (klogErr, rc, "failed to run '$(N)'", "N=%s", name));
+    else
+        rc = KOutMsg ("%-12s %10.1f %10.1f %10.1f %10.1f\n", name,
+                      ecb_enc, ecb_dec, cbc_enc, cbc_dec);
+    return rc;
+}
+
+
+static
+rc_t run (uint32_t size_mb)
+{
+    static const struct
+    {
+        const char * name;
+        rc_t (* make) (struct KCipher ** new_cipher, kcipher_type type);
+    } impl [] =
+    {
+        { "byte",     KCipherTestByteMake },
+        { "vector",   KCipherTestVecMake },
+        { "vec-reg",  KCipherTestVecRegMake },
+        { "aes-ni",   KCipherTestVecAesNiMake }
+    };
+    KCipherManager * mgr;
+    uint8_t * buffer;
+    unsigned ix;
+    rc_t rc;
+
+    buffer = malloc (BENCH_BUFFER_SIZE);
+    if (buffer == NULL)
+        return RC (rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+    memset (buffer, 0x5a, BENCH_BUFFER_SIZE);
+
+    rc = KOutMsg ("%-12s %10s %10s %10s %10s   (MB/s, AES-256)\n",
+                  "cipher", "ecb-enc", "ecb-dec", "cbc-enc", "cbc-dec");
+
+    for (ix = 0; (rc == 0) && (ix < sizeof impl / sizeof impl [0]); ++ ix)
+    {
+        KCipher * cipher;
+
+        rc = impl [ix] . make (&cipher, kcipher_AES);
+        if (rc)
+        {
+            if (GetRCState (rc) != rcUnsupported)
+                break;
+            rc = KOutMsg ("%-12s %10s\n", impl [ix] . name, "unsupported");
+        }
+        else
+        {
+            rc = bench_cipher (impl [ix] . name, cipher, buffer, size_mb);
+            KCipherRelease (cipher);
+        }
+    }
+
+    if (rc == 0)
+    {
+        rc = KCipherManagerMake (&mgr);
+        if (rc == 0)
+        {
+            KCipher * cipher;
+
+            rc = KCipherManagerMakeCipher (mgr, &cipher, kcipher_AES);
+            if (rc == 0)
+            {
+                rc = bench_cipher ("default", cipher, buffer, size_mb);
+                KCipherRelease (cipher);
+            }
+            KCipherManagerRelease (mgr);
+        }
+    }
+    free (buffer);
+    return rc;
+}
+
+
+/* KMain - EXTERN
+ *  executable entrypoint "main" is implemented by
+ *  an OS-specific wrapper that takes care of establishing
+ *  signal handlers, logging, etc.
+ *
+ *  in turn, OS-specific "main" will invoke "KMain" as
+ *  platform independent main entrypoint.
+ *
+ *  "argc" [ IN ] - the number of textual parameters in "argv"
+ *  should never be < 0, but has been left as a signed int
+ *  for reasons of tradition.
+ *
+ *  "argv" [ IN ] - array of NUL terminated strings expected
+ *  to be in the shell-native character set: ASCII or UTF-8
+ *  element 0 is expected to be executable identity or path.
+ */
+rc_t CC KMain ( int argc, char *argv [] )
+{
+    Args* args = NULL;
+    rc_t rc;
+
+    rc = ArgsMakeAndHandle(&args, argc, argv, 1, Options, sizeof Options / sizeof (OptDef));
+    if (rc)
+        LOGERR (klogInt, rc, "failed to parse command line parameters");
+    else
+    {
+        uint32_t size_mb = 64;
+        uint32_t pcount;
+
+        rc = ArgsOptionCount (args, OPTION_SIZE, &pcount);
+        if (rc)
+            LOGERR (klogInt, rc, "failed to examine size option");
+        else if (pcount)
+        {
+            const char * value;
+
+            rc = ArgsOptionValue (args, OPTION_SIZE, 0, &value);
+            if (rc)
+                LOGERR (klogInt, rc, "failed to examine size value");
+            else
+            {
+                size_mb = (uint32_t) strtoul (value, NULL, 10);
+                if (size_mb == 0)
+                {
+                    rc = RC (rcExe, rcArgv, rcParsing, rcParam, rcInvalid);
+                    LOGERR (klogErr, rc, "bad value for size");
+                }
+            }
+        }
+        if (rc == 0)
+            rc = run (size_mb);
+
+        ArgsWhack (args);
+    }
+    return rc;
+}
+
+/* EOF */
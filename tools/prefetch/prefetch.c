@@ -55,12 +55,16 @@
 #include <klib/container.h> /* BSTree */
 #include <klib/data-buffer.h> /* KDataBuffer */
 #include <klib/log.h> /* PLOGERR */
+#include <klib/namelist.h> /* VNamelist */
 #include <klib/out.h> /* KOutMsg */
 #include <klib/printf.h> /* string_printf */
 #include <klib/rc.h>
 #include <klib/status.h> /* STSMSG */
 #include <klib/text.h> /* String */
 
+#include <kproc/lock.h> /* KLock */
+#include <kproc/thread.h> /* KThread */
+
 #include <strtol.h> /* strtou64 */
 #include <sysalloc.h>
 
@@ -179,6 +183,9 @@ typedef struct {
     void *buffer;
     size_t bsize;
 
+    uint32_t connections; /* for segmented http download */
+    uint64_t segSize;
+
     bool undersized; /* remoteSz < min allowed size */
     bool oversized; /* remoteSz >= max allowed size */
 
@@ -276,6 +283,17 @@ rc_t _KFileOpenRemote(const KFile **self, KNSManager *kns, const char *path)
     return rc;
 }
 
+static rc_t _KFileWriteExactly(KFile *self,
+    uint64_t pos, const void *buffer, size_t size)
+{
+    size_t num_writ = 0;
+    rc_t rc = KFileWriteAll(self, pos, buffer, size, &num_writ);
+    if (rc == 0 && num_writ != size) {
+        rc = RC(rcExe, rcFile, rcWriting, rcTransfer, rcIncomplete);
+    }
+    return rc;
+}
+
 /********** KDirectory extension **********/
 static rc_t _KDirectoryMkTmpPrefix(const KDirectory *self,
     const String *prefix, char *out, size_t sz)
@@ -357,6 +375,48 @@ static rc_t _KDirectoryMkLockName(const KDirectory *self,
     return rc;
 }
 
+/* partial download and its completion map are kept across runs */
+static rc_t _KDirectoryMkPartName(const KDirectory *self,
+    const String *prefix, char *out, size_t sz)
+{
+    rc_t rc = 0;
+    size_t num_writ = 0;
+
+    assert(prefix);
+
+    rc = string_printf(out, sz, &num_writ, "%S.part", prefix);
+    DISP_RC2(rc, "string_printf(part)", prefix->addr);
+
+    if (rc == 0 && num_writ + sizeof ".map" > sz) {
+        rc = RC(rcExe, rcFile, rcCopying, rcBuffer, rcInsufficient);
+        PLOGERR(klogInt, (klogInt, rc,
+            "bad string_printf($(s).part) result", "s=%s", prefix->addr));
+        return rc;
+    }
+
+    return rc;
+}
+
+static rc_t _KDirectoryCleanPart(KDirectory *self, const char *part) {
+    rc_t rc = 0;
+
+    assert(self && part);
+
+    if (KDirectoryPathType(self, "%s.map", part) != kptNotFound) {
+        STSMSG(STS_DBG, ("removing %s.map", part));
+        rc = KDirectoryRemove(self, false, "%s.map", part);
+        DISP_RC2(rc, "KDirectoryRemove(map)", part);
+    }
+
+    if (rc == 0 && KDirectoryPathType(self, part) != kptNotFound) {
+        STSMSG(STS_DBG, ("removing %s", part));
+        rc = KDirectoryRemove(self, false, part);
+        DISP_RC2(rc, "KDirectoryRemove(part)", part);
+    }
+
+    return rc;
+}
+
 static
 rc_t _KDirectoryCleanCache(KDirectory *self, const String *local)
 {
@@ -893,6 +953,12 @@ static bool MainUseAscp(Main *self) {
     return rc == 0 && self->ascp && self->asperaKey;
 }
 
+/* the protocols to resolve remote locations with:
+   names-cache entries are keyed by them */
+static VRemoteProtocols MainProtocols(Main *self) {
+    return MainUseAscp(self) ? eProtocolFaspHttp : eProtocolHttp;
+}
+
 static bool MainHasDownloaded(const Main *self, const char *local) {
     TreeNode *sn = NULL;
 
@@ -999,6 +1065,423 @@ static rc_t MainDownloadFile(Resolved *self,
     return rc;
 }
 
+/********** Segmented download **********/
+/* Large objects are split into segments of main->segSize bytes
+   that are fetched concurrently over separate HTTP connections
+   straight into their place in a sparse ".part" file.
+
+   The ".part.map" sidecar starts with a header naming the object size
+   and segment size, followed by a byte per segment
+   that is set once the segment is complete.
+   A download that is interrupted resumes with the missing segments. */
+#define SEG_MAP_PENDING '.'
+#define SEG_MAP_DONE    '+'
+#define SEG_RETRIES 3
+
+typedef struct {
+    Main *main; /* just a pointer, no refcount here */
+    const String *remote;
+    const char *part;
+
+    KFile *map;
+    char hdr[128];
+    size_t hdrSz;
+
+    uint64_t size;
+    uint32_t count;
+    char *done; /* map content after the header */
+
+    KLock *lock;
+    uint32_t next;
+    uint32_t completed;
+    rc_t rc;
+} Segments;
+
+static rc_t SegmentsFini(Segments *self) {
+    rc_t rc = 0;
+
+    assert(self);
+
+    RELEASE(KFile, self->map);
+    RELEASE(KLock, self->lock);
+
+    free(self->done);
+
+    memset(self, 0, sizeof *self);
+
+    return rc;
+}
+
+/* try to resume from an existing map: return true if it matches */
+static bool SegmentsLoadMap(Segments *self) {
+    rc_t rc = 0;
+    uint64_t sz = 0;
+    size_t num_read = 0;
+    char hdr[sizeof self->hdr];
+    const KFile *map = NULL;
+    Main *main = NULL;
+
+    assert(self && self->main && self->done);
+
+    main = self->main;
+
+    if (KDirectoryPathType(main->dir, self->part) != kptFile) {
+        return false;
+    }
+
+    rc = KDirectoryOpenFileRead(main->dir, &map, "%s.map", self->part);
+    if (rc == 0) {
+        rc = KFileSize(map, &sz);
+    }
+    if (rc == 0 && sz != self->hdrSz + self->count) {
+        rc = RC(rcExe, rcFile, rcValidating, rcSize, rcIncorrect);
+    }
+    if (rc == 0) {
+        rc = KFileReadAll(map, 0, hdr, self->hdrSz, &num_read);
+    }
+    if (rc == 0 && (num_read != self->hdrSz
+                 || memcmp(hdr, self->hdr, self->hdrSz) != 0))
+    {
+        rc = RC(rcExe, rcFile, rcValidating, rcFormat, rcIncorrect);
+    }
+    if (rc == 0) {
+        rc = KFileReadExactly(map, self->hdrSz, self->done, self->count);
+    }
+
+    RELEASE(KFile, map);
+
+    if (rc == 0) {
+        uint32_t i = 0;
+        for (i = 0; i < self->count; ++i) {
+            if (self->done[i] == SEG_MAP_DONE) {
+                ++self->completed;
+            }
+            else {
+                self->done[i] = SEG_MAP_PENDING;
+            }
+        }
+        STSMSG(STS_INFO, ("%s: resuming with %u of %u segments complete",
+            self->part, self->completed, self->count));
+    }
+    else {
+        self->completed = 0;
+        STSMSG(STS_DBG, ("%s.map cannot be used: starting over", self->part));
+    }
+
+    return rc == 0;
+}
+
+static rc_t SegmentsInit(Segments *self,
+    Main *main, const String *remote, const char *part, uint64_t size)
+{
+    rc_t rc = 0;
+    bool resume = false;
+
+    assert(self && main && remote && part && main->segSize > 0);
+
+    memset(self, 0, sizeof *self);
+
+    self->main = main;
+    self->remote = remote;
+    self->part = part;
+    self->size = size;
+    self->count = (uint32_t)((size + main->segSize - 1) / main->segSize);
+
+    rc = string_printf(self->hdr, sizeof self->hdr, &self->hdrSz,
+        "prefetch-map 1 %lu %lu\n", size, main->segSize);
+    DISP_RC2(rc, "string_printf(map)", part);
+
+    if (rc == 0) {
+        self->done = malloc(self->count);
+        if (self->done == NULL) {
+            rc = RC(rcExe, rcData, rcAllocating, rcMemory, rcExhausted);
+        }
+        else {
+            memset(self->done, SEG_MAP_PENDING, self->count);
+        }
+    }
+
+    if (rc == 0) {
+        rc = KLockMake(&self->lock);
+        DISP_RC(rc, "KLockMake");
+    }
+
+    if (rc == 0) {
+        resume = SegmentsLoadMap(self);
+    }
+
+    if (rc == 0 && !resume) {
+        KFile *out = NULL;
+        STSMSG(STS_DBG, ("creating %s", part));
+        rc = KDirectoryCreateFile(main->dir, &out,
+            false, 0664, kcmInit | kcmParents, part);
+        DISP_RC2(rc, "Cannot OpenFileWrite", part);
+        if (rc == 0) {
+            rc = KFileSetSize(out, size);
+            DISP_RC2(rc, "KFileSetSize", part);
+        }
+        RELEASE(KFile, out);
+
+        if (rc == 0) {
+            rc = KDirectoryCreateFile(main->dir, &self->map,
+                false, 0664, kcmInit, "%s.map", part);
+            DISP_RC2(rc, "Cannot OpenFileWrite(map)", part);
+        }
+        if (rc == 0) {
+            rc = _KFileWriteExactly(self->map, 0, self->hdr, self->hdrSz);
+        }
+        if (rc == 0) {
+            rc = _KFileWriteExactly(self->map,
+                self->hdrSz, self->done, self->count);
+        }
+        DISP_RC2(rc, "Cannot write map", part);
+    }
+    else if (rc == 0) {
+        rc = KDirectoryOpenFileWrite(main->dir, &self->map,
+            true, "%s.map", part);
+        DISP_RC2(rc, "Cannot OpenFileWrite(map)", part);
+    }
+
+    return rc;
+}
+
+/* fetch one segment, picking up where a failed read stopped;
+   give up after SEG_RETRIES failures in a row */
+static rc_t SegmentsFetch(Segments *self, uint32_t idx,
+    const KFile **remote, KFile *out, void *buffer, size_t bsize)
+{
+    rc_t rc = 0;
+    uint32_t attempt = 0;
+    uint64_t pos = (uint64_t)idx * self->main->segSize;
+    uint64_t end = pos + self->main->segSize;
+
+    assert(self && remote && out && buffer);
+
+    if (end > self->size) {
+        end = self->size;
+    }
+
+    while (pos < end) {
+        size_t num_read = 0;
+        size_t toRead = bsize;
+        if (toRead > end - pos) {
+            toRead = (size_t)(end - pos);
+        }
+
+        rc = Quitting();
+        if (rc != 0) {
+            break;
+        }
+
+        if (*remote == NULL) {
+            rc = _KFileOpenRemote(remote, self->main->kns, self->remote->addr);
+        }
+        if (rc == 0) {
+            rc = KFileReadAll(*remote, pos, buffer, toRead, &num_read);
+            if (rc == 0 && num_read == 0) {
+                rc = RC(rcExe, rcFile, rcReading, rcTransfer, rcIncomplete);
+            }
+        }
+        if (rc != 0) {
+            /* drop the connection and try again on a new one */
+            RELEASE(KFile, *remote);
+            if (++attempt > SEG_RETRIES) {
+                PLOGERR(klogErr, (klogErr, rc,
+                    "cannot read $(path) at $(pos)",
+                    "path=%s,pos=%lu", self->remote->addr, pos));
+                break;
+            }
+            STSMSG(STS_DBG, ("retrying %s at %lu", self->remote->addr, pos));
+            rc = 0;
+            continue;
+        }
+
+        rc = _KFileWriteExactly(out, pos, buffer, num_read);
+        if (rc != 0) {
+            DISP_RC2(rc, "Cannot KFileWrite", self->part);
+            break;
+        }
+        pos += num_read;
+        attempt = 0;
+    }
+
+    return rc;
+}
+
+static rc_t CC SegmentsWorker(const KThread *t, void *data) {
+    Segments *self = data;
+    const KFile *remote = NULL;
+    KFile *out = NULL;
+    size_t bsize = 0;
+    void *buffer = NULL;
+    rc_t rc = 0;
+
+    assert(self && self->main);
+
+    bsize = self->main->bsize;
+    buffer = malloc(bsize);
+    if (buffer == NULL) {
+        rc = RC(rcExe, rcData, rcAllocating, rcMemory, rcExhausted);
+    }
+
+    if (rc == 0) {
+        rc = KDirectoryOpenFileWrite(self->main->dir, &out, true, self->part);
+        DISP_RC2(rc, "Cannot OpenFileWrite", self->part);
+    }
+
+    while (rc == 0) {
+        uint32_t idx = 0;
+
+        /* claim the next pending segment */
+        rc = KLockAcquire(self->lock);
+        if (rc != 0) {
+            break;
+        }
+        while (self->next < self->count
+            && self->done[self->next] == SEG_MAP_DONE)
+        {
+            ++self->next;
+        }
+        if (self->rc != 0 || self->next == self->count) {
+            KLockUnlock(self->lock);
+            break;
+        }
+        idx = self->next++;
+        KLockUnlock(self->lock);
+
+        rc = SegmentsFetch(self, idx, &remote, out, buffer, bsize);
+
+        if (rc == 0) {
+            rc = KLockAcquire(self->lock);
+            if (rc == 0) {
+                self->done[idx] = SEG_MAP_DONE;
+                rc = _KFileWriteExactly(self->map,
+                    self->hdrSz + idx, &self->done[idx], 1);
+                DISP_RC2(rc, "Cannot write map", self->part);
+                ++self->completed;
+                STSMSG(STS_FIN, ("%s: segment %u done (%u of %u)",
+                    self->part, idx, self->completed, self->count));
+                KLockUnlock(self->lock);
+            }
+        }
+    }
+
+    /* let the other workers stop early */
+    if (rc != 0 && KLockAcquire(self->lock) == 0) {
+        if (self->rc == 0) {
+            self->rc = rc;
+        }
+        KLockUnlock(self->lock);
+    }
+
+    RELEASE(KFile, out);
+    RELEASE(KFile, remote);
+    free(buffer);
+
+    return rc;
+}
+
+/* download to "part" if the object is large enough to be split,
+   otherwise leave "segmented" false for a plain download */
+static rc_t MainDownloadSegmented(Resolved *self,
+    Main *main, const char *part, bool *segmented)
+{
+    rc_t rc = 0;
+    uint64_t size = 0;
+    uint32_t i = 0;
+    uint32_t n = 0;
+    KThread **threads = NULL;
+    Segments segs;
+
+    assert(self && self->remote && main && segmented);
+
+    *segmented = false;
+
+    if (main->connections < 2 || main->segSize == 0) {
+        return 0;
+    }
+
+    if (self->file == NULL) {
+        rc = _KFileOpenRemote(&self->file, main->kns, self->remote->addr);
+        if (rc != 0) {
+            PLOGERR(klogInt, (klogInt, rc, "failed to open file for $(path)",
+                "path=%s", self->remote->addr));
+            return rc;
+        }
+    }
+
+    if (KFileSize(self->file, &size) != 0 || size < 2 * main->segSize) {
+        return 0;
+    }
+
+    *segmented = true;
+
+    rc = SegmentsInit(&segs, main, self->remote, part, size);
+
+    if (rc == 0 && segs.completed < segs.count) {
+        n = main->connections;
+        if (n > segs.count - segs.completed) {
+            n = segs.count - segs.completed;
+        }
+
+        threads = calloc(n, sizeof *threads);
+        if (threads == NULL) {
+            rc = RC(rcExe, rcData, rcAllocating, rcMemory, rcExhausted);
+        }
+    }
+
+    if (rc == 0 && n > 0) {
+        STSMSG(STS_INFO, ("%s -> %s: %u segments over %u connections",
+            self->remote->addr, part, segs.count - segs.completed, n));
+
+        for (i = 0; i < n; ++i) {
+            rc = KThreadMake(&threads[i], SegmentsWorker, &segs);
+            if (rc != 0) {
+                DISP_RC(rc, "KThreadMake");
+                break;
+            }
+        }
+
+        /* with at least one worker the download can still complete */
+        if (i > 0) {
+            rc = 0;
+        }
+
+        n = i;
+        for (i = 0; i < n; ++i) {
+            rc_t status = 0;
+            rc_t rc2 = KThreadWait(threads[i], &status);
+            if (rc2 == 0) {
+                rc2 = status;
+            }
+            if (rc == 0 && rc2 != 0) {
+                rc = rc2;
+            }
+            RELEASE(KThread, threads[i]);
+        }
+    }
+
+    if (rc == 0 && segs.completed != segs.count) {
+        rc = RC(rcExe, rcFile, rcCopying, rcTransfer, rcIncomplete);
+        PLOGERR(klogErr, (klogErr, rc, "$(path): $(n) of $(count) "
+            "segments downloaded", "path=%s,n=%u,count=%u",
+            part, segs.completed, segs.count));
+    }
+
+    if (rc == 0) {
+        STSMSG(STS_INFO, ("%s (%lu)", part, size));
+    }
+
+    {
+        rc_t rc2 = SegmentsFini(&segs);
+        if (rc == 0 && rc2 != 0) {
+            rc = rc2;
+        }
+    }
+
+    return rc;
+}
+
 /*  http://ftp-trace.ncbi.nlm.nih.gov/sra/sra-instant/reads/ByR.../SRR125365.sra
 anonftp@ftp-private.ncbi.nlm.nih.gov:/sra/sra-instant/reads/ByR.../SRR125365.sra
 */
@@ -1029,6 +1512,8 @@ static rc_t MainDownload(Resolved *self, Main *main) {
 
     char tmp[PATH_MAX] = "";
     char lock[PATH_MAX] = "";
+    char part[PATH_MAX] = "";
+    bool segmented = false;
 
     assert(self
         && self->cache && self->cache->size && self->cache->addr && main);
@@ -1048,6 +1533,10 @@ static rc_t MainDownload(Resolved *self, Main *main) {
         rc = _KDirectoryMkTmpName(main->dir, self->cache, tmp, sizeof tmp);
     }
 
+    if (rc == 0) {
+        rc = _KDirectoryMkPartName(main->dir, self->cache, part, sizeof part);
+    }
+
     if (KDirectoryPathType(main->dir, lock) != kptNotFound) {
         if (main->force != eForceYES) {
             KTime_t date = 0;
@@ -1127,6 +1616,9 @@ static rc_t MainDownload(Resolved *self, Main *main) {
                     self->accession, &vremote, &self->remote, &self->cache);
             }
             if (rc == 0) {
+                rc = MainDownloadSegmented(self, main, part, &segmented);
+            }
+            if (rc == 0 && !segmented) {
                 rc = MainDownloadFile(self, main, tmp);
             }
             RELEASE(VPath, vremote);
@@ -1136,14 +1628,20 @@ static rc_t MainDownload(Resolved *self, Main *main) {
     RELEASE(KFile, flock);
 
     if (rc == 0) {
-        STSMSG(STS_DBG, ("renaming %s -> %s", tmp, self->cache->addr));
-        rc = KDirectoryRename(main->dir, true, tmp, self->cache->addr);
+        const char *from = segmented ? part : tmp;
+        STSMSG(STS_DBG, ("renaming %s -> %s", from, self->cache->addr));
+        rc = KDirectoryRename(main->dir, true, from, self->cache->addr);
         if (rc != 0) {
             PLOGERR(klogInt, (klogInt, rc, "cannot rename $(from) to $(to)",
-                "from=%s,to=%s", tmp, self->cache->addr));
+                "from=%s,to=%s", from, self->cache->addr));
         }
     }
 
+    /* a partial download is kept for resuming unless it is not needed */
+    if (rc == 0) {
+        rc = _KDirectoryCleanPart(main->dir, part);
+    }
+
     if (rc == 0) {
         rc = MainDownloaded(main, self->cache->addr);
     }
@@ -1427,13 +1925,12 @@ static rc_t _ItemResolveResolved(VResolver *resolver,
 
 /* Resolved: resolve locations */
 static rc_t ItemInitResolved(Item *self, VResolver *resolver,
-    KDirectory *dir, bool ascp, const KRepositoryMgr *repoMgr,
+    KDirectory *dir, VRemoteProtocols protocols, const KRepositoryMgr *repoMgr,
     const KConfig *cfg, const VFSManager *vfs, KNSManager *kns, size_t minSize, size_t maxSize)
 {
     Resolved *resolved = NULL;
     rc_t rc = 0;
     KPathType type = kptNotFound;
-    VRemoteProtocols protocols = ascp ? eProtocolFaspHttp : eProtocolHttp;
 
     assert(self);
 
@@ -1508,7 +2005,7 @@ static rc_t ItemResolve(Item *item, int32_t row) {
     Resolved *self = NULL;
     static int n = 0;
     rc_t rc = 0;
-    bool ascp = false;
+    VRemoteProtocols protocols = eProtocolHttp;
 
     assert(item && item->main);
 
@@ -1522,12 +2019,11 @@ static rc_t ItemResolve(Item *item, int32_t row) {
 
     item->number = n;
 
-    ascp = MainUseAscp(item->main);
-    if (self->type == eRunTypeList) {
-        ascp = false;
+    if (self->type != eRunTypeList) {
+        protocols = MainProtocols(item->main);
     }
 
-    rc = ItemInitResolved(item, item->main->resolver, item->main->dir, ascp,
+    rc = ItemInitResolved(item, item->main->resolver, item->main->dir, protocols,
         item->main->repoMgr, item->main->cfg, item->main->vfsMgr,
         item->main->kns, item->main->minSize, item->main->maxSize);
 
@@ -1979,6 +2475,14 @@ static const char* TRANS_USAGE[] = { "transport: one of: ascp; http; both.",
     "use http if cannot download by ascp).",
     "Default: both", NULL };
 
+#define DEFAULT_CONNECTIONS 4
+#define CONN_OPTION "connections"
+#define CONN_ALIAS  "C"
+static const char* CONN_USAGE[] = {
+    "number of HTTP connections used to download a large object",
+    "in segments that survive an interrupted download",
+    "(1: single connection, no resume), default: 4", NULL };
+
 #define DEFAULT_MAX_FILE_SIZE "20G"
 #define SIZE_OPTION "max-size"
 #define SIZE_ALIAS  "X"
@@ -2005,6 +2509,7 @@ static OptDef Options[] = {
    ,{ ORDR_OPTION     , ORDR_ALIAS     , NULL, ORDR_USAGE  , 1, true ,false }
    ,{ ASCP_OPTION     , ASCP_ALIAS     , NULL, ASCP_USAGE  , 1, true ,false }
    ,{ HBEAT_OPTION    , HBEAT_ALIAS    , NULL, HBEAT_USAGE , 1, true, false }
+   ,{ CONN_OPTION     , CONN_ALIAS     , NULL, CONN_USAGE  , 1, true, false }
    ,{ FAIL_ASCP_OPTION, FAIL_ASCP_ALIAS, NULL, FAIL_ASCP_USAGE, 1, false, false}
 #ifdef _DEBUGGING
    ,{ TEXTKART_OPTION , NULL           , NULL, TEXTKART_USAGE , 1, true , false}
@@ -2184,6 +2689,30 @@ static rc_t MainProcessArgs(Main *self, int argc, char *argv[]) {
             self->heartbeat = (uint64_t)f;
         }
 
+/* CONN_OPTION */
+        rc = ArgsOptionCount(self->args, CONN_OPTION, &pcount);
+        if (rc != 0) {
+            LOGERR(klogErr, rc, "Failure to get '" CONN_OPTION "' argument");
+            break;
+        }
+
+        if (pcount > 0) {
+            const char *val = NULL;
+            rc = ArgsOptionValue(self->args, CONN_OPTION, 0, &val);
+            if (rc != 0) {
+                LOGERR(klogErr, rc,
+                    "Failure to get '" CONN_OPTION "' argument value");
+                break;
+            }
+            self->connections = atoi(val);
+            if (self->connections == 0) {
+                rc = RC(rcExe, rcArgv, rcParsing, rcParam, rcInvalid);
+                LOGERR(klogErr, rc,
+                    "Unrecognized '" CONN_OPTION "' argument value");
+                break;
+            }
+        }
+
 /* ORDR_OPTION */
         rc = ArgsOptionCount(self->args, ORDR_OPTION, &pcount);
         if (rc != 0) {
@@ -2372,6 +2901,9 @@ rc_t CC Usage(const Args *args) {
             if (strcmp(Options[i].aliases, ASCP_ALIAS) == 0) {
                 param = "ascp-binary|private-key-file";
             }
+            else if (strcmp(Options[i].aliases, CONN_ALIAS) == 0) {
+                param = "count";
+            }
             else if (strcmp(Options[i].aliases, FORCE_ALIAS) == 0 ||
                 strcmp(Options[i].aliases, HBEAT_ALIAS) == 0 ||
                 strcmp(Options[i].aliases, HBEAT_ALIAS) == 0 ||
@@ -2490,6 +3022,9 @@ static rc_t MainInit(int argc, char *argv[], Main *self) {
     self->heartbeat = 60000;
 /*  self->heartbeat = 69; */
 
+    self->connections = DEFAULT_CONNECTIONS;
+    self->segSize = 32 * 1024 * 1024;
+
     BSTreeInit(&self->downloaded);
 
     if (rc == 0) {
@@ -2742,6 +3277,36 @@ static rc_t MainRun(Main *self, const char *arg, const char *realArg) {
     return rc;
 }
 
+/* resolve all command line accessions in a few requests
+   before they are downloaded one by one */
+static void MainQueryBatch(Main *self, uint32_t pcount) {
+    uint32_t i = 0;
+    VNamelist *list = NULL;
+    rc_t rc = VNamelistMake(&list, pcount);
+    DISP_RC(rc, "VNamelistMake");
+
+    for (i = 0; rc == 0 && i < pcount; ++i) {
+        const char *obj = NULL;
+        rc = ArgsParamValue(self->args, i, &obj);
+        if (rc == 0) {
+            rc = VNamelistAppend(list, obj);
+        }
+    }
+
+    if (rc == 0) {
+        KNamelist *names = NULL;
+        rc = VNamelistToNamelist(list, &names);
+        if (rc == 0) {
+            rc = VResolverQueryBatch(self->resolver,
+                MainProtocols(self), names);
+            DISP_RC(rc, "VResolverQueryBatch");
+        }
+        RELEASE(KNamelist, names);
+    }
+
+    RELEASE(VNamelist, list);
+}
+
 /*********** Main **********/
 rc_t CC KMain(int argc, char *argv[]) {
     rc_t rc = 0;
@@ -2769,6 +3334,10 @@ rc_t CC KMain(int argc, char *argv[]) {
         }
 #endif
 
+        if (pcount > 1) {
+            MainQueryBatch(&pars, pcount);
+        }
+
         for (i = 0; i < pcount; ++i) {
             const char *obj = NULL;
             rc_t rc2 = ArgsParamValue(pars.args, i, &obj);
@@ -35,12 +35,18 @@
 #include <vdb/report.h>
 #include <vdb/database.h>
 #include <klib/container.h>
+#include <klib/namelist.h>
 #include <klib/log.h>
 #include <klib/out.h>
 #include <klib/status.h>
 #include <klib/text.h>
 #include <kapp/main.h>
 #include <kfs/directory.h>
+#include <vfs/manager.h> /* VFSManagerGetResolver */
+#include <vfs/resolver.h> /* VResolverQueryBatch */
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
 #include <sra/sradb-priv.h>
 #include <sra/types.h>
 #include <os-native.h>
@@ -132,10 +138,9 @@ static rc_t MaxNReadsValidator_Release( const SRASplitter* cself )
     {
         rc = RC( rcSRA, rcNode, rcExecuting, rcParam, rcNull );
     }
-    else if ( !g_legacy_report )
+    else
     {
-        if ( self->rejected_spots > 0 )
-            rc = KOutMsg( "Rejected %lu SPOTS because of to many READS\n", self->rejected_spots );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu SPOTS because of to many READS\n", 0, self->rejected_spots );
     }
     return rc;
 }
@@ -502,10 +507,9 @@ static rc_t SpotGroupSplitter_Release( const SRASplitter* cself )
     {
         rc = RC( rcSRA, rcNode, rcExecuting, rcParam, rcNull );
     }
-    else if ( !g_legacy_report )
+    else
     {
-        if ( self->rejected_spots > 0 )
-            rc = KOutMsg( "Rejected %lu SPOTS because of spotgroup filtering\n", self->rejected_spots );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu SPOTS because of spotgroup filtering\n", 0, self->rejected_spots );
     }
     return rc;
 }
@@ -614,19 +618,92 @@ static rc_t SpotGroupSplitterFactory_Make( const SRASplitterFactory** cself,
 /* ### Common dumper code ##################################################### */
 
 
-static rc_t SRADumper_DumpRun( const SRATable* table,
-        spotid_t minSpotId, spotid_t maxSpotId, const SRASplitterFactory* factories, uint64_t * num_spots )
+typedef struct SRADumperFilters_struct
 {
-    rc_t rc = 0, rcr = 0;
+    bool spot_group_on;     /* split by spot group */
+    bool spot_group_use;    /* split or filter by spot group */
+    char* const* spot_group;
+    bool read_filter_on;
+    SRAReadFilter read_filter;
+} SRADumperFilters;
+
+
+/* chains formatter factories after the core filters, fmt->table is used */
+static rc_t SRADumper_MakeFactories( const SRADumperFmt* fmt, const SRADumperFilters* filters,
+                                     const SRASplitterFactory** fact_head )
+{
+    rc_t rc = fmt->get_factory( fmt, fact_head );
+    if ( rc == 0 && *fact_head == NULL )
+    {
+        rc = RC( rcExe, rcFormatter, rcResolving, rcInterface, rcNull );
+    }
+
+    if ( rc == 0 && filters->spot_group_use )
+    {
+        const SRASplitterFactory* f = NULL;
+        rc = SpotGroupSplitterFactory_Make( &f, fmt->table, filters->spot_group_on, filters->spot_group );
+        if ( rc == 0 )
+        {
+            rc = SRASplitterFactory_AddNext( f, *fact_head );
+            if ( rc == 0 )
+            {
+                *fact_head = f;
+            }
+            else
+            {
+                SRASplitterFactory_Release( f );
+            }
+        }
+    }
+
+    if ( rc == 0 && filters->read_filter_on )
+    {
+        const SRASplitterFactory* f = NULL;
+        rc = ReadFilterSplitterFactory_Make( &f, fmt->table, filters->read_filter );
+        if ( rc == 0 )
+        {
+            rc = SRASplitterFactory_AddNext( f, *fact_head );
+            if ( rc == 0 )
+            {
+                *fact_head = f;
+            }
+            else
+            {
+                SRASplitterFactory_Release( f );
+            }
+        }
+    }
+
+    if ( rc == 0 )
+    {
+        /* this filter takes over head of chain to be first and kill off bad NREADS */
+        const SRASplitterFactory* f = NULL;
+        rc = MaxNReadsValidatorFactory_Make( &f, fmt->table );
+        if ( rc == 0 )
+        {
+            rc = SRASplitterFactory_AddNext( f, *fact_head );
+            if ( rc == 0 )
+            {
+                *fact_head = f;
+            }
+            else
+            {
+                SRASplitterFactory_Release( f );
+            }
+        }
+    }
+    return rc;
+}
+
+
+static rc_t SRADumper_DumpSpots( const SRASplitter* root_splitter,
+        spotid_t minSpotId, spotid_t maxSpotId, uint64_t * num_spots )
+{
+    rc_t rc = 0;
     spotid_t spot = 0;
 
     /* !!! make_readmask is a MACRO defined in factory.h !!! */
     make_readmask( readmask );
-    const SRASplitter* root_splitter = NULL;
-
-    if ( num_spots != NULL ) *num_spots = 0;
-
-    rc = SRASplitterFactory_NewObj( factories, &root_splitter );
 
     for ( spot = minSpotId; rc == 0 && spot <= maxSpotId; spot++ )
     {
@@ -650,12 +727,276 @@ static rc_t SRADumper_DumpRun( const SRATable* table,
             }
         }
     }
+    return rc;
+}
+
+
+static rc_t SRADumper_DumpRun( const SRATable* table,
+        spotid_t minSpotId, spotid_t maxSpotId, const SRASplitterFactory* factories, uint64_t * num_spots )
+{
+    rc_t rc = 0, rcr = 0;
+    const SRASplitter* root_splitter = NULL;
+
+    if ( num_spots != NULL ) *num_spots = 0;
+
+    rc = SRASplitterFactory_NewObj( factories, &root_splitter );
+    if ( rc == 0 )
+    {
+        rc = SRADumper_DumpSpots( root_splitter, minSpotId, maxSpotId, num_spots );
+    }
     rcr = SRASplitter_Release( root_splitter );
 
     return rc ? rc : rcr;
 }
 
 
+/* ### Multi-threaded dump ##################################################### */
+
+/* spot id range is cut into chunks handed out to workers round robin,
+   output of a chunk is held in memory until all chunks before it are written */
+#define DUMP_CHUNK_SPOTS ( 16 * 1024 )
+
+typedef struct SRADumperThreads_struct SRADumperThreads;
+
+typedef struct SRADumperWorker_struct
+{
+    SRADumperThreads* pool;
+    uint32_t idx;
+    const SRATable* table;  /* own table for own cursors */
+    const SRASplitterFactory* factories;
+    SRASplitterCapture* capture;
+    KThread* thread;
+    /* guarded by pool lock: chunk is captured and waits to be written */
+    bool ready;
+    bool finished;
+    rc_t rc;
+    uint64_t spots;
+} SRADumperWorker;
+
+struct SRADumperThreads_struct
+{
+    KLock* lock;
+    KCondition* cond;
+    spotid_t minSpotId;
+    spotid_t maxSpotId;
+    bool quit;
+    uint32_t qty;
+    SRADumperWorker* worker;
+};
+
+
+static rc_t CC SRADumper_Worker( const KThread* t, void* data )
+{
+    SRADumperWorker* self = data;
+    SRADumperThreads* pool = self->pool;
+    const SRASplitter* root_splitter = NULL;
+    uint64_t first = ( uint64_t )pool->minSpotId + ( uint64_t )self->idx * DUMP_CHUNK_SPOTS;
+    bool quit = false;
+
+    rc_t rc = SRASplitterFactory_NewObj( self->factories, &root_splitter );
+
+    for ( ; !quit && first <= pool->maxSpotId; first += ( uint64_t )pool->qty * DUMP_CHUNK_SPOTS )
+    {
+        uint64_t last = first + DUMP_CHUNK_SPOTS - 1;
+        uint64_t spots = 0;
+
+        if ( last > pool->maxSpotId )
+        {
+            last = pool->maxSpotId;
+        }
+        if ( rc == 0 )
+        {
+            rc = SRADumper_DumpSpots( root_splitter, ( spotid_t )first, ( spotid_t )last, &spots );
+        }
+
+        /* hand chunk over and wait until it is written */
+        KLockAcquire( pool->lock );
+        self->rc = rc;
+        self->spots = spots;
+        self->ready = true;
+        KConditionBroadcast( pool->cond );
+        while ( self->ready && !pool->quit )
+        {
+            KConditionWait( pool->cond, pool->lock );
+        }
+        quit = pool->quit || rc != 0;
+        KLockUnlock( pool->lock );
+    }
+    SRASplitter_Release( root_splitter );
+
+    KLockAcquire( pool->lock );
+    self->finished = true;
+    KConditionBroadcast( pool->cond );
+    KLockUnlock( pool->lock );
+
+    return rc;
+}
+
+
+static rc_t SRADumper_ThreadsWhack( SRADumperThreads* self, const SRATable* table )
+{
+    rc_t rc = 0;
+    uint32_t i;
+
+    if ( self->worker != NULL )
+    {
+        if ( self->lock != NULL )
+        {
+            KLockAcquire( self->lock );
+            self->quit = true;
+            KConditionBroadcast( self->cond );
+            KLockUnlock( self->lock );
+        }
+        for ( i = 0; i < self->qty; i++ )
+        {
+            SRADumperWorker* w = &self->worker[ i ];
+            if ( w->thread != NULL )
+            {
+                rc_t status = 0;
+                rc_t rc2 = KThreadWait( w->thread, &status );
+                if ( rc == 0 )
+                {
+                    rc = rc2 ? rc2 : status;
+                }
+                KThreadRelease( w->thread );
+            }
+            SRASplitterFactory_Release( w->factories );
+            SRASplitterCapture_Release( w->capture );
+            if ( w->table != table )
+            {
+                SRATableRelease( w->table );
+            }
+        }
+        free( self->worker );
+    }
+    KConditionRelease( self->cond );
+    KLockRelease( self->lock );
+    return rc;
+}
+
+
+/* dump spot id range using threads workers, each with a table of its own,
+   fmt->table and factories of the first worker are borrowed from caller */
+static rc_t SRADumper_DumpRunThreads( const SRADumperFmt* fmt, const SRADumperFilters* filters,
+        const SRAMgr* mgr, const char* path, const char* alt_table, uint32_t threads,
+        spotid_t minSpotId, spotid_t maxSpotId, const SRASplitterFactory* factories, uint64_t * num_spots )
+{
+    rc_t rc = 0;
+    uint32_t i;
+    uint64_t first;
+    SRADumperThreads pool;
+
+    *num_spots = 0;
+    memset( &pool, 0, sizeof pool );
+    pool.minSpotId = minSpotId;
+    pool.maxSpotId = maxSpotId;
+    pool.qty = threads;
+    pool.worker = calloc( threads, sizeof pool.worker[ 0 ] );
+    if ( pool.worker == NULL )
+    {
+        return RC( rcExe, rcThread, rcConstructing, rcMemory, rcExhausted );
+    }
+    rc = KLockMake( &pool.lock );
+    if ( rc == 0 )
+    {
+        rc = KConditionMake( &pool.cond );
+    }
+
+    /* all chains are made before any worker starts, formatters keep some state in globals */
+    for ( i = 0; rc == 0 && i < threads; i++ )
+    {
+        SRADumperWorker* w = &pool.worker[ i ];
+        w->pool = &pool;
+        w->idx = i;
+        if ( i == 0 )
+        {
+            w->table = fmt->table;
+            w->factories = factories;
+        }
+        else
+        {
+            SRADumperFmt wfmt = *fmt;
+            if ( alt_table != NULL )
+            {
+                rc = SRAMgrOpenAltTableRead( mgr, &w->table, alt_table, path );
+            }
+            else
+            {
+                rc = SRAMgrOpenTableRead( mgr, &w->table, path );
+            }
+            if ( rc == 0 )
+            {
+                wfmt.table = w->table;
+                rc = SRADumper_MakeFactories( &wfmt, filters, &w->factories );
+                if ( rc == 0 )
+                {
+                    rc = SRASplitterFactory_Init( w->factories );
+                }
+            }
+        }
+        if ( rc == 0 )
+        {
+            rc = SRASplitterCapture_Make( &w->capture );
+            if ( rc == 0 )
+            {
+                rc = SRASplitterFactory_SetCapture( w->factories, w->capture );
+            }
+        }
+    }
+
+    for ( i = 0; rc == 0 && i < threads; i++ )
+    {
+        rc = KThreadMake( &pool.worker[ i ].thread, SRADumper_Worker, &pool.worker[ i ] );
+    }
+
+    /* write chunks out in spot order */
+    for ( i = 0, first = minSpotId; rc == 0 && first <= maxSpotId; first += DUMP_CHUNK_SPOTS, i = ( i + 1 ) % threads )
+    {
+        SRADumperWorker* w = &pool.worker[ i ];
+        bool ready;
+        uint64_t spots;
+
+        rc = KLockAcquire( pool.lock );
+        if ( rc != 0 )
+        {
+            break;
+        }
+        while ( !w->ready && !w->finished )
+        {
+            KConditionWait( pool.cond, pool.lock );
+        }
+        ready = w->ready;
+        spots = w->spots;
+        rc = w->rc;
+        KLockUnlock( pool.lock );
+
+        if ( ready )
+        {
+            /* spots done before a failure are written out too, as they would be without threads */
+            rc_t rc2 = SRASplitterCapture_Flush( w->capture );
+            *num_spots += spots;
+            rc = rc ? rc : rc2;
+        }
+        else if ( rc == 0 )
+        {
+            rc = RC( rcExe, rcThread, rcExecuting, rcThread, rcDone );
+        }
+
+        KLockAcquire( pool.lock );
+        w->ready = false;
+        KConditionBroadcast( pool.cond );
+        KLockUnlock( pool.lock );
+    }
+
+    /* first worker's factories belong to caller */
+    pool.worker[ 0 ].factories = NULL;
+    {
+        rc_t rc2 = SRADumper_ThreadsWhack( &pool, fmt->table );
+        return rc ? rc : rc2;
+    }
+}
+
+
 static const SRADumperFmt_Arg KMainArgs[] =
 {
     { NULL, "no-user-settings",  NULL,         { "Internal Only", NULL } },
@@ -675,6 +1016,7 @@ static const SRADumperFmt_Arg KMainArgs[] =
     { NULL, "table",            "table-name",   { "Table name within cSRA object, default is \"SEQUENCE\"", NULL } },
 
     { NULL, "disable-multithreading", NULL,     { "disable multithreading", NULL } },
+    { NULL, "threads",          "count",        { "Number of threads formatting spots, output stays in spot order", NULL } },
 
     { "h",   "help",             NULL,          { "Output a brief explanation of program usage", NULL } },
     { "V",   "version",          NULL,          { "Display the version of the program", NULL } },
@@ -954,6 +1296,45 @@ static bool database_contains_table_name( const VDBManager * vmgr, const char *
 }
 
 
+/* resolve all accessions on the command line in a few requests
+   before they are dumped one by one; failures are left to the dump itself */
+static void query_batch( const char * const * table_path, int table_path_qty )
+{
+    VNamelist * list;
+    rc_t rc = VNamelistMake( &list, table_path_qty );
+    if ( rc == 0 )
+    {
+        int i;
+        for ( i = 0; rc == 0 && i < table_path_qty; i++ )
+        {
+            rc = VNamelistAppend( list, table_path[ i ] );
+        }
+        if ( rc == 0 )
+        {
+            VFSManager * vfs;
+            rc = VFSManagerMake( &vfs );
+            if ( rc == 0 )
+            {
+                VResolver * resolver;
+                rc = VFSManagerGetResolver( vfs, &resolver );
+                if ( rc == 0 )
+                {
+                    KNamelist * names;
+                    rc = VNamelistToNamelist( list, &names );
+                    if ( rc == 0 )
+                    {
+                        VResolverQueryBatch( resolver, eProtocolHttp, names );
+                        KNamelistRelease( names );
+                    }
+                    VResolverRelease( resolver );
+                }
+                VFSManagerRelease( vfs );
+            }
+        }
+        VNamelistRelease( list );
+    }
+}
+
 static const char * consensus_table_name = "CONSENSUS";
 
 /*******************************************************************************
@@ -988,10 +1369,12 @@ rc_t CC KMain ( int argc, char* argv[] )
     
     bool spot_group_on = false;
     bool no_mt = false;
+    uint32_t threads = 1;
     int spot_groups = 0;
     char* spot_group[128] = {NULL};
     bool read_filter_on = false;
     SRAReadFilter read_filter = 0xFF;
+    SRADumperFilters filters;
 
     /* for the fasta-ouput of fastq-dump: branch out completely of 'common' code */
     if ( fasta_dump_requested( argc, argv ) )
@@ -1070,6 +1453,10 @@ rc_t CC KMain ( int argc, char* argv[] )
         {
             no_mt = true;
         }
+        else if ( SRADumper_GetArg( &fmt, NULL, "threads", &i, argc, argv, &arg ) )
+        {
+            threads = AsciiToU32( arg, NULL, NULL );
+        }
         else if ( SRADumper_GetArg( &fmt, NULL, OPTION_REPORT, &i, argc, argv, &arg ) )
         {
         }
@@ -1261,6 +1648,16 @@ rc_t CC KMain ( int argc, char* argv[] )
         CoreUsage( argv[ 0 ], &fmt, false, EXIT_FAILURE );
     }
 
+    if ( threads == 0 || no_mt )
+    {
+        threads = 1;
+    }
+    else if ( threads > 1 && !fmt.threads_ok )
+    {
+        LOGMSG( klogWarn, "threads are not supported by this formatter, ignored" );
+        threads = 1;
+    }
+
     if ( minSpotId > maxSpotId )
     {
         spotid_t temp = maxSpotId;
@@ -1300,6 +1697,11 @@ rc_t CC KMain ( int argc, char* argv[] )
         }
     }
 
+    if ( table_path_qty > 1 )
+    {
+        query_batch( table_path, table_path_qty );
+    }
+
     rc = SRAMgrMakeRead( &sraMGR ); /* !!! in libsra !!! */
     if ( rc != 0 )
     {
@@ -1337,10 +1739,17 @@ rc_t CC KMain ( int argc, char* argv[] )
     }
 
 
+    filters.spot_group_on = spot_group_on;
+    filters.spot_group_use = spot_group_on || spot_groups > 0;
+    filters.spot_group = spot_group;
+    filters.read_filter_on = read_filter_on;
+    filters.read_filter = read_filter;
+
     /* loop tables */
     for ( i = 0; i < table_path_qty; i++ )
     {
         const SRASplitterFactory* fact_head = NULL;
+        const char * alt_table = NULL;
         spotid_t smax, smin;
         int path_type;
 
@@ -1384,6 +1793,7 @@ rc_t CC KMain ( int argc, char* argv[] )
                         table_path[ i ], table_to_open ) );
                     continue;
                 }
+                alt_table = table_to_open;
             }
 
         }
@@ -1559,71 +1969,11 @@ rc_t CC KMain ( int argc, char* argv[] )
             }
 
             /* table dependent */
-            rc = fmt.get_factory( &fmt, &fact_head );
+            rc = SRADumper_MakeFactories( &fmt, &filters, &fact_head );
             if ( rc != 0 )
             {
                 break;
             }
-            if ( fact_head == NULL )
-            {
-                rc = RC( rcExe, rcFormatter, rcResolving, rcInterface, rcNull );
-                break;
-            }
-
-            if ( rc == 0 && ( spot_group_on || spot_groups > 0 ) )
-            {
-                const SRASplitterFactory* f = NULL;
-                rc = SpotGroupSplitterFactory_Make( &f, fmt.table, spot_group_on, spot_group );
-                if ( rc == 0 )
-                {
-                    rc = SRASplitterFactory_AddNext( f, fact_head );
-                    if ( rc == 0 )
-                    {
-                        fact_head = f;
-                    }
-                    else
-                    {
-                        SRASplitterFactory_Release( f );
-                    }
-                }
-            }
-
-            if ( rc == 0 && read_filter_on )
-            {
-                const SRASplitterFactory* f = NULL;
-                rc = ReadFilterSplitterFactory_Make( &f, fmt.table, read_filter );
-                if ( rc == 0 )
-                {
-                    rc = SRASplitterFactory_AddNext( f, fact_head );
-                    if ( rc == 0 )
-                    {
-                        fact_head = f;
-                    }
-                    else
-                    {
-                        SRASplitterFactory_Release( f );
-                    }
-                }
-            }
-
-            if ( rc == 0 )
-            {
-                /* this filter takes over head of chain to be first and kill off bad NREADS */
-                const SRASplitterFactory* f = NULL;
-                rc = MaxNReadsValidatorFactory_Make( &f, fmt.table );
-                if ( rc == 0 )
-                {
-                    rc = SRASplitterFactory_AddNext( f, fact_head );
-                    if ( rc == 0 )
-                    {
-                        fact_head = f;
-                    }
-                    else
-                    {
-                        SRASplitterFactory_Release( f );
-                    }
-                }
-            }
 
             rc = SRASplitterFactory_Init( fact_head );
             if ( rc == 0 )
@@ -1631,8 +1981,21 @@ rc_t CC KMain ( int argc, char* argv[] )
                 uint64_t spots_read;
 
                 /* ********************************************************** */
-                rc = SRADumper_DumpRun( fmt.table, smin, smax, fact_head, &spots_read );
+                if ( threads > 1 && smax - smin >= DUMP_CHUNK_SPOTS )
+                {
+                    rc = SRADumper_DumpRunThreads( &fmt, &filters, sraMGR, table_path[ i ], alt_table, threads,
+                                                   smin, smax, fact_head, &spots_read );
+                }
+                else
+                {
+                    rc = SRADumper_DumpRun( fmt.table, smin, smax, fact_head, &spots_read );
+                }
                 /* ********************************************************** */
+                {
+                    /* all splitters are released here, threads included */
+                    rc_t rc2 = SRASplitterFactory_FilerRejects();
+                    rc = rc ? rc : rc2;
+                }
                 if ( rc == 0 )
                 { 
                     uint64_t spots_written = 0, file = 0;
@@ -63,6 +63,10 @@ struct SRADumperFmt
     /* mandatory return head of factories implemented in module, factories released by caller! */
     rc_t (*get_factory)(const SRADumperFmt* fmt, const SRASplitterFactory** factory);
 
+    /* optional - set if factories may be made more than once per table and splitters from
+       each of them run on their own thread, output is reassembled in spot order by the core */
+    bool threads_ok;
+
     /* set by parent code, do not change!!! */
     const char* accession;
     const SRATable* table;
@@ -63,8 +63,23 @@ typedef struct SRASplitterFile_struct {
     /* keep track of number of spots written to file */
     spotid_t curr_spot;
     uint64_t spot_qty;
+    /* captured output: data, path keys it was written under and file it goes to */
+    char* data;
+    size_t data_sz;
+    size_t data_max;
+    char* path;
+    int path_qty;
+    struct SRASplitterFile_struct* real;
 } SRASplitterFile;
 
+/* count of spots or reads a filter dropped, one per report message */
+typedef struct SRASplitterReject_struct {
+    SLNode dad;
+    const char* report;
+    uint32_t arg;
+    uint64_t qty;
+} SRASplitterReject;
+
 typedef struct SRASplitterFiler_struct {
     /* TBD - reorder structure to avoid premature ageing of compiler and CPU */
     char* prefix;
@@ -89,6 +104,10 @@ typedef struct SRASplitterFiler_struct {
     /* keep track of number of spots written to file */
     spotid_t curr_spot;
     uint64_t spot_qty;
+    /* output is kept in memory until SRASplitterCapture_Flush */
+    bool capture;
+    /* filter rejects in order of first report */
+    SLList rejects;
 } SRASplitterFiler;
 
 SRASplitterFiler* g_filer = NULL;
@@ -133,9 +152,49 @@ void CC SRASplitterFiler_StatFile( SLNode *node, void *data )
     }
 }
 
+static
+void CC SRASplitterFiler_WhackReject( SLNode *node, void *data )
+{
+    free(node);
+}
+
+static
+bool CC SRASplitterFiler_FindReject( SLNode *node, void *data )
+{
+    SRASplitterReject* r = (SRASplitterReject*)node;
+    SRASplitterReject** d = (SRASplitterReject**)data;
+
+    if( r->report == (*d)->report && r->arg == (*d)->arg ) {
+        *d = r;
+        return true;
+    }
+    return false;
+}
+
+static
+rc_t SRASplitterFiler_AddReject(SRASplitterFiler* self, const char* report, uint32_t arg, uint64_t qty)
+{
+    SRASplitterReject key, *r = &key;
+
+    key.report = report;
+    key.arg = arg;
+    if( !SLListDoUntil(&self->rejects, SRASplitterFiler_FindReject, &r) ) {
+        if( (r = malloc(sizeof(*r))) == NULL ) {
+            return RC(rcExe, rcNode, rcWriting, rcMemory, rcExhausted);
+        }
+        r->report = report;
+        r->arg = arg;
+        r->qty = 0;
+        SLListPushTail(&self->rejects, &r->dad);
+    }
+    r->qty += qty;
+    return 0;
+}
+
 void SRASplitterFiler_Release(void)
 {
     if( g_filer != NULL ) {
+        SLListWhack(&g_filer->rejects, SRASplitterFiler_WhackReject, NULL);
         SLListWhack(&g_filer->files, SRASplitterFiler_WhackFile, &g_filer->keep_empty);
         KFileRelease(g_filer->kf_stdout);
         KDirectoryRelease(g_filer->dir);
@@ -157,79 +216,148 @@ void SRASplitterFactory_FilerReport(uint64_t* total, uint64_t* biggest_file)
     }
 }
 
+rc_t SRASplitterFactory_FilerRejects(void)
+{
+    rc_t rc = 0;
+
+    if( g_filer != NULL ) {
+        SLNode* n;
+        for(n = SLListHead(&g_filer->rejects); n != NULL; n = SLNodeNext(n)) {
+            const SRASplitterReject* r = (const SRASplitterReject*)n;
+            if( r->qty > 0 && !g_legacy_report && rc == 0 ) {
+                rc = KOutMsg(r->report, r->qty, r->arg);
+            }
+        }
+        SLListWhack(&g_filer->rejects, SRASplitterFiler_WhackReject, NULL);
+    }
+    return rc;
+}
+
 static
-rc_t SRASplitterFiler_PushKey(const char* key)
+rc_t SRASplitterFiler_PushKey(SRASplitterFiler* self, const char* key)
 {
-    if( g_filer == NULL || key == NULL ) {
+    if( self == NULL || key == NULL ) {
         return RC(rcExe, rcFile, rcAttaching, rcParam, rcNull);
     }
-    if( g_filer->path_tail == sizeof(g_filer->path) - 1 ) {
+    if( self->path_tail == sizeof(self->path) / sizeof(self->path[0]) - 1 ) {
         return RC(rcExe, rcFile, rcAttaching, rcDirEntry, rcTooLong);
     }
-    if( g_filer->key_as_dir ) {
+    if( self->key_as_dir ) {
         /* skip initial non-letters */
         while( !isalnum(*key) && *key != '\0' ) {
             ++key;
         }
     }
-    g_filer->path[g_filer->path_tail++] = key;
-    g_filer->path_len += strlen(key) + 1;
+    self->path[self->path_tail++] = key;
+    self->path_len += strlen(key) + 1;
     return 0;
 }
 
 static
-rc_t SRASplitterFiler_PopKey(void)
+rc_t SRASplitterFiler_PopKey(SRASplitterFiler* self)
 {
-    if( g_filer->path_tail == 0 ) {
+    if( self->path_tail == 0 ) {
         return RC(rcExe, rcFile, rcDetaching, rcDirEntry, rcTooShort);
     }
-    g_filer->path_len -= strlen(g_filer->path[--g_filer->path_tail]) + 1;
+    self->path_len -= strlen(self->path[--self->path_tail]) + 1;
+    return 0;
+}
+
+static
+void CC SRASplitterFiler_WhackCapturedFile( SLNode *node, void *data )
+{
+    SRASplitterFile* file = (SRASplitterFile*)node;
+
+    free(file->key);
+    free(file->data);
+    free(file->path);
+    free(file);
+}
+
+static
+rc_t SRASplitterFiler_CapturePath(const SRASplitterFiler* self, SRASplitterFile* file)
+{
+    /* remember keys below prefix to find real file on flush */
+    int i;
+    char* p = malloc(self->path_len + 1);
+
+    if( p == NULL ) {
+        return RC(rcExe, rcFile, rcResolving, rcMemory, rcExhausted);
+    }
+    file->path = p;
+    file->path_qty = self->path_tail - 1;
+    for(i = 1; i < self->path_tail; i++ ) {
+        strcpy(p, self->path[i]);
+        p += strlen(p) + 1;
+    }
+    return 0;
+}
+
+static
+rc_t SRASplitterFiler_Capture(SRASplitterFile* file, const void* buf, size_t size)
+{
+    if( file->data_sz + size > file->data_max ) {
+        size_t sz = file->data_max ? file->data_max : OUTPUT_BUFFER_SIZE;
+        char* d;
+        while( sz < file->data_sz + size ) {
+            sz *= 2;
+        }
+        if( (d = realloc(file->data, sz)) == NULL ) {
+            return RC(rcExe, rcFile, rcWriting, rcMemory, rcExhausted);
+        }
+        file->data = d;
+        file->data_max = sz;
+    }
+    memcpy(&file->data[file->data_sz], buf, size);
+    file->data_sz += size;
     return 0;
 }
 
 static
-rc_t SRASplitterFiler_OpenFile(SRASplitterFile* file, bool initial)
+rc_t SRASplitterFiler_OpenFile(SRASplitterFiler* self, SRASplitterFile* file, bool initial)
 {
     rc_t rc = 0;
 
     if( file == NULL || (initial && file->file != NULL) ) {
         rc = RC(rcExe, rcFile, rcOpening, rcParam, rcInvalid);
+    } else if( self->capture ) {
+        /* captured output is kept in memory */
     } else if( initial || file->file == NULL ) {
         int i, vacancy = -1;
         time_t oldest = 0;
 
         for(i = 0; i < DUMPER_MAX_OPEN_FILES; i++) {
-            if(g_filer->open[i] == NULL ) {
+            if(self->open[i] == NULL ) {
                 vacancy = i;
                 break;
             }
-            if(g_filer->open[i]->opened < oldest || oldest == 0 ) {
-                oldest = g_filer->open[i]->opened;
+            if(self->open[i]->opened < oldest || oldest == 0 ) {
+                oldest = self->open[i]->opened;
                 vacancy = i;
             }
         }
-        if( g_filer->open[vacancy] != NULL ) {
+        if( self->open[vacancy] != NULL ) {
             SRA_DUMP_DBG(5, ("Close file[%i]: %lu '%s%s'\n", vacancy,
-                g_filer->open[vacancy]->opened, g_filer->open[vacancy]->key, g_filer->arc_extension));
-            KFileRelease(g_filer->open[vacancy]->file);
-            g_filer->open[vacancy]->file = NULL;
-            g_filer->open[vacancy] = NULL;
+                self->open[vacancy]->opened, self->open[vacancy]->key, self->arc_extension));
+            KFileRelease(self->open[vacancy]->file);
+            self->open[vacancy]->file = NULL;
+            self->open[vacancy] = NULL;
         }
-        if( g_filer->kf_stdout ) {
+        if( self->kf_stdout ) {
             SRA_DUMP_DBG(5, ("attach to pre-opened stdout: '%s'\n", file->key));
-            rc = KFileAddRef(g_filer->kf_stdout);
-            file->file = g_filer->kf_stdout;
+            rc = KFileAddRef(self->kf_stdout);
+            file->file = self->kf_stdout;
         } else if( initial ) {
-            SRA_DUMP_DBG(5, ("Create file: '%s%s'\n", file->key, g_filer->arc_extension));
+            SRA_DUMP_DBG(5, ("Create file: '%s%s'\n", file->key, self->arc_extension));
             if( (rc = KDirectoryCreateFile(file->dir, &file->file, false, 0664, kcmInit,
-                                           "%s%s", file->name, g_filer->arc_extension)) == 0 ) {
-                if( g_filer->do_gzip ) {
+                                           "%s%s", file->name, self->arc_extension)) == 0 ) {
+                if( self->do_gzip ) {
                     KFile* gz;
                     if( (rc = KFileMakeGzipForWrite(&gz, file->file)) == 0 ) {
                         KFileRelease(file->file);
                         file->file = gz;
                     }
-                } else if( g_filer->do_bzip2 ) {
+                } else if( self->do_bzip2 ) {
                     KFile* bz;
                     if( (rc = KFileMakeBzip2ForWrite(&bz, file->file)) == 0 ) {
                         KFileRelease(file->file);
@@ -238,23 +366,23 @@ rc_t SRASplitterFiler_OpenFile(SRASplitterFile* file, bool initial)
                 }
             }
         } else if( file->file == NULL ) {
-            SRA_DUMP_DBG(5, ("Reopen file: '%s%s'\n", file->key, g_filer->arc_extension));
+            SRA_DUMP_DBG(5, ("Reopen file: '%s%s'\n", file->key, self->arc_extension));
             /* position is rememebered since last time */
             if( (rc = KDirectoryOpenFileWrite(file->dir, &file->file, false,
-                                              "%s%s", file->name, g_filer->arc_extension)) == 0 ) {
+                                              "%s%s", file->name, self->arc_extension)) == 0 ) {
 #if ! SUPPORT_MULTI_SESSION_GZIP_FILES
-                if( g_filer->do_gzip || g_filer->do_bzip2 ) {
+                if( self->do_gzip || self->do_bzip2 ) {
                     /* compressed files cannot (currently) be re-opened until we support multi-session compression */
                     rc = RC(rcExe, rcFile, rcOpening, rcConstraint, rcViolated);
                 }
 #else
-                if( g_filer->do_gzip ) {
+                if( self->do_gzip ) {
                     KFile* gz;
                     if( (rc = KFileMakeGzipForAppend(&gz, file->file)) == 0 ) {
                         KFileRelease(file->file);
                         file->file = gz;
                     }
-                } else if( g_filer->do_bzip2 ) {
+                } else if( self->do_bzip2 ) {
                     KFile* bz;
                     if( (rc = KFileMakeBzip2ForWrite(&bz, file->file)) == 0 ) {
                         KFileRelease(file->file);
@@ -265,7 +393,7 @@ rc_t SRASplitterFiler_OpenFile(SRASplitterFile* file, bool initial)
             }
         }
 #if OUTPUT_BUFFER_SIZE
-        if( rc == 0 && !g_filer->kf_stdout ) {
+        if( rc == 0 && !self->kf_stdout ) {
             /* attach buffer */
             KFile *buf = NULL;
             if( (rc = KBufFileMakeWrite(&buf, file->file, false, OUTPUT_BUFFER_SIZE)) == 0 ) {
@@ -275,7 +403,7 @@ rc_t SRASplitterFiler_OpenFile(SRASplitterFile* file, bool initial)
 #if _DEBUGGING
                 /* we only want to see this in debug */
                 PLOGERR(klogErr, (klogErr, rc, "creating buffer for file '$(s)$(e)'",
-                    PLOG_2(PLOG_S(s),PLOG_S(e)), file->key, g_filer->arc_extension));
+                    PLOG_2(PLOG_S(s),PLOG_S(e)), file->key, self->arc_extension));
 #else
                 rc = 0;
 #endif
@@ -283,23 +411,28 @@ rc_t SRASplitterFiler_OpenFile(SRASplitterFile* file, bool initial)
         }
 #endif
         if( rc == 0 ) {
-            g_filer->open[vacancy] = file;
+            self->open[vacancy] = file;
             file->opened = time(NULL);
             SRA_DUMP_DBG(5, ("Opened file[%i]: %lu '%s%s'\n",
-                vacancy, file->opened, file->key, g_filer->arc_extension));
+                vacancy, file->opened, file->key, self->arc_extension));
         }
     }
     return rc;
 }
 
+typedef struct SRASplitterFiler_FindData_struct {
+    const char* key;
+    SRASplitterFile* file;
+} SRASplitterFiler_FindData;
+
 static
 bool CC SRASplitterFiler_GetCurrFile_FindByKey( SLNode *node, void *data )
 {
-    SRASplitterFile** d = (SRASplitterFile**)data;
+    SRASplitterFiler_FindData* d = (SRASplitterFiler_FindData*)data;
     SRASplitterFile* file = (SRASplitterFile*)node;
 
-    if( strcmp(file->key, g_filer->key_buf) == 0 ) {
-        *d = file;
+    if( strcmp(file->key, d->key) == 0 ) {
+        d->file = file;
         return true;
     }
     return false;
@@ -326,16 +459,16 @@ rc_t SRASplitterFiler_FixFSName(const char* name, char** fname)
 }
 
 static
-rc_t SRASplitterFiler_GetCurrFile(const SRASplitterFile** out_file)
+rc_t SRASplitterFiler_GetCurrFile(SRASplitterFiler* self, const SRASplitterFile** out_file)
 {
     rc_t rc = 0;
     int i;
-    char* key = g_filer->key_buf; /* shortcut */
-    SRASplitterFile* file = NULL;
+    char* key = self->key_buf; /* shortcut */
+    SRASplitterFiler_FindData found;
 
     if( out_file == NULL ) {
         return RC(rcExe, rcFile, rcOpening, rcParam, rcInvalid);
-    } else if( g_filer->kf_stdout ) {
+    } else if( self->kf_stdout ) {
         strcpy(key, "stdout");
     } else {
         /* prepare the key
@@ -343,39 +476,49 @@ rc_t SRASplitterFiler_GetCurrFile(const SRASplitterFile** out_file)
            otherwise key will be prefix_path[i](_path[i+1]..)_?suffix
          */
         key[0] = '\0';
-        for(i = 0; i < g_filer->path_tail; i++ ) {
-            if( g_filer->path[i][0] == '\0' ) {
+        for(i = 0; i < self->path_tail; i++ ) {
+            if( self->path[i][0] == '\0' ) {
                 continue;
             }
-            if( g_filer->key_as_dir ) {
+            if( self->key_as_dir ) {
                 if( i != 0 ) {
                     strcat(key, "/");
                 }
-                strcat(key, g_filer->path[i]);
+                strcat(key, self->path[i]);
             } else {
-                if( i != 0 && isalnum(g_filer->path[i][0]) ) {
+                if( i != 0 && isalnum(self->path[i][0]) ) {
                     strcat(key, "_");
                 }
-                strcat(key, g_filer->path[i]);
+                strcat(key, self->path[i]);
             }
         }
     }
-    if( !SLListDoUntil( &g_filer->files, SRASplitterFiler_GetCurrFile_FindByKey, &file ) ) {
+    found.key = key;
+    found.file = NULL;
+    if( !SLListDoUntil( &self->files, SRASplitterFiler_GetCurrFile_FindByKey, &found ) ) {
+        SRASplitterFile* file = calloc(1, sizeof(*file));
         SRA_DUMP_DBG(5, ("New file: '%s'\n", key));
-        file = calloc(1, sizeof(*file));
         key = strdup(key);
         if( file == NULL || key == NULL ) {
             free(file);
             free(key);
             rc = RC(rcExe, rcFile, rcResolving, rcMemory, rcExhausted);
+        } else if( self->capture ) {
+            file->key = key;
+            if( (rc = SRASplitterFiler_CapturePath(self, file)) == 0 ) {
+                SLListPushTail(&self->files, &file->dad);
+                found.file = file;
+            } else {
+                SRASplitterFiler_WhackCapturedFile(&file->dad, NULL);
+            }
         } else {
             file->key = key;
-            if( g_filer->key_as_dir ) {
-                KDirectory* sub = g_filer->dir;
-                for(i = 0; rc == 0 && i < (g_filer->path_tail - 1); i++ ) {
-                    if( g_filer->path[i][0] != '\0' ) {
+            if( self->key_as_dir ) {
+                KDirectory* sub = self->dir;
+                for(i = 0; rc == 0 && i < (self->path_tail - 1); i++ ) {
+                    if( self->path[i][0] != '\0' ) {
                         char* ndir = NULL;
-                        if( (rc = SRASplitterFiler_FixFSName(g_filer->path[i], &ndir)) == 0 ) {
+                        if( (rc = SRASplitterFiler_FixFSName(self->path[i], &ndir)) == 0 ) {
                             if( (rc = KDirectoryCreateDir(sub, 0775, kcmCreate, ndir)) == 0 ||
                                 (GetRCObject(rc) == rcDirectory && GetRCState(rc) == rcExists) ) {
                                 if( (rc = KDirectoryOpenDirUpdate(sub, &file->dir, true, ndir)) == 0 ) {
@@ -387,22 +530,23 @@ rc_t SRASplitterFiler_GetCurrFile(const SRASplitterFile** out_file)
                         }
                     }
                 }
-                rc = SRASplitterFiler_FixFSName(&file->key[strlen(file->key) - strlen(g_filer->path[g_filer->path_tail - 1])], &file->name);
+                rc = SRASplitterFiler_FixFSName(&file->key[strlen(file->key) - strlen(self->path[self->path_tail - 1])], &file->name);
             } else {
-                file->dir = g_filer->dir;
+                file->dir = self->dir;
                 rc = SRASplitterFiler_FixFSName(file->key, &file->name);
             }
-            if( rc == 0 && (rc = SRASplitterFiler_OpenFile(file, true)) == 0 ) {
-                SLListPushTail(&g_filer->files, &file->dad);
+            if( rc == 0 && (rc = SRASplitterFiler_OpenFile(self, file, true)) == 0 ) {
+                SLListPushTail(&self->files, &file->dad);
+                found.file = file;
             } else {
-                SRASplitterFiler_WhackFile(&file->dad, &g_filer->keep_empty);
+                SRASplitterFiler_WhackFile(&file->dad, &self->keep_empty);
             }
         }
     } else {
-        SRA_DUMP_DBG(5, ("Curr file key '%s': '%s'\n", key, file->name));
-        rc = SRASplitterFiler_OpenFile(file, false);
+        SRA_DUMP_DBG(5, ("Curr file key '%s': '%s'\n", key, found.file->name));
+        rc = SRASplitterFiler_OpenFile(self, found.file, false);
     }
-    *out_file = rc ? NULL : file;
+    *out_file = rc ? NULL : found.file;
     return rc;
 }
 
@@ -413,13 +557,13 @@ rc_t SRASplitterFactory_FilerPrefix(const char* prefix)
     if( g_filer == NULL ) {
         rc = RC(rcExe, rcFile, rcUpdating, rcSelf, rcNotOpen);
     } else if( prefix == NULL || strcmp(prefix, g_filer->prefix) != 0 ) {
-        if( (rc = SRASplitterFiler_PopKey()) == 0 ) {
+        if( (rc = SRASplitterFiler_PopKey(g_filer)) == 0 ) {
             free(g_filer->prefix);
             g_filer->prefix = strdup(prefix ? prefix : "");
             if( g_filer->prefix == NULL ) {
                 rc = RC(rcExe, rcFile, rcConstructing, rcMemory, rcExhausted);
             } else {
-                rc = SRASplitterFiler_PushKey(g_filer->prefix);
+                rc = SRASplitterFiler_PushKey(g_filer, g_filer->prefix);
             }
         }
     }
@@ -443,9 +587,10 @@ rc_t SRASplitterFactory_FilerInit(bool to_stdout, bool gzip, bool bzip2, bool ke
         g_filer->do_bzip2 = bzip2;
         g_filer->arc_extension = gzip ? ".gz" : (bzip2 ? ".bz2" : "");
         SLListInit(&g_filer->files);
+        SLListInit(&g_filer->rejects);
         /* push empty prefix */
         g_filer->prefix = strdup("");
-        if( (rc = SRASplitterFiler_PushKey(g_filer->prefix)) == 0 &&
+        if( (rc = SRASplitterFiler_PushKey(g_filer, g_filer->prefix)) == 0 &&
             (rc = KDirectoryNativeDir(&g_filer->dir)) == 0 ) {
             if( to_stdout ) {
                 if( (rc = KFileMakeStdOut(&g_filer->kf_stdout)) == 0 ) {
@@ -496,13 +641,118 @@ rc_t SRASplitterFactory_FilerInit(bool to_stdout, bool gzip, bool bzip2, bool ke
             }
         }
     }
-    if( rc != 0 ) {
-        SRASplitterFiler_PopKey();
+    if( rc != 0 && g_filer != NULL ) {
+        SRASplitterFiler_PopKey(g_filer);
         SRASplitterFiler_Release();
     }
     return rc;
 }
 
+rc_t SRASplitterCapture_Make(SRASplitterCapture** cself)
+{
+    rc_t rc = 0;
+    SRASplitterFiler* self = NULL;
+
+    if( cself == NULL ) {
+        rc = RC(rcExe, rcFile, rcConstructing, rcParam, rcNull);
+    } else if( g_filer == NULL ) {
+        rc = RC(rcExe, rcFile, rcConstructing, rcSelf, rcNotOpen);
+    } else if( (self = calloc(1, sizeof(*self))) == NULL ) {
+        rc = RC(rcExe, rcFile, rcConstructing, rcMemory, rcExhausted);
+    } else {
+        int i;
+        self->capture = true;
+        self->key_as_dir = g_filer->key_as_dir;
+        self->keep_empty = g_filer->keep_empty;
+        self->arc_extension = g_filer->arc_extension;
+        if( g_filer->kf_stdout != NULL && (rc = KFileAddRef(g_filer->kf_stdout)) == 0 ) {
+            /* only tells that all keys go to the same stream */
+            self->kf_stdout = g_filer->kf_stdout;
+        }
+        SLListInit(&self->files);
+        SLListInit(&self->rejects);
+        /* start from the same place in tree as global filer, usually just prefix */
+        for(i = 0; i < g_filer->path_tail; i++ ) {
+            self->path[i] = g_filer->path[i];
+        }
+        self->path_tail = g_filer->path_tail;
+        self->path_len = g_filer->path_len;
+    }
+    if( cself != NULL ) {
+        *cself = rc ? NULL : self;
+    }
+    if( rc != 0 ) {
+        free(self);
+    }
+    return rc;
+}
+
+rc_t SRASplitterCapture_Flush(SRASplitterCapture* self)
+{
+    rc_t rc = 0;
+    SLNode* n;
+
+    if( self == NULL || g_filer == NULL ) {
+        return RC(rcExe, rcFile, rcWriting, rcSelf, rcNull);
+    }
+    for(n = SLListHead(&self->files); rc == 0 && n != NULL; n = SLNodeNext(n)) {
+        SRASplitterFile* f = (SRASplitterFile*)n;
+
+        if( f->real == NULL ) {
+            /* rebuild path in global filer and find or create file there */
+            const SRASplitterFile* real = NULL;
+            const char* p = f->path;
+            int i, pushed = 0;
+
+            for(i = 0; rc == 0 && i < f->path_qty; i++, pushed++ ) {
+                rc = SRASplitterFiler_PushKey(g_filer, p);
+                p += strlen(p) + 1;
+            }
+            if( rc == 0 ) {
+                rc = SRASplitterFiler_GetCurrFile(g_filer, &real);
+            }
+            while( pushed-- > 0 ) {
+                SRASplitterFiler_PopKey(g_filer);
+            }
+            f->real = (SRASplitterFile*)real;
+        } else {
+            rc = SRASplitterFiler_OpenFile(g_filer, f->real, false);
+        }
+        if( rc == 0 && f->data_sz > 0 ) {
+            size_t writ = 0;
+            rc = KFileWriteAll(f->real->file, f->real->pos, f->data, f->data_sz, &writ);
+            f->real->pos += writ;
+        }
+        if( rc == 0 && f->spot_qty > 0 ) {
+            f->real->curr_spot = f->curr_spot;
+            f->real->spot_qty += f->spot_qty;
+        }
+        f->data_sz = 0;
+        f->spot_qty = 0;
+    }
+    if( rc == 0 && self->spot_qty > 0 ) {
+        g_filer->curr_spot = self->curr_spot;
+        g_filer->spot_qty += self->spot_qty;
+        self->spot_qty = 0;
+    }
+    return rc;
+}
+
+void SRASplitterCapture_Release(SRASplitterCapture* self)
+{
+    if( self != NULL ) {
+        SLNode* n;
+        for(n = SLListHead(&self->rejects); n != NULL && g_filer != NULL; n = SLNodeNext(n)) {
+            const SRASplitterReject* r = (const SRASplitterReject*)n;
+            SRASplitterFiler_AddReject(g_filer, r->report, r->arg, r->qty);
+        }
+        SLListWhack(&self->rejects, SRASplitterFiler_WhackReject, NULL);
+        SLListWhack(&self->files, SRASplitterFiler_WhackCapturedFile, NULL);
+        KFileRelease(self->kf_stdout);
+        free(self);
+    }
+}
+
 /* ### Base splitter code ##################################################### */
 
 /* used to detect correct object pointers */
@@ -515,6 +765,7 @@ struct SRASplitterFactory {
     SRASplitterFactory_Init_Func* Init;
     SRASplitterFactory_NewObj_Func* NewObj;
     SRASplitterFactory_Release_Func* Release;
+    SRASplitterFiler* filer;
 };
 
 /* used to detect correct object pointers */
@@ -532,6 +783,7 @@ struct SRASplitter {
     SRASplitter_Release_Func* Release;
     BSTree children;
     SRASplitter_Child* last_found;
+    SRASplitterFiler* filer;
 };
 
 struct SRASplitter_Child {
@@ -657,7 +909,7 @@ rc_t SRASplitter_FindNextFile(SRASplitter* self, const char* key)
             /* create new child using global filer */
             const SRASplitterFile* file = NULL;
             SRA_DUMP_DBG(5, ("New file on key '%s'\n", key));
-            if( (rc = SRASplitterFiler_GetCurrFile(&file)) == 0 ) {
+            if( (rc = SRASplitterFiler_GetCurrFile(self->filer, &file)) == 0 ) {
                 if( (rc = SRASplitter_Child_MakeFile(&self->last_found, key, file)) == 0 ) {
                     if( (rc = BSTreeInsertUnique(&self->children, &self->last_found->node, NULL, SRASplitter_Child_Cmp)) != 0 ) {
                         SRASplitter_Child_Whack(&self->last_found->node, NULL);
@@ -669,7 +921,7 @@ rc_t SRASplitter_FindNextFile(SRASplitter* self, const char* key)
     }
     if( rc == 0 ) {
         /* make sure file is opened */
-        rc = SRASplitterFiler_OpenFile((SRASplitterFile*)(self->last_found->child.file), false);
+        rc = SRASplitterFiler_OpenFile(self->filer, (SRASplitterFile*)(self->last_found->child.file), false);
     }
     return rc;
 }
@@ -768,13 +1020,13 @@ rc_t SRASplitter_AddSpot( const SRASplitter * cself, spotid_t spot, readmask_t *
                         if ( rc == 0 )
                         {
                             /* push spot to next splitter in chain */
-                            rc = SRASplitterFiler_PushKey( self->last_found->key );
+                            rc = SRASplitterFiler_PushKey( self->filer, self->last_found->key );
                             if ( rc == 0 )
                             {
                                 /* here comes RECURSION!!! */
                                 rc_t rc2;
                                 rc = SRASplitter_AddSpot( self->last_found->child.splitter, spot, local_readmask );
-                                rc2 = SRASplitterFiler_PopKey();
+                                rc2 = SRASplitterFiler_PopKey( self->filer );
                                 rc = rc ? rc : rc2;
                             }
                         }
@@ -808,13 +1060,13 @@ rc_t SRASplitter_AddSpot( const SRASplitter * cself, spotid_t spot, readmask_t *
                     if ( rc == 0 )
                     {
                         /* push spot to next splitter in chain */
-                        rc = SRASplitterFiler_PushKey( self->last_found->key );
+                        rc = SRASplitterFiler_PushKey( self->filer, self->last_found->key );
                         if ( rc == 0 )
                         {
                             /* here comes RECURSION!!! */
                             rc_t rc2;
                             rc = SRASplitter_AddSpot( self->last_found->child.splitter, spot, readmask );
-                            rc2 = SRASplitterFiler_PopKey();
+                            rc2 = SRASplitterFiler_PopKey( self->filer );
                             rc = rc ? rc : rc2;
                         }
                     }
@@ -857,10 +1109,10 @@ rc_t SRASplitter_FileActivate(const SRASplitter* cself, const char* key)
     SRASplitter* self = NULL;
 
     if( (rc = SRASplitter_ResolveSelf(cself, rcExecuting, &self)) == 0 ) {
-        if( (rc = SRASplitterFiler_PushKey(key)) == 0 ) {
+        if( (rc = SRASplitterFiler_PushKey(self->filer, key)) == 0 ) {
             /* sets self->last_found */
             rc = SRASplitter_FindNextFile(self, key);
-            rc2 = SRASplitterFiler_PopKey();
+            rc2 = SRASplitterFiler_PopKey( self->filer );
             rc = rc ? rc : rc2;
         }
     }
@@ -882,7 +1134,15 @@ rc_t SRASplitter_FileWrite( const SRASplitter* cself, spotid_t spot, const void*
         {
             size_t writ = 0;
             SRASplitterFile* f = ( SRASplitterFile* )( self->last_found->child.file );
-            rc = KFileWrite( f->file, f->pos, buf, size, &writ );
+            if ( self->filer->capture )
+            {
+                rc = SRASplitterFiler_Capture( f, buf, size );
+                writ = size;
+            }
+            else
+            {
+                rc = KFileWrite( f->file, f->pos, buf, size, &writ );
+            }
             if ( rc == 0 )
             {
                 f->pos += writ;
@@ -891,10 +1151,10 @@ rc_t SRASplitter_FileWrite( const SRASplitter* cself, spotid_t spot, const void*
                      f->curr_spot = spot;
                      f->spot_qty = f->spot_qty + 1;
                 }
-                if ( g_filer->curr_spot != spot && spot != 0 )
+                if ( self->filer->curr_spot != spot && spot != 0 )
                 {
-                    g_filer->curr_spot = spot;
-                    g_filer->spot_qty = g_filer->spot_qty + 1;
+                    self->filer->curr_spot = spot;
+                    self->filer->spot_qty = self->filer->spot_qty + 1;
                 }
             }
         }
@@ -902,6 +1162,18 @@ rc_t SRASplitter_FileWrite( const SRASplitter* cself, spotid_t spot, const void*
     return rc;
 }
 
+rc_t SRASplitter_Rejected( const SRASplitter* cself, const char* report, uint32_t arg, uint64_t count )
+{
+    SRASplitter* self = NULL;
+
+    rc_t rc = SRASplitter_ResolveSelf( cself, rcWriting, &self );
+    if ( rc == 0 )
+    {
+        rc = SRASplitterFiler_AddReject( self->filer, report, arg, count );
+    }
+    return rc;
+}
+
 rc_t SRASplitter_FileWritePos( const SRASplitter* cself, spotid_t spot, 
                                uint64_t pos, const void* buf, size_t size )
 {
@@ -914,6 +1186,11 @@ rc_t SRASplitter_FileWritePos( const SRASplitter* cself, spotid_t spot,
         {
             rc = RC( rcExe, rcFile, rcWriting, rcDirEntry, rcUnknown );
         }
+        else if ( self->filer->capture )
+        {
+            /* captured output can only be appended */
+            rc = RC( rcExe, rcFile, rcWriting, rcFunction, rcUnsupported );
+        }
         else if ( buf != NULL && size > 0 )
         {
             const SRASplitterFile* f = self->last_found->child.file;
@@ -1022,6 +1299,20 @@ rc_t SRASplitterFactory_AddNext(const SRASplitterFactory* cself, const SRASplitt
     return rc;
 }
 
+rc_t SRASplitterFactory_SetCapture(const SRASplitterFactory* cself, SRASplitterCapture* capture)
+{
+    rc_t rc = 0;
+    SRASplitterFactory* self = NULL;
+
+    while( rc == 0 && cself != NULL ) {
+        if( (rc = SRASplitterFactory_ResolveSelf(cself, rcAttaching, &self)) == 0 ) {
+            self->filer = capture;
+            cself = self->next;
+        }
+    }
+    return rc;
+}
+
 rc_t SRASplitterFactory_Init(const SRASplitterFactory* cself)
 {
     rc_t rc = 0;
@@ -1053,6 +1344,7 @@ rc_t SRASplitterFactory_NewObj(const SRASplitterFactory* cself, const SRASplitte
             SRASplitter* sp = NULL;
             if( (rc = SRASplitter_ResolveSelf(*splitter, rcConstructing, &sp)) == 0 ) {
                 sp->type = self->type;
+                sp->filer = self->filer != NULL ? self->filer : g_filer;
                 if( (self->type == eSplitterSpot   && (!sp->GetKey ||  sp->GetKeySet ||  sp->Dump) ) ||
                     (self->type == eSplitterRead   && ( sp->GetKey || !sp->GetKeySet ||  sp->Dump) ) ||
                     (self->type == eSplitterFormat && ( sp->GetKey ||  sp->GetKeySet || !sp->Dump) ) ) {
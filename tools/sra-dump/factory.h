@@ -132,6 +132,14 @@ rc_t SRASplitter_FileActivate(const SRASplitter* self, const char* key);
 rc_t SRASplitter_FileWrite( const SRASplitter* cself, spotid_t spot, const void* buf, size_t size );
 rc_t SRASplitter_FileWritePos( const SRASplitter* cself, spotid_t spot, uint64_t pos, const void* buf, size_t size );
 
+/**
+  * Count spots or reads a filter dropped, usually from its release function.
+  * report [IN] - static KOutMsg format taking count as %lu and arg as %u,
+  *               counts with the same report and arg are added up
+  * Printed once per table by SRASplitterFactory_FilerRejects.
+  */
+rc_t SRASplitter_Rejected( const SRASplitter* cself, const char* report, uint32_t arg, uint64_t count );
+
 typedef struct SRASplitterFactory SRASplitterFactory;
 
 typedef rc_t (SRASplitterFactory_Init_Func)(const SRASplitterFactory* self);
@@ -152,8 +160,25 @@ rc_t SRASplitterFactory_FilerInit(bool to_stdout, bool gzip, bool bzip2, bool ke
 /* this only works correctly on top of the splitter tree !! */
 rc_t SRASplitterFactory_FilerPrefix(const char* prefix);
 void SRASplitterFactory_FilerReport(uint64_t* total, uint64_t* biggest_file);
+/* prints and forgets rejects counted so far, call after all splitters are released */
+rc_t SRASplitterFactory_FilerRejects(void);
 void SRASplitterFiler_Release(void);
 
+/**
+  * Output capture, lets a splitter chain run on its own thread.
+  * Splitters spawned by factories bound to a capture keep all file output in memory,
+  * Flush appends it to the files of the global filer and empties the capture,
+  * Release hands rejects counted by its splitters over to the global filer.
+  * Files written with SRASplitter_FileWritePos cannot be captured.
+  */
+typedef struct SRASplitterFiler_struct SRASplitterCapture;
+
+/* must be called after SRASplitterFactory_FilerPrefix */
+rc_t SRASplitterCapture_Make(SRASplitterCapture** self);
+/* must be called from the same thread as the rest of global filer calls */
+rc_t SRASplitterCapture_Flush(SRASplitterCapture* self);
+void SRASplitterCapture_Release(SRASplitterCapture* self);
+
 /**
   * Create factory object
   */
@@ -180,6 +205,11 @@ ESRASplitterTypes SRASplitterFactory_GetType(const SRASplitterFactory* self);
   */
 rc_t SRASplitterFactory_AddNext(const SRASplitterFactory* self, const SRASplitterFactory* next);
 
+/**
+  * Bind a chain of factories to output capture, must be done before 1st call to SRASplitterFactory_NewObj
+  */
+rc_t SRASplitterFactory_SetCapture(const SRASplitterFactory* self, SRASplitterCapture* capture);
+
 /**
   * Initialize a chain of factories. Factories must be chaind properly before init.
   * Type chain must look like (eSpot|eRead)*, eFormat.
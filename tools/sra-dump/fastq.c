@@ -645,8 +645,7 @@ static rc_t AlignedFilter_Release( const SRASplitter* cself )
     }
     else
     {
-        if ( self->rejected_reads > 0 && !g_legacy_report )
-            rc = KOutMsg( "Rejected %lu READS because of aligned/unaligned filter\n", self->rejected_reads );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because of aligned/unaligned filter\n", 0, self->rejected_reads );
     }
     return rc;
 }
@@ -857,8 +856,7 @@ static rc_t AlignRegionFilter_Release( const SRASplitter* cself )
     }
     else
     {
-        if ( self->rejected_spots > 0 && !g_legacy_report )
-            rc = KOutMsg( "Rejected %lu SPOTS because of AlignRegionFilter\n", self->rejected_spots );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu SPOTS because of AlignRegionFilter\n", 0, self->rejected_spots );
     }
     return rc;
 }
@@ -1087,8 +1085,7 @@ static rc_t AlignPairDistanceFilter_Release( const SRASplitter* cself )
     }
     else
     {
-        if ( self->rejected_reads > 0 && !g_legacy_report )
-            rc = KOutMsg( "Rejected %lu READS because of AlignPairDistanceFilter\n", self->rejected_reads );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because of AlignPairDistanceFilter\n", 0, self->rejected_reads );
     }
     return rc;
 }
@@ -1281,8 +1278,7 @@ static rc_t FastqBioFilter_Release( const SRASplitter * cself )
         rc = RC( rcExe, rcNode, rcExecuting, rcParam, rcInvalid );
     else
     {
-        if ( self->rejected_reads > 0 && !g_legacy_report )
-            rc = KOutMsg( "Rejected %lu READS because of filtering out non-biological READS\n", self->rejected_reads );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because of filtering out non-biological READS\n", 0, self->rejected_reads );
     }
     return rc;
 }
@@ -1451,8 +1447,7 @@ static rc_t FastqRNumberFilter_Release( const SRASplitter* cself )
     }
     else
     {
-        if ( self->rejected_reads > 0 && !g_legacy_report )
-            rc = KOutMsg( "Rejected %lu READS because of max. number of READS = %u\n", self->rejected_reads, FastqArgs.maxReads );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because of max. number of READS = %u\n", FastqArgs.maxReads, self->rejected_reads );
     }
     return rc;
 }
@@ -1767,13 +1762,11 @@ static rc_t FastqQFilter_Release( const SRASplitter * cself )
 
     if ( self == NULL )
         rc = RC( rcExe, rcNode, rcExecuting, rcParam, rcInvalid );
-    else if ( !g_legacy_report )
+    else
     {
-        if ( self->rejected_reads > 0 )
-            rc = KOutMsg( "Rejected %lu READS because of Quality-Filtering\n", self->rejected_reads );
-        if ( rc == 0 && self->rejected_spots > 0 )
-            rc = KOutMsg( "Rejected %lu SPOTS because of Quality-Filtering\n", self->rejected_spots );
-
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because of Quality-Filtering\n", 0, self->rejected_reads );
+        if ( rc == 0 )
+            rc = SRASplitter_Rejected( cself, "Rejected %lu SPOTS because of Quality-Filtering\n", 0, self->rejected_spots );
     }
     return rc;
 }
@@ -1971,12 +1964,11 @@ static rc_t FastqReadLenFilter_Release( const SRASplitter * cself )
 
     if ( self == NULL )
         rc = RC( rcExe, rcNode, rcExecuting, rcParam, rcInvalid );
-    else if ( !g_legacy_report )
+    else
     {
-        if ( self->rejected_reads > 0 )
-            rc = KOutMsg( "Rejected %lu READS because READLEN < %u\n", self->rejected_reads, FastqArgs.minReadLen );
-        if ( self->rejected_spots > 0 && rc == 0 )
-            rc = KOutMsg( "Rejected %lu SPOTS because SPOTLEN < %u\n", self->rejected_spots, FastqArgs.minReadLen );
+        rc = SRASplitter_Rejected( cself, "Rejected %lu READS because READLEN < %u\n", FastqArgs.minReadLen, self->rejected_reads );
+        if ( rc == 0 )
+            rc = SRASplitter_Rejected( cself, "Rejected %lu SPOTS because SPOTLEN < %u\n", FastqArgs.minReadLen, self->rejected_spots );
     }
     return rc;
 }
@@ -2075,12 +2067,46 @@ static rc_t FastqReadLenFilterFactory_Make( const SRASplitterFactory** cself,
 
 /* ============== FASTQ read splitter ============================ */
 
-char* FastqReadSplitter_key_buf = NULL;
+/* key_buf: "   1\0   2\0...\0   9\0  10\0  11\0...\03220..\08192\0" */
+static rc_t FastqReadSplitter_MakeKeys( char** key_buf, const size_t key_offset )
+{
+    rc_t rc = 0;
+
+    if ( nreads_max > 9999 )
+    {
+        /* key_offset and sprintf format size are insufficient for keys longer than 4 digits */
+        rc = RC( rcExe, rcNode, rcConstructing, rcBuffer, rcInsufficient );
+    }
+    else
+    {
+        *key_buf = malloc( nreads_max * key_offset );
+        if ( *key_buf == NULL )
+        {
+            rc = RC( rcExe, rcNode, rcConstructing, rcMemory, rcExhausted );
+        }
+        else
+        {
+            /* fill buffer w/keys */
+            int i;
+            char* p = *key_buf;
+            for ( i = 1; rc == 0 && i <= nreads_max; i++ )
+            {
+                if ( sprintf( p, "%4u", i ) <= 0 )
+                {
+                    rc = RC( rcExe, rcNode, rcConstructing, rcTransfer, rcIncomplete );
+                }
+                p += key_offset;
+            }
+        }
+    }
+    return rc;
+}
 
 
 typedef struct FastqReadSplitter_struct
 {
     const FastqReader* reader;
+    const char* key_buf;
     SRASplitter_Keys* keys;
     uint32_t keys_max;
 } FastqReadSplitter;
@@ -2102,38 +2128,6 @@ static rc_t FastqReadSplitter_GetKeySet( const SRASplitter* cself, const SRASpli
         uint32_t num_reads = 0;
 
         *keys = 0;
-        if ( FastqReadSplitter_key_buf == NULL )
-        {
-            /* initial alloc key_buf: "  1\0  2\0...\0  9\0 10\0 11\0...\03220..\08192\0" */
-            if ( nreads_max > 9999 )
-            {
-                /* key_offset and sprintf format size are insufficient for keys longer than 4 digits */
-                rc = RC( rcExe, rcNode, rcExecuting, rcBuffer, rcInsufficient );
-            }
-            else
-            {
-                FastqReadSplitter_key_buf = malloc( nreads_max * key_offset );
-                if ( FastqReadSplitter_key_buf == NULL )
-                {
-                    rc = RC( rcExe, rcNode, rcExecuting, rcMemory, rcExhausted );
-                }
-                else
-                {
-                    /* fill buffer w/keys */
-                    int i;
-                    char* p = FastqReadSplitter_key_buf;
-                    for ( i = 1; rc == 0 && i <= nreads_max; i++ )
-                    {
-                        if ( sprintf( p, "%4u", i ) <= 0 )
-                        {
-                            rc = RC( rcExe, rcNode, rcExecuting, rcTransfer, rcIncomplete );
-                        }
-                        p += key_offset;
-                    }
-                }
-            }
-        }
-
         if ( rc == 0 )
         {
             rc = FastqReaderSeekSpot( self->reader, spot );
@@ -2166,7 +2160,7 @@ static rc_t FastqReadSplitter_GetKeySet( const SRASplitter* cself, const SRASpli
                                 self->keys_max = good + 1;
                             }
                         }
-                        self->keys[ good ].key = &FastqReadSplitter_key_buf[ readId * key_offset ];
+                        self->keys[ good ].key = &self->key_buf[ readId * key_offset ];
                         while ( self->keys[ good ].key[ 0 ] == ' ' && self->keys[ good ].key[0] != '\0' )
                         {
                             self->keys[ good ].key++;
@@ -2216,6 +2210,7 @@ typedef struct FastqReadSplitterFactory_struct
     const char* accession;
     const SRATable* table;
     const FastqReader* reader;
+    char* key_buf;
 } FastqReadSplitterFactory;
 
 
@@ -2235,6 +2230,10 @@ static rc_t FastqReadSplitterFactory_Init( const SRASplitterFactory* cself )
                               FastqArgs.is_platform_cs_native, false, FastqArgs.fasta > 0, false, 
                               false, !FastqArgs.applyClip, FastqArgs.SuppressQualForCSKey, 0,
                               FastqArgs.offset, '\0', 0, 0 );
+        if ( rc == 0 )
+        {
+            rc = FastqReadSplitter_MakeKeys( &self->key_buf, 5 );
+        }
     }
     return rc;
 }
@@ -2256,6 +2255,7 @@ static rc_t FastqReadSplitterFactory_NewObj( const SRASplitterFactory* cself, co
         if ( rc == 0 )
         {
             ( (FastqReadSplitter*)(*splitter) )->reader = self->reader;
+            ( (FastqReadSplitter*)(*splitter) )->key_buf = self->key_buf;
         }
     }
     return rc;
@@ -2268,8 +2268,7 @@ static void FastqReadSplitterFactory_Release( const SRASplitterFactory* cself )
     {
         FastqReadSplitterFactory* self = ( FastqReadSplitterFactory* )cself;
         FastqReaderWhack( self->reader );
-        free( FastqReadSplitter_key_buf );
-        FastqReadSplitter_key_buf = NULL;
+        free( self->key_buf );
     }
 }
 
@@ -2303,11 +2302,11 @@ static rc_t FastqReadSplitterFactory_Make( const SRASplitterFactory** cself,
 
 /* ============== FASTQ 3 read splitter ============================ */
 
-char* Fastq3ReadSplitter_key_buf = NULL;
 
 typedef struct Fastq3ReadSplitter_struct
 {
     const FastqReader* reader;
+    const char* key_buf;
     SRASplitter_Keys keys[ 2 ];
 } Fastq3ReadSplitter;
 
@@ -2329,38 +2328,6 @@ static rc_t Fastq3ReadSplitter_GetKeySet( const SRASplitter* cself, const SRASpl
         uint32_t num_reads = 0;
 
         *keys = 0;
-        if ( Fastq3ReadSplitter_key_buf == NULL )
-        {
-            /* initial alloc key_buf: "  1\0  2\0...\0  9\0 10\0 11\0...\03220..\08192\0" */
-            if ( nreads_max > 9999 )
-            {
-                /* key_offset and sprintf format size are insufficient for keys longer than 4 digits */
-                rc = RC( rcExe, rcNode, rcExecuting, rcBuffer, rcInsufficient );
-            }
-            else
-            {
-                Fastq3ReadSplitter_key_buf = malloc( nreads_max * key_offset );
-                if ( Fastq3ReadSplitter_key_buf == NULL )
-                {
-                    rc = RC( rcExe, rcNode, rcExecuting, rcMemory, rcExhausted );
-                }
-                else
-                {
-                    /* fill buffer w/keys */
-                    int i;
-                    char* p = Fastq3ReadSplitter_key_buf;
-                    for ( i = 1; rc == 0 && i <= nreads_max; i++ )
-                    {
-                        if ( sprintf( p, "%4u", i ) <= 0 )
-                        {
-                            rc = RC( rcExe, rcNode, rcExecuting, rcTransfer, rcIncomplete );
-                        }
-                        p += key_offset;
-                    }
-                }
-            }
-        }
-
         if ( rc == 0 )
         {
             rc = FastqReaderSeekSpot( self->reader, spot );
@@ -2380,7 +2347,7 @@ static rc_t Fastq3ReadSplitter_GetKeySet( const SRASplitter* cself, const SRASpl
                         {
                             continue;
                         }
-                        self->keys[ good ].key = &Fastq3ReadSplitter_key_buf[ good * key_offset ];
+                        self->keys[ good ].key = &self->key_buf[ good * key_offset ];
                         while ( self->keys[ good ].key[ 0 ] == ' ' && self->keys[good].key[ 0 ] != '\0' )
                         {
                             self->keys[ good ].key++;
@@ -2429,6 +2396,7 @@ typedef struct Fastq3ReadSplitterFactory_struct
     const char* accession;
     const SRATable* table;
     const FastqReader* reader;
+    char* key_buf;
 } Fastq3ReadSplitterFactory;
 
 
@@ -2448,6 +2416,10 @@ static rc_t Fastq3ReadSplitterFactory_Init( const SRASplitterFactory* cself )
                               FastqArgs.is_platform_cs_native, false, FastqArgs.fasta > 0, false, 
                               false, !FastqArgs.applyClip, FastqArgs.SuppressQualForCSKey, 0,
                               FastqArgs.offset, '\0', 0, 0 );
+        if ( rc == 0 )
+        {
+            rc = FastqReadSplitter_MakeKeys( &self->key_buf, 5 );
+        }
     }
     return rc;
 }
@@ -2469,6 +2441,7 @@ static rc_t Fastq3ReadSplitterFactory_NewObj( const SRASplitterFactory* cself, c
         if ( rc == 0 )
         {
             ( (Fastq3ReadSplitter*)(*splitter) )->reader = self->reader;
+            ( (Fastq3ReadSplitter*)(*splitter) )->key_buf = self->key_buf;
         }
     }
     return rc;
@@ -2481,7 +2454,7 @@ static void Fastq3ReadSplitterFactory_Release( const SRASplitterFactory* cself )
     {
         Fastq3ReadSplitterFactory* self = ( Fastq3ReadSplitterFactory* )cself;
         FastqReaderWhack( self->reader );
-        free( Fastq3ReadSplitter_key_buf );
+        free( self->key_buf );
     }
 }
 
@@ -3661,11 +3634,12 @@ rc_t FastqDumper_Factories( const SRADumperFmt* fmt, const SRASplitterFactory**
 
     if ( rc == 0 )
     {
-        if ( FastqArgs.b_deffmt != NULL )
+        /* factories can be made several times, deflines are shared */
+        if ( FastqArgs.b_deffmt != NULL && FastqArgs.b_defline == NULL )
         {
             rc = Defline_Parse( &FastqArgs.b_defline, FastqArgs.b_deffmt );
         }
-        if ( FastqArgs.q_deffmt != NULL )
+        if ( rc == 0 && FastqArgs.q_deffmt != NULL && FastqArgs.q_defline == NULL )
         {
             rc = Defline_Parse( &FastqArgs.q_defline, FastqArgs.q_deffmt );
         }
@@ -3798,6 +3772,7 @@ rc_t SRADumper_Init( SRADumperFmt* fmt )
     fmt->release = FastqDumper_Release;
     fmt->arg_desc = arg;
     fmt->add_arg = FastqDumper_AddArg;
+    fmt->threads_ok = true;
     fmt->get_factory = FastqDumper_Factories;
     fmt->gzip = true;
     fmt->bzip2 = true;
@@ -437,3 +437,69 @@ rc_t foreach_unaligned_entry( const matecache * const self,
     }
     return rc;
 }
+
+
+typedef struct merge_ctx
+{
+    matecache_per_file * dst;
+    const matecache_per_file * src;
+} merge_ctx;
+
+
+static rc_t CC on_merge_unaligned( uint64_t key, uint64_t value, void *user_data )
+{
+    merge_ctx * mctx = user_data;
+    uint64_t seq_id;
+    rc_t rc = KVectorGetU64( mctx->src->unaligned_64_b, key, &seq_id );
+    if ( rc != 0 )
+        (void)LOGERR( klogErr, rc, "cannot retrieve value (unaligned b) U64" );
+    else
+    {
+        rc = KVectorSetU64( mctx->dst->unaligned_64_a, key, value );
+        if ( rc != 0 )
+            (void)LOGERR( klogErr, rc, "cannot insert into KVector (unaligned a) U64" );
+        else
+        {
+            rc = KVectorSetU64( mctx->dst->unaligned_64_b, key, seq_id );
+            if ( rc != 0 )
+                (void)LOGERR( klogErr, rc, "cannot insert into KVector (unaligned b) U64" );
+        }
+    }
+    return rc;
+}
+
+
+rc_t matecache_merge( matecache * const self, const matecache * const other )
+{
+    rc_t rc = 0;
+    if ( self == NULL || other == NULL )
+    {
+        rc = RC( rcApp, rcNoTarg, rcAccessing, rcSelf, rcNull );
+        (void)LOGERR( klogErr, rc, "cannot merge matecache" );
+    }
+    else
+    {
+        uint32_t idx;
+        for ( idx = 0; idx < self->count && idx < other->count && rc == 0; ++idx )
+        {
+            merge_ctx mctx;
+            mctx.dst = &self->per_file[ idx ];
+            mctx.src = &other->per_file[ idx ];
+            rc = KVectorVisitU64( mctx.src->unaligned_64_a, false, on_merge_unaligned, &mctx );
+            if ( rc == 0 )
+            {
+                mctx.dst->stat_unaligned.count += mctx.src->stat_unaligned.count;
+                mctx.dst->stat_unaligned.inserts += mctx.src->stat_unaligned.inserts;
+
+                mctx.dst->stat_same_ref.inserts += mctx.src->stat_same_ref.inserts;
+                mctx.dst->stat_same_ref.lookups += mctx.src->stat_same_ref.lookups;
+                mctx.dst->stat_same_ref.finds += mctx.src->stat_same_ref.finds;
+                if ( mctx.src->maxcount_same_ref > mctx.dst->maxcount_same_ref )
+                    mctx.dst->maxcount_same_ref = mctx.src->maxcount_same_ref;
+            }
+        }
+        if ( rc == 0 )
+            self->flashes += other->flashes;
+    }
+    return rc;
+}
@@ -82,6 +82,10 @@ rc_t matecache_clear_same_ref( matecache * const self );
 
 rc_t matecache_report( const matecache * const self );
 
+/* takes over the unaligned entries and the statistics of a cache filled by a worker-thread,
+   entries of the same reference are not taken, they are cleared at the end of every reference anyway */
+rc_t matecache_merge( matecache * const self, const matecache * const other );
+
 
 /* cache functions for aligned mates on the same reference */
 
@@ -30,8 +30,11 @@
 #include <kfs/buffile.h>
 #include <kfs/bzip.h>
 #include <kfs/gzip.h>
+#include <klib/printf.h>
 #include <sysalloc.h>
 
+#include <stdlib.h>
+
 static rc_t CC out_redir_callback( void * self, const char * buffer, size_t bufsize, size_t * num_writ )
 {
     out_redir * redir = ( out_redir * )self;
@@ -118,3 +121,77 @@ void release_out_redir( out_redir * self )
     self->org_writer = NULL;
 }
 
+
+
+void init_out_buffer( out_buffer * self )
+{
+    self->base = NULL;
+    self->used = 0;
+    self->size = 0;
+}
+
+
+void release_out_buffer( out_buffer * self )
+{
+    free( self->base );
+    init_out_buffer( self );
+}
+
+
+static rc_t grow_out_buffer( out_buffer * self, size_t needed )
+{
+    rc_t rc = 0;
+    size_t size = ( self->size > 0 ) ? self->size : 0x10000;
+    while ( size < needed )
+        size += size;
+    if ( size > self->size )
+    {
+        char * base = realloc( self->base, size );
+        if ( base == NULL )
+            rc = RC( rcExe, rcBuffer, rcResizing, rcMemory, rcExhausted );
+        else
+        {
+            self->base = base;
+            self->size = size;
+        }
+    }
+    return rc;
+}
+
+
+rc_t out_buffer_vprint( out_buffer * self, const char * fmt, va_list args )
+{
+    size_t num_writ = 0;
+    rc_t rc = grow_out_buffer( self, self->used + 1 );
+    if ( rc == 0 )
+    {
+        /* the list may be needed twice */
+        va_list args_copy;
+        va_copy( args_copy, args );
+        rc = string_vprintf( self->base + self->used, self->size - self->used, &num_writ, fmt, args );
+        if ( rc != 0 && GetRCState( rc ) == rcInsufficient )
+        {
+            rc = grow_out_buffer( self, self->used + num_writ + 1 );
+            if ( rc == 0 )
+                rc = string_vprintf( self->base + self->used, self->size - self->used, &num_writ, fmt, args_copy );
+        }
+        va_end( args_copy );
+        if ( rc == 0 )
+            self->used += num_writ;
+    }
+    return rc;
+}
+
+
+rc_t flush_out_buffer( out_buffer * self )
+{
+    rc_t rc = 0;
+    if ( self->used > 0 )
+    {
+        KWrtHandler * handler = KOutHandlerGet();
+        size_t num_writ = 0;
+        rc = handler->writer( handler->data, self->base, self->used, &num_writ );
+        self->used = 0;
+    }
+    return rc;
+}
@@ -39,6 +39,8 @@ extern "C" {
 
 #include <kfs/file.h>
 
+#include <stdarg.h>
+
 enum out_redir_mode
 {
     orm_uncompressed = 0,
@@ -61,4 +63,23 @@ rc_t init_out_redir( out_redir * self, enum out_redir_mode mode, const char * fi
 
 void release_out_redir( out_redir * self );
 
+
+/* output of worker-threads is collected in memory and written later in order */
+typedef struct out_buffer
+{
+    char * base;
+    size_t used;
+    size_t size;
+} out_buffer;
+
+
+void init_out_buffer( out_buffer * self );
+
+void release_out_buffer( out_buffer * self );
+
+rc_t out_buffer_vprint( out_buffer * self, const char * fmt, va_list args );
+
+/* writes the collected output via the current KOut-handler and empties the buffer */
+rc_t flush_out_buffer( out_buffer * self );
+
 #endif
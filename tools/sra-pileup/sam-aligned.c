@@ -27,10 +27,14 @@
 #include <align/manager.h>
 #include <align/iterator.h>
 #include <kapp/main.h>
+#include <kproc/thread.h>
+#include <kproc/lock.h>
+#include <kproc/cond.h>
 #include <sysalloc.h>
 
 #include "read_fkt.h"
 #include "cg_tools.h"
+#include "out_redir.h"
 #include "sam-aligned.h"
 
 const char * PRIM_TABLE = "PRIMARY_ALIGNMENT";
@@ -808,19 +812,19 @@ static rc_t print_qslice( const samdump_opts * const opts, bool reverse, const c
             rc = dump_quality_33( opts, ptr, len, reverse ); /* sam-dump-opts.c */
             if ( rc == 0 )
             {
-                rc = KOutMsg( "\t" );
+                rc = dump_msg( opts, "\t" );
                 if ( rc == 0 )
                     *source_offset += len;
             }
         }
         else
-            rc = KOutMsg( "*\t" );
+            rc = dump_msg( opts, "*\t" );
     }
     return rc;
 }
 
 
-static rc_t modify_and_print_cigar( const char * cigar, size_t cigar_len,
+static rc_t modify_and_print_cigar( const samdump_opts * const opts, const char * cigar, size_t cigar_len,
                                     CigOps *ref_cig, int32_t ref_cig_len, INSDC_coord_zero ref_pos, uint32_t read_len )
 {
     rc_t rc;
@@ -831,10 +835,10 @@ static rc_t modify_and_print_cigar( const char * cigar, size_t cigar_len,
         CigOps al_cig[ 1024 ];
         ExplodeCIGAR( al_cig, 1024, cigar, cigar_len );
         combined_len = CombineCIGAR( cigbuf, al_cig, read_len, ref_pos, ref_cig, ref_cig_len );
-        rc = KOutMsg( "%s\t", cigbuf );
+        rc = dump_msg( opts, "%s\t", cigbuf );
     }
     else
-        rc = KOutMsg( "*\t" );
+        rc = dump_msg( opts, "*\t" );
     return rc;
 }
 
@@ -934,14 +938,14 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
         {
             if ( spot_group_len > 0 )
                 /* SAM-FIELD: QNAME     constructed from spot-group/seq-name */
-                rc = KOutMsg( "%.*s-1:%.*s\t", spot_group_len, spot_group, seq_name_len, seq_name );
+                rc = dump_msg( opts, "%.*s-1:%.*s\t", spot_group_len, spot_group, seq_name_len, seq_name );
 
         }
         else
         {
             if ( seq_name_len > 0 )
                 /* SAM-FIELD: QNAME     constructed from allel-id/sub-id */
-                rc = KOutMsg( "%.*s/ALLELE_%li.%u\t", seq_name_len, seq_name, rec->id, ploidy_idx );
+                rc = dump_msg( opts, "%.*s/ALLELE_%li.%u\t", seq_name_len, seq_name, rec->id, ploidy_idx );
         }
     }
 
@@ -969,7 +973,7 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
     /* SAM-FIELD: POS       SRA-column: REF_POS + 1 */
     /* SAM-FIELD: MAPQ      SRA-column: MAPQ ( from evidence-alignment-table, not from allel! ) */
     if ( rc == 0 )
-        rc = KOutMsg( "%u\t%s\t%i\t%d\t", sam_flags, ref_name, allele_pos + ref_pos + 1, mapq );
+        rc = dump_msg( opts, "%u\t%s\t%i\t%d\t", sam_flags, ref_name, allele_pos + ref_pos + 1, mapq );
 
     /* get READ, QUALITY and EIDT_DIST before cigar manipulation because we need/change these values */
     if ( rc == 0 )
@@ -983,7 +987,7 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
         if ( rc == 0 )
             rc = cg_cigar_treatments( opts->cigar_treatment, &cgc_input, &cgc_output, align_id, &atx->eval );
         if ( rc == 0 )
-            rc = modify_and_print_cigar( cgc_output.p_cigar.ptr, cgc_output.p_cigar.len,
+            rc = modify_and_print_cigar( opts, cgc_output.p_cigar.ptr, cgc_output.p_cigar.len,
                                          atx->cig_op_buffer, ref_cig_len, ref_pos, cgc_output.p_read.len );
     }
 
@@ -992,7 +996,7 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
     /* SAM-FIELD: TLEN      SRA-column: TEMPLATE_LEN '0' not in table */
     /* SAM-FIELD: SEQ       SRA-column: READ  */
     if ( rc == 0 )
-        rc = KOutMsg( "*\t0\t0\t%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
+        rc = dump_msg( opts, "*\t0\t0\t%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
 
     /* SAM-FIELD: QUAL      SRA-column: SAM_QUALITY */
     if ( rc == 0 && cgc_output.p_quality.len > 0 )
@@ -1000,15 +1004,15 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
 
     /* OPT SAM-FIELD: RG     SRA-column: SEQ_SPOT_GROUP */
     if ( rc == 0 && spot_group_len > 0 )
-        rc = KOutMsg( "\tRG:Z:%.*s", spot_group_len, spot_group );
+        rc = dump_msg( opts, "\tRG:Z:%.*s", spot_group_len, spot_group );
 
     if ( rc == 0 && cgc_output.p_tags.len > 0 )
-        rc = KOutMsg( "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
+        rc = dump_msg( opts, "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
 
     /* OPT SAM-FIELD: ZI     SRA-column: rec->id */
     /* OPT SAM-FIELD: ZA     SRA-column: ploidy_idx */
     if ( rc == 0 )
-        rc = KOutMsg( "\tZI:i:%li\tZA:i:%u", rec->id, ploidy_idx );
+        rc = dump_msg( opts, "\tZI:i:%li\tZA:i:%u", rec->id, ploidy_idx );
 
     /* OPT SAM-FIELD: NH     SRA-column: ALIGNMENT_COUNT */
     if ( rc == 0 && atx->eval.al_count_idx != COL_NOT_AVAILABLE )
@@ -1017,19 +1021,19 @@ static rc_t print_evidence_alignment_cg_sam( const samdump_opts * const opts, co
         uint32_t al_count_len;
         rc = read_uint8_ptr( align_id, cursor, atx->eval.al_count_idx, &al_count, &al_count_len, "ALIGNMENT_COUNT" );
         if ( rc == 0 && al_count_len > 0 )
-            rc = KOutMsg( "\tNH:i:%u", *al_count );
+            rc = dump_msg( opts, "\tNH:i:%u", *al_count );
     }
 
     /* OPT SAM-FIELD: NM     SRA-column: EDIT_DISTANCE */
     if ( rc == 0 )
-        rc = KOutMsg( "\tNM:i:%u", cgc_output.edit_dist );
+        rc = dump_msg( opts, "\tNM:i:%u", cgc_output.edit_dist );
 
     /* OPT SAM-FIELD: XI     SRA-column: ALIGN_ID */
     if ( rc == 0 && opts->print_alignment_id_in_column_xi )
-        rc = KOutMsg( "\tXI:i:%u", align_id );
+        rc = dump_msg( opts, "\tXI:i:%u", align_id );
 
     if ( rc == 0 )
-        rc = KOutMsg( "\n" );
+        rc = dump_msg( opts, "\n" );
 
     return rc;
 }
@@ -1056,14 +1060,14 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
         {
             if ( spot_group_len > 0 )
                 /* SAM-FIELD: QNAME     constructed from spot-group/seq-name */
-                rc = KOutMsg( "%.*s-1:%.*s\t", spot_group_len, spot_group, seq_name_len, seq_name );
+                rc = dump_msg( opts, "%.*s-1:%.*s\t", spot_group_len, spot_group, seq_name_len, seq_name );
 
         }
         else
         {
             if ( seq_name_len > 0 )
                 /* SAM-FIELD: QNAME     constructed from allel-id/sub-id */
-                rc = KOutMsg( "%.*s/ALLELE_%li.%u\t", seq_name_len, seq_name, rec->id, ploidy_idx );
+                rc = dump_msg( opts, "%.*s/ALLELE_%li.%u\t", seq_name_len, seq_name, rec->id, ploidy_idx );
         }
     }
 
@@ -1091,7 +1095,7 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
     /* SAM-FIELD: POS       SRA-column: REF_POS + 1 */
     /* SAM-FIELD: MAPQ      SRA-column: MAPQ ( from evidence-alignment-table, not from allel! ) */
     if ( rc == 0 )
-        rc = KOutMsg( "%u\tALLELE_%li.%u\t%i\t%d\t", sam_flags, rec->id, ploidy_idx, ref_pos + 1, mapq );
+        rc = dump_msg( opts, "%u\tALLELE_%li.%u\t%i\t%d\t", sam_flags, rec->id, ploidy_idx, ref_pos + 1, mapq );
 
     /* get READ, QUALITY and EIDT_DIST before cigar manipulation because we need/change these values */
     if ( rc == 0 )
@@ -1105,7 +1109,7 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
         if ( rc == 0 )
         rc = cg_cigar_treatments( opts->cigar_treatment, &cgc_input, &cgc_output, align_id, &atx->eval );
         if ( rc == 0 )
-            rc = KOutMsg( "%.*s\t", cgc_output.p_cigar.len, cgc_output.p_cigar.ptr );
+            rc = dump_msg( opts, "%.*s\t", cgc_output.p_cigar.len, cgc_output.p_cigar.ptr );
     }
 
     /* SAM-FIELD: RNEXT     SRA-column: MATE_REF_NAME '*' no mates! */
@@ -1113,7 +1117,7 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
     /* SAM-FIELD: TLEN      SRA-column: TEMPLATE_LEN '0' not in table */
     /* SAM-FIELD: SEQ       SRA-column: READ  */
     if ( rc == 0 )
-        rc = KOutMsg( "*\t0\t0\t%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
+        rc = dump_msg( opts, "*\t0\t0\t%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
 
     /* SAM-FIELD: QUAL      SRA-column: SAM_QUALITY */
     if ( rc == 0 && cgc_output.p_quality.len > 0 )
@@ -1121,10 +1125,10 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
 
     /* OPT SAM-FIELD: RG     SRA-column: SEQ_SPOT_GROUP */
     if ( rc == 0 && spot_group_len > 0 )
-        rc = KOutMsg( "\tRG:Z:%.*s", spot_group_len, spot_group );
+        rc = dump_msg( opts, "\tRG:Z:%.*s", spot_group_len, spot_group );
 
     if ( rc == 0 && cgc_output.p_tags.len > 0 )
-        rc = KOutMsg( "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
+        rc = dump_msg( opts, "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
 
     /* OPT SAM-FIELD: NH     SRA-column: ALIGNMENT_COUNT */
     if ( rc == 0 && atx->eval.al_count_idx != COL_NOT_AVAILABLE )
@@ -1133,19 +1137,19 @@ static rc_t print_evidence_alignment_cg_ev_dnb( const samdump_opts * const opts,
         uint32_t al_count_len;
         rc = read_uint8_ptr( align_id, cursor, atx->eval.al_count_idx, &al_count, &al_count_len, "ALIGNMENT_COUNT" );
         if ( rc == 0 && al_count_len > 0 )
-            rc = KOutMsg( "\tNH:i:%u", *al_count );
+            rc = dump_msg( opts, "\tNH:i:%u", *al_count );
     }
 
     /* OPT SAM-FIELD: NM     SRA-column: EDIT_DISTANCE */
     if ( rc == 0 )
-        rc = KOutMsg( "\tNM:i:%u", cgc_output.edit_dist );
+        rc = dump_msg( opts, "\tNM:i:%u", cgc_output.edit_dist );
 
     /* OPT SAM-FIELD: XI     SRA-column: ALIGN_ID */
     if ( rc == 0 && opts->print_alignment_id_in_column_xi )
-        rc = KOutMsg( "\tXI:i:%u", align_id );
+        rc = dump_msg( opts, "\tXI:i:%u", align_id );
 
     if ( rc == 0 )
-        rc = KOutMsg( "\n" );
+        rc = dump_msg( opts, "\n" );
 
     return rc;
 }
@@ -1210,24 +1214,24 @@ static rc_t print_alignment_sam_ev( const samdump_opts * const opts, const char
                 if ( rc == 0 )
                 {
                     if ( opts->print_cg_names )
-                        rc = KOutMsg( "-1:0\t" );
+                        rc = dump_msg( opts, "-1:0\t" );
                     else
-                        rc = KOutMsg( "ALLELE_%li.%u\t", rec->id, ploidy_idx + 1 );
+                        rc = dump_msg( opts, "ALLELE_%li.%u\t", rec->id, ploidy_idx + 1 );
                 }
 
                 if ( rc == 0 )
-                    rc = KOutMsg( "0\t%s\t%u\t%d\t", ref_name, pos + 1, rec->mapq );
+                    rc = dump_msg( opts, "0\t%s\t%u\t%d\t", ref_name, pos + 1, rec->mapq );
 
                 /* SAM-FIELD: CIGAR     SRA-column: CIGAR_SHORT / CIGAR_LONG sliced!!! */
                 if ( rc == 0 )
-                    rc = KOutMsg( "%.*s\t", cigar_slice_len, transformed_cigar );
+                    rc = dump_msg( opts, "%.*s\t", cigar_slice_len, transformed_cigar );
 
                 /* SAM-FIELD: RNEXT     SRA-column: MATE_REF_NAME ( !!! row_len can be zero !!! ) */
                 /* SAM-FIELD: PNEXT     SRA-column: MATE_REF_POS + 1 ( !!! row_len can be zero !!! ) */
                 /* SAM-FIELD: TLEN      SRA-column: TEMPLATE_LEN ( !!! row_len can be zero !!! ) */
                 /* SAM-FIELD: SEQ       SRA-column: READ sliced!!! */
                 if ( rc == 0 )
-                    rc = KOutMsg( "*\t0\t0\t%.*s\t", read_slice_len, read );
+                    rc = dump_msg( opts, "*\t0\t0\t%.*s\t", read_slice_len, read );
 
                 /* SAM-FIELD: QUAL      SRA-column: SAM_QUALITY sliced!!! */
                 if ( rc == 0 )
@@ -1235,18 +1239,18 @@ static rc_t print_alignment_sam_ev( const samdump_opts * const opts, const char
 
                 /* OPT SAM-FIELD: RG     SRA-column: ploidy_idx */
                 if ( rc == 0 )
-                    rc = KOutMsg( "RG:Z:ALLELE_%u", ploidy_idx + 1 );
+                    rc = dump_msg( opts, "RG:Z:ALLELE_%u", ploidy_idx + 1 );
 
                 /* OPT SAM-FIELD: XI     SRA-column: ALIGN_ID */
                 if ( rc == 0 && opts->print_alignment_id_in_column_xi )
-                    rc = KOutMsg( "\tXI:i:%u", rec->id );
+                    rc = dump_msg( opts, "\tXI:i:%u", rec->id );
 
                 /* OPT SAM-FIELD: NM     SRA-column: EDIT_DISTANCE sliced!!! */
                 if ( rc == 0 && ( ploidy_idx < edit_dist_vector_len ) )
-                    rc = KOutMsg( "\tNM:i:%u", edit_dist_vector[ ploidy_idx ] );
+                    rc = dump_msg( opts, "\tNM:i:%u", edit_dist_vector[ ploidy_idx ] );
 
                 if ( rc == 0 )
-                    rc = KOutMsg( "\n" );
+                    rc = dump_msg( opts, "\n" );
 
                 (*rows_so_far)++;
             }
@@ -1484,11 +1488,11 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
                 rc = dump_name( opts, *seq_spot_id, NULL, 0 ); /* sam-dump-opts.c */
         }
         else
-            rc = KOutMsg( "*" );
+            rc = dump_msg( opts, "*" );
     }
 
     if ( rc == 0 )
-        rc = KOutMsg( "\t" );
+        rc = dump_msg( opts, "\t" );
 
     /* massage the sam-flag if we are not dumping unaligned reads... */
     if ( !opts->dump_unaligned_reads    /** not going to dump unaligned **/
@@ -1503,7 +1507,7 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
     /* SAM-FIELD: POS       SRA-column: REF_POS + 1 */
     /* SAM-FIELD: MAPQ      SRA-column: MAPQ */
     if ( rc == 0 )
-        rc = KOutMsg( "%u\t%s\t%u\t%d\t", sam_flags, ref_name, pos + 1, rec->mapq );
+        rc = dump_msg( opts, "%u\t%s\t%u\t%d\t", sam_flags, ref_name, pos + 1, rec->mapq );
 
     /* get READ, QUALITY and EIDT_DIST before cigar manipulation because we need/change these values */
     if ( rc == 0 )
@@ -1547,7 +1551,7 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
             }
         }
         if ( rc == 0 )
-            rc = KOutMsg( "%.*s\t", cgc_output.p_cigar.len, cgc_output.p_cigar.ptr );
+            rc = dump_msg( opts, "%.*s\t", cgc_output.p_cigar.len, cgc_output.p_cigar.ptr );
         if ( temp_cigar != NULL )
             free( temp_cigar );
     }
@@ -1559,20 +1563,20 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
     {
         if ( mate_ref_name_len > 0 )
         {
-            rc = KOutMsg( "%.*s\t%u\t%d\t", mate_ref_name_len, mate_ref_name, mate_ref_pos + 1, tlen );
+            rc = dump_msg( opts, "%.*s\t%u\t%d\t", mate_ref_name_len, mate_ref_name, mate_ref_pos + 1, tlen );
         }
         else
         {
             if ( mate_ref_pos_len == 0 )
-                rc = KOutMsg( "*\t0\t%d\t", tlen );
+                rc = dump_msg( opts, "*\t0\t%d\t", tlen );
             else
-                rc = KOutMsg( "*\t%u\t%d\t", mate_ref_pos, tlen );
+                rc = dump_msg( opts, "*\t%u\t%d\t", mate_ref_pos, tlen );
         }
     }
 
     /* SAM-FIELD: SEQ       SRA-column: READ */
     if ( rc == 0 )
-        rc = KOutMsg( "%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
+        rc = dump_msg( opts, "%.*s\t", cgc_output.p_read.len, cgc_output.p_read.ptr );
 
     /* SAM-FIELD: QUAL      SRA-column: SAM_QUALITY */
     if ( rc == 0 )
@@ -1580,7 +1584,7 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
         if ( cgc_output.p_quality.len > 0 )
             rc = dump_quality_33( opts, cgc_output.p_quality.ptr, cgc_output.p_quality.len, false );
         else
-            rc = KOutMsg( "*" );
+            rc = dump_msg( opts, "*" );
     }
 
     /* OPT SAM-FIELD: RG     SRA-column: SPOT_GROUP */
@@ -1590,15 +1594,15 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
         uint32_t spot_grp_len;
         rc = read_char_ptr( id, cursor, atx->cmn.seq_spot_group_idx, &spot_grp, &spot_grp_len, "SPOT_GROUP" );
         if ( rc == 0 && spot_grp_len > 0 )
-            rc = KOutMsg( "\tRG:Z:%.*s", spot_grp_len, spot_grp );
+            rc = dump_msg( opts, "\tRG:Z:%.*s", spot_grp_len, spot_grp );
     }
 
     if ( rc == 0 && cgc_output.p_tags.len > 0 )
-        rc = KOutMsg( "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
+        rc = dump_msg( opts, "\t%.*s", cgc_output.p_tags.len, cgc_output.p_tags.ptr );
 
     /* OPT SAM-FIELD: XI     SRA-column: ALIGN_ID */
     if ( rc == 0 && opts->print_alignment_id_in_column_xi )
-        rc = KOutMsg( "\tXI:i:%u", id );
+        rc = dump_msg( opts, "\tXI:i:%u", id );
 
     /* to match sam-tools output: in case we are dumping this in CG-mode.... */
     if ( rc == 0 && ( opts->cigar_treatment != ct_unchanged ) && ( atx->al_group_idx != COL_NOT_AVAILABLE ) )
@@ -1613,7 +1617,7 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
             {
                 if ( align_grp[ i ] == '_' )
                 {
-                    rc = KOutMsg( "\tZI:i:%.*s\tZA:i:%.1s", i, align_grp, align_grp + i + 1 );
+                    rc = dump_msg( opts, "\tZI:i:%.*s\tZA:i:%.1s", i, align_grp, align_grp + i + 1 );
                     break;
                 }
             }
@@ -1627,33 +1631,33 @@ static rc_t print_alignment_sam_ps( const samdump_opts * const opts, const char
         uint32_t al_count_len;
         rc = read_uint8_ptr( id, cursor, atx->cmn.al_count_idx, &al_count, &al_count_len, "ALIGNMENT_COUNT" );
         if ( rc == 0 && al_count_len > 0 )
-            rc = KOutMsg( "\tNH:i:%u", *al_count );
+            rc = dump_msg( opts, "\tNH:i:%u", *al_count );
     }
 
     /* OPT SAM-FIELD: NM     SRA-column: EDIT_DISTANCE */
     if ( rc == 0 )
-        rc = KOutMsg( "\tNM:i:%u", ( cgc_output.edit_dist - NM_adjustments ) );
+        rc = dump_msg( opts, "\tNM:i:%u", ( cgc_output.edit_dist - NM_adjustments ) );
 
     /* OPT SAM-FIELD: XS:A:+/-  SRA-column: RNA-SPLICING detected via computation */
     if ( rc == 0 && opts->rna_splicing && ( candidates.fwd_matched > 0 || candidates.rev_matched > 0 ) )
     {
         if ( candidates.fwd_matched > 0 )
-            rc = KOutMsg( "\tXS:A:+" );
+            rc = dump_msg( opts, "\tXS:A:+" );
         else 
-            rc = KOutMsg( "\tXS:A:-" );
+            rc = dump_msg( opts, "\tXS:A:-" );
 /*
         uint32_t i;
-        KOutMsg( "\tXS:A:" );
+        dump_msg( opts, "\tXS:A:" );
         for ( i = 0; i < candidates.count; ++i )
         {
             rna_splice_candidate * rsc = &candidates.candidates[ i ];
-            KOutMsg( "( offs=%u | len=%u | op_idx=%u | matech=%u )", rsc->offset, rsc->len, rsc->op_idx, rsc->matched );
+            dump_msg( opts, "( offs=%u | len=%u | op_idx=%u | matech=%u )", rsc->offset, rsc->len, rsc->op_idx, rsc->matched );
         }
 */
     }
 
     if ( rc == 0 )
-        rc = KOutMsg( "\n" );
+        rc = dump_msg( opts, "\n" );
     return rc;
 }
 
@@ -1684,9 +1688,9 @@ static rc_t print_alignment_fastx( const samdump_opts * const opts, const char *
     ( *rows_so_far )++;
 
     if ( opts->output_format == of_fastq )
-        rc = KOutMsg( "@" );
+        rc = dump_msg( opts, "@" );
     else
-        rc = KOutMsg( ">" );
+        rc = dump_msg( opts, ">" );
 
     /* SAM-FIELD: QNAME     1.row: name */
     if ( rc == 0 )
@@ -1705,14 +1709,14 @@ static rc_t print_alignment_fastx( const samdump_opts * const opts, const char *
                 rc = dump_name( opts, *seq_spot_id, NULL, 0 ); /* sam-dump-opts.c */
         }
         else
-            rc = KOutMsg( "*" );
+            rc = dump_msg( opts, "*" );
 
         if ( rc == 0 )
         {
             uint32_t seq_read_id;
             rc = read_uint32( rec->id, cursor, atx->cmn.seq_read_id_idx, &seq_read_id, 0, "SEQ_READ_ID" );
             if ( rc == 0 )
-                rc = KOutMsg( "/%u", seq_read_id );
+                rc = dump_msg( opts, "/%u", seq_read_id );
         }
     }
 
@@ -1725,15 +1729,15 @@ static rc_t print_alignment_fastx( const samdump_opts * const opts, const char *
     {
         switch( atx->align_table_type )
         {
-        case att_primary    :   rc = KOutMsg( " primary" ); break;
-        case att_secondary  :   rc = KOutMsg( " secondary" ); break;
-        case att_evidence   :   rc = KOutMsg( " evidence" ); break;
+        case att_primary    :   rc = dump_msg( opts, " primary" ); break;
+        case att_secondary  :   rc = dump_msg( opts, " secondary" ); break;
+        case att_evidence   :   rc = dump_msg( opts, " evidence" ); break;
         }
     }
 
     /* against what reference aligned, at what position, with what mapping-quality */
     if ( rc == 0 )
-        rc = KOutMsg( " ref=%s pos=%u mapq=%i\n", ref_name, pos + 1, rec->mapq );
+        rc = dump_msg( opts, " ref=%s pos=%u mapq=%i\n", ref_name, pos + 1, rec->mapq );
 
     /* READ at a new line */
     if ( rc == 0 )
@@ -1744,16 +1748,16 @@ static rc_t print_alignment_fastx( const samdump_opts * const opts, const char *
         if ( rc == 0 )
         {
             if ( read_size > 0 )
-                rc = KOutMsg( "%.*s\n", read_size, read );
+                rc = dump_msg( opts, "%.*s\n", read_size, read );
             else
-                rc = KOutMsg( "*\n" );
+                rc = dump_msg( opts, "*\n" );
         }
     }
 
     /* QUALITY on a new line if in fastq-mode */
     if ( rc == 0 && opts->output_format == of_fastq )
     {
-        rc = KOutMsg( "+\n" );
+        rc = dump_msg( opts, "+\n" );
         if ( rc == 0 )
         {
             const char * quality;
@@ -1764,10 +1768,10 @@ static rc_t print_alignment_fastx( const samdump_opts * const opts, const char *
                 if ( quality_size > 0 )
                     rc = dump_quality_33( opts, quality, quality_size, false );
                 else
-                    rc = KOutMsg( "*" );
+                    rc = dump_msg( opts, "*" );
             }
             if ( rc == 0 )
-                rc = KOutMsg( "\n" );
+                rc = dump_msg( opts, "\n" );
         }
     }
 
@@ -1947,9 +1951,13 @@ static void CC destroy_align_table_context( void *item, void *data )
 }
 
 
-static rc_t print_all_aligned_spots_of_this_reference( const samdump_opts * const opts, const input_database * const ids,
-                                                       matecache * const mc, const AlignMgr * const a_mgr,
-                                                       const ReferenceObj * const ref_obj, uint64_t * const rows_so_far )
+/* prints the alignments starting in the window [ ref_pos, ref_pos + ref_len ) of one reference,
+   if open_lock is given, the tables of the shared input-database are opened and closed under it */
+static rc_t print_aligned_spots_of_window( const samdump_opts * const opts, const input_database * const ids,
+                                           matecache * const mc, const AlignMgr * const a_mgr,
+                                           const ReferenceObj * const ref_obj,
+                                           INSDC_coord_zero ref_pos, INSDC_coord_len ref_len,
+                                           KLock * const open_lock, uint64_t * const rows_so_far )
 {
     PlacementSetIterator * set_iter;
     /* the we ask the alignment-manager to produce a placement-set-iterator... */
@@ -1962,31 +1970,50 @@ static rc_t print_all_aligned_spots_of_this_reference( const samdump_opts * cons
     {
         /* here we need a vector to passed along into the creation of the iterators */
         Vector context_list;
-        INSDC_coord_len ref_len;
-
         VectorInit ( &context_list, 0, 5 );
 
-        rc = ReferenceObj_SeqLength( ref_obj, &ref_len );
+        if ( open_lock != NULL )
+            KLockAcquire( open_lock );
+        rc = add_pl_iters( opts, set_iter, ref_obj, ids,
+            ref_pos,            /* where the window starts on the reference */
+            ref_len,            /* the length of the window */
+            NULL,               /* no spotgroup re-grouping (yet) */
+            &context_list
+            );
+        if ( open_lock != NULL )
+            KLockUnlock( open_lock );
+
         if ( rc == 0 )
-        {
-            rc = add_pl_iters( opts, set_iter, ref_obj, ids,
-                0,                  /* where it starts on the reference */
-                ref_len,            /* the whole length of this reference/chromosome */
-                NULL,               /* no spotgroup re-grouping (yet) */
-                &context_list
-                );
-            if ( rc == 0 )
-                rc = walk_placements( opts, set_iter, mc, rows_so_far );
-        }
+            rc = walk_placements( opts, set_iter, mc, rows_so_far );
 
         /* walk the context_list to free the align_table_context records, close/free the cursors... */
+        if ( open_lock != NULL )
+            KLockAcquire( open_lock );
         VectorWhack ( &context_list, destroy_align_table_context, NULL );
         PlacementSetIteratorRelease( set_iter );
+        if ( open_lock != NULL )
+            KLockUnlock( open_lock );
     }
     return rc;
 }
 
 
+static rc_t print_all_aligned_spots_of_this_reference( const samdump_opts * const opts, const input_database * const ids,
+                                                       matecache * const mc, const AlignMgr * const a_mgr,
+                                                       const ReferenceObj * const ref_obj, uint64_t * const rows_so_far )
+{
+    INSDC_coord_len ref_len;
+    rc_t rc = ReferenceObj_SeqLength( ref_obj, &ref_len );
+    if ( rc == 0 )
+        rc = print_aligned_spots_of_window( opts, ids, mc, a_mgr, ref_obj,
+                0,                  /* where it starts on the reference */
+                ref_len,            /* the whole length of this reference/chromosome */
+                NULL,               /* single threaded, no locking */
+                rows_so_far );
+    return rc;
+}
+
+
 /*
    the user did not specify regions, print all alignments from all input-files
    this is strategy #1 to do this, create a ref_iter for every reference each
@@ -2026,6 +2053,335 @@ static rc_t print_all_aligned_spots_0( const samdump_opts * const opts, const in
 }
 
 
+/* ### strategy #1 with worker-threads ############################################ */
+
+/* references are cut into windows of this many bases, handed out to the workers round robin,
+   the output of a window is held in memory until all windows before it are written */
+#define ALIGNED_WINDOW_LEN ( 1024 * 1024 )
+
+typedef struct aligned_window
+{
+    uint32_t db_nr;         /* index into ifs->dbs */
+    uint32_t ref_idx;
+    INSDC_coord_zero ref_pos;
+    INSDC_coord_len ref_len;
+} aligned_window;
+
+
+typedef struct aligned_pool aligned_pool;
+
+typedef struct aligned_worker
+{
+    aligned_pool * pool;
+    uint32_t idx;
+    samdump_opts opts;                  /* copy of the caller's options, printing into buf */
+    out_buffer buf;
+    const AlignMgr * a_mgr;
+    const ReferenceList ** reflists;    /* own reflist per input-database, they read with a cursor */
+    KThread * thread;
+    /* guarded by pool lock: window is printed into buf and waits to be written */
+    matecache * mc;
+    uint64_t rows;
+    bool ready;
+    bool finished;
+    rc_t rc;
+} aligned_worker;
+
+
+struct aligned_pool
+{
+    KLock * lock;
+    KCondition * cond;
+    KLock * open_lock;                  /* tables of the shared input-databases are opened one at a time */
+    const input_files * ifs;
+    Vector windows;
+    bool quit;
+    uint32_t qty;
+    aligned_worker * worker;
+};
+
+
+static rc_t make_aligned_windows( const input_files * const ifs, Vector * const windows )
+{
+    rc_t rc = 0;
+    uint32_t db_nr;
+    for ( db_nr = 0; db_nr < ifs->database_count && rc == 0; ++db_nr )
+    {
+        const input_database * ids = VectorGet( &ifs->dbs, db_nr );
+        if ( ids != NULL )
+        {
+            uint32_t refobj_count;
+            rc = ReferenceList_Count( ids->reflist, &refobj_count );
+            if ( rc == 0 && refobj_count > 0 )
+            {
+                uint32_t ref_idx;
+                for ( ref_idx = 0; ref_idx < refobj_count && rc == 0; ++ref_idx )
+                {
+                    const ReferenceObj * ref_obj;
+                    rc = ReferenceList_Get( ids->reflist, &ref_obj, ref_idx );
+                    if ( rc == 0 && ref_obj != NULL )
+                    {
+                        INSDC_coord_len ref_len;
+                        bool circular = false;
+                        rc = ReferenceObj_SeqLength( ref_obj, &ref_len );
+                        if ( rc == 0 )
+                            rc = ReferenceObj_Circular( ref_obj, &circular );
+                        if ( rc == 0 )
+                        {
+                            /* alignments wrapping around the end of a circular reference
+                               would show up in the first window too, these are not cut */
+                            INSDC_coord_len step = circular ? ref_len : ALIGNED_WINDOW_LEN;
+                            INSDC_coord_len pos = 0;
+                            do
+                            {
+                                aligned_window * win = malloc( sizeof * win );
+                                if ( win == NULL )
+                                    rc = RC( rcApp, rcNoTarg, rcConstructing, rcMemory, rcExhausted );
+                                else
+                                {
+                                    win->db_nr = db_nr;
+                                    win->ref_idx = ref_idx;
+                                    win->ref_pos = pos;
+                                    win->ref_len = ( ref_len - pos > step ) ? step : ref_len - pos;
+                                    pos += win->ref_len;
+                                    rc = VectorAppend( windows, NULL, win );
+                                    if ( rc != 0 )
+                                        free( win );
+                                }
+                            } while ( rc == 0 && pos < ref_len );
+                        }
+                        ReferenceObj_Release( ref_obj );
+                    }
+                }
+            }
+        }
+    }
+    return rc;
+}
+
+
+static rc_t print_aligned_window( aligned_worker * const self, const aligned_window * const win )
+{
+    const input_database * ids = VectorGet( &self->pool->ifs->dbs, win->db_nr );
+    const ReferenceObj * ref_obj;
+    rc_t rc = 0;
+
+    self->rows = 0;
+    if ( self->opts.use_mate_cache )
+        rc = make_matecache( &self->mc, self->pool->ifs->database_count );
+    if ( rc == 0 )
+        rc = ReferenceList_Get( self->reflists[ win->db_nr ], &ref_obj, win->ref_idx );
+    if ( rc == 0 )
+    {
+        rc = print_aligned_spots_of_window( &self->opts, ids, self->mc, self->a_mgr, ref_obj,
+                win->ref_pos, win->ref_len, self->pool->open_lock, &self->rows );
+        ReferenceObj_Release( ref_obj );
+    }
+    return rc;
+}
+
+
+static rc_t CC aligned_worker_thread( const KThread * t, void * data )
+{
+    aligned_worker * self = data;
+    aligned_pool * pool = self->pool;
+    uint32_t i, count = VectorLength( &pool->windows );
+    bool quit = false;
+    rc_t rc = 0;
+
+    for ( i = self->idx; !quit && i < count; i += pool->qty )
+    {
+        rc = print_aligned_window( self, VectorGet( &pool->windows, i ) );
+
+        /* hand window over and wait until it is written */
+        KLockAcquire( pool->lock );
+        self->rc = rc;
+        self->ready = true;
+        KConditionBroadcast( pool->cond );
+        while ( self->ready && !pool->quit )
+            KConditionWait( pool->cond, pool->lock );
+        quit = pool->quit || rc != 0;
+        KLockUnlock( pool->lock );
+    }
+
+    KLockAcquire( pool->lock );
+    self->finished = true;
+    KConditionBroadcast( pool->cond );
+    KLockUnlock( pool->lock );
+
+    return rc;
+}
+
+
+static void CC aligned_window_whack( void * item, void * data )
+{
+    free( item );
+}
+
+
+static rc_t release_aligned_pool( aligned_pool * const self )
+{
+    rc_t rc = 0;
+    uint32_t i, db_nr;
+
+    if ( self->worker != NULL )
+    {
+        if ( self->lock != NULL )
+        {
+            KLockAcquire( self->lock );
+            self->quit = true;
+            KConditionBroadcast( self->cond );
+            KLockUnlock( self->lock );
+        }
+        for ( i = 0; i < self->qty; ++i )
+        {
+            aligned_worker * w = &self->worker[ i ];
+            if ( w->thread != NULL )
+            {
+                rc_t status = 0;
+                rc_t rc2 = KThreadWait( w->thread, &status );
+                if ( rc == 0 )
+                    rc = rc2 ? rc2 : status;
+                KThreadRelease( w->thread );
+            }
+            if ( w->reflists != NULL )
+            {
+                for ( db_nr = 0; db_nr < self->ifs->database_count; ++db_nr )
+                    ReferenceList_Release( w->reflists[ db_nr ] );
+                free( ( void * )w->reflists );
+            }
+            if ( w->mc != NULL )
+                release_matecache( w->mc );
+            AlignMgrRelease( w->a_mgr );
+            release_out_buffer( &w->buf );
+        }
+        free( self->worker );
+    }
+    VectorWhack( &self->windows, aligned_window_whack, NULL );
+    KLockRelease( self->open_lock );
+    KConditionRelease( self->cond );
+    KLockRelease( self->lock );
+    return rc;
+}
+
+
+static rc_t make_aligned_worker( aligned_pool * const pool, aligned_worker * const w,
+                                 const samdump_opts * const opts, uint32_t idx )
+{
+    rc_t rc;
+    uint32_t db_nr;
+
+    w->pool = pool;
+    w->idx = idx;
+    w->opts = *opts;
+    init_out_buffer( &w->buf );
+    w->opts.out_buf = &w->buf;
+    rc = AlignMgrMakeRead( &w->a_mgr );
+    if ( rc != 0 )
+    {
+        (void)LOGERR( klogErr, rc, "cannot create alignment-manager" );
+    }
+    else
+    {
+        w->reflists = calloc( pool->ifs->database_count, sizeof w->reflists[ 0 ] );
+        if ( w->reflists == NULL )
+            rc = RC( rcApp, rcNoTarg, rcConstructing, rcMemory, rcExhausted );
+        for ( db_nr = 0; db_nr < pool->ifs->database_count && rc == 0; ++db_nr )
+        {
+            const input_database * ids = VectorGet( &pool->ifs->dbs, db_nr );
+            if ( ids != NULL )
+            {
+                rc = ReferenceList_MakeDatabase( &w->reflists[ db_nr ], ids->db,
+                                                 pool->ifs->reflist_options, 0, NULL, 0 );
+                if ( rc != 0 )
+                    (void)PLOGERR( klogErr, ( klogErr, rc, "cannot create reflist for '$(t)'", "t=%s", ids->path ) );
+            }
+        }
+    }
+    return rc;
+}
+
+
+/*
+   strategy #1 with opts->threads workers, each printing windows of the references into a buffer
+   with an alignment-manager, reflists and a mate-cache of its own,
+   the buffers are written and the mate-caches merged in the order of the windows,
+   this gives exactly the output of print_all_aligned_spots_0()
+*/
+static rc_t print_all_aligned_spots_threaded( const samdump_opts * const opts, const input_files * const ifs,
+                                              matecache * const mc, uint64_t * const rows_so_far )
+{
+    rc_t rc;
+    uint32_t i, count;
+    aligned_pool pool;
+
+    memset( &pool, 0, sizeof pool );
+    pool.ifs = ifs;
+    pool.qty = opts->threads;
+    VectorInit( &pool.windows, 0, 64 );
+    pool.worker = calloc( pool.qty, sizeof pool.worker[ 0 ] );
+    if ( pool.worker == NULL )
+        rc = RC( rcApp, rcNoTarg, rcConstructing, rcMemory, rcExhausted );
+    else
+        rc = make_aligned_windows( ifs, &pool.windows );
+    if ( rc == 0 )
+        rc = KLockMake( &pool.lock );
+    if ( rc == 0 )
+        rc = KLockMake( &pool.open_lock );
+    if ( rc == 0 )
+        rc = KConditionMake( &pool.cond );
+
+    for ( i = 0; rc == 0 && i < pool.qty; ++i )
+        rc = make_aligned_worker( &pool, &pool.worker[ i ], opts, i );
+
+    for ( i = 0; rc == 0 && i < pool.qty; ++i )
+        rc = KThreadMake( &pool.worker[ i ].thread, aligned_worker_thread, &pool.worker[ i ] );
+
+    /* write windows out in the order of the references */
+    count = VectorLength( &pool.windows );
+    for ( i = 0; rc == 0 && i < count; ++i )
+    {
+        aligned_worker * w = &pool.worker[ i % pool.qty ];
+        bool ready;
+
+        rc = KLockAcquire( pool.lock );
+        if ( rc != 0 )
+            break;
+        while ( !w->ready && !w->finished )
+            KConditionWait( pool.cond, pool.lock );
+        ready = w->ready;
+        rc = w->rc;
+        KLockUnlock( pool.lock );
+
+        if ( ready )
+        {
+            /* rows printed before a failure are written out too, as they would be without threads */
+            rc_t rc2 = flush_out_buffer( &w->buf );
+            *rows_so_far += w->rows;
+            if ( rc2 == 0 && mc != NULL && w->mc != NULL )
+                rc2 = matecache_merge( mc, w->mc );
+            release_matecache( w->mc );
+            w->mc = NULL;
+            rc = rc ? rc : rc2;
+        }
+        else if ( rc == 0 )
+        {
+            rc = RC( rcApp, rcThread, rcExecuting, rcThread, rcDone );
+        }
+
+        KLockAcquire( pool.lock );
+        w->ready = false;
+        KConditionBroadcast( pool.cond );
+        KLockUnlock( pool.lock );
+    }
+
+    {
+        rc_t rc2 = release_aligned_pool( &pool );
+        return rc ? rc : rc2;
+    }
+}
+
+
 /*
    the user did not specify regions, print all alignments from all input-files
    this is strategy #2 to do this, throw all iterators for all input-files and all there references
@@ -2119,7 +2475,14 @@ rc_t print_aligned_spots( const samdump_opts * const opts, const input_files * c
             /* the user did not specify regions to be printed ==> print all alignments */
             switch( opts->dump_mode )
             {
-                case dm_one_ref_at_a_time : rc = print_all_aligned_spots_0( opts, ifs, mc, a_mgr, rows_so_far ); break;
+                case dm_one_ref_at_a_time :
+                    /* the output of worker-threads is stitched together in reference order,
+                       the test-limit has to be checked row by row and is left to one thread */
+                    if ( opts->threads > 1 && opts->test_rows == 0 )
+                        rc = print_all_aligned_spots_threaded( opts, ifs, mc, rows_so_far );
+                    else
+                        rc = print_all_aligned_spots_0( opts, ifs, mc, a_mgr, rows_so_far );
+                    break;
                 case dm_prepare_all_refs  : rc = print_all_aligned_spots_1( opts, ifs, mc, a_mgr, rows_so_far ); break;
             }
         }
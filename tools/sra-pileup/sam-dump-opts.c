@@ -26,7 +26,9 @@
 
 
 #include "sam-dump-opts.h"
+#include "out_redir.h"
 #include <align/quality-quantizer.h>
+#include <klib/writer.h>
 #include <sysalloc.h>
 
 #define CURSOR_CACHE_SIZE 256*1024*1024
@@ -925,6 +927,12 @@ static rc_t gather_int_options( Args * args, samdump_opts * opts )
     {
         rc = get_int32_options( args, OPT_MIN_MAPQ, &opts->min_mapq, &opts->use_min_mapq );
     }
+    if ( rc == 0 )
+    {
+        rc = get_int_option( args, OPT_THREADS, 1, &opts->threads, true );
+        if ( rc == 0 && opts->no_mt )
+            opts->threads = 1;
+    }
     return rc;
 }
 
@@ -1288,6 +1296,7 @@ void report_options( const samdump_opts * opts )
     KOutMsg( "rna-splicing          : %s\n",  opts->rna_splicing ? "YES" : "NO" );
 
     KOutMsg( "multithreading        : %s\n",  opts->no_mt ? "NO" : "YES" );    
+    KOutMsg( "threads               : %u\n",  opts->threads );
 }
 
 
@@ -1364,6 +1373,22 @@ bool test_limit_reached( const samdump_opts * opts, uint64_t rows_so_far )
 }
 
 
+rc_t dump_msg( const samdump_opts * opts, const char * fmt, ... )
+{
+    rc_t rc;
+    va_list args;
+
+    va_start( args, fmt );
+    if ( opts->out_buf != NULL )
+        rc = out_buffer_vprint( opts->out_buf, fmt, args );
+    else
+        rc = vkprintf( NULL, fmt, args );
+    va_end( args );
+
+    return rc;
+}
+
+
 rc_t dump_name( const samdump_opts * opts, int64_t seq_spot_id,
                 const char * spot_group, uint32_t spot_group_len )
 {
@@ -1372,9 +1397,9 @@ rc_t dump_name( const samdump_opts * opts, int64_t seq_spot_id,
     if ( opts->print_cg_names )
     {
         if ( spot_group != NULL && spot_group_len != 0 )
-            rc = KOutMsg( "%.*s-1:%lu", spot_group_len, spot_group, seq_spot_id );
+            rc = dump_msg( opts, "%.*s-1:%lu", spot_group_len, spot_group, seq_spot_id );
         else
-            rc = KOutMsg( "%lu", seq_spot_id );
+            rc = dump_msg( opts, "%lu", seq_spot_id );
     }
     else
     {
@@ -1382,19 +1407,19 @@ rc_t dump_name( const samdump_opts * opts, int64_t seq_spot_id,
         {
             /* we do have to print a prefix */
             if ( opts->print_spot_group_in_name && spot_group != NULL && spot_group_len > 0 )
-                rc = KOutMsg( "%s.%lu.%.*s", opts->qname_prefix, seq_spot_id, spot_group_len, spot_group );
+                rc = dump_msg( opts, "%s.%lu.%.*s", opts->qname_prefix, seq_spot_id, spot_group_len, spot_group );
             else
             /* we do NOT have to append the spot-group */
-                rc = KOutMsg( "%s.%lu", opts->qname_prefix, seq_spot_id );
+                rc = dump_msg( opts, "%s.%lu", opts->qname_prefix, seq_spot_id );
         }
         else
         {
             /* we do NOT have to print a prefix */
             if ( opts->print_spot_group_in_name && spot_group != NULL && spot_group_len > 0 )
-                rc = KOutMsg( "%lu.%.*s", seq_spot_id, spot_group_len, spot_group );
+                rc = dump_msg( opts, "%lu.%.*s", seq_spot_id, spot_group_len, spot_group );
             else
             /* we do NOT have to append the spot-group */
-                rc = KOutMsg( "%lu", seq_spot_id );
+                rc = dump_msg( opts, "%lu", seq_spot_id );
         }
     }
     return rc;
@@ -1410,19 +1435,19 @@ rc_t dump_name_legacy( const samdump_opts * opts, const char * name, size_t name
     {
         /* we do have to print a prefix */
         if ( opts->print_spot_group_in_name && spot_group != NULL && spot_group_len > 0 )
-            rc = KOutMsg( "%s.%.*s%.*s", opts->qname_prefix, name_len, name, spot_group_len, spot_group );
+            rc = dump_msg( opts, "%s.%.*s%.*s", opts->qname_prefix, name_len, name, spot_group_len, spot_group );
         else
         /* we do NOT have to append the spot-group */
-            rc = KOutMsg( "%s.%.*s", opts->qname_prefix, name_len, name );
+            rc = dump_msg( opts, "%s.%.*s", opts->qname_prefix, name_len, name );
     }
     else
     {
         /* we do NOT have to print a prefix */
         if ( opts->print_spot_group_in_name && spot_group != NULL && spot_group_len > 0 )
-            rc = KOutMsg( "%.*s.%.*s", name_len, name, spot_group_len, spot_group );
+            rc = dump_msg( opts, "%.*s.%.*s", name_len, name, spot_group_len, spot_group );
         else
         /* we do NOT have to append the spot-group */
-            rc = KOutMsg( "%.*s", name_len, name );
+            rc = dump_msg( opts, "%.*s", name_len, name );
     }
     return rc;
 }
@@ -1441,7 +1466,7 @@ rc_t dump_quality( const samdump_opts * opts, char const *quality, uint32_t qual
             {
                 uint32_t qual = quality[ qual_len - i - 1 ];
                 char newValue = ( opts->qual_quant_matrix[ qual ] + 33 );
-                rc = KOutMsg( "%c", newValue );
+                rc = dump_msg( opts, "%c", newValue );
             }
         }
         else
@@ -1449,7 +1474,7 @@ rc_t dump_quality( const samdump_opts * opts, char const *quality, uint32_t qual
             for ( i = 0; i < qual_len && rc == 0; ++i )
             {
                 char qual = quality[ qual_len - i - 1 ] + 33;
-                rc = KOutMsg( "%c", qual );
+                rc = dump_msg( opts, "%c", qual );
             }
         }
     }
@@ -1461,7 +1486,7 @@ rc_t dump_quality( const samdump_opts * opts, char const *quality, uint32_t qual
             {
                 uint32_t qual = quality[ i ];
                 char newValue = opts->qual_quant_matrix[ qual ] + 33;
-                rc = KOutMsg( "%c", newValue );
+                rc = dump_msg( opts, "%c", newValue );
             }
 
         }
@@ -1470,7 +1495,7 @@ rc_t dump_quality( const samdump_opts * opts, char const *quality, uint32_t qual
             for ( i = 0; i < qual_len && rc == 0; ++i )
             {
                 char qual = quality[ i ] + 33;
-                rc = KOutMsg( "%c", qual );
+                rc = dump_msg( opts, "%c", qual );
             }
         }
     }
@@ -1491,7 +1516,7 @@ rc_t dump_quality_33( const samdump_opts * opts, char const *quality, uint32_t q
             {
                 uint32_t qual = quality[ qual_len - i - 1 ] - 33;
                 char newValue = ( opts->qual_quant_matrix[ qual ] + 33 );
-                rc = KOutMsg( "%c", newValue );
+                rc = dump_msg( opts, "%c", newValue );
             }
         }
         else
@@ -1499,7 +1524,7 @@ rc_t dump_quality_33( const samdump_opts * opts, char const *quality, uint32_t q
             for ( i = 0; i < qual_len && rc == 0; ++i )
             {
                 char qual = quality[ qual_len - i - 1 ];
-                rc = KOutMsg( "%c", qual );
+                rc = dump_msg( opts, "%c", qual );
             }
         }
     }
@@ -1511,13 +1536,13 @@ rc_t dump_quality_33( const samdump_opts * opts, char const *quality, uint32_t q
             {
                 uint32_t qual = quality[ i ] - 33;
                 char newValue = opts->qual_quant_matrix[ qual ] + 33;
-                rc = KOutMsg( "%c", newValue );
+                rc = dump_msg( opts, "%c", newValue );
             }
 
         }
         else
         {
-            rc = KOutMsg( "%.*s", qual_len, quality );
+            rc = dump_msg( opts, "%.*s", qual_len, quality );
         }
     }
     return rc;
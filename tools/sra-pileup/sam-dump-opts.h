@@ -44,6 +44,7 @@ extern "C" {
 
 #include <kapp/args.h>
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -94,6 +95,7 @@ extern "C" {
 #define OPT_NEW         "new"
 #define OPT_RNA_SPLICE  "rna-splicing"
 #define OPT_NO_MT       "disable-multithreading"
+#define OPT_THREADS     "threads"
 
 typedef struct range
 {
@@ -140,6 +142,8 @@ enum cigar_treatment
 };
 
 
+struct out_buffer;
+
 enum dump_mode
 {
     /* in case of: aligned reads requested + no regions given */
@@ -248,6 +252,12 @@ typedef struct samdump_opts
 
     /* option to disable multi-threading */
     bool no_mt;
+
+    /* how many threads print aligned reads, 1 if disabled */
+    uint32_t threads;
+
+    /* worker-threads print into this buffer instead of KOutMsg, NULL on the main thread */
+    struct out_buffer * out_buf;
     
     uint8_t qual_quant_matrix[ 256 ];
 } samdump_opts;
@@ -279,6 +289,9 @@ bool is_this_alignment_requested( const samdump_opts * opts, const char *refname
 
 bool test_limit_reached( const samdump_opts * opts, uint64_t rows_so_far );
 
+/* prints like KOutMsg, or into opts->out_buf if set */
+rc_t dump_msg( const samdump_opts * opts, const char * fmt, ... );
+
 rc_t dump_name( const samdump_opts * opts, int64_t seq_spot_id,
                 const char * spot_group, uint32_t spot_group_len );
 rc_t dump_name_legacy( const samdump_opts * opts, const char * name, size_t name_len,
@@ -33,7 +33,9 @@
 #include <klib/vector.h>
 #include <klib/printf.h>
 #include <klib/data-buffer.h>
+#include <klib/namelist.h>
 #include <vfs/manager.h>
+#include <vfs/resolver.h>
 #include <vfs/path.h>
 #include <vfs/path-priv.h>
 #include <kfs/file.h>
@@ -4772,6 +4774,49 @@ static rc_t GetParams( Args const *const args, char const **const errmsg )
 }
 
 
+/* resolve all accessions on the command line in a few requests
+   before they are dumped one by one; failures are left to ProcessPath */
+static void QueryBatch( Args const *args, uint32_t pcount )
+{
+    VNamelist *list;
+    rc_t rc = VNamelistMake( &list, pcount );
+    if ( rc == 0 )
+    {
+        uint32_t i;
+        for ( i = 0; rc == 0 && i < pcount; ++i )
+        {
+            char const *arg;
+            rc = ArgsParamValue( args, i, &arg );
+            if ( rc == 0 )
+                rc = VNamelistAppend( list, arg );
+        }
+        if ( rc == 0 )
+        {
+            VFSManager *vfs;
+            rc = VFSManagerMake( &vfs );
+            if ( rc == 0 )
+            {
+                VResolver *resolver;
+                rc = VFSManagerGetResolver( vfs, &resolver );
+                if ( rc == 0 )
+                {
+                    KNamelist *names;
+                    rc = VNamelistToNamelist( list, &names );
+                    if ( rc == 0 )
+                    {
+                        VResolverQueryBatch( resolver, eProtocolHttp, names );
+                        KNamelistRelease( names );
+                    }
+                    VResolverRelease( resolver );
+                }
+                VFSManagerRelease( vfs );
+            }
+        }
+        VNamelistRelease( list );
+    }
+}
+
+
 rc_t CC SAM_Dump_Main( int argc, char* argv[] )
 {
     rc_t rc = 0;
@@ -4814,6 +4859,9 @@ rc_t CC SAM_Dump_Main( int argc, char* argv[] )
                 {
                     unsigned i;
                     
+                    if ( pcount > 1 )
+                        QueryBatch( args, pcount );
+
                     for ( i = 0; i < pcount; ++i )
                     {
                         char const *arg;
@@ -155,6 +155,9 @@ char const *rna_splice_usage[]        = { "modify cigar-string and output flags
                                        NULL };
 
 char const *no_mt_usage[]             = { "disable multithreading", NULL };                                       
+
+char const *threads_usage[]           = { "number of threads printing aligned reads (default 1)",
+                                       NULL };
                                       
 OptDef SamDumpArgs[] =
 {
@@ -197,6 +200,7 @@ OptDef SamDumpArgs[] =
     { OPT_NO_MATE_CACHE,NULL, NULL, sd_no_mate_cache_usage,  0, false, false },  /* do not use mate-cache */
     { OPT_RNA_SPLICE,   NULL, NULL, rna_splice_usage,        0, false, false },  /* detect rna-splicing in sequence */
     { OPT_NO_MT,        NULL, NULL, no_mt_usage,              0, false, false },   /* force new code-path */    
+    { OPT_THREADS,      NULL, NULL, threads_usage,           1, true,  false },  /* worker-threads for aligned reads */
     { OPT_DUMP_MODE,    NULL, NULL, NULL,                    0, true,  false },  /* how to produce aligned reads if no regions given */
     { OPT_CIGAR_TEST,   NULL, NULL, NULL,                    0, true,  false },  /* test cg-treatment of cigar string */
     { OPT_LEGACY,       NULL, NULL, NULL,                    0, false, false },  /* force legacy code-path */
@@ -244,6 +248,7 @@ char const *sd_usage_params[] =
     NULL,                       /* no mate-cache */
     NULL,                       /* detect rna-splicing in sequence */
     NULL,                       /* no-mt */    
+    "count",                    /* threads */
     NULL,                       /* dump_mode */
     NULL,                       /* cigar test */
     NULL,                       /* force legacy code path */
@@ -632,6 +632,12 @@ ColumnPair *TablePairMakeColumnPair ( TablePair *self, const ctx_t *ctx,
                 col -> presorted = reader -> presorted;
                 col -> large = large;
 
+                /* simple readers and writers keep all of their
+                   state in their own cursors, so the pair may be
+                   copied alongside others on a separate thread */
+                col -> concurrent = reader -> vt == & SimpleColumnReader_vt &&
+                    writer -> vt == & SimpleColumnWriter_vt;
+
                 rc = string_printf ( col -> full_spec, full_spec_size + 1, NULL,
                     "%s.%s", self -> full_spec, colspec );
                 if ( rc == 0 )
@@ -662,7 +668,10 @@ ColumnPair *TablePairMakeStaticColumnPair ( TablePair *self, const ctx_t *ctx,
     TRY ( col = TablePairMakeColumnPair ( self, ctx, reader, writer, colspec, false ) )
     {
         if ( col != NULL )
+        {
             col -> is_static = true;
+            col -> concurrent = false;
+        }
     }
 
     return col;
@@ -275,6 +275,8 @@ struct ColumnPair
 
     bool large;
 
+    bool concurrent;
+
     char full_spec [ 1 ];
 };
 
@@ -146,18 +146,42 @@ size_t MappingRowSetNextPhys ( MappingRowSet *self, const ctx_t *ctx,
 static
 void MappingRowSetReset ( MappingRowSet *self, const ctx_t *ctx, bool for_static );
 
+static
+void MappingRowSetForkReset ( MappingRowSet *self, const ctx_t *ctx, bool for_static );
+
+static
+RowSet *MappingRowSetFork ( const MappingRowSet *self, const ctx_t *ctx );
+
+static RowSet_vt MappingRowSetForkPhys_vt =
+{
+    MappingRowSetWhack,
+    MappingRowSetNextPhys,
+    MappingRowSetForkReset,
+    MappingRowSetFork
+};
+
+static RowSet_vt MappingRowSetForkStat_vt =
+{
+    MappingRowSetWhack,
+    MappingRowSetNextStat,
+    MappingRowSetForkReset,
+    MappingRowSetFork
+};
+
 static RowSet_vt MappingRowSetPhys_vt =
 {
     MappingRowSetWhack,
     MappingRowSetNextPhys,
-    MappingRowSetReset
+    MappingRowSetReset,
+    MappingRowSetFork
 };
 
 static RowSet_vt MappingRowSetStat_vt =
 {
     MappingRowSetWhack,
     MappingRowSetNextStat,
-    MappingRowSetReset
+    MappingRowSetReset,
+    MappingRowSetFork
 };
 
 static
@@ -202,14 +226,16 @@ static RowSet_vt MapFileMappingRowSetPhys_vt =
 {
     MappingRowSetWhack,
     MappingRowSetNextPhys,
-    MapFileMappingRowSetReset
+    MapFileMappingRowSetReset,
+    MappingRowSetFork
 };
 
 static RowSet_vt MapFileMappingRowSetStat_vt =
 {
     MappingRowSetWhack,
     MappingRowSetNextStat,
-    MapFileMappingRowSetReset
+    MapFileMappingRowSetReset,
+    MappingRowSetFork
 };
 
 static
@@ -244,6 +270,38 @@ void MapFileMappingRowSetReset ( MappingRowSet *self, const ctx_t *ctx, bool for
     self -> cur_elem = 0;
 }
 
+static
+void MappingRowSetForkReset ( MappingRowSet *self, const ctx_t *ctx, bool for_static )
+{
+    /* the pairs were generated or selected by the original row-set */
+    self -> dad . vt = for_static ? & MappingRowSetForkStat_vt : & MappingRowSetForkPhys_vt;
+    self -> cur_elem = 0;
+}
+
+static
+RowSet *MappingRowSetFork ( const MappingRowSet *self, const ctx_t *ctx )
+{
+    FUNC_ENTRY ( ctx );
+
+    MappingRowSet *rs;
+    TRY ( rs = MemAlloc ( ctx, sizeof * rs, false ) )
+    {
+        TRY ( RowSetInit ( & rs -> dad, ctx, & MappingRowSetForkPhys_vt ) )
+        {
+            /* share the map prepared by the original */
+            rs -> map = self -> map;
+            rs -> iter = ( MappingRowSetIterator* ) RowSetIteratorDuplicate ( & self -> iter -> dad, ctx );
+            rs -> num_elems = self -> num_elems;
+            rs -> cur_elem = 0;
+            return & rs -> dad;
+        }
+
+        MemFree ( ctx, rs, sizeof * rs );
+    }
+
+    return NULL;
+}
+
 
 /*--------------------------------------------------------------------------
  * MappingRowSetIterator
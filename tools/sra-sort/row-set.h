@@ -74,6 +74,9 @@ struct RowSet_vt
     /* reset iterator to initial state */
     void ( * reset ) ( ROWSET_IMPL *self, const ctx_t *ctx,
         bool for_static );
+
+    /* create an independent iterator over current row-ids */
+    RowSet* ( * fork ) ( const ROWSET_IMPL *self, const ctx_t *ctx );
 };
 
 
@@ -102,6 +105,15 @@ RowSet *RowSetDuplicate ( const RowSet *self, const ctx_t *ctx );
     POLY_DISPATCH_VOID ( reset, self, ROWSET_IMPL, ctx, for_static )
 
 
+/* Fork
+ *  create an iterator over the row-ids selected by the last Reset
+ *  that may be used on another thread. Reset on a fork only rewinds it,
+ *  and the fork remains valid until the original is Reset again.
+ */
+#define RowSetFork( self, ctx ) \
+    POLY_DISPATCH_PTR ( fork, self, const ROWSET_IMPL, ctx )
+
+
 /* Init
  */
 void RowSetInit ( RowSet *self, const ctx_t *ctx, const RowSet_vt *vt );
@@ -87,11 +87,15 @@ void SimpleRowSetReset ( SimpleRowSet *self, const ctx_t *ctx, bool for_static )
     self -> row_id = self -> first;
 }
 
+static
+RowSet *SimpleRowSetFork ( const SimpleRowSet *self, const ctx_t *ctx );
+
 static RowSet_vt SimpleRowSet_vt =
 {
     SimpleRowSetWhack,
     SimpleRowSetNext,
-    SimpleRowSetReset
+    SimpleRowSetReset,
+    SimpleRowSetFork
 };
 
 
@@ -114,6 +118,16 @@ RowSet *SimpleRowSetMake ( const ctx_t *ctx, int64_t first, int64_t last_excl )
     return NULL;
 }
 
+/* Fork
+ *  the ids are generated, so a fork is just another row-set
+ */
+static
+RowSet *SimpleRowSetFork ( const SimpleRowSet *self, const ctx_t *ctx )
+{
+    FUNC_ENTRY ( ctx );
+    return SimpleRowSetMake ( ctx, self -> first, self -> last_excl );
+}
+
 
 /*--------------------------------------------------------------------------
  * SimpleRowSetIterator
@@ -151,18 +151,42 @@ size_t SortingRowSetNextPhys ( SortingRowSet *self, const ctx_t *ctx,
 static
 void SortingRowSetReset ( SortingRowSet *self, const ctx_t *ctx, bool for_static );
 
+static
+void SortingRowSetForkReset ( SortingRowSet *self, const ctx_t *ctx, bool for_static );
+
+static
+RowSet *SortingRowSetFork ( const SortingRowSet *self, const ctx_t *ctx );
+
 static RowSet_vt SortingRowSetPhys_vt =
 {
     SortingRowSetWhack,
     SortingRowSetNextPhys,
-    SortingRowSetReset
+    SortingRowSetReset,
+    SortingRowSetFork
 };
 
 static RowSet_vt SortingRowSetStat_vt =
 {
     SortingRowSetWhack,
     SortingRowSetNextStat,
-    SortingRowSetReset
+    SortingRowSetReset,
+    SortingRowSetFork
+};
+
+static RowSet_vt SortingRowSetForkPhys_vt =
+{
+    SortingRowSetWhack,
+    SortingRowSetNextPhys,
+    SortingRowSetForkReset,
+    SortingRowSetFork
+};
+
+static RowSet_vt SortingRowSetForkStat_vt =
+{
+    SortingRowSetWhack,
+    SortingRowSetNextStat,
+    SortingRowSetForkReset,
+    SortingRowSetFork
 };
 
 static
@@ -213,6 +237,38 @@ void SortingRowSetReset ( SortingRowSet *self, const ctx_t *ctx, bool for_static
     self -> cur_elem = 0;
 }
 
+static
+void SortingRowSetForkReset ( SortingRowSet *self, const ctx_t *ctx, bool for_static )
+{
+    /* the ids were selected by the original row-set */
+    self -> dad . vt = for_static ? & SortingRowSetForkStat_vt : & SortingRowSetForkPhys_vt;
+    self -> cur_elem = 0;
+}
+
+static
+RowSet *SortingRowSetFork ( const SortingRowSet *self, const ctx_t *ctx )
+{
+    FUNC_ENTRY ( ctx );
+
+    SortingRowSet *rs;
+    TRY ( rs = MemAlloc ( ctx, sizeof * rs, false ) )
+    {
+        TRY ( RowSetInit ( & rs -> dad, ctx, & SortingRowSetForkPhys_vt ) )
+        {
+            /* share the map selected by the original */
+            rs -> src_ids = self -> src_ids;
+            rs -> iter = ( SortingRowSetIterator* ) RowSetIteratorDuplicate ( & self -> iter -> dad, ctx );
+            rs -> num_elems = self -> num_elems;
+            rs -> cur_elem = 0;
+            return & rs -> dad;
+        }
+
+        MemFree ( ctx, rs, sizeof * rs );
+    }
+
+    return NULL;
+}
+
 
 /*--------------------------------------------------------------------------
  * SortingRowSetIterator
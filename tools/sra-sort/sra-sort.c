@@ -83,6 +83,7 @@ rc_t CC UsageSummary ( const char *prog_name )
 #define OPT_MAX_LARGE_IDX_IDS "max-large-idx-ids"
 #define OPT_TEMP_DIR "tempdir"
 #define OPT_MMAP_DIR "mmapdir"
+#define OPT_THREADS "threads"
 #define OPT_UNSORTED_OLD_NEW "unsorted-old-new"
 
 #define OPT_COLUMN_MD5 "column-md5"
@@ -105,6 +106,7 @@ static const char *hlp_max_ref_idx_ids [] = { "sets number of join-index ids to
 static const char *hlp_max_large_idx_ids [] = { "sets number of rows to process with large columns", NULL };
 static const char *hlp_temp_dir [] = { "sets a specific directory to use for temporary files", NULL };
 static const char *hlp_mmap_dir [] = { "sets a specific directory to use for memory-mapped buffers", NULL };
+static const char *hlp_threads [] = { "sets number of threads copying columns, within the memory limit", NULL };
 static const char *hlp_unsorted_old_new [] = { "write old=>new index in unsorted order", NULL };
 
 static const char *hlp_column_md5 [] = { "generate md5sum compatible checksum files for each column [default]", NULL };
@@ -138,6 +140,7 @@ static OptDef options [] =
   , { OPT_MAX_LARGE_IDX_IDS, NULL, NULL, hlp_max_large_idx_ids, 1, true, false }
   , { OPT_TEMP_DIR, NULL, NULL, hlp_temp_dir, 1, true, false }
   , { OPT_MMAP_DIR, NULL, NULL, hlp_mmap_dir, 1, true, false }
+  , { OPT_THREADS, NULL, NULL, hlp_threads, 1, true, false }
   , { OPT_UNSORTED_OLD_NEW, NULL, NULL, hlp_unsorted_old_new, 1, false, false }
 
   , { OPT_COLUMN_MD5, NULL, NULL, hlp_column_md5, 1, false, false }
@@ -162,6 +165,7 @@ static const char *option_params [] =
   , "num-ids"
   , "path-to-tmp"
   , "path-to-mmaps"
+  , "count"
   , NULL
   , NULL
   , NULL
@@ -347,6 +351,9 @@ void initialize_params ( const ctx_t *ctx, Caps *caps, Tool *tp, Selection *sel,
     tp -> min_idx_ids =  64 * 1024 * 1024;
     tp -> max_missing_ids = tp -> max_idx_ids;
 
+    /* copy columns on the calling thread */
+    tp -> num_threads = 1;
+
 #if 0
     /* refpos cache size */
     tp -> refpos_cache_capacity = 100 * 1024 * 1024;
@@ -440,6 +447,19 @@ tp->write_new_to_old=true;
     if ( count != 0 )
         tp -> max_large_idx_ids = ( size_t ) val;
 
+    ON_FAIL ( val = ArgsGetOptU64 ( args, ctx, OPT_THREADS, & count ) )
+        return;
+    if ( count != 0 )
+    {
+        if ( val == 0 || val > 256 )
+        {
+            rc_t rc = RC ( rcExe, rcArgv, rcParsing, rcParam, rcOutofrange );
+            ERROR ( rc, "bad '%s' parameter: %lu", OPT_THREADS, val );
+            return;
+        }
+        tp -> num_threads = ( uint32_t ) val;
+    }
+
     ON_FAIL ( found = ArgsGetOptBool ( args, ctx, OPT_IGNORE_FAILURE, & count ) )
         return;
     if ( count != 0 )
@@ -95,6 +95,9 @@ struct Tool
     /* the number of missing SEQUENCE ids to gather at a time */
     size_t max_missing_ids;
 
+    /* the number of threads copying columns */
+    uint32_t num_threads;
+
     /* pid of tool */
     int pid;
 
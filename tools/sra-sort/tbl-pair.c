@@ -43,11 +43,13 @@ typedef struct TablePair StdTblPair;
 #include <vdb/cursor.h>
 #include <vdb/vdb-priv.h>
 #include <kdb/meta.h>
+#include <kproc/thread.h>
 #include <klib/printf.h>
 #include <klib/text.h>
 #include <klib/namelist.h>
 #include <klib/rc.h>
 
+#include <atomic.h>
 #include <string.h>
 
 
@@ -215,6 +217,196 @@ void CC TablePairReleaseColumnPair ( void *item, void *data )
 }
 
 
+/* CopyColumns
+ *  copies a RowSet into every column of a group
+ *
+ *  with more than one thread, concurrent column pairs are shared
+ *  out among worker threads that each walk their own fork of the
+ *  RowSet. the others may depend upon the table's RowSetIterator
+ *  and are copied afterward on the calling thread.
+ */
+typedef struct TablePairCopyJob TablePairCopyJob;
+struct TablePairCopyJob
+{
+    const Vector *cols;
+    atomic_t next;
+    atomic_t failed;
+};
+
+typedef struct TablePairCopyTask TablePairCopyTask;
+struct TablePairCopyTask
+{
+    Caps caps;
+    TablePairCopyJob *job;
+    RowSet *rs;
+    KThread *t;
+};
+
+static
+void TablePairCopyTaskColumns ( TablePairCopyTask *self, const ctx_t *ctx )
+{
+    FUNC_ENTRY ( ctx );
+
+    TablePairCopyJob *job = self -> job;
+    uint32_t count = VectorLength ( job -> cols );
+
+    while ( atomic_read ( & job -> failed ) == 0 )
+    {
+        ColumnPair *col;
+        uint32_t i = ( uint32_t ) atomic_read_and_add ( & job -> next, 1 );
+        if ( i >= count )
+            break;
+
+        col = VectorGet ( job -> cols, i );
+        assert ( col != NULL );
+        if ( ! col -> concurrent )
+            continue;
+
+        ON_FAIL ( ColumnPairCopy ( col, ctx, self -> rs ) )
+            atomic_set ( & job -> failed, 1 );
+    }
+}
+
+static
+rc_t CC TablePairCopyTaskRun ( const KThread *self, void *data )
+{
+    TablePairCopyTask *task = data;
+
+    DECLARE_CTX_INFO ();
+    ctx_t thread_ctx = { & task -> caps, NULL, & ctx_info };
+    const ctx_t *ctx = & thread_ctx;
+
+    TablePairCopyTaskColumns ( task, ctx );
+
+    return ctx -> rc;
+}
+
+static
+void TablePairCopyConcurrentColumns ( TablePair *self, const ctx_t *ctx,
+    const Vector *cols, RowSet *rs, uint32_t num_threads )
+{
+    FUNC_ENTRY ( ctx );
+
+    TablePairCopyTask *tasks;
+
+    /* select row-ids once, to be shared by the forks */
+    TRY ( RowSetReset ( rs, ctx, false ) )
+    {
+        TRY ( tasks = MemAlloc ( ctx, sizeof * tasks * num_threads, true ) )
+        {
+            rc_t rc;
+            uint32_t i, started;
+            TablePairCopyJob job;
+
+            job . cols = cols;
+            atomic_set ( & job . next, 0 );
+            atomic_set ( & job . failed, 0 );
+
+            /* the first task runs on this thread */
+            for ( started = 0; started < num_threads; ++ started )
+            {
+                TablePairCopyTask *task = & tasks [ started ];
+                task -> job = & job;
+
+                ON_FAIL ( task -> rs = RowSetFork ( rs, ctx ) )
+                    break;
+
+                if ( started != 0 )
+                {
+                    ON_FAIL ( CapsInit ( & task -> caps, ctx ) )
+                    {
+                        RowSetRelease ( task -> rs, ctx );
+                        break;
+                    }
+
+                    rc = KThreadMake ( & task -> t, TablePairCopyTaskRun, task );
+                    if ( rc != 0 )
+                    {
+                        WARN ( "failed to start column copy thread - continuing with %u", started );
+                        CapsWhack ( & task -> caps, ctx );
+                        RowSetRelease ( task -> rs, ctx );
+                        break;
+                    }
+                }
+            }
+
+            if ( started != 0 )
+            {
+                STATUS ( 3, "copying '%s' columns on %u threads", self -> full_spec, started );
+
+                if ( FAILED () )
+                    atomic_set ( & job . failed, 1 );
+                else
+                    TablePairCopyTaskColumns ( & tasks [ 0 ], ctx );
+
+                for ( i = 1; i < started; ++ i )
+                {
+                    rc_t status;
+                    TablePairCopyTask *task = & tasks [ i ];
+
+                    rc = KThreadWait ( task -> t, & status );
+                    if ( rc == 0 )
+                        rc = status;
+                    if ( rc != 0 && ! FAILED () )
+                        ERROR ( rc, "failed to copy '%s' columns on thread %u", self -> full_spec, i );
+
+                    KThreadRelease ( task -> t );
+                    CapsWhack ( & task -> caps, ctx );
+                    RowSetRelease ( task -> rs, ctx );
+                }
+
+                RowSetRelease ( tasks [ 0 ] . rs, ctx );
+            }
+
+            MemFree ( ctx, tasks, sizeof * tasks * num_threads );
+        }
+    }
+}
+
+static
+void TablePairCopyColumns ( TablePair *self, const ctx_t *ctx, const Vector *cols, RowSet *rs )
+{
+    FUNC_ENTRY ( ctx );
+
+    uint32_t i, count = VectorLength ( cols );
+    uint32_t num_threads = ctx -> caps -> tool -> num_threads;
+    bool concurrent = false;
+
+    if ( num_threads > 1 )
+    {
+        uint32_t num_concurrent = 0;
+        for ( i = 0; i < count; ++ i )
+        {
+            const ColumnPair *col = VectorGet ( cols, i );
+            assert ( col != NULL );
+            if ( col -> concurrent )
+                ++ num_concurrent;
+        }
+
+        if ( num_concurrent > 1 )
+        {
+            if ( num_threads > num_concurrent )
+                num_threads = num_concurrent;
+
+            ON_FAIL ( TablePairCopyConcurrentColumns ( self, ctx, cols, rs, num_threads ) )
+                return;
+
+            concurrent = true;
+        }
+    }
+
+    for ( i = 0; i < count; ++ i )
+    {
+        ColumnPair *col = VectorGet ( cols, i );
+        assert ( col != NULL );
+        if ( concurrent && col -> concurrent )
+            continue;
+        ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
+            break;
+    }
+}
+
+
 /* Copy
  *  the table has to obtain a RowSetIterator
  *  which it walks vertically
@@ -303,21 +495,13 @@ void TablePairCopyPresortColumns ( TablePair *self, const ctx_t *ctx )
 
             while ( ! FAILED () )
             {
-                uint32_t i;
-
                 RowSet *rs;
                 ON_FAIL ( rs = RowSetIteratorNext ( rsi, ctx ) )
                     break;
                 if ( rs == NULL )
                     break;
 
-                for ( i = 0; i < count; ++ i )
-                {
-                    ColumnPair *col = VectorGet ( & self -> presort_cols, i );
-                    assert ( col != NULL );
-                    ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
-                        break;
-                }
+                TablePairCopyColumns ( self, ctx, & self -> presort_cols, rs );
 
                 RowSetRelease ( rs, ctx );
             }
@@ -356,21 +540,13 @@ void TablePairCopyMappedColumns ( TablePair *self, const ctx_t *ctx )
 
             while ( ! FAILED () )
             {
-                uint32_t i;
-
                 RowSet *rs;
                 ON_FAIL ( rs = RowSetIteratorNext ( rsi, ctx ) )
                     break;
                 if ( rs == NULL )
                     break;
 
-                for ( i = 0; i < count; ++ i )
-                {
-                    ColumnPair *col = VectorGet ( & self -> mapped_cols, i );
-                    assert ( col != NULL );
-                    ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
-                        break;
-                }
+                TablePairCopyColumns ( self, ctx, & self -> mapped_cols, rs );
 
                 RowSetRelease ( rs, ctx );
             }
@@ -409,21 +585,13 @@ void TablePairCopyLargeColumns ( TablePair *self, const ctx_t *ctx )
 
             while ( ! FAILED () )
             {
-                uint32_t i;
-
                 RowSet *rs;
                 ON_FAIL ( rs = RowSetIteratorNext ( rsi, ctx ) )
                     break;
                 if ( rs == NULL )
                     break;
 
-                for ( i = 0; i < count; ++ i )
-                {
-                    ColumnPair *col = VectorGet ( & self -> large_cols, i );
-                    assert ( col != NULL );
-                    ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
-                        break;
-                }
+                TablePairCopyColumns ( self, ctx, & self -> large_cols, rs );
 
                 RowSetRelease ( rs, ctx );
             }
@@ -462,21 +630,13 @@ void TablePairCopyLargeMappedColumns ( TablePair *self, const ctx_t *ctx )
 
             while ( ! FAILED () )
             {
-                uint32_t i;
-
                 RowSet *rs;
                 ON_FAIL ( rs = RowSetIteratorNext ( rsi, ctx ) )
                     break;
                 if ( rs == NULL )
                     break;
 
-                for ( i = 0; i < count; ++ i )
-                {
-                    ColumnPair *col = VectorGet ( & self -> large_mapped_cols, i );
-                    assert ( col != NULL );
-                    ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
-                        break;
-                }
+                TablePairCopyColumns ( self, ctx, & self -> large_mapped_cols, rs );
 
                 RowSetRelease ( rs, ctx );
             }
@@ -515,21 +675,13 @@ void TablePairCopyNormalColumns ( TablePair *self, const ctx_t *ctx )
 
             while ( ! FAILED () )
             {
-                uint32_t i;
-
                 RowSet *rs;
                 ON_FAIL ( rs = RowSetIteratorNext ( rsi, ctx ) )
                     break;
                 if ( rs == NULL )
                     break;
 
-                for ( i = 0; i < count; ++ i )
-                {
-                    ColumnPair *col = VectorGet ( & self -> normal_cols, i );
-                    assert ( col != NULL );
-                    ON_FAIL ( ColumnPairCopy ( col, ctx, rs ) )
-                        break;
-                }
+                TablePairCopyColumns ( self, ctx, & self -> normal_cols, rs );
 
                 RowSetRelease ( rs, ctx );
             }
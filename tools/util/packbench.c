@@ -0,0 +1,428 @@
+/*===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+*/
+
+#include "packbench.vers.h"
+
+#include <kapp/main.h>
+#include <kapp/args.h>
+
+#include <klib/pack.h>
+#include <klib/vlen-encode.h>
+#include <klib/log.h>
+#include <klib/out.h>
+#include <klib/rc.h>
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+/* Version  EXTERN
+ *  return 4-part version code: 0xMMmmrrrr, where
+ *      MM = major release
+ *      mm = minor release
+ *    rrrr = bug-fix release
+ */
+ver_t CC KAppVersion ( void )
+{
+    return PACKBENCH_VERS;
+}
+
+
+#define OPTION_SIZE   "size"
+#define ALIAS_SIZE    "s"
+static
+const char * size_usage[] =
+{ "megabytes of unpacked data to run through each kernel at each level",
+  "default 256", NULL };
+
+static
+OptDef Options[] =
+{
+    /* name            alias max times oparam required fmtfunc help text loc */
+    { OPTION_SIZE,   ALIAS_SIZE,   NULL, size_usage,   1, true,  false }
+};
+
+
+/* Usage
+ */
+const char UsageDefaultName [] = "packbench";
+
+rc_t CC UsageSummary (const char * progname)
+{
+    return KOutMsg (
+        "\n"
+        "Usage:\n"
+        "  %s [options]\n"
+        "\n"
+        "Summary:\n"
+        "  Report the throughput in GB/s of unpacked data for Pack, Unpack,\n"
+        "  vlen_decode and vlen_decodeU at each vector level this processor\n"
+        "  supports, starting with the scalar code.\n"
+        "\n", progname);
+}
+
+
+rc_t CC Usage (const Args * args)
+{
+    const char * progname = UsageDefaultName;
+    const char * fullpath = UsageDefaultName;
+    rc_t rc;
+
+    if (args == NULL)
+        rc = RC (rcApp, rcArgv, rcAccessing, rcSelf, rcNull);
+    else
+        rc = ArgsProgram (args, &fullpath, &progname);
+
+    UsageSummary (progname);
+
+    KOutMsg ("Options:\n");
+
+    HelpOptionLine (ALIAS_SIZE, OPTION_SIZE, "megabytes", size_usage);
+
+    HelpOptionsStandard ();
+
+    HelpVersion (fullpath, KAppVersion());
+
+    return rc;
+}
+
+
+/* elements per call */
+#define BENCH_ELEMS (256 * 1024)
+
+static const char * level_name [] = { "scalar", "sse4.1", "avx2" };
+#define LEVELS (sizeof level_name / sizeof level_name [0])
+
+typedef struct Bench Bench;
+struct Bench
+{
+    uint8_t * unpacked;
+    uint8_t * packed;
+    uint8_t * vlen;
+    uint64_t * values;
+    bitsz_t packed_bits;
+    uint64_t vlen_bytes;
+};
+
+/* the kind of run being timed */
+enum { bench_pack, bench_unpack, bench_vlen, bench_vlenU };
+
+static
+double elapsed (const struct timeval * start)
+{
+    struct timeval now;
+
+    gettimeofday (&now, NULL);
+    return (double)(now.tv_sec - start->tv_sec) +
+        (double)(now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static
+uint32_t next_random (uint32_t * seed)
+{
+    * seed = * seed * 1103515245 + 12345;
+    return * seed >> 8;
+}
+
+
+/* fill the unpacked buffer with values of "packed" bits and pack them */
+static
+rc_t prepare_pack (Bench * b, uint32_t unpacked, uint32_t packed)
+{
+    uint32_t seed = 1;
+    uint32_t ix;
+
+    for (ix = 0; ix < BENCH_ELEMS; ++ ix)
+    {
+        uint32_t val = next_random (&seed) & ((1U << packed) - 1);
+        switch (unpacked)
+        {
+        case 8:
+            b -> unpacked [ix] = (uint8_t) val;
+            break;
+        case 16:
+            ((uint16_t *) b -> unpacked) [ix] = (uint16_t) val;
+            break;
+        case 32:
+            ((uint32_t *) b -> unpacked) [ix] = val;
+            break;
+        }
+    }
+
+    return Pack (unpacked, packed, b -> unpacked, (size_t) BENCH_ELEMS * unpacked / 8,
+                 NULL, b -> packed, 0, (bitsz_t) BENCH_ELEMS * 32, &b -> packed_bits);
+}
+
+/* encode values of 1 byte, 2 bytes or a mix of both, plus a few longer ones */
+static
+rc_t prepare_vlen (Bench * b, uint32_t bytes, bool sign)
+{
+    uint32_t seed = 1;
+    uint32_t ix;
+
+    for (ix = 0; ix < BENCH_ELEMS; ++ ix)
+    {
+        uint32_t r = next_random (&seed);
+        uint32_t digits = bytes == 1 ? 6 : bytes == 2 ? 13 : (r & 1) ? 6 : 13;
+        int64_t val = r & ((1U << digits) - 1);
+
+        if (bytes == 0 && (r % 61) == 0)
+            val = r;
+        if (sign && (r & 0x100) != 0)
+            val = - val;
+        b -> values [ix] = (uint64_t) val;
+    }
+
+    return sign
+        ? vlen_encode (b -> vlen, (uint64_t) BENCH_ELEMS * 10, &b -> vlen_bytes,
+                       (const int64_t *) b -> values, BENCH_ELEMS)
+        : vlen_encodeU (b -> vlen, (uint64_t) BENCH_ELEMS * 10, &b -> vlen_bytes,
+                        b -> values, BENCH_ELEMS);
+}
+
+
+/* time "kind" until size_mb megabytes of unpacked data went through */
+static
+rc_t bench_run (Bench * b, uint32_t kind, uint32_t unpacked, uint32_t packed,
+                uint32_t size_mb, double * gbps)
+{
+    uint64_t bytes = (uint64_t) BENCH_ELEMS * unpacked / 8;
+    uint64_t total = (uint64_t) size_mb << 20;
+    uint64_t done = 0;
+    struct timeval start;
+    double secs;
+    rc_t rc = 0;
+
+    gettimeofday (&start, NULL);
+    while (rc == 0 && done < total)
+    {
+        bitsz_t psize;
+        size_t usize;
+        uint64_t consumed;
+
+        switch (kind)
+        {
+        case bench_pack:
+            rc = Pack (unpacked, packed, b -> unpacked, bytes, NULL,
+                       b -> packed, 0, (bitsz_t) BENCH_ELEMS * 32, &psize);
+            break;
+        case bench_unpack:
+            rc = Unpack (packed, unpacked, b -> packed, 0, b -> packed_bits, NULL,
+                         b -> unpacked, bytes, &usize);
+            break;
+        case bench_vlen:
+            rc = vlen_decode ((int64_t *) b -> values, BENCH_ELEMS,
+                              b -> vlen, b -> vlen_bytes, &consumed);
+            break;
+        case bench_vlenU:
+            rc = vlen_decodeU (b -> values, BENCH_ELEMS,
+                               b -> vlen, b -> vlen_bytes, &consumed);
+            break;
+        }
+        done += bytes;
+    }
+
+    secs = elapsed (&start);
+    * gbps = (secs > 0) ? done / secs / 1e9 : 0;
+    return rc;
+}
+
+/* one line of the report: the same run at each level */
+static
+rc_t bench_line (Bench * b, const char * name, uint32_t kind,
+                 uint32_t unpacked, uint32_t packed, uint32_t size_mb)
+{
+    rc_t rc = KOutMsg ("%-16s", name);
+    KPackSimd level;
+
+    for (level = kpackScalar; rc == 0 && level < LEVELS; ++ level)
+    {
+        double gbps;
+
+        if (PackSimdLimit (level) != level)
+            rc = KOutMsg (" %10s", "-");
+        else
+        {
+            rc = bench_run (b, kind, unpacked, packed, size_mb, &gbps);
+            if (rc == 0)
+                rc = KOutMsg (" %10.2f", gbps);
+        }
+    }
+
+    if (rc == 0)
+        rc = KOutMsg ("\n");
+    else
+        PLOGERR (klogErr, (klogErr, rc, "failed to run '$(N)'", "N=%s", name));
+    return rc;
+}
+
+
+static
+rc_t run (uint32_t size_mb)
+{
+    static const uint32_t widths [] = { 8, 16, 32 };
+    static const uint32_t bits [] = { 1, 2, 4, 8 };
+    static const char * vlen_name [] = { "mixed", "1 byte", "2 byte" };
+    Bench b;
+    unsigned ix, jx;
+    rc_t rc;
+
+    b . unpacked = malloc ((size_t) BENCH_ELEMS * 4);
+    b . packed = malloc ((size_t) BENCH_ELEMS * 4);
+    b . vlen = malloc ((size_t) BENCH_ELEMS * 10);
+    b . values = malloc ((size_t) BENCH_ELEMS * 8);
+    if (b . unpacked == NULL || b . packed == NULL ||
+        b . vlen == NULL || b . values == NULL)
+    {
+        free (b . unpacked);
+        free (b . packed);
+        free (b . vlen);
+        free (b . values);
+        return RC (rcExe, rcBuffer, rcAllocating, rcMemory, rcExhausted);
+    }
+
+    rc = KOutMsg ("%-16s %10s %10s %10s   (GB/s unpacked, in use: %s)\n",
+                  "kernel", level_name [0], level_name [1], level_name [2],
+                  level_name [PackSimdLevel ()]);
+
+    for (ix = 0; rc == 0 && ix < sizeof widths / sizeof widths [0]; ++ ix)
+    {
+        for (jx = 0; rc == 0 && jx < sizeof bits / sizeof bits [0]; ++ jx)
+        {
+            char name [32];
+
+            if (widths [ix] == bits [jx])
+                continue;
+
+            PackSimdLimit (kpackScalar);
+            rc = prepare_pack (&b, widths [ix], bits [jx]);
+            if (rc == 0)
+            {
+                sprintf (name, "pack %u->%u", widths [ix], bits [jx]);
+                rc = bench_line (&b, name, bench_pack, widths [ix], bits [jx], size_mb);
+            }
+            if (rc == 0)
+            {
+                sprintf (name, "unpack %u->%u", bits [jx], widths [ix]);
+                rc = bench_line (&b, name, bench_unpack, widths [ix], bits [jx], size_mb);
+            }
+        }
+    }
+
+    for (ix = 0; rc == 0 && ix < sizeof vlen_name / sizeof vlen_name [0]; ++ ix)
+    {
+        char name [32];
+
+        PackSimdLimit (kpackScalar);
+        rc = prepare_vlen (&b, ix, false);
+        if (rc == 0)
+        {
+            sprintf (name, "vlenU %s", vlen_name [ix]);
+            rc = bench_line (&b, name, bench_vlenU, 64, 0, size_mb);
+        }
+
+        PackSimdLimit (kpackScalar);
+        if (rc == 0)
+            rc = prepare_vlen (&b, ix, true);
+        if (rc == 0)
+        {
+            sprintf (name, "vlen %s", vlen_name [ix]);
+            rc = bench_line (&b, name, bench_vlen, 64, 0, size_mb);
+        }
+    }
+
+    /* leave the processor's best level in use */
+    PackSimdLimit (kpackAVX2);
+
+    free (b . unpacked);
+    free (b . packed);
+    free (b . vlen);
+    free (b . values);
+    return rc;
+}
+
+
+/* KMain - EXTERN
+ *  executable entrypoint "main" is implemented by
+ *  an OS-specific wrapper that takes care of establishing
+ *  signal handlers, logging, etc.
+ *
+ *  in turn, OS-specific "main" will invoke "KMain" as
+ *  platform independent main entrypoint.
+ *
+ *  "argc" [ IN ] - the number of textual parameters in "argv"
+ *  should never be < 0, but has been left as a signed int
+ *  for reasons of tradition.
+ *
+ *  "argv" [ IN ] - array of NUL terminated strings expected
+ *  to be in the shell-native character set: ASCII or UTF-8
+ *  element 0 is expected to be executable identity or path.
+ */
+rc_t CC KMain ( int argc, char *argv [] )
+{
+    Args* args = NULL;
+    rc_t rc;
+
+    rc = ArgsMakeAndHandle(&args, argc, argv, 1, Options, sizeof Options / sizeof (OptDef));
+    if (rc)
+        LOGERR (klogInt, rc, "failed to parse command line parameters");
+    else
+    {
+        uint32_t size_mb = 256;
+        uint32_t pcount;
+
+        rc = ArgsOptionCount (args, OPTION_SIZE, &pcount);
+        if (rc)
+            LOGERR (klogInt, rc, "failed to examine size option");
+        else if (pcount)
+        {
+            const char * value;
+
+            rc = ArgsOptionValue (args, OPTION_SIZE, 0, &value);
+            if (rc)
+                LOGERR (klogInt, rc, "failed to examine size value");
+            else
+            {
+                size_mb = (uint32_t) strtoul (value, NULL, 10);
+                if (size_mb == 0)
+                {
+                    rc = RC (rcExe, rcArgv, rcParsing, rcParam, rcInvalid);
+                    LOGERR (klogErr, rc, "bad value for size");
+                }
+            }
+        }
+        if (rc == 0)
+            rc = run (size_mb);
+
+        ArgsWhack (args);
+    }
+    return rc;
+}
+
+/* EOF */
@@ -195,46 +195,76 @@ static rc_t vdb_fastq_loop_without_name( const p_dump_context ctx, const fastq_c
 }
 
 
+static rc_t vdb_fasta_print_row( const p_dump_context ctx, const fastq_ctx * fctx,
+                                 int64_t row_id, const char * data, uint32_t row_len )
+{
+    uint32_t idx = 0;
+    int32_t to_print = row_len;
+
+    rc_t rc = KOutMsg( ">%s.%li %li length=%u\n",
+                       fctx->run_name, row_id, row_id, row_len );
+    if ( to_print > ctx->max_line_len )
+        to_print = ctx->max_line_len;
+    while ( rc == 0 && to_print > 0 )
+    {
+        rc = KOutMsg( "%.*s\n", to_print, &data[ idx ] );
+        if ( rc == 0 )
+        {
+            idx += ctx->max_line_len;
+            to_print = ( row_len - idx );
+            if ( to_print > ctx->max_line_len )
+                to_print = ctx->max_line_len;
+        }
+    }
+    return rc;
+}
+
+
+typedef struct fasta_span_ctx
+{
+    const p_dump_context ctx;
+    const fastq_ctx * fctx;
+    int64_t row_id;     /* the next row to print, or the one that failed */
+} fasta_span_ctx;
+
+
+/* called by VCursorReadRange() for the rows of one blob */
+static rc_t CC vdb_fasta_span( const VCursorBlobSpan * span, void * data )
+{
+    fasta_span_ctx * sctx = data;
+    rc_t rc = Quitting();
+    uint32_t i;
+
+    if ( rc == 0 && span->elem_bits != 8 )
+        rc = RC( rcExe, rcColumn, rcReading, rcType, rcInvalid );
+
+    for ( i = 0; rc == 0 && i < span->row_count; ++i )
+    {
+        const char * row = ( const char * )span->base + span->row_offset[ i ];
+        sctx->row_id = span->first_row + i;
+        rc = vdb_fasta_print_row( sctx->ctx, sctx->fctx, sctx->row_id, row, span->row_len[ i ] );
+    }
+    if ( rc == 0 )
+        sctx->row_id = span->first_row + span->row_count;
+    return rc;
+}
+
+
+/* READ is the only column, the rows are taken a blob at a time */
 static rc_t vdb_fasta_loop_without_name( const p_dump_context ctx, const fastq_ctx * fctx )
 {
     rc_t rc = 0;
-    int64_t row_id;
+    uint64_t start, count;
+    fasta_span_ctx sctx = { ctx, fctx, 0 };
 
     vdn_start( ctx->row_generator );
-    while ( vdn_next( ctx->row_generator, (uint64_t*)&row_id ) && rc == 0 )
+    while ( rc == 0 && vdn_next_range( ctx->row_generator, &start, &count ) )
     {
-        rc = Quitting();
-        if ( rc == 0 )
-        {
-            uint32_t elem_bits, boff, row_len;
-            const char * data;
-
-            rc = VCursorCellDataDirect( fctx->cursor, row_id, fctx->idx_read, &elem_bits,
-                                        (const void**)&data, &boff, &row_len );
-            if ( rc != 0 )
-                vdb_fastq_row_error( "VCursorCellDataDirect( row#$(row_nr), READ ) failed", rc, row_id );
-            else
-            {
-                uint32_t idx = 0;
-                int32_t to_print = row_len;
-
-                rc = KOutMsg( ">%s.%li %li length=%u\n",
-                              fctx->run_name, row_id, row_id, row_len );
-                if ( to_print > ctx->max_line_len )
-                    to_print = ctx->max_line_len;
-                while ( rc == 0 && to_print > 0 )
-                {
-                    rc = KOutMsg( "%.*s\n", to_print, &data[ idx ] );
-                    if ( rc == 0 )
-                    {
-                        idx += ctx->max_line_len;
-                        to_print = ( row_len - idx );
-                        if ( to_print > ctx->max_line_len )
-                            to_print = ctx->max_line_len;
-                    }
-                }
-            }
-        }
+        sctx.row_id = ( int64_t )start;
+        rc = VCursorReadRange( fctx->cursor, fctx->idx_read, ( int64_t )start, count,
+                               vdb_fasta_span, &sctx );
+        if ( rc != 0 && GetRCState( rc ) != rcCanceled )
+            vdb_fastq_row_error( "VCursorReadRange( row#$(row_nr), READ ) failed", rc, sctx.row_id );
     }
     return rc;
 }
@@ -415,6 +415,42 @@ static bool vdn_next_node( num_gen* generator, uint64_t* value )
     return res;
 }
 
+/* hands out the rest of the current node as one run of numbers,
+   in endless mode everything from the current number on */
+bool vdn_next_range( num_gen* generator, uint64_t* start, uint64_t* count )
+{
+    bool res = false;
+    if ( generator != NULL )
+    {
+        if ( vdn_range_defined( generator ) )
+        {
+            if ( generator->curr_node < generator->node_count )
+            {
+                p_num_gen_node node = (p_num_gen_node)VectorGet( &(generator->nodes), 
+                                                (uint32_t)generator->curr_node );
+                if ( node != NULL )
+                {
+                    uint64_t node_count = ( node->count < 2 ? 1 : node->count );
+                    if ( start ) *start = node->start + generator->curr_node_sub_pos;
+                    if ( count ) *count = node_count - generator->curr_node_sub_pos;
+                    generator->curr_node++;
+                    generator->curr_node_sub_pos = 0;
+                    res = true;
+                }
+            }
+        }
+        else if ( generator->curr_node != UINT64_MAX )
+        {
+            /* endless mode, there are NO nodes (number-ranges) defined */
+            if ( start ) *start = generator->curr_node;
+            if ( count ) *count = UINT64_MAX - generator->curr_node;
+            generator->curr_node = UINT64_MAX;
+            res = true;
+        }
+    }
+    return res;
+}
+
 bool vdn_range_defined( num_gen* generator )
 {
     bool res = false;
@@ -69,6 +69,7 @@ bool vdn_check_range( num_gen* generator,
 
 bool vdn_start( num_gen* generator );
 bool vdn_next( num_gen* generator, uint64_t* value );
+bool vdn_next_range( num_gen* generator, uint64_t* start, uint64_t* count );
 bool vdn_range_defined( num_gen* generator );
 
 #ifdef __cplusplus